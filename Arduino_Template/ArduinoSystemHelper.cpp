@@ -58,31 +58,9 @@ bool ArduinoSystemHelper::initNetwork(IPAddress serverIP, uint16_t serverPort) {
     
     SPI.begin();
     
-    // 从控制器ID生成MAC地址
-    int controllerNum = controllerId.substring(1).toInt();
-    byte mac[] = {
-        0xDE, 0xAD, 0xBE, 0xEF, 
-        (byte)((controllerNum >> 8) & 0xFF), 
-        (byte)(controllerNum & 0xFF)
-    };
-    
-    // 计算IP地址
-    int lastOctet = 100 + (controllerNum % 150);
-    IPAddress ip(192, 168, 10, lastOctet);
-    IPAddress gateway(192, 168, 10, 1);
-    IPAddress subnet(255, 255, 255, 0);
-    IPAddress dns(192, 168, 10, 1);
-    
-    // 初始化W5100
+    // 初始化W5100（片选引脚10）；MAC/IP配置和Ethernet.begin由harbingerClient.begin完成，
+    // 链路稳定在loop中后台等待，这里不阻塞
     Ethernet.init(10);
-    delay(50);    // 🚀 减少到50ms，足够W5100初始化
-    
-    Ethernet.begin(mac, ip, dns, gateway, subnet);
-    delay(1000);   // 🚀 减少到500ms，大多数情况下足够
-    
-    if (Ethernet.localIP() == IPAddress(0, 0, 0, 0)) {
-        return false;
-    }
     
     // 初始化HarbingerClient
     if (harbingerClient.begin(controllerId, "Arduino")) {
@@ -17,7 +17,22 @@ enum OutputState {
 enum InputMode {
     INPUT_SINGLE,      // 单次采样
     INPUT_CONTINUOUS,  // 连续采样
-    INPUT_CHANGE       // 变化检测
+    INPUT_CHANGE,      // 变化检测
+    INPUT_PULSE        // 位图去抖 + 脉宽/频率测量（上拉输入，低电平有效）
+};
+
+// 位图历史长度（uint32_t移位寄存器，最新采样在bit0）
+#define DIO_HISTORY_BITS        32
+#define DIO_DEFAULT_STABLE_SAMPLES 5   // 默认连续稳定采样数
+#define DIO_MAX_PULSE_CHANNELS  2      // 同时处于INPUT_PULSE模式的通道数（测量状态独立成池，不占普通通道内存）
+
+// 脉冲测量状态（INPUT_PULSE通道从池中借用）
+struct PulseMeasure {
+    unsigned long lastEdgeTime;   // 最近一次稳定边沿时间戳
+    uint16_t lastHighWidth;       // 上一个完整高电平脉宽(ms)，饱和到65535
+    uint16_t lastLowWidth;        // 上一个完整低电平脉宽(ms)，饱和到65535
+    uint16_t edgeCount;           // 稳定边沿计数
+    bool inUse;
 };
 
 // ========================== 统一输出管理器 ==========================
@@ -90,20 +105,28 @@ class DigitalInputChannel {
 private:
     InputMode mode;
     bool lastValue;
-    bool currentValue;
+    bool currentValue;            // INPUT_PULSE模式下为去抖后的稳定电平
     unsigned long lastSampleTime;
-    unsigned long sampleInterval;
+    uint16_t sampleInterval;      // 采样间隔(ms)，最大65秒
     bool hasChanged;
     bool isActive;
     
+    // 位图采样历史：每bit一个采样，最新采样在bit0
+    uint32_t history;
+    uint8_t sampleCount;          // 有效采样数（最多32）
+    uint8_t stableSamples;        // 去抖所需连续稳定采样数（1-32）
+    
+    // 脉冲测量（仅INPUT_PULSE模式，其他模式为NULL）
+    PulseMeasure* pulse;
+    static PulseMeasure pulsePool[DIO_MAX_PULSE_CHANNELS];
+    
+    void pushSample(bool value);
+    void sampleDebounced(unsigned long now);
+    void releasePulse();
+    
 public:
     int8_t pin;  // 改为public，方便DigitalIOController访问
     
-    // 连续采样缓冲区
-    uint8_t sampleBuffer[8];
-    uint8_t bufferIndex;
-    uint8_t sampleCount;
-    
 public:
     DigitalInputChannel();
     
@@ -118,7 +141,17 @@ public:
     
     // 连续采样
     void setSampleInterval(unsigned long intervalMs);
+    void setStableSamples(uint8_t count);
     uint8_t getSampleHistory(bool* buffer, uint8_t maxCount);
+    uint32_t getHistoryBits() const;
+    
+    // 脉冲测量（INPUT_PULSE模式，其他模式返回0/false）
+    bool isHeldFor(bool level, unsigned long ms) const;   // 当前稳定电平为level且已保持≥ms
+    unsigned long getHoldDuration() const;                // 当前稳定电平已保持时间
+    unsigned long getLastEdgeTime() const;
+    uint16_t getPulseWidth(bool level) const;             // 上一个完整level脉冲的宽度
+    uint16_t getEdgeCount() const;
+    float getFrequency() const;                           // 由最近一个完整周期计算(Hz)，无数据返回0
     
     // 状态查询
     bool getIsActive() const;
@@ -168,6 +201,13 @@ public:
     static void stopInput(int pin);
     static void stopAllInputs();
     
+    // 脉冲输入（位图去抖 + 计时）
+    static bool startPulseInput(int pin, unsigned long intervalMs = 10, uint8_t stableSamples = DIO_DEFAULT_STABLE_SAMPLES);
+    static bool isInputHeldFor(int pin, bool level, unsigned long ms);
+    static unsigned long getInputHoldDuration(int pin);
+    static uint16_t getInputPulseWidth(int pin, bool level);
+    static float getInputFrequency(int pin);
+    
     // 批量操作
     static void setOutputPattern(int* pins, bool* levels, uint8_t count);
     static void scheduleOutputSequence(int* pins, bool* levels, unsigned long* delays, unsigned long* durations, uint8_t count);
@@ -207,6 +247,8 @@ public:
 #define INPUT_READ(pin)                DigitalIOController::readInput(pin)
 #define INPUT_START(pin, mode, interval) DigitalIOController::startInput(pin, mode, interval)
 #define INPUT_CHANGED(pin)             DigitalIOController::hasInputChanged(pin)
+#define INPUT_START_PULSE(pin, interval, stable) DigitalIOController::startPulseInput(pin, interval, stable)
+#define INPUT_HELD(pin, level, ms)     DigitalIOController::isInputHeldFor(pin, level, ms)
 
 // 传统兼容宏（内部使用）
 #define DIO_SET(pin, level)            DigitalIOController::setOutput(pin, level)
@@ -50,7 +50,7 @@ bool GameFlowManager::startStage(const String& stageId) {
     
     // 更新环节管理信息
     currentStageId = normalizedId;
-    stageStartTime = millis();
+    stageStartTime = millis() - harbingerClient.getDispatchLateness();  // at=定时启动时对齐到约定时刻
     stageRunning = true;
     
     // 根据环节ID执行对应逻辑
@@ -83,8 +83,10 @@ bool GameFlowManager::startStage(const String& stageId) {
         Serial.print(STAGE_001_2_FADE_DURATION);
         Serial.println(F("ms)"));
         
-        // 设置第2路初始音量为30
+        // 第2路从初始音量淡出，结束后停止播放（由语音控制器按限速驱动）
         voice.setVolume(STAGE_001_2_FADE_CHANNEL, STAGE_001_2_FADE_START_VOL);
+        voice.fadeTo(STAGE_001_2_FADE_CHANNEL, STAGE_001_2_FADE_END_VOL, STAGE_001_2_FADE_DURATION,
+                     STAGE_001_2_FADE_CURVE, true);
         
         // 音频播放现在由updateStep001_2()方法根据START时间控制
         Serial.println(F("⏳ 等待通道到达启动时间..."));
@@ -128,6 +130,9 @@ void GameFlowManager::stopCurrentStage() {
         Serial.print(F("⏹️ 结束当前环节: "));
         Serial.println(currentStageId);
         
+        if (currentStageId == "001_2") {
+            voice.cancelFade(STAGE_001_2_FADE_CHANNEL);  // 环节停止时淡出一并停止
+        }
         stageRunning = false;
         currentStageId = "";
         stageStartTime = 0;
@@ -143,6 +148,7 @@ void GameFlowManager::stopAllStages() {
     
     // 停止所有音频通道
     for (int channel = 1; channel <= 4; channel++) {
+        voice.cancelFade(channel);
         voice.stop(channel);
         delay(50);  // 给每个停止命令一些时间执行
     }
@@ -395,41 +401,6 @@ void GameFlowManager::updateStep001_2() {
         Serial.println(STAGE_001_2_SONG_ID);
     }
     
-    // 音量淡出控制：3秒内从30减到0，每100ms减1
-    if (elapsed <= STAGE_001_2_FADE_DURATION) {
-        static unsigned long lastVolumeUpdate = 0;
-        static int currentVolume = STAGE_001_2_FADE_START_VOL;
-        static bool volumeUpdateComplete = false;
-        
-        if (!volumeUpdateComplete && elapsed - lastVolumeUpdate >= STAGE_001_2_FADE_INTERVAL) {
-            // 计算当前应该的音量：30 - (elapsed / 100)
-            int targetVolume = STAGE_001_2_FADE_START_VOL - (elapsed / STAGE_001_2_FADE_INTERVAL);
-            if (targetVolume < STAGE_001_2_FADE_END_VOL) {
-                targetVolume = STAGE_001_2_FADE_END_VOL;
-            }
-            
-            if (currentVolume != targetVolume) {
-                currentVolume = targetVolume;
-                voice.setVolume(STAGE_001_2_FADE_CHANNEL, currentVolume);
-                lastVolumeUpdate = elapsed;
-                
-                Serial.print(F("🔊 通道"));
-                Serial.print(STAGE_001_2_FADE_CHANNEL);
-                Serial.print(F("音量调整为"));
-                Serial.print(currentVolume);
-                Serial.print(F("("));
-                Serial.print(elapsed);
-                Serial.println(F("ms)"));
-            }
-        }
-    } else if (elapsed == STAGE_001_2_FADE_DURATION + 100) {
-        // 3秒后停止第2路音频
-        voice.stop(STAGE_001_2_FADE_CHANNEL);
-        Serial.print(F("⏹️ 通道"));
-        Serial.print(STAGE_001_2_FADE_CHANNEL);
-        Serial.println(F("音频停止"));
-    }
-    
     // 83.347秒后跳转到下一环节
     if (!jumpRequested && elapsed >= STAGE_001_2_DURATION) {
         // 重置静态变量，为下次启动准备
@@ -38,7 +38,7 @@
 #define STAGE_001_2_FADE_START_VOL  30       // 起始音量
 #define STAGE_001_2_FADE_END_VOL    0        // 结束音量
 #define STAGE_001_2_FADE_DURATION   3000     // 3秒淡出时间
-#define STAGE_001_2_FADE_INTERVAL   100      // 100ms调整一次音量(30步*100ms=3000ms)
+#define STAGE_001_2_FADE_CURVE      BY_FADE_LINEAR  // 淡出曲线
 #define STAGE_001_2_DURATION        83347    // 83.347秒总时长
 #define STAGE_001_2_NEXT_STAGE      "002_0"  // 跳转目标环节
 
@@ -1,6 +1,7 @@
 #include "SimpleGameStage.h"
 #include "MillisPWM.h"
 #include "GameFlowManager.h"
+#include "UniversalHarbingerClient.h"
 
 // 前向声明，避免循环依赖
 class GameFlowManager;
@@ -32,7 +33,7 @@ SimpleGameStage::SimpleGameStage() {
 // 开始指定环节
 void SimpleGameStage::startStage(int stageNumber) {
     currentStage = stageNumber;
-    stageStartTime = millis();
+    stageStartTime = millis() - harbingerClient.getDispatchLateness();  // at=定时启动时对齐到约定时刻
     stageRunning = true;
     
     // 重置所有时间段的执行状态
@@ -210,18 +211,25 @@ void SimpleGameStage::executeStartAction(int segmentIndex) {
             Serial.println("ms)");
             break;
             
-        case LED_FLASH:
-            pinMode(segment.pin, OUTPUT);
-            // value1是间隔时间，这里开始第一次点亮
-            digitalWrite(segment.pin, HIGH);
+        case LED_FLASH: {
+            // value1是点亮时间，value2是熄灭时间(0=与点亮相同)，由PWM通道按截止时间频闪
+            int offMs = (segment.value2 > 0) ? segment.value2 : segment.value1;
+            uint16_t count = segment.duration / max(segment.value1 + offMs, 1);
+            if (count == 0) count = 1;  // 时长不足一个周期也只闪一次；startFlash的0表示无限
+            MillisPWM::startFlash(segment.pin, segment.value1, offMs, count);
             Serial.print("LED");
             Serial.print(segment.pin);
-            Serial.print(" FLASH开始 (间隔");
+            Serial.print(" FLASH开始 (");
             Serial.print(segment.value1);
-            Serial.print("ms, 持续");
+            Serial.print("/");
+            Serial.print(offMs);
+            Serial.print("ms x");
+            Serial.print(count);
+            Serial.print(", 持续");
             Serial.print(segment.duration);
             Serial.println("ms)");
             break;
+        }
             
         case PWM_RAMP:
             pinMode(segment.pin, OUTPUT);
@@ -308,7 +316,8 @@ void SimpleGameStage::executeEndAction(int segmentIndex) {
             break;
             
         case LED_FLASH:
-            digitalWrite(segment.pin, LOW);
+            MillisPWM::stopFlash(segment.pin);
+            MillisPWM::setBrightness(segment.pin, 0);
             Serial.print("LED");
             Serial.print(segment.pin);
             Serial.println(" FLASH STOP");
@@ -420,8 +429,8 @@ void SimpleGameStage::ledBreathing(unsigned long startTime, unsigned long durati
     addSegment(startTime, duration, pin, LED_BREATHING, cycleMs, 0);
 }
 
-void SimpleGameStage::ledFlash(unsigned long startTime, unsigned long duration, int pin, int intervalMs) {
-    addSegment(startTime, duration, pin, LED_FLASH, intervalMs, 0);
+void SimpleGameStage::ledFlash(unsigned long startTime, unsigned long duration, int pin, int intervalMs, int offMs) {
+    addSegment(startTime, duration, pin, LED_FLASH, intervalMs, offMs);
 }
 
 void SimpleGameStage::pwmRamp(unsigned long startTime, unsigned long duration, int pin, int fromValue, int toValue) {
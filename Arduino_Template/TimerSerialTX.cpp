@@ -0,0 +1,118 @@
+#include "TimerSerialTX.h"
+#include <avr/interrupt.h>
+
+// 静态成员变量定义
+TimerSerialTX* TimerSerialTX::active = NULL;
+
+// Timer3比较A中断：每个位周期触发一次
+ISR(TIMER3_COMPA_vect) {
+    TimerSerialTX::tickFromISR();
+}
+
+TimerSerialTX::TimerSerialTX(int pin) : txPin((int8_t)pin), txReg(NULL), txMask(0),
+                                        head(0), tail(0), shiftReg(0), bitsLeft(0) {
+}
+
+void TimerSerialTX::begin(unsigned long baud) {
+    uint8_t port = digitalPinToPort(txPin);
+    if (port == NOT_A_PIN || baud == 0) return;
+
+    txReg = portOutputRegister(port);
+    txMask = digitalPinToBitMask(txPin);
+    pinMode(txPin, OUTPUT);
+    digitalWrite(txPin, HIGH);  // 空闲为高电平
+
+    uint8_t oldSREG = SREG;
+    cli();
+    head = tail = 0;
+    bitsLeft = 0;
+    active = this;
+
+    // CTC模式(TOP=OCR3A)，8分频：16MHz/8 = 2MHz，9600bps时每位208个计数
+    TCCR3A = 0;
+    TCCR3B = _BV(WGM32) | _BV(CS31);
+    OCR3A = (uint16_t)((F_CPU / 8 + baud / 2) / baud - 1);
+    TCNT3 = 0;
+    TIMSK3 &= ~_BV(OCIE3A);  // 有数据时才开启
+    SREG = oldSREG;
+}
+
+void TimerSerialTX::end() {
+    flush();
+    TIMSK3 &= ~_BV(OCIE3A);
+    active = NULL;
+}
+
+size_t TimerSerialTX::write(uint8_t data) {
+    if (txReg == NULL) return 0;
+
+    uint8_t next = (head + 1) & (TSTX_BUFFER_SIZE - 1);
+    while (next == tail) {
+        // 缓冲已满：等待ISR取走一个字节；关中断时ISR不会执行，由这里轮询发送
+        pollTick();
+    }
+    buffer[head] = data;
+    head = next;
+
+    startTimer();
+    return 1;
+}
+
+void TimerSerialTX::startTimer() {
+    // 检查与开启放在同一个临界区内，避免ISR刚关闭中断时漏掉新字节
+    uint8_t oldSREG = SREG;
+    cli();
+    if (!(TIMSK3 & _BV(OCIE3A))) {
+        TCNT3 = 0;
+        TIFR3 = _BV(OCF3A);      // 清除过期的比较标志，起始位占满一个位周期
+        TIMSK3 |= _BV(OCIE3A);
+    }
+    SREG = oldSREG;
+}
+
+void TimerSerialTX::flush() {
+    while (!isIdle()) {
+        pollTick();
+    }
+}
+
+void TimerSerialTX::pollTick() {
+    if (SREG & _BV(SREG_I)) return;          // 中断开启：由ISR发送
+    if (TIFR3 & _BV(OCF3A)) {
+        TIFR3 = _BV(OCF3A);                  // 写1清除标志，下一位周期再置位
+        handleTick();
+    }
+}
+
+bool TimerSerialTX::isIdle() const {
+    // 停止位发完且缓冲为空时ISR才关闭中断
+    return !(TIMSK3 & _BV(OCIE3A));
+}
+
+void TimerSerialTX::tickFromISR() {
+    if (active != NULL) {
+        active->handleTick();
+    }
+}
+
+void TimerSerialTX::handleTick() {
+    if (bitsLeft == 0) {
+        if (tail == head) {
+            // 无数据：线路保持高电平，关闭中断
+            TIMSK3 &= ~_BV(OCIE3A);
+            return;
+        }
+        // 低位先发：bit0=起始位0，bit1-8=数据，bit9=停止位1
+        shiftReg = ((uint16_t)buffer[tail] << 1) | 0x200;
+        tail = (tail + 1) & (TSTX_BUFFER_SIZE - 1);
+        bitsLeft = 10;
+    }
+
+    if (shiftReg & 1) {
+        *txReg |= txMask;
+    } else {
+        *txReg &= ~txMask;
+    }
+    shiftReg >>= 1;
+    bitsLeft--;
+}
@@ -0,0 +1,62 @@
+#ifndef TIMER_SERIAL_TX_H
+#define TIMER_SERIAL_TX_H
+
+#include <Arduino.h>
+
+// ========================== 定时器驱动的只发送软串口 ==========================
+// SoftwareSerial发送每个字节都关中断约1ms(9600bps)，一帧BY命令约10ms，
+// 期间millis、软件PWM和中断输入全部停顿。这里改用Timer3比较A中断，每个中断只输出一位，
+// 字节排入环形缓冲后立即返回，全程不屏蔽全局中断。
+//
+// Timer3被切换到CTC模式，其比较输出引脚(2/3/5)不再能用analogWrite；
+// MillisPWM检测到定时器已被占用时会自动对这些引脚使用软件PWM。
+// 只发送：BY模块的查询应答在该通道上收不到，查询会超时后跳过。
+//
+// 在关中断时调用（ISR内、cli()之后）：缓冲未满时照常排队；缓冲已满或flush()时
+// 中断不会来取字节，改为轮询比较标志OCF3A在当前上下文里逐位发出，位时序仍由Timer3决定，
+// 不丢字节也不死等，但每个字节会阻塞约1ms(9600bps)。
+
+#define TSTX_BUFFER_SIZE    32      // 发送环形缓冲（必须是2的幂）
+
+class TimerSerialTX : public Stream {
+private:
+    int8_t txPin;
+    volatile uint8_t* txReg;         // 发送引脚的PORTx寄存器
+    uint8_t txMask;
+
+    // 环形缓冲：head仅由主循环写，tail仅由ISR写
+    uint8_t buffer[TSTX_BUFFER_SIZE];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+
+    // ISR侧移位状态：起始位 + 8数据位 + 停止位
+    uint16_t shiftReg;
+    uint8_t bitsLeft;
+
+    static TimerSerialTX* active;    // ISR分派目标（同时只有一个实例）
+
+    void startTimer();
+    void pollTick();                 // 关中断时代替ISR：比较标志置位则发出一位
+
+public:
+    TimerSerialTX(int txPin);
+
+    void begin(unsigned long baud);
+    void end();
+
+    // Stream接口（只发送）
+    virtual size_t write(uint8_t data);
+    using Print::write;
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+    virtual void flush();            // 等待缓冲发送完毕
+
+    bool isIdle() const;
+
+    // ISR入口（内部使用）
+    void handleTick();
+    static void tickFromISR();
+};
+
+#endif // TIMER_SERIAL_TX_H
@@ -20,6 +20,7 @@
 #include "GameFlowManager.h"
 #include "TimeManager.h"
 #include "DigitalIOController.h"
+#include "InputCapture.h"
 #include "ArduinoSystemHelper.h"
 #include "UniversalHarbingerClient.h"
 #include "GameProtocolHandler.h"
@@ -31,6 +32,7 @@
 #define DEBUG 1
 #define CONTROLLER_ID "C101"
 #define ENABLE_NETWORK true   // 网络开关
+#define ENABLE_GROUP_MULTICAST false // 组播组命令（多控制器同步效果），需要ENABLE_NETWORK；额外占用一个W5100 socket且数据报无认证，仅在隔离的展厅网络中开启
 #define ENABLE_VOICE true     // 语音控制开关
 
 // ========================== 全局实例 ==========================
@@ -38,14 +40,19 @@ BY_VoiceController_Unified voice;  // 统一语音控制器实例
 
 void setup() {
     // 初始化串口
-    Serial.begin(SERIAL_BAUDRATE);
-    while (!Serial && millis() < 3000); // 等待串口就绪，最多3秒
+    Serial.begin(SERIAL_BAUDRATE);   // Mega的硬件串口无需等待USB枚举
+    
+    // ========================== 硬件初始化 ==========================
+    // 最先执行：植物灯/射灯/按键灯拉低、输入上拉，上电后立即处于安全状态
+    initC101Hardware();  // 初始化C101特定的硬件引脚
+    harbingerClient.markBootPhase(F("hw"));
 
     Serial.println(F("=== C101 4路语音控制器启动 ==="));
 
     // 初始化各个组件
     MPWM_BEGIN();              // PWM系统 (核心)
     DIO_BEGIN();               // 数字IO控制器
+    ICAP_BEGIN();              // 中断输入捕获（按键/干簧管/读卡器）
     commandProcessor.begin();  // 命令处理器
     gameStageManager.begin();  // 游戏环节状态机
     
@@ -72,6 +79,7 @@ void setup() {
         } else {
             Serial.println(F("❌ 统一语音控制器初始化失败"));
         }
+        harbingerClient.markBootPhase(F("voice"));
         
         Serial.println(F("语音命令格式：c1p(播放) c1s(停止) c1:11(播放歌曲11)"));
         Serial.println(F("测试命令：c1:11, c2:11, c3:11, c4:11"));
@@ -86,24 +94,25 @@ void setup() {
         IPAddress serverIP(192, 168, 10, 10);
         if (systemHelper.initNetwork(serverIP, 9000)) {
             Serial.println(F("网络初始化成功"));
+            if (ENABLE_GROUP_MULTICAST) {
+                IPAddress groupIP(239, 255, 10, 10);
+                harbingerClient.joinGroup(groupIP);
+            }
         } else {
             Serial.println(F("网络初始化失败"));
         }
     }
     
-    // ========================== 硬件初始化 ==========================
-    Serial.println(F("初始化硬件..."));
-    
-    // 使用配置文件的硬件初始化函数
-    initC101Hardware();  // 初始化C101特定的硬件引脚
     Serial.println(F("✓ 4路音频模块硬件配置完成"));
     
     // 设置GameStateMachine的设备控制回调
     gameStateMachine.setDeviceControlCallback(onGameStateChange);
     Serial.println(F("✓ 游戏状态回调设置完成"));
     
-    // 8. 通信客户端初始化
-    if (harbingerClient.begin(CONTROLLER_ID, "Arduino")) {
+    // 8. 通信客户端初始化（initNetwork已初始化时跳过，避免重复Ethernet.begin并重新等待链路）
+    if (harbingerClient.getConnectionState() != CONN_DISCONNECTED) {
+        Serial.println(F("✓ 通信客户端已由网络系统初始化"));
+    } else if (harbingerClient.begin(CONTROLLER_ID, "Arduino")) {
         Serial.println(F("✓ 通信客户端初始化成功"));
         
         // 连接到服务器
@@ -122,20 +131,14 @@ void setup() {
     Serial.println(F("✓ 游戏协议处理器初始化完成"));
     
     Serial.println(F("所有组件初始化完成"));
+    harbingerClient.markBootPhase(F("setup"));   // 以太网链路和服务器连接在loop中后台完成
     Serial.println(F("输入 'help' 查看所有命令"));
 }
 
 void loop() {
     // ========================== 紧急开门高优先级检测 ==========================
-    // 在所有其他处理之前，立即检测紧急开门信号
-    static bool lastEmergencyState = HIGH;
-    bool currentEmergencyState = digitalRead(C101_DOOR_CARD_COM_PIN);
-    if (lastEmergencyState == HIGH && currentEmergencyState == LOW) {
-        // 立即触发紧急开门，不等待gameFlowManager.update()
-        digitalWrite(C101_DOOR_LOCK_PIN, LOW);  // Pin26解锁（断电）
-        Serial.println(F("🚨⚡ 高优先级紧急开门触发！"));
-    }
-    lastEmergencyState = currentEmergencyState;
+    // 电磁锁由InputCapture在Timer0比较B中断中直接解锁，这里只取出捕获的边沿
+    ICAP_UPDATE();
     
     // ========================== 串口命令处理 ==========================
     if (Serial.available()) {
@@ -0,0 +1,158 @@
+/**
+ * =============================================================================
+ * CommandTable - 编译期哈希命令表
+ * 版本: 1.1
+ *
+ * 功能:
+ * - 命令名在编译期算出16位哈希，与处理函数、参数规格一起存入PROGMEM
+ * - 名字/用法/帮助按实际长度连续存放在一块PROGMEM文本中，表项只保存指针
+ * - 编译期生成按哈希排序的索引，分派 = 一次哈希 + 二分查找 + 命中后一次strcmp_P确认
+ * - 参数按表项规格统一解析一次(逗号或空格分隔)，处理函数直接拿整数/浮点值
+ * - 帮助信息按表顺序生成：标题行、命令行、模式命令说明都来自同一张表
+ * =============================================================================
+ */
+
+#ifndef COMMAND_TABLE_H
+#define COMMAND_TABLE_H
+
+#include <Arduino.h>
+
+// ========================== 配置 ==========================
+#define CMD_MAX_ARGS        4       // 每条命令最多解析的参数个数
+#define CMD_HELP_COLUMN     28      // 帮助文本对齐列
+
+// 表项类型
+#define CMD_KIND_EXEC       0       // 可执行命令（按名字精确匹配）
+#define CMD_KIND_PATTERN    1       // 模式命令说明（如p<pin>，由调用方自行解析，只用于帮助）
+#define CMD_KIND_TITLE      2       // 帮助分组标题
+
+// 参数规格：低4位最少参数个数，高4位最多参数个数
+#define CMD_ARGS(minArgs, maxArgs)  ((uint8_t)((minArgs) | ((maxArgs) << 4)))
+#define CMD_NO_ARGS                 CMD_ARGS(0, 0)
+#define CMD_ARG_FLOAT(n)            ((uint8_t)(1 << (n)))   // 第n个参数按浮点解析
+
+// 分派结果
+#define CMD_NOT_FOUND       -1
+#define CMD_FAILED          0
+#define CMD_OK              1
+
+// ========================== 编译期哈希 ==========================
+// djb2异或变体，截断为16位；运行期commandHash()必须与之一致
+constexpr uint16_t cmdHashStep(const char* s, uint16_t h) {
+    return *s ? cmdHashStep(s + 1, (uint16_t)(((uint16_t)(h << 5) + h) ^ (uint8_t)*s)) : h;
+}
+#define CMD_HASH(name)      cmdHashStep(name, 5381)
+
+// 第n行文本在文本块中的偏移 = 前n行文本长度之和
+constexpr uint16_t cmdTextOffset(const uint16_t* sizes, uint8_t n) {
+    return n ? (uint16_t)(sizes[n - 1] + cmdTextOffset(sizes, n - 1)) : 0;
+}
+
+// 第i行在哈希排序中的名次（哈希相同按表顺序）
+constexpr uint8_t cmdHashRank(const uint16_t* hashes, uint8_t count, uint8_t i, uint8_t j) {
+    return j >= count ? 0
+        : (uint8_t)(((hashes[j] < hashes[i] || (hashes[j] == hashes[i] && j < i)) ? 1 : 0)
+                    + cmdHashRank(hashes, count, i, j + 1));
+}
+
+// 哈希排序后第k位对应的表行
+constexpr uint8_t cmdSortedAt(const uint16_t* hashes, uint8_t count, uint8_t k, uint8_t i) {
+    return cmdHashRank(hashes, count, i, 0) == k ? i : cmdSortedAt(hashes, count, k, i + 1);
+}
+
+// ========================== 参数与表项 ==========================
+struct CommandArgs {
+    const String* command;          // 原始命令名（转发型命令使用）
+    const String* params;           // 原始参数串
+    uint8_t count;                  // 实际解析到的参数个数
+    union {
+        long i;
+        float f;
+    } value[CMD_MAX_ARGS];
+
+    long intAt(uint8_t n, long fallback = 0) const {
+        return (n < count) ? value[n].i : fallback;
+    }
+    float floatAt(uint8_t n, float fallback = 0) const {
+        return (n < count) ? value[n].f : fallback;
+    }
+};
+
+typedef bool (*CommandHandler)(const CommandArgs& args);
+
+struct CommandEntry {
+    uint16_t hash;
+    uint8_t kind;
+    uint8_t argSpec;
+    uint8_t floatMask;
+    CommandHandler handler;
+    const char* text;               // PROGMEM: "名字\0用法\0帮助\0"，帮助为空时不出现在帮助中（别名）
+};
+
+struct CommandTable {
+    const CommandEntry* entries;    // PROGMEM，表顺序即帮助顺序
+    const uint8_t* order;           // PROGMEM，按哈希升序排列的表行号
+    uint8_t count;
+};
+
+// 表行宏：命令表写成X宏列表，每行第一个参数X由CMD_DEFINE_TABLE依次代入各生成步骤
+#define CMD_ENTRY(X, name, args, handler, usage, help) \
+    X(CMD_KIND_EXEC, name, args, 0, handler, usage, help)
+#define CMD_ENTRY_F(X, name, args, floatMask, handler, usage, help) \
+    X(CMD_KIND_EXEC, name, args, floatMask, handler, usage, help)
+#define CMD_ALIAS(X, name, args, handler) \
+    X(CMD_KIND_EXEC, name, args, 0, handler, "", "")
+#define CMD_PATTERN(X, pattern, usage, help) \
+    X(CMD_KIND_PATTERN, pattern, CMD_NO_ARGS, 0, NULL, usage, help)
+#define CMD_TITLE(X, title) \
+    X(CMD_KIND_TITLE, "", CMD_NO_ARGS, 0, NULL, "", title)
+
+// 生成步骤（行号由__COUNTER__相对本步骤起点得出）
+#define CMD_ROW_TEXT(kind, name, args, floatMask, handler, usage, help) \
+    name "\0" usage "\0" help "\0"
+#define CMD_ROW_SIZE(kind, name, args, floatMask, handler, usage, help) \
+    (uint16_t)sizeof(name "\0" usage "\0" help),
+#define CMD_ROW_HASH(kind, name, args, floatMask, handler, usage, help) \
+    (uint16_t)((kind) == CMD_KIND_EXEC ? CMD_HASH(name) : 0),
+#define CMD_ROW_ENTRY(kind, name, args, floatMask, handler, usage, help) \
+    { (uint16_t)((kind) == CMD_KIND_EXEC ? CMD_HASH(name) : 0), kind, args, floatMask, handler, \
+      text + cmdTextOffset(sizes, __COUNTER__ - entryBase - 1) },
+#define CMD_ROW_ORDER(kind, name, args, floatMask, handler, usage, help) \
+    cmdSortedAt(hashes, count, __COUNTER__ - orderBase - 1, 0),
+
+// 由X宏列表生成PROGMEM文本块、表项、哈希排序索引和表描述；sizes/hashes只参与编译期计算
+#define CMD_DEFINE_TABLE(table, LIST) \
+    namespace table##_DATA { \
+        static const char text[] PROGMEM = LIST(CMD_ROW_TEXT); \
+        constexpr uint16_t sizes[] = { LIST(CMD_ROW_SIZE) }; \
+        constexpr uint16_t hashes[] = { LIST(CMD_ROW_HASH) }; \
+        constexpr uint8_t count = sizeof(hashes) / sizeof(hashes[0]); \
+        constexpr int entryBase = __COUNTER__; \
+        static const CommandEntry entries[] PROGMEM = { LIST(CMD_ROW_ENTRY) }; \
+        constexpr int orderBase = __COUNTER__; \
+        static const uint8_t order[] PROGMEM = { LIST(CMD_ROW_ORDER) }; \
+    } \
+    static const CommandTable table PROGMEM = { table##_DATA::entries, table##_DATA::order, table##_DATA::count }
+
+// ========================== 表操作 ==========================
+uint16_t commandHash(const char* name);
+
+/**
+ * @brief 按名字查找可执行表项并复制到RAM（哈希索引二分查找）
+ * @param table PROGMEM中的表描述（CMD_DEFINE_TABLE生成）
+ * @return true=找到
+ */
+bool findCommand(const CommandTable& table, const String& name, CommandEntry& entry);
+
+/**
+ * @brief 查找、解析参数并执行
+ * @return CMD_NOT_FOUND / CMD_FAILED(参数不足或处理失败) / CMD_OK
+ */
+int8_t dispatchCommand(const CommandTable& table, const String& command, const String& params);
+
+/**
+ * @brief 按表顺序输出帮助
+ */
+void printCommandHelp(const CommandTable& table);
+
+#endif // COMMAND_TABLE_H
@@ -11,6 +11,7 @@
 #include "BY_VoiceController_Unified.h"
 #include "C101_SimpleConfig.h"  // 添加配置文件引用
 #include "MillisPWM.h"          // 添加PWM呼吸灯控制
+#include "InputCapture.h"       // 中断输入捕获（按键/干簧管/读卡器）
 #include <string.h>  // for memset
 
 // 外部全局实例
@@ -171,9 +172,11 @@ void UnifiedPinManager::updateSinglePin(int index) {
 GameFlowManager::GameFlowManager() {
     // 初始化并行环节数组
     activeStageCount = 0;
+    runningMask = 0;
     globalStopped = false;
     
     // 初始化兼容性变量
+    compatType = STAGE_TYPE_NONE;
     currentStageId = "";
     stageStartTime = 0;
     stageRunning = false;
@@ -188,6 +191,10 @@ GameFlowManager::GameFlowManager() {
     for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
         stages[i] = StageState();
     }
+    for (int i = 0; i < STAGE_TYPE_COUNT; i++) {
+        typeSlot[i] = STAGE_SLOT_NONE;
+        resetStageTypeState(i);
+    }
 }
 
 bool GameFlowManager::begin() {
@@ -195,17 +202,19 @@ bool GameFlowManager::begin() {
     
     // 初始化所有环节状态
     for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-        stages[i].running = false;
-        stages[i].stageId = "";
-        stages[i].startTime = 0;
-        stages[i].jumpRequested = false;
-        memset(&stages[i].state, 0, sizeof(stages[i].state));
+        stages[i] = StageState();
+    }
+    for (int i = 0; i < STAGE_TYPE_COUNT; i++) {
+        typeSlot[i] = STAGE_SLOT_NONE;
+        resetStageTypeState(i);
     }
     
     activeStageCount = 0;
+    runningMask = 0;
     globalStopped = false;
     
     // 初始化兼容旧接口的变量
+    compatType = STAGE_TYPE_NONE;
     currentStageId = "";
     stageStartTime = 0;
     stageRunning = false;
@@ -252,6 +261,16 @@ bool GameFlowManager::begin() {
     
     Serial.println(F("✅ 统一引脚管理器初始化完成"));
     
+    // 注册中断捕获输入
+    // 读卡器：ISR中直接解锁电磁锁，解锁延迟不受loop负载影响
+    InputCapture::watch(C101_DOOR_CARD_COM_PIN, 0);
+    InputCapture::setDirectAction(C101_DOOR_CARD_COM_PIN, LOW, C101_DOOR_LOCK_PIN, LOW);
+    InputCapture::watch(STAGE_001_1_REED_PIN, STAGE_001_1_REED_DEBOUNCE_TIME);
+    for (int i = 0; i < C101_TAUNT_BUTTON_COUNT; i++) {
+        InputCapture::watch(C101_TAUNT_BUTTON_COM_PINS[i], STAGE_006_0_BUTTON_DEBOUNCE_TIME);
+    }
+    Serial.println(F("✅ 中断捕获输入注册完成"));
+    
     // 打印PWM通道状态
     MillisPWM::printChannelStatus();
     
@@ -260,39 +279,112 @@ bool GameFlowManager::begin() {
 }
 
 // ========================== 私有辅助方法 ==========================
-int GameFlowManager::findStageIndex(const String& stageId) {
-    for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-        if (stages[i].running && stages[i].stageId == stageId) {
-            return i;
+// 环节ID驻留表（Flash），下标即StageType
+static const char STAGE_NAMES[STAGE_TYPE_COUNT][6] PROGMEM = {
+    "000_0", "001_1", "001_2", "002_0", "006_0"
+};
+
+// 环节ID两端可忽略的字符：引号和空白（串口命令行尾的\r\n、制表符等）
+static bool isStageIdPadding(char c) {
+    return c == '"' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+uint8_t GameFlowManager::internStageId(const char* stageId, unsigned int length) {
+    // 跳过引号和空白（兼容服务器带引号的step参数）
+    while (length > 0 && isStageIdPadding(*stageId)) {
+        stageId++;
+        length--;
+    }
+    while (length > 0 && isStageIdPadding(stageId[length - 1])) {
+        length--;
+    }
+    
+    if (length != sizeof(STAGE_NAMES[0]) - 1) {
+        return STAGE_TYPE_NONE;
+    }
+    for (uint8_t type = 0; type < STAGE_TYPE_COUNT; type++) {
+        if (memcmp_P(stageId, STAGE_NAMES[type], length) == 0) {
+            return type;
         }
     }
-    return -1;
+    return STAGE_TYPE_NONE;
+}
+
+uint8_t GameFlowManager::internStageId(const String& stageId) {
+    return internStageId(stageId.c_str(), stageId.length());
+}
+
+const __FlashStringHelper* GameFlowManager::getStageName(uint8_t type) {
+    if (type >= STAGE_TYPE_COUNT) {
+        return F("");
+    }
+    return (const __FlashStringHelper*)STAGE_NAMES[type];
+}
+
+int GameFlowManager::findStageIndex(const String& stageId) {
+    return findStageIndex(internStageId(stageId));
+}
+
+int GameFlowManager::findStageIndex(uint8_t type) const {
+    if (type >= STAGE_TYPE_COUNT || typeSlot[type] == STAGE_SLOT_NONE) {
+        return -1;
+    }
+    return typeSlot[type];
 }
 
-int GameFlowManager::findEmptySlot() {
+int GameFlowManager::findEmptySlot() const {
     for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-        if (!stages[i].running) {
+        if (!isSlotRunning(i)) {
             return i;
         }
     }
     return -1;
 }
 
-void GameFlowManager::updateCompatibilityVars() {
-    // 更新兼容性变量，使其指向第一个活跃环节
-    stageRunning = (activeStageCount > 0);
+bool GameFlowManager::isSlotRunning(int index) const {
+    return (runningMask >> index) & 1;
+}
+
+void GameFlowManager::releaseSlot(int index) {
+    if (!isSlotRunning(index)) {
+        return;
+    }
     
-    if (activeStageCount > 0) {
-        // 找到第一个运行中的环节
-        for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-            if (stages[i].running) {
-                currentStageId = stages[i].stageId;
-                stageStartTime = stages[i].startTime;
-                jumpRequested = stages[i].jumpRequested;
-                break;
-            }
+    uint8_t type = stages[index].type;
+    if (type < STAGE_TYPE_COUNT) {
+        typeSlot[type] = STAGE_SLOT_NONE;
+    }
+    stages[index].type = STAGE_TYPE_NONE;
+    stages[index].jumpRequested = false;
+    runningMask &= ~(1u << index);
+    activeStageCount--;
+}
+
+void GameFlowManager::resetStageTypeState(uint8_t type) {
+    switch (type) {
+        case STAGE_TYPE_000_0: memset(&state000, 0, sizeof(state000)); break;
+        case STAGE_TYPE_001_1: memset(&state001_1, 0, sizeof(state001_1)); break;
+        case STAGE_TYPE_001_2: memset(&state001_2, 0, sizeof(state001_2)); break;
+        case STAGE_TYPE_002_0: memset(&state002, 0, sizeof(state002)); break;
+        case STAGE_TYPE_006_0: memset(&state006, 0, sizeof(state006)); break;
+        default: break;
+    }
+}
+
+void GameFlowManager::updateCompatibilityVars() {
+    // 只在启停/跳转标志变化时调用，兼容性变量指向第一个活跃环节
+    stageRunning = (runningMask != 0);
+    
+    if (runningMask != 0) {
+        int first = __builtin_ctz(runningMask);
+        if (compatType != stages[first].type) {
+            compatType = stages[first].type;
+            currentStageId = getStageName(compatType);
         }
-    } else {
+        stageStartTime = stages[first].startTime;
+        jumpRequested = stages[first].jumpRequested;
+    } else if (compatType != STAGE_TYPE_NONE) {
+        compatType = STAGE_TYPE_NONE;
         currentStageId = "";
         stageStartTime = 0;
         jumpRequested = false;
@@ -301,13 +393,20 @@ void GameFlowManager::updateCompatibilityVars() {
 
 // ========================== 环节控制 ==========================
 bool GameFlowManager::startStage(const String& stageId) {
-    // 标准化环节ID
-    String normalizedId = normalizeStageId(stageId);
-    
+    uint8_t type = internStageId(stageId);
+    if (type == STAGE_TYPE_NONE) {
+        Serial.print(F("❌ 未定义的C101环节: "));
+        Serial.println(stageId);
+        return false;
+    }
+    return startStageType(type);
+}
+
+bool GameFlowManager::startStageType(uint8_t type) {
     // 检查环节是否已经在运行
-    if (findStageIndex(normalizedId) >= 0) {
+    if (findStageIndex(type) >= 0) {
         Serial.print(F("⚠️ 环节已在运行: "));
-        Serial.println(normalizedId);
+        Serial.println(getStageName(type));
         return false;
     }
     
@@ -322,26 +421,24 @@ bool GameFlowManager::startStage(const String& stageId) {
     Serial.print(F("=== 启动C101音频环节[槽位"));
     Serial.print(slot);
     Serial.print(F("]: "));
-    Serial.print(stageId);
-    if (normalizedId != stageId) {
-        Serial.print(F(" (标准化为: "));
-        Serial.print(normalizedId);
-        Serial.print(F(")"));
-    }
+    Serial.print(getStageName(type));
     Serial.println(F(" ==="));
     
     // 重置全局停止标志
     globalStopped = false;
     
     // 初始化环节状态
-    stages[slot].stageId = normalizedId;
-    stages[slot].startTime = millis();
-    stages[slot].running = true;
+    stages[slot].type = type;
+    stages[slot].startTime = millis() - harbingerClient.getDispatchLateness();  // at=定时启动时对齐到约定时刻
     stages[slot].jumpRequested = false;
-    memset(&stages[slot].state, 0, sizeof(stages[slot].state));
+    stages[slot].co.reset();
+    resetStageTypeState(type);
+    typeSlot[type] = slot;
+    runningMask |= (1u << slot);
+    activeStageCount++;
     
     // 根据环节ID执行对应逻辑
-    if (normalizedId == "000_0") {
+    if (type == STAGE_TYPE_000_0) {
         Serial.println(F("🌟 ===== C101序章初始化效果启动 ====="));
         Serial.println(F("💡 环节000_0：植物灯顺序呼吸效果（C101专用，无音频）"));
         
@@ -387,17 +484,14 @@ bool GameFlowManager::startStage(const String& stageId) {
         Serial.println(F("✅ 000_0环节引脚状态配置完成"));
         
         // 初始化环节特定状态（C101无音频，只有灯光控制）
-        stages[slot].state.stage000.channelStarted = false;  // 保留字段但不使用
-        stages[slot].state.stage000.lastCheckTime = 0;       // 保留字段但不使用
-        stages[slot].state.stage000.currentLightIndex = -1;  // 修复：初始化为-1，确保第一次切换正确
-        stages[slot].state.stage000.lightCycleStartTime = 0;
-        stages[slot].state.stage000.lightEffectStarted = false;
+        state000.currentLightIndex = -1;  // 修复：初始化为-1，确保第一次切换正确
+        state000.lightCycleStartTime = 0;
+        state000.lightEffectStarted = false;
         
         Serial.println(F("⏳ 等待植物灯效果启动..."));
-        activeStageCount++;
         updateCompatibilityVars();
         return true;
-    } else if (normalizedId == "001_1") {
+    } else if (type == STAGE_TYPE_001_1) {
         Serial.println(F("🎮 ===== 游戏开始环节启动 ====="));
         Serial.println(F("🔍 环节001_1：干簧管检测环节（C101专用，无音频）"));
         Serial.print(F("🔍 等待Pin"));
@@ -444,62 +538,52 @@ bool GameFlowManager::startStage(const String& stageId) {
         
         // 🌱 重要：确保植物灯继续000_0的呼吸效果
         // 检查000_0环节是否还在运行，如果是，则继承其植物灯状态
-        int stage000Index = findStageIndex("000_0");
-        if (stage000Index >= 0 && stages[stage000Index].running) {
+        int stage000Index = findStageIndex(STAGE_TYPE_000_0);
+        if (stage000Index >= 0) {
             Serial.println(F("🌱 检测到000_0环节仍在运行，继承植物灯状态"));
             // 继承000_0环节的当前植物灯索引
-            stages[slot].state.stage001_1.lastLightIndex = stages[stage000Index].state.stage000.currentLightIndex;
+            state001_1.lastLightIndex = state000.currentLightIndex;
             Serial.print(F("🌱 继承植物灯索引: "));
-            Serial.println(stages[slot].state.stage001_1.lastLightIndex);
+            Serial.println(state001_1.lastLightIndex);
             
             // 停止000_0环节，由001_1接管植物灯控制
             Serial.println(F("🌱 停止000_0环节，由001_1接管植物灯控制"));
-            stages[stage000Index].running = false;
-            activeStageCount--;
+            releaseSlot(stage000Index);
         } else {
             Serial.println(F("🌱 000_0环节已停止，启动植物灯呼吸效果"));
             // 如果000_0已停止，则重新启动植物灯呼吸效果
             MillisPWM::startBreathing(C101_PLANT_LIGHT_PINS[0], 3.0);  // 从灯1开始
-            stages[slot].state.stage001_1.lastLightIndex = 0;
+            state001_1.lastLightIndex = 0;
         }
         
-        // 初始化干簧管检测引脚
-        pinMode(STAGE_001_1_REED_PIN, INPUT_PULLUP);
-        Serial.print(F("🔍 初始化干簧管检测引脚"));
+        // 干簧管由InputCapture中断采样，丢弃环节开始前的旧触发
+        InputCapture::clearPress(STAGE_001_1_REED_PIN);
+        Serial.print(F("🔍 干簧管检测引脚"));
         Serial.print(STAGE_001_1_REED_PIN);
-        Serial.println(F("为INPUT_PULLUP模式"));
+        Serial.println(F("由中断捕获"));
         
         // 初始化环节特定状态（C101无音频，只有干簧管检测）
-        stages[slot].state.stage001_1.channelStarted = false;  // 保留字段但不使用
-        stages[slot].state.stage001_1.lastCheckTime = 0;       // 保留字段但不使用
-        stages[slot].state.stage001_1.lastReedCheckTime = 0;
-        stages[slot].state.stage001_1.lastReedState = digitalRead(STAGE_001_1_REED_PIN);
-        stages[slot].state.stage001_1.reedTriggered = false;
-        stages[slot].state.stage001_1.lastLightIndex = -1;     // 初始化为-1表示未设置
-        // 初始化防抖状态
-        stages[slot].state.stage001_1.lowStateStartTime = 0;   // 未开始LOW状态
-        stages[slot].state.stage001_1.debounceComplete = false; // 防抖未完成
+        state001_1.lastCheckTime = 0;
+        state001_1.reedTriggered = false;
+        state001_1.lastLightIndex = -1;     // 初始化为-1表示未设置
         
         Serial.print(F("🔍 干簧管初始状态: "));
-        Serial.println(stages[slot].state.stage001_1.lastReedState ? "HIGH" : "LOW");
+        Serial.println(InputCapture::getLevel(STAGE_001_1_REED_PIN) ? "HIGH" : "LOW");
         
         Serial.println(F("⏳ 等待干簧管触发..."));
-        activeStageCount++;
         updateCompatibilityVars();
         return true;
-    } else if (normalizedId == "001_2") {
+    } else if (type == STAGE_TYPE_001_2) {
         Serial.println(F("🌱 ===== 植物灯渐灭环节启动 ====="));
         Serial.print(F("🌱 环节001_2：植物灯渐灭效果("));
         Serial.print(STAGE_001_2_FADE_DURATION);
         Serial.println(F("ms内完成)"));
         
         // 🌱 重要：确保001_1环节完全停止，避免继续执行植物灯切换逻辑
-        int stage001_1Index = findStageIndex("001_1");
-        if (stage001_1Index >= 0 && stages[stage001_1Index].running) {
+        int stage001_1Index = findStageIndex(STAGE_TYPE_001_1);
+        if (stage001_1Index >= 0) {
             Serial.println(F("🌱 检测到001_1环节仍在运行，立即停止"));
-            stages[stage001_1Index].running = false;
-            stages[stage001_1Index].stageId = "";
-            activeStageCount--;
+            releaseSlot(stage001_1Index);
             Serial.println(F("🌱 001_1环节已停止，植物灯切换逻辑将终止"));
         }
         
@@ -544,16 +628,13 @@ bool GameFlowManager::startStage(const String& stageId) {
         Serial.println(F("✅ 001_2环节引脚状态配置完成"));
         
         // 初始化环节特定状态
-        stages[slot].state.stage001_2.fadeStarted = false;
-        stages[slot].state.stage001_2.lastFadeUpdate = 0;
-        stages[slot].state.stage001_2.currentFadeStep = 0;
-        stages[slot].state.stage001_2.fadeComplete = false;
+        state001_2.fadeStarted = false;
+        state001_2.fadeComplete = false;
         
         Serial.println(F("⏳ 准备开始植物灯渐灭效果..."));
-        activeStageCount++;
         updateCompatibilityVars();
         return true;
-    } else if (normalizedId == "002_0") {
+    } else if (type == STAGE_TYPE_002_0) {
         Serial.println(F("🎨 ===== 画灯谜题复杂效果环节启动 ====="));
         Serial.println(F("🎵 环节002_0：002号音频播放一次 + 203号音频循环播放"));
         Serial.println(F("🌟 画灯呼吸效果 + 闪烁效果并行执行"));
@@ -599,23 +680,21 @@ bool GameFlowManager::startStage(const String& stageId) {
         // ========================== 初始化画灯效果状态 ==========================
         Serial.println(F("🎨 初始化画灯效果状态..."));
         
-        // 音频相关状态（保留但不使用）
-        stages[slot].state.stage002.channel1Started = false;
-        stages[slot].state.stage002.channel2Started = false;
-        stages[slot].state.stage002.multiJumpTriggered = false;
+        // 多环节跳转状态
+        state002.multiJumpTriggered = false;
         
         // 呼吸效果状态初始化
-        stages[slot].state.stage002.breathEffectStartTime = 0;
-        stages[slot].state.stage002.currentBreathStep = -1;      // -1表示未开始
-        stages[slot].state.stage002.breathEffectActive = false;
+        state002.breathEffectStartTime = 0;
+        state002.currentBreathStep = -1;      // -1表示未开始
+        state002.breathEffectActive = false;
         
         // 闪烁效果状态初始化
-        stages[slot].state.stage002.flashEffectStartTime = 0;
-        stages[slot].state.stage002.currentFlashGroup = -1;      // -1表示未开始
-        stages[slot].state.stage002.currentFlashCycle = 0;
-        stages[slot].state.stage002.flashEffectActive = false;
-        stages[slot].state.stage002.flashState = false;
-        stages[slot].state.stage002.lastFlashToggle = 0;
+        state002.flashEffectStartTime = 0;
+        state002.currentFlashGroup = -1;      // -1表示未开始
+        state002.currentFlashCycle = 0;
+        state002.flashEffectActive = false;
+        state002.flashState = false;
+        state002.lastFlashToggle = 0;
         
         Serial.println(F("🌟 画灯呼吸效果时间表："));
         Serial.print(F("   8118ms: 画4长呼吸亮 -> 12009ms: 画4长呼吸灭"));
@@ -629,10 +708,9 @@ bool GameFlowManager::startStage(const String& stageId) {
         
         Serial.println(F("⏳ 等待画灯效果启动..."));
         Serial.println(F("⏳ 等待30秒触发多环节跳转..."));
-        activeStageCount++;
         updateCompatibilityVars();
         return true;
-    } else if (normalizedId == "006_0") {
+    } else if (type == STAGE_TYPE_006_0) {
         Serial.println(F("🎮 ===== 嘲讽按键游戏环节启动 ====="));
         Serial.println(F("🎵 环节006_0：音频提示+按键匹配游戏"));
         Serial.print(F("🎯 需要连续"));
@@ -679,55 +757,24 @@ bool GameFlowManager::startStage(const String& stageId) {
         // ========================== 初始化嘲讽按键游戏状态 ==========================
         Serial.println(F("�� 初始化嘲讽按键游戏状态..."));
         
-        // 初始化内部状态机
-        stages[slot].state.stage006.subState = (decltype(stages[slot].state.stage006.subState))0; // SUB_INIT
-        
-        // 游戏核心状态
-        stages[slot].state.stage006.totalCount = 0;           // 总计数器从0开始
-        stages[slot].state.stage006.correctCount = 0;         // 正确计数器
-        stages[slot].state.stage006.currentCorrectButton = 0; // 当前正确按键
-        stages[slot].state.stage006.pressedButton = 0;        // 按下的按键
-        stages[slot].state.stage006.buttonPressed = false;    // 按键状态
-        
-        // 语音控制状态
-        stages[slot].state.stage006.voiceTriggered = false;
-        stages[slot].state.stage006.voiceTriggerTime = 0;
-        stages[slot].state.stage006.voicePlayedOnce = false;
-        stages[slot].state.stage006.lastVoiceTime = 0;
-        
-        // 按键防抖状态
-        stages[slot].state.stage006.buttonDebouncing = false;
-        stages[slot].state.stage006.debouncingButton = -1;
-        stages[slot].state.stage006.debounceStartTime = 0;
+        // 游戏核心状态（协程从头开始执行，见updateStep006）
+        state006.totalCount = 0;           // 总计数器从0开始
+        state006.correctCount = 0;         // 正确计数器
+        state006.currentCorrectButton = 0; // 当前正确按键
+        state006.pressedButton = 0;        // 按下的按键
         
-        // 时序控制状态
-        stages[slot].state.stage006.errorStartTime = 0;
-        stages[slot].state.stage006.correctStartTime = 0;
+        // 时序状态
+        state006.roundStartTime = 0;
+        state006.lastVoiceTime = 0;
+        state006.plantBreathIndex = 0;
         
         // 初始化植物灯状态记录
         for (int i = 0; i < 4; i++) {
-            stages[slot].state.stage006.plantLightStates[i] = false;
+            state006.plantLightStates[i] = false;
         }
         
-        // 初始化植物灯时序呼吸状态
-        stages[slot].state.stage006.plantBreathActive = false;
-        stages[slot].state.stage006.plantBreathStartTime = 0;
-        stages[slot].state.stage006.plantBreathIndex = 0;
-        
-        // 初始化嘲讽按键输入引脚
-        for (int i = 0; i < C101_TAUNT_BUTTON_COUNT; i++) {
-            pinMode(C101_TAUNT_BUTTON_COM_PINS[i], INPUT_PULLUP);
-        }
-        Serial.println(F("🔘 嘲讽按键输入引脚初始化完成"));
-        
-        // 初始化按键防抖状态
-        stages[slot].state.stage006.buttonDebouncing = false;
-        stages[slot].state.stage006.debouncingButton = -1;
-        stages[slot].state.stage006.debounceStartTime = 0;
-        for (int i = 0; i < 4; i++) {
-            stages[slot].state.stage006.lastButtonStates[i] = HIGH;  // 初始状态为HIGH（未按下）
-        }
-        Serial.println(F("🔘 按键防抖状态初始化完成"));
+        // 嘲讽按键由InputCapture中断捕获并防抖
+        Serial.println(F("🔘 嘲讽按键由中断捕获"));
         
         // 初始化语音IO输出引脚
         pinMode(STAGE_006_0_VOICE_IO_1, OUTPUT);
@@ -747,13 +794,12 @@ bool GameFlowManager::startStage(const String& stageId) {
         Serial.println(F("   m%4映射：0→IO1, 1→IO3, 2→IO2, 3→IO4"));
         
         Serial.println(F("⏳ 等待游戏开始..."));
-        activeStageCount++;
         updateCompatibilityVars();
         return true;
     } else {
         Serial.print(F("❌ 未定义的C101环节: "));
-        Serial.println(normalizedId);
-        stages[slot].running = false;
+        Serial.println(getStageName(type));
+        releaseSlot(slot);
         return false;
     }
 }
@@ -764,34 +810,28 @@ bool GameFlowManager::startMultipleStages(const String& stageIds) {
     Serial.println(F(" ==="));
     
     int successCount = 0;
-    int startPos = 0;
-    
-    // 解析逗号分隔的环节ID列表
-    while (startPos < stageIds.length()) {
-        int commaPos = stageIds.indexOf(',', startPos);
-        String stageId;
-        
-        if (commaPos < 0) {
-            // 最后一个环节
-            stageId = stageIds.substring(startPos);
-        } else {
-            // 中间的环节
-            stageId = stageIds.substring(startPos, commaPos);
+    const char* ids = stageIds.c_str();
+    unsigned int length = stageIds.length();
+    unsigned int tokenStart = 0;
+    
+    // 单遍扫描逗号分隔的环节ID列表，原地驻留，不生成子串
+    for (unsigned int i = 0; i <= length; i++) {
+        if (i < length && ids[i] != ',') {
+            continue;
         }
         
-        // 去除前后空格
-        stageId.trim();
-        
-        if (stageId.length() > 0) {
-            if (startStage(stageId)) {
+        unsigned int tokenLength = i - tokenStart;
+        uint8_t type = internStageId(ids + tokenStart, tokenLength);
+        if (type != STAGE_TYPE_NONE) {
+            if (startStageType(type)) {
                 successCount++;
             }
+        } else if (tokenLength > 0) {
+            Serial.print(F("❌ 未定义的C101环节: "));
+            Serial.write((const uint8_t*)(ids + tokenStart), tokenLength);
+            Serial.println();
         }
-        
-        if (commaPos < 0) {
-            break;
-        }
-        startPos = commaPos + 1;
+        tokenStart = i + 1;
     }
     
     Serial.print(F("✅ 成功启动"));
@@ -803,39 +843,30 @@ bool GameFlowManager::startMultipleStages(const String& stageIds) {
 }
 
 void GameFlowManager::stopStage(const String& stageId) {
-    String normalizedId = normalizeStageId(stageId);
-    int index = findStageIndex(normalizedId);
+    int index = findStageIndex(stageId);
     
     if (index >= 0) {
         Serial.print(F("⏹️ 停止环节[槽位"));
         Serial.print(index);
         Serial.print(F("]: "));
-        Serial.println(normalizedId);
+        Serial.println(getStageName(stages[index].type));
         
-        stages[index].running = false;
-        stages[index].stageId = "";
-        activeStageCount--;
+        releaseSlot(index);
         updateCompatibilityVars();
     }
 }
 
 void GameFlowManager::stopCurrentStage() {
     // 兼容旧接口：停止第一个活跃环节
-    if (activeStageCount > 0) {
-        for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-            if (stages[i].running) {
-                Serial.print(F("⏹️ 结束当前环节[槽位"));
-                Serial.print(i);
-                Serial.print(F("]: "));
-                Serial.println(stages[i].stageId);
-                
-                stages[i].running = false;
-                stages[i].stageId = "";
-                activeStageCount--;
-                updateCompatibilityVars();
-                break;
-            }
-        }
+    if (runningMask != 0) {
+        int i = __builtin_ctz(runningMask);
+        Serial.print(F("⏹️ 结束当前环节[槽位"));
+        Serial.print(i);
+        Serial.print(F("]: "));
+        Serial.println(getStageName(stages[i].type));
+        
+        releaseSlot(i);
+        updateCompatibilityVars();
     }
 }
 
@@ -877,17 +908,14 @@ void GameFlowManager::stopAllStages() {
     Serial.println(F("🎵 所有音频播放已停止"));
     
     // 停止所有环节
-    for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-        if (stages[i].running) {
-            Serial.print(F("⏹️ 停止环节[槽位"));
-            Serial.print(i);
-            Serial.print(F("]: "));
-            Serial.println(stages[i].stageId);
-            
-            stages[i].running = false;
-            stages[i].stageId = "";
-            stages[i].jumpRequested = false;
-        }
+    while (runningMask != 0) {
+        int i = __builtin_ctz(runningMask);
+        Serial.print(F("⏹️ 停止环节[槽位"));
+        Serial.print(i);
+        Serial.print(F("]: "));
+        Serial.println(getStageName(stages[i].type));
+        
+        releaseSlot(i);
     }
     
     activeStageCount = 0;
@@ -912,9 +940,7 @@ bool GameFlowManager::isStageRunning() const {
 }
 
 bool GameFlowManager::isStageRunning(const String& stageId) {
-    String normalizedId = normalizeStageId(stageId);
-    int index = findStageIndex(normalizedId);
-    return (index >= 0 && stages[index].running);
+    return findStageIndex(stageId) >= 0;
 }
 
 unsigned long GameFlowManager::getStageElapsedTime() const {
@@ -925,9 +951,8 @@ unsigned long GameFlowManager::getStageElapsedTime() const {
 }
 
 unsigned long GameFlowManager::getStageElapsedTime(const String& stageId) {
-    String normalizedId = normalizeStageId(stageId);
-    int index = findStageIndex(normalizedId);
-    if (index >= 0 && stages[index].running) {
+    int index = findStageIndex(stageId);
+    if (index >= 0) {
         return millis() - stages[index].startTime;
     }
     return 0;
@@ -940,20 +965,15 @@ int GameFlowManager::getActiveStageCount() const {
 void GameFlowManager::getActiveStages(String stages[], int maxCount) {
     int count = 0;
     for (int i = 0; i < MAX_PARALLEL_STAGES && count < maxCount; i++) {
-        if (this->stages[i].running) {
-            stages[count++] = this->stages[i].stageId;
+        if (isSlotRunning(i)) {
+            stages[count++] = getStageName(this->stages[i].type);
         }
     }
 }
 
 // ========================== 环节列表 ==========================
 bool GameFlowManager::isValidStageId(const String& stageId) {
-    String normalizedId = normalizeStageId(stageId);
-    return (normalizedId == "000_0" || 
-            normalizedId == "001_1" ||
-            normalizedId == "001_2" || 
-            normalizedId == "002_0" ||
-            normalizedId == "006_0");
+    return internStageId(stageId) != STAGE_TYPE_NONE;
 }
 
 void GameFlowManager::printAvailableStages() {
@@ -986,9 +1006,12 @@ void GameFlowManager::update() {
     // 检查紧急开门功能
     checkEmergencyDoorControl();
     
-    // 更新所有活跃环节
-    for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-        if (stages[i].running) {
+    // 按运行位图更新活跃环节（协程等待中的环节直接跳过）
+    uint16_t pending = runningMask;
+    while (pending != 0) {
+        int i = __builtin_ctz(pending);
+        pending &= pending - 1;
+        if (isSlotRunning(i) && stages[i].co.isReady()) {
             updateStage(i);
         }
     }
@@ -1006,11 +1029,11 @@ void GameFlowManager::printStatus() {
     if (activeStageCount > 0) {
         Serial.println(F("--- 运行中的环节 ---"));
         for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-            if (stages[i].running) {
+            if (isSlotRunning(i)) {
                 Serial.print(F("[槽位"));
                 Serial.print(i);
                 Serial.print(F("] "));
-                Serial.print(stages[i].stageId);
+                Serial.print(getStageName(stages[i].type));
                 Serial.print(F(" - 运行时间: "));
                 Serial.print(millis() - stages[i].startTime);
                 Serial.print(F("ms"));
@@ -1032,8 +1055,8 @@ void GameFlowManager::requestStageJump(const String& nextStage) {
     // 兼容旧接口：使用第一个活跃环节
     if (activeStageCount > 0) {
         for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-            if (stages[i].running && !stages[i].jumpRequested) {
-                requestMultiStageJump(stages[i].stageId, nextStage);
+            if (isSlotRunning(i) && !stages[i].jumpRequested) {
+                requestMultiStageJump(getStageName(stages[i].type), nextStage);
                 break;
             }
         }
@@ -1060,6 +1083,7 @@ void GameFlowManager::requestMultiStageJump(const String& currentStep, const Str
     int index = findStageIndex(currentStep);
     if (index >= 0) {
         stages[index].jumpRequested = true;
+        updateCompatibilityVars();
     }
 }
 
@@ -1075,25 +1099,25 @@ void GameFlowManager::initEmergencyDoorControl() {
     Serial.println(F("秒"));
     
     // 确保引脚已正确初始化（在initC101Hardware中已完成）
-    lastCardReaderState = digitalRead(C101_DOOR_CARD_COM_PIN);
+    lastCardReaderState = InputCapture::getLevel(C101_DOOR_CARD_COM_PIN);
     Serial.println(F("✅ 紧急开门功能就绪"));
 }
 
 void GameFlowManager::updateEmergencyDoorControl() {
-    // 检测Pin24门禁读卡器状态 - 高频检测
-    bool currentCardReaderState = digitalRead(C101_DOOR_CARD_COM_PIN);
+    // Pin24门禁读卡器由InputCapture中断采样，电磁锁已在ISR中直接断电
+    bool currentCardReaderState = InputCapture::getLevel(C101_DOOR_CARD_COM_PIN);
     
-    // 方式1：边沿检测（从HIGH到LOW的下降沿触发）
-    bool edgeTriggered = (lastCardReaderState == HIGH && currentCardReaderState == LOW);
+    // 方式1：中断捕获的下降沿（loop阻塞期间的刷卡也不会丢失）
+    bool edgeTriggered = InputCapture::takePress(C101_DOOR_CARD_COM_PIN);
     
     // 方式2：直接LOW状态检测（更敏感）
     bool directTriggered = (currentCardReaderState == LOW && !emergencyUnlockActive);
     
-    // 任一方式触发都立即解锁
+    // 任一方式触发都开始10秒解锁计时
     if (edgeTriggered || directTriggered) {
         Serial.println(F("🚨 紧急开门触发！门禁读卡器检测到信号"));
         
-        // 立即解锁电磁锁
+        // 同步引脚管理器状态（ISR已直接解锁）
         pinManager.setPinState(C101_DOOR_LOCK_PIN, LOW);   // Pin26解锁（断电）
         emergencyUnlockStartTime = millis();
         emergencyUnlockActive = true;
@@ -1150,6 +1174,7 @@ void GameFlowManager::notifyStageComplete(const String& currentStep, const Strin
     // 标记该环节已请求跳转
     if (index >= 0) {
         stages[index].jumpRequested = true;
+        updateCompatibilityVars();
     }
 }
 
@@ -1171,12 +1196,13 @@ void GameFlowManager::notifyStageComplete(const String& currentStep, unsigned lo
     // 标记该环节已请求跳转
     if (index >= 0) {
         stages[index].jumpRequested = true;
+        updateCompatibilityVars();
     }
 }
 
 // C101音频环节更新方法
 void GameFlowManager::updateStep000(int index) {
-    if (index < 0 || index >= MAX_PARALLEL_STAGES || !stages[index].running) {
+    if (index < 0 || index >= MAX_PARALLEL_STAGES || !isSlotRunning(index)) {
         return;
     }
     
@@ -1191,9 +1217,9 @@ void GameFlowManager::updateStep000(int index) {
     // C101的000_0环节：只有植物灯顺序呼吸效果，无音频播放
     
     // 启动植物灯顺序呼吸效果
-    if (!stage.state.stage000.lightEffectStarted && elapsed >= STAGE_000_0_START) {
-        stage.state.stage000.lightEffectStarted = true;
-        stage.state.stage000.lightCycleStartTime = elapsed;
+    if (!state000.lightEffectStarted && elapsed >= STAGE_000_0_START) {
+        state000.lightEffectStarted = true;
+        state000.lightCycleStartTime = elapsed;
         
         // 🔧 立即启动植物灯1的呼吸效果
         MillisPWM::startBreathing(C101_PLANT_LIGHT_PINS[0], 3.0);  // 3秒呼吸周期
@@ -1201,8 +1227,8 @@ void GameFlowManager::updateStep000(int index) {
     }
     
     // 植物灯顺序呼吸效果控制
-    if (stage.state.stage000.lightEffectStarted) {
-        unsigned long cycleElapsed = elapsed - stage.state.stage000.lightCycleStartTime;
+    if (state000.lightEffectStarted) {
+        unsigned long cycleElapsed = elapsed - state000.lightCycleStartTime;
         unsigned long currentCycleTime = cycleElapsed % STAGE_000_0_LIGHT_CYCLE;
         
         // 根据时间表确定当前应该亮起的灯
@@ -1219,10 +1245,10 @@ void GameFlowManager::updateStep000(int index) {
         }
         
         // 如果需要切换灯光
-        if (stage.state.stage000.currentLightIndex != targetLightIndex) {
+        if (state000.currentLightIndex != targetLightIndex) {
             // 关闭当前灯
-            if (stage.state.stage000.currentLightIndex >= 0) {
-                MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[stage.state.stage000.currentLightIndex]);
+            if (state000.currentLightIndex >= 0) {
+                MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[state000.currentLightIndex]);
             }
             
             // 开启新灯
@@ -1231,7 +1257,7 @@ void GameFlowManager::updateStep000(int index) {
             Serial.print(targetLightIndex + 1);
             Serial.println(F("呼吸"));
             
-            stage.state.stage000.currentLightIndex = targetLightIndex;
+            state000.currentLightIndex = targetLightIndex;
         }
     }
     
@@ -1240,7 +1266,7 @@ void GameFlowManager::updateStep000(int index) {
 }
 
 void GameFlowManager::updateStep001_1(int index) {
-    if (index < 0 || index >= MAX_PARALLEL_STAGES || !stages[index].running) {
+    if (index < 0 || index >= MAX_PARALLEL_STAGES || !isSlotRunning(index)) {
         return;
     }
     
@@ -1254,11 +1280,11 @@ void GameFlowManager::updateStep001_1(int index) {
     
     // 🌱 继续执行植物灯顺序呼吸效果（继承000_0的逻辑）
     // 使用环节状态中的时间基准来保持连续性
-    if (stage.state.stage001_1.lastCheckTime == 0) {
+    if (state001_1.lastCheckTime == 0) {
         // 第一次运行时，设置基准时间
-        stage.state.stage001_1.lastCheckTime = millis() - elapsed;
+        state001_1.lastCheckTime = millis() - elapsed;
     }
-    unsigned long totalElapsed = millis() - stage.state.stage001_1.lastCheckTime;
+    unsigned long totalElapsed = millis() - state001_1.lastCheckTime;
     
     // 植物灯顺序呼吸效果控制（与000_0相同的逻辑）
     unsigned long currentCycleTime = totalElapsed % STAGE_000_0_LIGHT_CYCLE;
@@ -1277,10 +1303,10 @@ void GameFlowManager::updateStep001_1(int index) {
     }
     
     // 如果需要切换灯光
-    if (stage.state.stage001_1.lastLightIndex != targetLightIndex) {
+    if (state001_1.lastLightIndex != targetLightIndex) {
         // 关闭当前灯
-        if (stage.state.stage001_1.lastLightIndex >= 0) {
-            MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[stage.state.stage001_1.lastLightIndex]);
+        if (state001_1.lastLightIndex >= 0) {
+            MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[state001_1.lastLightIndex]);
         }
         
         // 开启新灯
@@ -1289,54 +1315,26 @@ void GameFlowManager::updateStep001_1(int index) {
         Serial.print(targetLightIndex + 1);
         Serial.println(F("呼吸"));
         
-        stage.state.stage001_1.lastLightIndex = targetLightIndex;
+        state001_1.lastLightIndex = targetLightIndex;
     }
     
-    // 干簧管检测逻辑：高频检测 + 防抖机制
-    if (!stage.state.stage001_1.reedTriggered) {
-        unsigned long now = millis();
+    // 干簧管检测逻辑：中断捕获的LOW脉冲≥防抖时间即触发（含loop阻塞期间的短脉冲）
+    if (!state001_1.reedTriggered &&
+        (InputCapture::takePress(STAGE_001_1_REED_PIN) ||
+         InputCapture::isHeldFor(STAGE_001_1_REED_PIN, LOW, STAGE_001_1_REED_DEBOUNCE_TIME))) {
+        Serial.print(F("🔍 Pin"));
+        Serial.print(STAGE_001_1_REED_PIN);
+        Serial.print(F("防抖完成(边沿于"));
+        Serial.print(millis() - InputCapture::getLastEdgeTime(STAGE_001_1_REED_PIN));
+        Serial.println(F("ms前)，跳转到001_2"));
         
-        // 高频检测（10ms间隔）
-        if (now - stage.state.stage001_1.lastReedCheckTime >= STAGE_001_1_REED_CHECK_INTERVAL) {
-            bool currentReedState = digitalRead(STAGE_001_1_REED_PIN);
-            
-            if (currentReedState == LOW) {
-                // 检测到LOW状态
-                if (stage.state.stage001_1.lowStateStartTime == 0) {
-                    // 第一次检测到LOW状态，记录开始时间
-                    stage.state.stage001_1.lowStateStartTime = now;
-                } else {
-                    // 持续LOW状态，检查是否达到防抖时间
-                    unsigned long lowDuration = now - stage.state.stage001_1.lowStateStartTime;
-                    if (lowDuration >= STAGE_001_1_REED_DEBOUNCE_TIME && !stage.state.stage001_1.debounceComplete) {
-                        // 防抖完成，触发跳转
-                        Serial.print(F("🔍 Pin"));
-                        Serial.print(STAGE_001_1_REED_PIN);
-                        Serial.print(F("防抖完成("));
-                        Serial.print(lowDuration);
-                        Serial.println(F("ms)，跳转到001_2"));
-                        
-                        stage.state.stage001_1.reedTriggered = true;
-                        stage.state.stage001_1.debounceComplete = true;
-                        notifyStageComplete("001_1", STAGE_001_1_NEXT_STAGE, elapsed);
-                    }
-                }
-            } else {
-                // 检测到HIGH状态，重置防抖状态
-                if (stage.state.stage001_1.lowStateStartTime != 0) {
-                    stage.state.stage001_1.lowStateStartTime = 0;
-                    stage.state.stage001_1.debounceComplete = false;
-                }
-            }
-            
-            // 更新检测时间
-            stage.state.stage001_1.lastReedCheckTime = now;
-        }
+        state001_1.reedTriggered = true;
+        notifyStageComplete("001_1", STAGE_001_1_NEXT_STAGE, elapsed);
     }
 }
 
 void GameFlowManager::updateStep001_2(int index) {
-    if (index < 0 || index >= MAX_PARALLEL_STAGES || !stages[index].running) {
+    if (index < 0 || index >= MAX_PARALLEL_STAGES || !isSlotRunning(index)) {
         return;
     }
     
@@ -1349,8 +1347,8 @@ void GameFlowManager::updateStep001_2(int index) {
     }
     
     // 立即开始植物灯渐灭效果（从0ms开始，不需要延迟）
-    if (!stage.state.stage001_2.fadeStarted) {
-        stage.state.stage001_2.fadeStarted = true;
+    if (!state001_2.fadeStarted) {
+        state001_2.fadeStarted = true;
         Serial.println(F("🌱 立即开始植物灯渐灭效果"));
         
         // 停止所有植物灯的呼吸效果，开始fade渐灭
@@ -1362,8 +1360,8 @@ void GameFlowManager::updateStep001_2(int index) {
     }
     
     // 检查渐灭是否完成
-    if (stage.state.stage001_2.fadeStarted && !stage.state.stage001_2.fadeComplete && elapsed >= STAGE_001_2_FADE_DURATION) {
-        stage.state.stage001_2.fadeComplete = true;
+    if (state001_2.fadeStarted && !state001_2.fadeComplete && elapsed >= STAGE_001_2_FADE_DURATION) {
+        state001_2.fadeComplete = true;
         
         // 确保所有植物灯都完全关闭
         for (int i = 0; i < C101_PLANT_LIGHT_COUNT; i++) {
@@ -1376,7 +1374,7 @@ void GameFlowManager::updateStep001_2(int index) {
 }
 
 void GameFlowManager::updateStep002(int index) {
-    if (index < 0 || index >= MAX_PARALLEL_STAGES || !stages[index].running) {
+    if (index < 0 || index >= MAX_PARALLEL_STAGES || !isSlotRunning(index)) {
         return;
     }
     
@@ -1392,8 +1390,8 @@ void GameFlowManager::updateStep002(int index) {
     // 🔧 自然呼吸效果：每个画灯在指定时间段内完成一次完整的呼吸周期
     if (elapsed >= STAGE_002_0_BREATH_START_1 && elapsed < STAGE_002_0_BREATH_END_2) {
         // 画4长呼吸时间段：8118ms-13509ms (总时长5391ms)
-        if (stage.state.stage002.currentBreathStep != 0) {
-            stage.state.stage002.currentBreathStep = 0;
+        if (state002.currentBreathStep != 0) {
+            state002.currentBreathStep = 0;
             // 计算呼吸周期：整个时间段就是一个完整的呼吸周期
             float breathCycleDuration = (STAGE_002_0_BREATH_END_2 - STAGE_002_0_BREATH_START_1) / 1000.0; // 转换为秒
             MillisPWM::startBreathing(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_4_INDEX], breathCycleDuration);
@@ -1401,9 +1399,9 @@ void GameFlowManager::updateStep002(int index) {
             Serial.print(breathCycleDuration);
             Serial.println(F("秒）"));
         }
-    } else if (elapsed >= STAGE_002_0_BREATH_END_2 && stage.state.stage002.currentBreathStep == 0) {
+    } else if (elapsed >= STAGE_002_0_BREATH_END_2 && state002.currentBreathStep == 0) {
         // 画4长呼吸结束
-        stage.state.stage002.currentBreathStep = 1;
+        state002.currentBreathStep = 1;
         MillisPWM::stopBreathing(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_4_INDEX]);
         MillisPWM::setBrightness(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_4_INDEX], 0);
         Serial.println(F("🎨 画4长射灯呼吸结束"));
@@ -1411,8 +1409,8 @@ void GameFlowManager::updateStep002(int index) {
     
     if (elapsed >= STAGE_002_0_BREATH_START_3 && elapsed < STAGE_002_0_BREATH_END_4) {
         // 画8长呼吸时间段：17205ms-19822ms (总时长2617ms)
-        if (stage.state.stage002.currentBreathStep != 2) {
-            stage.state.stage002.currentBreathStep = 2;
+        if (state002.currentBreathStep != 2) {
+            state002.currentBreathStep = 2;
             // 计算呼吸周期：整个时间段就是一个完整的呼吸周期
             float breathCycleDuration = (STAGE_002_0_BREATH_END_4 - STAGE_002_0_BREATH_START_3) / 1000.0; // 转换为秒
             MillisPWM::startBreathing(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_8_INDEX], breathCycleDuration);
@@ -1420,9 +1418,9 @@ void GameFlowManager::updateStep002(int index) {
             Serial.print(breathCycleDuration);
             Serial.println(F("秒）"));
         }
-    } else if (elapsed >= STAGE_002_0_BREATH_END_4 && stage.state.stage002.currentBreathStep == 2) {
+    } else if (elapsed >= STAGE_002_0_BREATH_END_4 && state002.currentBreathStep == 2) {
         // 画8长呼吸结束
-        stage.state.stage002.currentBreathStep = 3;
+        state002.currentBreathStep = 3;
         MillisPWM::stopBreathing(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_8_INDEX]);
         MillisPWM::setBrightness(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_8_INDEX], 0);
         Serial.println(F("🎨 画8长射灯呼吸结束"));
@@ -1430,8 +1428,8 @@ void GameFlowManager::updateStep002(int index) {
     
     if (elapsed >= STAGE_002_0_BREATH_START_5 && elapsed < STAGE_002_0_BREATH_END_6) {
         // 画2长呼吸时间段：24741ms-28995ms (总时长4254ms)
-        if (stage.state.stage002.currentBreathStep != 4) {
-            stage.state.stage002.currentBreathStep = 4;
+        if (state002.currentBreathStep != 4) {
+            state002.currentBreathStep = 4;
             // 计算呼吸周期：整个时间段就是一个完整的呼吸周期
             float breathCycleDuration = (STAGE_002_0_BREATH_END_6 - STAGE_002_0_BREATH_START_5) / 1000.0; // 转换为秒
             MillisPWM::startBreathing(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_2_INDEX], breathCycleDuration);
@@ -1439,9 +1437,9 @@ void GameFlowManager::updateStep002(int index) {
             Serial.print(breathCycleDuration);
             Serial.println(F("秒）"));
         }
-    } else if (elapsed >= STAGE_002_0_BREATH_END_6 && stage.state.stage002.currentBreathStep == 4) {
+    } else if (elapsed >= STAGE_002_0_BREATH_END_6 && state002.currentBreathStep == 4) {
         // 画2长呼吸结束
-        stage.state.stage002.currentBreathStep = 5;
+        state002.currentBreathStep = 5;
         MillisPWM::stopBreathing(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_2_INDEX]);
         MillisPWM::setBrightness(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_2_INDEX], 0);
         Serial.println(F("🎨 画2长射灯呼吸结束"));
@@ -1471,18 +1469,18 @@ void GameFlowManager::updateStep002(int index) {
         }
         
         // 🔧 关键修复：如果当前闪烁组正在执行且未完成，保持该组状态
-        if (stage.state.stage002.currentFlashGroup >= 0 && 
-            stage.state.stage002.currentFlashCycle < STAGE_002_0_FLASH_CYCLES) {
+        if (state002.currentFlashGroup >= 0 && 
+            state002.currentFlashCycle < STAGE_002_0_FLASH_CYCLES) {
             // 正在闪烁中，不管时间窗口，保持当前闪烁组
-            currentFlashGroup = stage.state.stage002.currentFlashGroup;
+            currentFlashGroup = state002.currentFlashGroup;
         }
         
         // 如果闪烁组发生变化，重置闪烁状态
-        if (currentFlashGroup != stage.state.stage002.currentFlashGroup) {
-            stage.state.stage002.currentFlashGroup = currentFlashGroup;
-            stage.state.stage002.currentFlashCycle = 0;
-            stage.state.stage002.flashState = false;
-            stage.state.stage002.lastFlashToggle = millis();
+        if (currentFlashGroup != state002.currentFlashGroup) {
+            state002.currentFlashGroup = currentFlashGroup;
+            state002.currentFlashCycle = 0;
+            state002.flashState = false;
+            state002.lastFlashToggle = millis();
             
             // 🔧 修复：停止PWM，确保digitalWrite能正常工作
             if (currentFlashGroup == 0 || currentFlashGroup == 2) {
@@ -1507,28 +1505,28 @@ void GameFlowManager::updateStep002(int index) {
         }
         
         // 执行闪烁逻辑
-        if (currentFlashGroup >= 0 && stage.state.stage002.currentFlashCycle < STAGE_002_0_FLASH_CYCLES) {
+        if (currentFlashGroup >= 0 && state002.currentFlashCycle < STAGE_002_0_FLASH_CYCLES) {
             unsigned long now = millis();
-            unsigned long flashInterval = stage.state.stage002.flashState ? STAGE_002_0_FLASH_ON_TIME : STAGE_002_0_FLASH_OFF_TIME;
+            unsigned long flashInterval = state002.flashState ? STAGE_002_0_FLASH_ON_TIME : STAGE_002_0_FLASH_OFF_TIME;
             
-            if (now - stage.state.stage002.lastFlashToggle >= flashInterval) {
-                stage.state.stage002.flashState = !stage.state.stage002.flashState;
-                stage.state.stage002.lastFlashToggle = now;
+            if (now - state002.lastFlashToggle >= flashInterval) {
+                state002.flashState = !state002.flashState;
+                state002.lastFlashToggle = now;
                 
                 // 根据闪烁组和状态控制灯光
                 if (currentFlashGroup == 0 || currentFlashGroup == 2) {
                     // 画4长+画8长闪烁
-                    pinManager.setPinState(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_4_INDEX], stage.state.stage002.flashState ? HIGH : LOW);
-                    pinManager.setPinState(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_8_INDEX], stage.state.stage002.flashState ? HIGH : LOW);
+                    pinManager.setPinState(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_4_INDEX], state002.flashState ? HIGH : LOW);
+                    pinManager.setPinState(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_8_INDEX], state002.flashState ? HIGH : LOW);
                 } else if (currentFlashGroup == 1 || currentFlashGroup == 3) {
                     // 画2长+画6长闪烁
-                    pinManager.setPinState(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_2_INDEX], stage.state.stage002.flashState ? HIGH : LOW);
-                    pinManager.setPinState(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_6_INDEX], stage.state.stage002.flashState ? HIGH : LOW);
+                    pinManager.setPinState(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_2_INDEX], state002.flashState ? HIGH : LOW);
+                    pinManager.setPinState(C101_PAINTING_LIGHT_PINS[STAGE_002_0_PAINTING_LIGHT_6_INDEX], state002.flashState ? HIGH : LOW);
                 }
                 
                 // 如果完成了一个亮灭周期，增加循环计数
-                if (!stage.state.stage002.flashState) {
-                    stage.state.stage002.currentFlashCycle++;
+                if (!state002.flashState) {
+                    state002.currentFlashCycle++;
                 }
             }
         }
@@ -1536,8 +1534,8 @@ void GameFlowManager::updateStep002(int index) {
     
     // ========================== 多环节跳转控制 ==========================
     // 30秒时触发多环节跳转
-    if (!stage.state.stage002.multiJumpTriggered && elapsed >= STAGE_002_0_MULTI_JUMP_TIME) {
-        stage.state.stage002.multiJumpTriggered = true;
+    if (!state002.multiJumpTriggered && elapsed >= STAGE_002_0_MULTI_JUMP_TIME) {
+        state002.multiJumpTriggered = true;
         Serial.print(F("🚀 [C101-槽位"));
         Serial.print(index);
         Serial.print(F("] 30秒时触发多环节跳转: "));
@@ -1563,6 +1561,7 @@ void GameFlowManager::updateStep002(int index) {
                 Serial.print(STAGE_002_0_NEXT_STAGE);
                 Serial.println(F("已在运行"));
                 stage.jumpRequested = true;  // 标记为已处理，避免重复检查
+                updateCompatibilityVars();
             }
         } else {
             Serial.print(F("⏰ [C101-槽位"));
@@ -1573,24 +1572,6 @@ void GameFlowManager::updateStep002(int index) {
     }
 }
 
-// 工具方法
-String GameFlowManager::normalizeStageId(const String& stageId) {
-    String normalized = stageId;
-    
-    // 移除引号
-    normalized.replace("\"", "");
-    
-    // C101音频格式保持下划线格式：000_0, 001_2, 002_0
-    // 不需要转换，直接返回
-    
-    Serial.print(F("🔧 环节ID标准化: "));
-    Serial.print(stageId);
-    Serial.print(F(" -> "));
-    Serial.println(normalized);
-    
-    return normalized;
-}
-
 // ========================== 音量管理方法 ==========================
 void GameFlowManager::initializeAllVolumes() {
     Serial.println(F("🔊 初始化所有通道音量..."));
@@ -1630,7 +1611,7 @@ void GameFlowManager::resetAllVolumes() {
 
 // ========================== 006_0环节：嘲讽按键游戏 ==========================
 void GameFlowManager::updateStep006(int index) {
-    if (index < 0 || index >= MAX_PARALLEL_STAGES || !stages[index].running) {
+    if (index < 0 || index >= MAX_PARALLEL_STAGES || !isSlotRunning(index)) {
         return;
     }
     
@@ -1642,377 +1623,244 @@ void GameFlowManager::updateStep006(int index) {
         return;
     }
     
-    // ========================== 基于步骤的if-else流程 ==========================
+    // 4个嘲讽按键对应的InputCapture通道位图
+    uint8_t buttonMask = 0;
+    for (int i = 0; i < 4; i++) {
+        buttonMask |= InputCapture::getChannelMask(C101_TAUNT_BUTTON_COM_PINS[i]);
+    }
     
-    if (stage.state.stage006.subState == 0) {
-        // ========================== STEP_1_INIT: 初始化 ==========================
-        
-        Serial.println(F("🎮 开始006环节初始化"));
-        
-        // 启动4个按键的呼吸效果（3秒周期）
-        for (int i = 0; i < 4; i++) {
-            MillisPWM::startBreathing(C101_TAUNT_BUTTON_LIGHT_PINS[i], 3.0);
-        }
-        
-        // 初始化游戏状态
-        stage.state.stage006.totalCount = 1;  // 第一轮 m=1
-        stage.state.stage006.correctCount = 0;
-        stage.state.stage006.buttonPressed = false;
-        stage.state.stage006.buttonDebouncing = false;
-        
-        // 初始化按键状态记录
-        for (int i = 0; i < 4; i++) {
-            stage.state.stage006.lastButtonStates[i] = digitalRead(C101_TAUNT_BUTTON_COM_PINS[i]);
-        }
-        
-        // 初始化植物灯状态记录
-        for (int i = 0; i < 4; i++) {
-            stage.state.stage006.plantLightStates[i] = false;
+    // ========================== 协程流程（顺序书写，在CO_AWAIT处让出） ==========================
+    CO_BEGIN(stage.co);
+    
+    // ========================== STEP_1_INIT: 初始化 ==========================
+    Serial.println(F("🎮 开始006环节初始化"));
+    
+    // 启动4个按键的呼吸效果（3秒周期）
+    for (int i = 0; i < 4; i++) {
+        MillisPWM::startBreathing(C101_TAUNT_BUTTON_LIGHT_PINS[i], 3.0);
+    }
+    
+    // 初始化游戏状态
+    state006.totalCount = 1;  // 第一轮 m=1
+    state006.correctCount = 0;
+    for (int i = 0; i < 4; i++) {
+        state006.plantLightStates[i] = false;
+    }
+    
+    while (true) {
+        // ========================== 每轮开始：播放语音提示 ==========================
+        {
+            // 丢弃本轮之前（含上一轮处理期间）的按压
+            for (int i = 0; i < 4; i++) {
+                InputCapture::clearPress(C101_TAUNT_BUTTON_COM_PINS[i]);
+            }
+            
+            // 计算本轮的正确按键和语音IO
+            int voiceIndex = (state006.totalCount - 1) % 4;
+            state006.currentCorrectButton = (voiceIndex == 0) ? 1 : 
+                                                       (voiceIndex == 1) ? 3 : 
+                                                       (voiceIndex == 2) ? 2 : 4;
+            
+            Serial.print(F("🎵 播放语音IO"));
+            Serial.print(voiceIndex + 1);
+            Serial.print(F("，正确按键="));
+            Serial.println(state006.currentCorrectButton);
+            
+            // 语音IO触发 - 使用临时状态自动恢复
+            pinManager.setPinTemporaryState(getStage006VoicePin(), LOW, STAGE_006_0_VOICE_TRIGGER_LOW_TIME, HIGH);
+            state006.lastVoiceTime = millis();
+            state006.pressedButton = 0;
         }
         
-        // 计算第一轮的正确按键和语音IO
-        int voiceIndex = (stage.state.stage006.totalCount - 1) % 4;  // m=1时，voiceIndex=0
-        stage.state.stage006.currentCorrectButton = (voiceIndex == 0) ? 1 : 
-                                                   (voiceIndex == 1) ? 3 : 
-                                                   (voiceIndex == 2) ? 2 : 4;
-        
-        // 触发对应的语音IO
-        int voicePin = (voiceIndex == 0) ? STAGE_006_0_VOICE_IO_1 :
-                       (voiceIndex == 1) ? STAGE_006_0_VOICE_IO_3 :
-                       (voiceIndex == 2) ? STAGE_006_0_VOICE_IO_2 : 
-                                           STAGE_006_0_VOICE_IO_4;
-        
-        Serial.print(F("🎵 播放语音IO"));
-        Serial.print(voiceIndex + 1);
-        Serial.print(F("，正确按键="));
-        Serial.println(stage.state.stage006.currentCorrectButton);
-        
-        // 正常的语音IO触发逻辑 - 使用临时状态自动恢复
-        pinManager.setPinTemporaryState(voicePin, LOW, STAGE_006_0_VOICE_TRIGGER_LOW_TIME, HIGH);
-        stage.state.stage006.voiceTriggered = true;
-        stage.state.stage006.voiceTriggerTime = millis();
-        stage.state.stage006.voicePlayedOnce = false;
-        stage.state.stage006.lastVoiceTime = millis();
-        
-        // 立即转入等待输入状态
-        stage.state.stage006.subState = 1; // SUB_WAITING_INPUT
-        return;
-    } else if (stage.state.stage006.subState == 1) {
         // ========================== STEP_2_WAIT_INPUT: 等待玩家输入 ==========================
-        
-        // 语音IO恢复逻辑现在由pinManager自动处理，无需手动控制
-        // 检查语音IO是否已经自动恢复
-        if (stage.state.stage006.voiceTriggered && 
-            millis() - stage.state.stage006.voiceTriggerTime >= STAGE_006_0_VOICE_TRIGGER_LOW_TIME) {
-            stage.state.stage006.voiceTriggered = false;
-            stage.state.stage006.voicePlayedOnce = true;
-        }
-        
-        // 循环播放控制（仅在循环模式下）
-        if (STAGE_006_0_VOICE_PLAY_MODE == 1 && // 循环模式
-            stage.state.stage006.voicePlayedOnce && // 已播放过一次
-            !stage.state.stage006.voiceTriggered && // 当前没有正在播放
-            millis() - stage.state.stage006.lastVoiceTime >= STAGE_006_0_VOICE_LOOP_INTERVAL) {
+        // 单次模式无超时；循环模式超时即重播语音
+        while (state006.pressedButton == 0) {
+            CO_AWAIT_INPUT(stage.co, buttonMask,
+                           STAGE_006_0_VOICE_PLAY_MODE == 1 ? max(STAGE_006_0_VOICE_LOOP_INTERVAL, STAGE_006_0_VOICE_TRIGGER_LOW_TIME) : 0);
             
-            // 重新触发语音播放
-            int voiceIndex = (stage.state.stage006.totalCount - 1) % 4;
-            int voicePin = (voiceIndex == 0) ? STAGE_006_0_VOICE_IO_1 :
-                           (voiceIndex == 1) ? STAGE_006_0_VOICE_IO_3 :
-                           (voiceIndex == 2) ? STAGE_006_0_VOICE_IO_2 : 
-                                               STAGE_006_0_VOICE_IO_4;
+            for (int i = 0; i < 4; i++) {
+                if (InputCapture::takePress(C101_TAUNT_BUTTON_COM_PINS[i])) {
+                    state006.pressedButton = i + 1;
+                    break;
+                }
+            }
             
-            pinManager.setPinTemporaryState(voicePin, LOW, STAGE_006_0_VOICE_TRIGGER_LOW_TIME, HIGH);
-            stage.state.stage006.voiceTriggered = true;
-            stage.state.stage006.voiceTriggerTime = millis();
-            stage.state.stage006.lastVoiceTime = millis();
-            stage.state.stage006.voicePlayedOnce = false;
+            if (state006.pressedButton == 0) {
+                // 循环播放：重新触发语音
+                pinManager.setPinTemporaryState(getStage006VoicePin(), LOW, STAGE_006_0_VOICE_TRIGGER_LOW_TIME, HIGH);
+                state006.lastVoiceTime = millis();
+            }
         }
         
-        // 按键检测
-        if (!stage.state.stage006.buttonPressed) {
-            if (!stage.state.stage006.buttonDebouncing) {
-                // 不在防抖中，检测按键状态变化
-                for (int i = 0; i < 4; i++) {
-                    int currentState = digitalRead(C101_TAUNT_BUTTON_COM_PINS[i]);
-                    
-                    // 检测到按键从HIGH变为LOW（按下）
-                    if (stage.state.stage006.lastButtonStates[i] == HIGH && currentState == LOW) {
-                        // 启动防抖
-                        stage.state.stage006.buttonDebouncing = true;
-                        stage.state.stage006.debouncingButton = i;
-                        stage.state.stage006.debounceStartTime = millis();
-                        break;
-                    }
-                    
-                    // 更新状态记录
-                    stage.state.stage006.lastButtonStates[i] = currentState;
+        {
+            int buttonIndex = state006.pressedButton - 1;
+            Serial.print(F("✅ 按键"));
+            Serial.print(buttonIndex + 1);
+            Serial.println(F("按下"));
+            
+            // 设置按键灯状态：只有按下的按键亮，其他熄灭
+            for (int i = 0; i < 4; i++) {
+                MillisPWM::stopBreathing(C101_TAUNT_BUTTON_LIGHT_PINS[i]);
+                if (i == buttonIndex) {
+                    // 按下的按键设为HIGH亮
+                    pinManager.setPinState(C101_TAUNT_BUTTON_LIGHT_PINS[i], HIGH);
+                } else {
+                    // 其他按键先停止PWM，再设为LOW
+                    MillisPWM::stop(C101_TAUNT_BUTTON_LIGHT_PINS[i]);
+                    pinManager.setPinState(C101_TAUNT_BUTTON_LIGHT_PINS[i], LOW);
                 }
+            }
+            
+            bool correct = (state006.pressedButton == state006.currentCorrectButton);
+            if (correct) {
+                Serial.println(F("✅ 按键正确！"));
+                state006.correctCount++;
+                
+                // 正确按键 - 点亮对应的植物灯（按键1对应植物灯1）
+                MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[buttonIndex]);
+                pinManager.setPinState(C101_PLANT_LIGHT_PINS[buttonIndex], HIGH);
+                state006.plantLightStates[buttonIndex] = true;
+                
+                Serial.print(F("🌱 植物灯"));
+                Serial.print(buttonIndex + 1);
+                Serial.println(F("点亮"));
             } else {
-                // 正在防抖中，检查防抖是否完成
-                int buttonIndex = stage.state.stage006.debouncingButton;
-                int currentState = digitalRead(C101_TAUNT_BUTTON_COM_PINS[buttonIndex]);
-                unsigned long debounceElapsed = millis() - stage.state.stage006.debounceStartTime;
+                Serial.println(F("❌ 按键错误！"));
                 
-                if (currentState == LOW && debounceElapsed >= STAGE_006_0_BUTTON_DEBOUNCE_TIME) {
-                    // 防抖完成，确认按键按下
-                    Serial.print(F("✅ 按键"));
-                    Serial.print(buttonIndex + 1);
-                    Serial.println(F("按下"));
-                    
-                    stage.state.stage006.buttonPressed = true;
-                    stage.state.stage006.pressedButton = buttonIndex + 1;
-                    stage.state.stage006.buttonDebouncing = false;
-                    
-                    // 设置按键灯状态：只有按下的按键亮，其他熄灭
-                    for (int i = 0; i < 4; i++) {
-                        MillisPWM::stopBreathing(C101_TAUNT_BUTTON_LIGHT_PINS[i]);
-                        if (i == buttonIndex) {
-                            // 按下的按键设为HIGH亮
-                            pinManager.setPinState(C101_TAUNT_BUTTON_LIGHT_PINS[i], HIGH);
-                        } else {
-                            // 其他按键先停止PWM，再设为LOW
-                            MillisPWM::stop(C101_TAUNT_BUTTON_LIGHT_PINS[i]);
-                            pinManager.setPinState(C101_TAUNT_BUTTON_LIGHT_PINS[i], LOW);
-                        }
-                    }
-                    
-                    // 判断按键是否正确
-                    if (stage.state.stage006.pressedButton == stage.state.stage006.currentCorrectButton) {
-                        Serial.println(F("✅ 按键正确！"));
-                        stage.state.stage006.correctCount++;
-                        
-                        // 正确按键 - 点亮对应的植物灯（按键1对应植物灯1）
-                        int plantIndex = stage.state.stage006.pressedButton - 1; // 按键1对应植物灯0
-                        if (plantIndex >= 0 && plantIndex < 4) {
-                            // 先停止PWM，再设置数字状态
-                            MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[plantIndex]);
-                            pinManager.setPinState(C101_PLANT_LIGHT_PINS[plantIndex], HIGH);
-                            stage.state.stage006.plantLightStates[plantIndex] = true;
-                            
-                            Serial.print(F("🌱 植物灯"));
-                            Serial.print(plantIndex + 1);
-                            Serial.println(F("点亮"));
-                        }
-                        
-                        // 启动植物灯时序呼吸效果（375ms间隔）
-                        stage.state.stage006.plantBreathStartTime = millis();
-                        stage.state.stage006.plantBreathIndex = 0;
-                        stage.state.stage006.plantBreathActive = true;
-                        
-                        Serial.println(F("🌱 开始植物灯时序呼吸效果"));
-                    } else {
-                        Serial.println(F("❌ 按键错误！"));
-                        
-                        // 错误按键 - 停止所有植物灯呼吸并熄灭
-                        for (int i = 0; i < 4; i++) {
-                            MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[i]);
-                            MillisPWM::stop(C101_PLANT_LIGHT_PINS[i]);
-                            pinManager.setPinState(C101_PLANT_LIGHT_PINS[i], LOW);
-                            stage.state.stage006.plantLightStates[i] = false;
-                        }
-                        
-                        stage.state.stage006.correctCount = 0;  // 重置正确计数
-                        stage.state.stage006.plantBreathActive = false; // 停止植物灯呼吸时序
-                    }
-                    
-                    // 发送游戏状态通知
-                    stage.state.stage006.totalCount++; // m+1
-                    int jumpIndex = (stage.state.stage006.totalCount - 1) % 4;
-                    String jumpResult = (jumpIndex == 0) ? STAGE_006_0_JUMP_MOD_0 :
-                                       (jumpIndex == 1) ? STAGE_006_0_JUMP_MOD_1 :
-                                       (jumpIndex == 2) ? STAGE_006_0_JUMP_MOD_2 : 
-                                                          STAGE_006_0_JUMP_MOD_3;
-                    
-                    if (stage.state.stage006.pressedButton == stage.state.stage006.currentCorrectButton) {
-                        // 正确按键的消息发送
-                        String message = "$[GAME]@C101{^STEP_STATUS^(current_step=\"006_0\",";
-                        message += "button_feedback=" + jumpResult + ")}#";
-                        
-                        Serial.print(F("📤 发送正确命令: "));
-                        Serial.println(message);
-                        harbingerClient.sendMessage(message);
-                        
-                        stage.state.stage006.subState = 2; // SUB_CORRECT
-                        stage.state.stage006.correctStartTime = millis();
-                    } else {
-                        // 错误按键的消息发送
-                        int errorGroup = ((stage.state.stage006.totalCount - 2) / 2) % 3;
-                        String errorJump = (errorGroup == 0) ? STAGE_006_0_ERROR_JUMP_1 :
-                                          (errorGroup == 1) ? STAGE_006_0_ERROR_JUMP_2 : 
-                                                              STAGE_006_0_ERROR_JUMP_3;
-                        
-                        String message = "$[GAME]@C101{^STEP_STATUS^(current_step=\"006_0\",";
-                        message += "button_feedback=" + jumpResult + ",";
-                        message += "error_music=" + errorJump + ")}#";
-                        
-                        Serial.print(F("📤 发送错误命令: "));
-                        Serial.println(message);
-                        harbingerClient.sendMessage(message);
-                        
-                        stage.state.stage006.subState = 3; // SUB_ERROR
-                        stage.state.stage006.errorStartTime = millis();
-                    }
-                } else if (currentState == HIGH) {
-                    // 按键在防抖期间被释放，取消防抖
-                    stage.state.stage006.buttonDebouncing = false;
-                    stage.state.stage006.lastButtonStates[buttonIndex] = HIGH;
+                // 错误按键 - 停止所有植物灯呼吸并熄灭
+                for (int i = 0; i < 4; i++) {
+                    MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[i]);
+                    MillisPWM::stop(C101_PLANT_LIGHT_PINS[i]);
+                    pinManager.setPinState(C101_PLANT_LIGHT_PINS[i], LOW);
+                    state006.plantLightStates[i] = false;
                 }
+                
+                state006.correctCount = 0;  // 重置正确计数
             }
-        }
-        
-    } else if (stage.state.stage006.subState == 2) {
-        // ========================== STEP_3_PROCESS_CORRECT: 处理正确按键 ==========================
-        
-        unsigned long correctElapsed = millis() - stage.state.stage006.correctStartTime;
-        
-        // 检查是否达到成功条件
-        if (stage.state.stage006.correctCount >= STAGE_006_0_REQUIRED_CORRECT) {
-            Serial.println(F("🎉 游戏成功！达到所需正确数"));
-            notifyStageComplete("006_0", STAGE_006_0_SUCCESS_JUMP, elapsed);
-            stage.state.stage006.subState = 5; // SUB_SUCCESS
-        } else if (correctElapsed >= STAGE_006_0_CORRECT_PROCESS_TIME) {  // 使用配置项替代硬编码的1000
-            Serial.println(F("🔄 正确处理完成，转入下一轮准备"));
-            stage.state.stage006.subState = 4; // SUB_NEXT_ROUND
-            stage.state.stage006.errorStartTime = millis();  // 🔧 修复：使用统一的时间变量名
-            stage.state.stage006.isCorrectWait = true;  // 标记为正确处理后的等待
-        }
-        
-    } else if (stage.state.stage006.subState == 3) {
-        // ========================== STEP_4_PROCESS_ERROR: 处理错误按键 ==========================
-        
-        unsigned long errorElapsed = millis() - stage.state.stage006.errorStartTime;
-        
-        // 被按下的错误按键也要熄灭（在1125ms时）
-        if (errorElapsed >= 1125 && stage.state.stage006.pressedButton > 0) {
-            int buttonIndex = stage.state.stage006.pressedButton - 1;
-            Serial.print(F("💡 熄灭错误按键"));
-            Serial.print(buttonIndex + 1);
-            Serial.println(F("灯光"));
-            MillisPWM::stopBreathing(C101_TAUNT_BUTTON_LIGHT_PINS[buttonIndex]);
-            MillisPWM::stop(C101_TAUNT_BUTTON_LIGHT_PINS[buttonIndex]);
-            pinManager.setPinState(C101_TAUNT_BUTTON_LIGHT_PINS[buttonIndex], LOW);
-            stage.state.stage006.pressedButton = 0;  // 标记已处理
-        }
-        
-        // 进入等待状态（增加延迟确保用户看到按键灯熄灭）
-        if (errorElapsed >= STAGE_006_0_ERROR_PROCESS_TIME) {  // 使用配置项替代硬编码的2000ms
-            Serial.println(F("🔄 错误处理完成，转入下一轮准备"));
-            stage.state.stage006.subState = 4; // SUB_NEXT_ROUND
-            stage.state.stage006.errorStartTime = millis();
-            stage.state.stage006.isCorrectWait = false;  // 标记为错误处理后的等待
-        }
-        
-    } else if (stage.state.stage006.subState == 4) {
-        // ========================== STEP_5_NEXT_ROUND: 准备下一轮 ==========================
-        
-        unsigned long waitElapsed = millis() - stage.state.stage006.errorStartTime;
-        
-        // 根据是正确还是错误处理后的等待，使用不同的等待时间
-        unsigned long waitTime = stage.state.stage006.isCorrectWait ? 
-                                 STAGE_006_0_CORRECT_WAIT_TIME : 
-                                 STAGE_006_0_ERROR_WAIT_TIME;
-        
-        if (waitElapsed >= waitTime) {
-            // 重置按键状态
-            stage.state.stage006.buttonPressed = false;
-            stage.state.stage006.pressedButton = 0;
-            stage.state.stage006.buttonDebouncing = false;
             
-            // 重置语音状态 - 确保音频IO恢复HIGH状态
-            stage.state.stage006.voiceTriggered = false;
-            stage.state.stage006.voiceTriggerTime = 0;
-            stage.state.stage006.voicePlayedOnce = false;
-            stage.state.stage006.lastVoiceTime = 0;
+            // 发送游戏状态通知
+            state006.totalCount++; // m+1
+            int jumpIndex = (state006.totalCount - 1) % 4;
+            String jumpResult = (jumpIndex == 0) ? STAGE_006_0_JUMP_MOD_0 :
+                               (jumpIndex == 1) ? STAGE_006_0_JUMP_MOD_1 :
+                               (jumpIndex == 2) ? STAGE_006_0_JUMP_MOD_2 : 
+                                                  STAGE_006_0_JUMP_MOD_3;
             
-            // 强制重置所有语音IO为HIGH状态
-            pinManager.setPinState(STAGE_006_0_VOICE_IO_1, HIGH);
-            pinManager.setPinState(STAGE_006_0_VOICE_IO_2, HIGH);
-            pinManager.setPinState(STAGE_006_0_VOICE_IO_3, HIGH);
-            pinManager.setPinState(STAGE_006_0_VOICE_IO_4, HIGH);
-            Serial.println(F("🔄 所有语音IO重置为HIGH状态"));
+            String message = "$[GAME]@C101{^STEP_STATUS^(current_step=\"006_0\",";
+            if (correct) {
+                // 正确按键的消息发送
+                message += "button_feedback=" + jumpResult + ")}#";
+                Serial.print(F("📤 发送正确命令: "));
+            } else {
+                // 错误按键的消息发送
+                int errorGroup = ((state006.totalCount - 2) / 2) % 3;
+                String errorJump = (errorGroup == 0) ? STAGE_006_0_ERROR_JUMP_1 :
+                                  (errorGroup == 1) ? STAGE_006_0_ERROR_JUMP_2 : 
+                                                      STAGE_006_0_ERROR_JUMP_3;
+                message += "button_feedback=" + jumpResult + ",";
+                message += "error_music=" + errorJump + ")}#";
+                Serial.print(F("📤 发送错误命令: "));
+            }
+            Serial.println(message);
+            harbingerClient.sendMessage(message);
             
-            // 重新启动所有按键呼吸效果
-            for (int i = 0; i < 4; i++) {
-                MillisPWM::stopBreathing(C101_TAUNT_BUTTON_LIGHT_PINS[i]);
-                MillisPWM::stop(C101_TAUNT_BUTTON_LIGHT_PINS[i]);
-                pinManager.setPinState(C101_TAUNT_BUTTON_LIGHT_PINS[i], LOW);
-                MillisPWM::startBreathing(C101_TAUNT_BUTTON_LIGHT_PINS[i], 3.0);
+            state006.roundStartTime = millis();
+        }
+        
+        if (state006.pressedButton == state006.currentCorrectButton) {
+            // ========================== STEP_3_PROCESS_CORRECT: 处理正确按键 ==========================
+            if (state006.correctCount >= STAGE_006_0_REQUIRED_CORRECT) {
+                // ========================== STEP_6_SUCCESS: 游戏成功，等待跳转 ==========================
+                Serial.println(F("🎉 游戏成功！达到所需正确数"));
+                notifyStageComplete("006_0", STAGE_006_0_SUCCESS_JUMP, elapsed);
+                CO_EXIT(stage.co);
             }
-            Serial.println(F("🔄 所有按键呼吸效果重新启动"));
             
-            // 计算下一轮的正确按键和语音IO
-            int voiceIndex = (stage.state.stage006.totalCount - 1) % 4;
-            stage.state.stage006.currentCorrectButton = (voiceIndex == 0) ? 1 : 
-                                                       (voiceIndex == 1) ? 3 : 
-                                                       (voiceIndex == 2) ? 2 : 4;
+            // 植物灯时序呼吸：每375ms处理一个植物灯
+            Serial.println(F("🌱 开始植物灯时序呼吸效果"));
+            for (state006.plantBreathIndex = 0;
+                 state006.plantBreathIndex < 4;
+                 state006.plantBreathIndex++) {
+                CO_AWAIT_UNTIL_TIME(stage.co, state006.roundStartTime +
+                                    (unsigned long)state006.plantBreathIndex * STAGE_006_0_PLANT_ON_DELAY);
+                updateStage006PlantBreath(state006.plantBreathIndex);
+            }
+            CO_AWAIT_UNTIL_TIME(stage.co, state006.roundStartTime + 4UL * STAGE_006_0_PLANT_ON_DELAY);
+            Serial.println(F("🌱 植物灯时序呼吸效果完成"));
             
-            int voicePin = (voiceIndex == 0) ? STAGE_006_0_VOICE_IO_1 :
-                           (voiceIndex == 1) ? STAGE_006_0_VOICE_IO_3 :
-                           (voiceIndex == 2) ? STAGE_006_0_VOICE_IO_2 : 
-                                               STAGE_006_0_VOICE_IO_4;
+            CO_AWAIT_UNTIL_TIME(stage.co, state006.roundStartTime + STAGE_006_0_CORRECT_PROCESS_TIME);
+            Serial.println(F("🔄 正确处理完成，转入下一轮准备"));
             
-            Serial.print(F("🎵 播放语音IO"));
-            Serial.print(voiceIndex + 1);
-            Serial.print(F("，正确按键="));
-            Serial.println(stage.state.stage006.currentCorrectButton);
+            // ========================== STEP_5_NEXT_ROUND: 准备下一轮 ==========================
+            CO_AWAIT_UNTIL_TIME(stage.co, state006.roundStartTime +
+                                STAGE_006_0_CORRECT_PROCESS_TIME + STAGE_006_0_CORRECT_WAIT_TIME);
+        } else {
+            // ========================== STEP_4_PROCESS_ERROR: 处理错误按键 ==========================
+            // 被按下的错误按键也要熄灭（在1125ms时）
+            CO_AWAIT_UNTIL_TIME(stage.co, state006.roundStartTime + 1125);
+            Serial.print(F("💡 熄灭错误按键"));
+            Serial.print(state006.pressedButton);
+            Serial.println(F("灯光"));
+            MillisPWM::stopBreathing(C101_TAUNT_BUTTON_LIGHT_PINS[state006.pressedButton - 1]);
+            MillisPWM::stop(C101_TAUNT_BUTTON_LIGHT_PINS[state006.pressedButton - 1]);
+            pinManager.setPinState(C101_TAUNT_BUTTON_LIGHT_PINS[state006.pressedButton - 1], LOW);
             
-            // 触发下一轮语音
-            pinManager.setPinTemporaryState(voicePin, LOW, STAGE_006_0_VOICE_TRIGGER_LOW_TIME, HIGH);
-            stage.state.stage006.voiceTriggered = true;
-            stage.state.stage006.voiceTriggerTime = millis();
-            stage.state.stage006.lastVoiceTime = millis();
+            CO_AWAIT_UNTIL_TIME(stage.co, state006.roundStartTime + STAGE_006_0_ERROR_PROCESS_TIME);
+            Serial.println(F("🔄 错误处理完成，转入下一轮准备"));
             
-            // 转入等待输入状态
-            stage.state.stage006.subState = 1; // SUB_WAITING_INPUT
-            Serial.println(F("�� 准备完成，返回等待输入状态"));
+            // ========================== STEP_5_NEXT_ROUND: 准备下一轮 ==========================
+            CO_AWAIT_UNTIL_TIME(stage.co, state006.roundStartTime +
+                                STAGE_006_0_ERROR_PROCESS_TIME + STAGE_006_0_ERROR_WAIT_TIME);
         }
         
-    } else if (stage.state.stage006.subState == 5) {
-        // ========================== STEP_6_SUCCESS: 游戏成功 ==========================
-        
-        // 游戏成功，不需要更新逻辑，等待跳转
-        return;
-    }
-
-    // ========================== 植物灯时序呼吸效果处理 ==========================
-    if (stage.state.stage006.plantBreathActive) {
-        unsigned long breathElapsed = millis() - stage.state.stage006.plantBreathStartTime;
-        unsigned long currentCheckTime = stage.state.stage006.plantBreathIndex * 375; // 每375ms检查一次
+        // 强制重置所有语音IO为HIGH状态
+        pinManager.setPinState(STAGE_006_0_VOICE_IO_1, HIGH);
+        pinManager.setPinState(STAGE_006_0_VOICE_IO_2, HIGH);
+        pinManager.setPinState(STAGE_006_0_VOICE_IO_3, HIGH);
+        pinManager.setPinState(STAGE_006_0_VOICE_IO_4, HIGH);
+        Serial.println(F("🔄 所有语音IO重置为HIGH状态"));
         
-        if (breathElapsed >= currentCheckTime) {
-            int currentPlantIndex = stage.state.stage006.plantBreathIndex;
-            
-            if (currentPlantIndex < 4) {
-                // 检查当前植物灯是否应该呼吸
-                if (stage.state.stage006.plantLightStates[currentPlantIndex]) {
-                    // 该植物灯已点亮，启动呼吸效果
-                    MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[currentPlantIndex]);
-                    MillisPWM::startBreathing(C101_PLANT_LIGHT_PINS[currentPlantIndex], 3.0);
-                    Serial.print(F("🌱 植物灯"));
-                    Serial.print(currentPlantIndex + 1);
-                    Serial.println(F("开始呼吸"));
-                } else {
-                    // 该植物灯未点亮，确保停止呼吸并设为LOW
-                    MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[currentPlantIndex]);
-                    MillisPWM::stop(C101_PLANT_LIGHT_PINS[currentPlantIndex]);
-                    pinManager.setPinState(C101_PLANT_LIGHT_PINS[currentPlantIndex], LOW);
-                }
-                
-                stage.state.stage006.plantBreathIndex++;
-            } else {
-                // 所有植物灯都检查完毕，停止时序呼吸
-                stage.state.stage006.plantBreathActive = false;
-                Serial.println(F("🌱 植物灯时序呼吸效果完成"));
-            }
+        // 重新启动所有按键呼吸效果
+        for (int i = 0; i < 4; i++) {
+            MillisPWM::stopBreathing(C101_TAUNT_BUTTON_LIGHT_PINS[i]);
+            MillisPWM::stop(C101_TAUNT_BUTTON_LIGHT_PINS[i]);
+            pinManager.setPinState(C101_TAUNT_BUTTON_LIGHT_PINS[i], LOW);
+            MillisPWM::startBreathing(C101_TAUNT_BUTTON_LIGHT_PINS[i], 3.0);
         }
+        Serial.println(F("🔄 所有按键呼吸效果重新启动"));
+        Serial.println(F("🔄 准备完成，返回等待输入状态"));
     }
+    
+    CO_END(stage.co);
+}
 
-    // ========================== 按键防抖处理 ==========================
+// 006_0当前轮次对应的语音IO引脚（m%4映射：0→IO1, 1→IO3, 2→IO2, 3→IO4）
+int GameFlowManager::getStage006VoicePin() const {
+    int voiceIndex = (state006.totalCount - 1) % 4;
+    return (voiceIndex == 0) ? STAGE_006_0_VOICE_IO_1 :
+           (voiceIndex == 1) ? STAGE_006_0_VOICE_IO_3 :
+           (voiceIndex == 2) ? STAGE_006_0_VOICE_IO_2 : 
+                               STAGE_006_0_VOICE_IO_4;
+}
+
+// 006_0植物灯时序呼吸：已点亮的植物灯开始呼吸，未点亮的保持熄灭
+void GameFlowManager::updateStage006PlantBreath(int plantIndex) {
+    if (state006.plantLightStates[plantIndex]) {
+        MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[plantIndex]);
+        MillisPWM::startBreathing(C101_PLANT_LIGHT_PINS[plantIndex], 3.0);
+        Serial.print(F("🌱 植物灯"));
+        Serial.print(plantIndex + 1);
+        Serial.println(F("开始呼吸"));
+    } else {
+        MillisPWM::stopBreathing(C101_PLANT_LIGHT_PINS[plantIndex]);
+        MillisPWM::stop(C101_PLANT_LIGHT_PINS[plantIndex]);
+        pinManager.setPinState(C101_PLANT_LIGHT_PINS[plantIndex], LOW);
+    }
 }
 
 // 更新单个环节
 void GameFlowManager::updateStage(int index) {
-    if (index < 0 || index >= MAX_PARALLEL_STAGES || !stages[index].running) {
+    if (index < 0 || index >= MAX_PARALLEL_STAGES || !isSlotRunning(index)) {
         return;
     }
     
@@ -2021,23 +1869,15 @@ void GameFlowManager::updateStage(int index) {
         return;
     }
     
-    const String& stageId = stages[index].stageId;
-    
-    // 根据环节ID调用对应的更新方法
-    if (stageId == "000_0") {
-        updateStep000(index);
-    } else if (stageId == "001_1") {
-        updateStep001_1(index);
-    } else if (stageId == "001_2") {
-        updateStep001_2(index);
-    } else if (stageId == "002_0") {
-        updateStep002(index);
-    } else if (stageId == "006_0") {
-        updateStep006(index);
+    // 根据环节类型调用对应的更新方法（兼容性变量只在启停/跳转时更新）
+    switch (stages[index].type) {
+        case STAGE_TYPE_000_0: updateStep000(index); break;
+        case STAGE_TYPE_001_1: updateStep001_1(index); break;
+        case STAGE_TYPE_001_2: updateStep001_2(index); break;
+        case STAGE_TYPE_002_0: updateStep002(index); break;
+        case STAGE_TYPE_006_0: updateStep006(index); break;
+        default: break;
     }
-    
-    // 更新兼容性变量
-    updateCompatibilityVars();
 }
 
 // 检查紧急开门功能
@@ -17,9 +17,26 @@
 #define GAME_FLOW_MANAGER_H
 
 #include <Arduino.h>
+#include "StageCoroutine.h"
 
 // ========================== 并行环节配置 ==========================
-#define MAX_PARALLEL_STAGES 4  // 最大并行环节数（根据需要调整）
+#define MAX_PARALLEL_STAGES 8  // 最大并行环节数（根据需要调整，最多16）
+#define STAGE_SLOT_NONE     0xFF
+
+#if MAX_PARALLEL_STAGES > 16
+#error "MAX_PARALLEL_STAGES超出runningMask位数"
+#endif
+
+// 环节类型（驻留ID）：环节ID字符串只在入口解析一次，之后按类型号调度
+enum StageType : uint8_t {
+    STAGE_TYPE_000_0 = 0,
+    STAGE_TYPE_001_1,
+    STAGE_TYPE_001_2,
+    STAGE_TYPE_002_0,
+    STAGE_TYPE_006_0,
+    STAGE_TYPE_COUNT,
+    STAGE_TYPE_NONE = 0xFF
+};
 
 // ========================== 音量管理配置 ==========================
 #define DEFAULT_VOLUME 30       // 默认音量值
@@ -444,115 +461,80 @@ extern UnifiedPinManager pinManager;
 
 class GameFlowManager {
 private:
-    // 环节状态结构体
+    // 环节槽位：只保存所有环节共用的调度字段，扩大槽位数不随环节状态增长
     struct StageState {
-        String stageId;              // 环节ID
-        unsigned long startTime;     // 开始时间
-        bool running;                // 是否运行中
+        uint8_t type;                // 环节类型（StageType驻留ID）
         bool jumpRequested;          // 是否已请求跳转
-        
-        // 环节特定状态（使用union节省内存）
-        union {
-            struct {  // 000_0环节状态
-                bool channelStarted;
-                unsigned long lastCheckTime;
-                // 植物灯顺序呼吸效果状态
-                int currentLightIndex;       // 当前亮起的灯索引(0-3)
-                unsigned long lightCycleStartTime;  // 当前循环开始时间
-                bool lightEffectStarted;     // 灯光效果是否已启动
-            } stage000;
-            
-            struct {  // 001_1环节状态
-                bool channelStarted;
-                unsigned long lastCheckTime;
-                unsigned long lastReedCheckTime;  // 上次干簧管检测时间
-                bool lastReedState;               // 上次干簧管状态
-                bool reedTriggered;               // 干簧管是否已触发跳转
-                int lastLightIndex;               // 上次亮起的植物灯索引(-1表示未初始化)
-                // 防抖相关状态
-                unsigned long lowStateStartTime;  // 开始LOW状态的时间(0表示未开始)
-                bool debounceComplete;            // 防抖是否完成
-            } stage001_1;
-            
-            struct {  // 001_2环节状态
-                bool fadeStarted;             // 渐灭效果是否已开始
-                unsigned long lastFadeUpdate; // 上次渐灭更新时间
-                int currentFadeStep;          // 当前渐灭步骤(0-30)
-                bool fadeComplete;            // 渐灭是否完成
-            } stage001_2;
-            
-            struct {  // 002_0环节状态
-                bool channel1Started;
-                bool channel2Started;
-                bool multiJumpTriggered;  // 多环节跳转是否已触发
-                // 呼吸效果状态
-                unsigned long breathEffectStartTime;  // 呼吸效果开始时间
-                int currentBreathStep;                 // 当前呼吸步骤(0-5)
-                bool breathEffectActive;               // 呼吸效果是否激活
-                // 闪烁效果状态
-                unsigned long flashEffectStartTime;   // 闪烁效果开始时间
-                int currentFlashGroup;                 // 当前闪烁组(0-3)
-                int currentFlashCycle;                 // 当前闪烁周期内的循环次数
-                bool flashEffectActive;                // 闪烁效果是否激活
-                bool flashState;                       // 当前闪烁状态(true=亮, false=灭)
-                unsigned long lastFlashToggle;        // 上次闪烁切换时间
-            } stage002;
-            
-            struct {  // 006_0环节状态
-                // 内部状态机
-                enum SubState {
-                    SUB_INIT,           // 初始化
-                    SUB_WAITING_INPUT,  // 等待输入
-                    SUB_CORRECT,        // 正确处理
-                    SUB_ERROR,          // 错误处理
-                    SUB_ERROR_WAIT,     // 错误等待
-                    SUB_SUCCESS         // 成功完成
-                } subState;
-                
-                // 游戏核心状态 (必要)
-                int totalCount;                // 总计数器m
-                int correctCount;              // 正确计数器
-                int currentCorrectButton;      // 当前正确的按键(1-4)
-                int pressedButton;             // 玩家按下的按键(1-4)
-                bool buttonPressed;            // 是否有按键被按下
-                
-                // 语音控制状态 (必要)
-                bool voiceTriggered;           // 语音是否已触发
-                unsigned long voiceTriggerTime; // 语音触发时间
-                bool voicePlayedOnce;          // 语音是否已播放过一次
-                unsigned long lastVoiceTime;   // 上次语音播放时间
-                
-                // 按键防抖状态 (必要)
-                bool buttonDebouncing;         // 是否正在防抖
-                int debouncingButton;          // 正在防抖的按键索引(0-3)
-                unsigned long debounceStartTime; // 防抖开始时间
-                int lastButtonStates[4];       // 上次按键状态记录
-                
-                // 时序控制状态 (必要)
-                unsigned long errorStartTime;  // 错误处理开始时间
-                unsigned long correctStartTime; // 正确处理开始时间
-                bool isCorrectWait;             // 是否是正确处理后的等待状态
-                
-                // 植物灯状态 (必要)
-                bool plantLightStates[4];      // 植物灯状态记录
-                bool plantBreathActive;        // 植物灯时序呼吸是否激活
-                unsigned long plantBreathStartTime; // 植物灯时序呼吸开始时间
-                int plantBreathIndex;          // 植物灯时序呼吸索引
-            } stage006;
-        } state;
+        unsigned long startTime;     // 开始时间
+        StageCoroutine co;           // 协程恢复状态（协程化环节使用）
         
         // 构造函数
-        StageState() : stageId(""), startTime(0), running(false), jumpRequested(false) {
-            memset(&state, 0, sizeof(state));
+        StageState() : type(STAGE_TYPE_NONE), jumpRequested(false), startTime(0) {
+            co.reset();
         }
     };
     
-    // 并行环节数组
+    // 并行环节槽位池
     StageState stages[MAX_PARALLEL_STAGES];
+    uint16_t runningMask;                    // 运行中槽位位图（bit i = 槽位i）
+    uint8_t typeSlot[STAGE_TYPE_COUNT];      // 环节类型 -> 槽位（STAGE_SLOT_NONE表示未运行）
+    
+    // ========================== 环节专属状态 ==========================
+    // 同一环节类型同时只运行一个实例，状态按类型独立分配，各自只占用本环节所需大小
+    struct {  // 000_0环节状态
+        int currentLightIndex;              // 当前亮起的灯索引(0-3)
+        unsigned long lightCycleStartTime;  // 当前循环开始时间
+        bool lightEffectStarted;            // 灯光效果是否已启动
+    } state000;
+    
+    struct {  // 001_1环节状态
+        unsigned long lastCheckTime;        // 植物灯时间基准
+        bool reedTriggered;                 // 干簧管是否已触发跳转
+        int lastLightIndex;                 // 上次亮起的植物灯索引(-1表示未初始化)
+        // 防抖由InputCapture按LOW时长完成
+    } state001_1;
+    
+    struct {  // 001_2环节状态
+        bool fadeStarted;                   // 渐灭效果是否已开始
+        bool fadeComplete;                  // 渐灭是否完成
+    } state001_2;
+    
+    struct {  // 002_0环节状态
+        bool multiJumpTriggered;            // 多环节跳转是否已触发
+        // 呼吸效果状态
+        unsigned long breathEffectStartTime;  // 呼吸效果开始时间
+        int currentBreathStep;                 // 当前呼吸步骤(0-5)
+        bool breathEffectActive;               // 呼吸效果是否激活
+        // 闪烁效果状态
+        unsigned long flashEffectStartTime;   // 闪烁效果开始时间
+        int currentFlashGroup;                 // 当前闪烁组(0-3)
+        int currentFlashCycle;                 // 当前闪烁周期内的循环次数
+        bool flashEffectActive;                // 闪烁效果是否激活
+        bool flashState;                       // 当前闪烁状态(true=亮, false=灭)
+        unsigned long lastFlashToggle;        // 上次闪烁切换时间
+    } state002;
+    
+    struct {  // 006_0环节状态（流程由协程驱动，见updateStep006）
+        // 游戏核心状态
+        int totalCount;                // 总计数器m
+        int correctCount;              // 正确计数器
+        int currentCorrectButton;      // 当前正确的按键(1-4)
+        int pressedButton;             // 玩家按下的按键(1-4)，0表示未按下
+        
+        // 时序状态（跨等待点保存）
+        unsigned long roundStartTime;  // 正确/错误处理开始时间
+        unsigned long lastVoiceTime;   // 上次语音播放时间
+        int plantBreathIndex;          // 植物灯时序呼吸索引
+        
+        // 植物灯状态
+        bool plantLightStates[4];      // 植物灯状态记录
+    } state006;
+    
     int activeStageCount;            // 当前活跃环节数
     bool globalStopped;              // 全局停止标志
     
-    // 兼容旧接口的当前环节引用
+    // 兼容旧接口的当前环节引用（仅在运行集合或跳转标志变化时更新）
+    uint8_t compatType;              // currentStageId对应的环节类型
     String currentStageId;           // 当前环节ID（指向第一个活跃环节）
     unsigned long stageStartTime;    // 环节开始时间（指向第一个活跃环节）
     bool stageRunning;               // 环节是否运行中（任意环节运行即为true）
@@ -565,7 +547,14 @@ private:
     
     // 查找环节索引
     int findStageIndex(const String& stageId);
-    int findEmptySlot();
+    int findStageIndex(uint8_t type) const;
+    int findEmptySlot() const;
+    bool isSlotRunning(int index) const;
+    
+    // 环节启停（按类型/槽位）
+    bool startStageType(uint8_t type);
+    void releaseSlot(int index);
+    void resetStageTypeState(uint8_t type);
     
     // 环节完成通知
     void notifyStageComplete(const String& currentStep, const String& nextStep, unsigned long duration);
@@ -576,10 +565,14 @@ private:
     void updateStep001_1(int index);          // 更新001_1环节
     void updateStep001_2(int index);          // 更新001_2环节
     void updateStep002(int index);            // 更新002_0环节
-    void updateStep006(int index);            // 更新006_0环节
+    void updateStep006(int index);            // 更新006_0环节（协程）
+    int getStage006VoicePin() const;
+    void updateStage006PlantBreath(int plantIndex);
     
     // 工具方法
-    String normalizeStageId(const String& stageId);  // 标准化环节ID格式
+    static uint8_t internStageId(const char* stageId, unsigned int length);  // 环节ID -> StageType
+    static uint8_t internStageId(const String& stageId);
+    static const __FlashStringHelper* getStageName(uint8_t type);         // StageType -> 环节ID
     void updateCompatibilityVars();                  // 更新兼容性变量
     
     // 000_0环节引脚配置方法
@@ -0,0 +1,108 @@
+#include "HarbingerFrame.h"
+
+// 解析状态
+#define HBF_STATE_IDLE      0
+#define HBF_STATE_LENGTH    1
+#define HBF_STATE_TYPE      2
+#define HBF_STATE_COMMAND   3
+#define HBF_STATE_PAYLOAD   4
+#define HBF_STATE_CRC_LOW   5
+#define HBF_STATE_CRC_HIGH  6
+
+// ========================== CRC ==========================
+uint16_t hbfCrc16(uint16_t crc, uint8_t data) {
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+// ========================== 解析器 ==========================
+HarbingerFrameParser::HarbingerFrameParser() {
+    reset();
+}
+
+void HarbingerFrameParser::reset() {
+    state = HBF_STATE_IDLE;
+    index = 0;
+    crc = 0xFFFF;
+    crcLow = 0;
+}
+
+int8_t HarbingerFrameParser::feed(uint8_t data) {
+    switch (state) {
+        case HBF_STATE_IDLE:
+            if (data == HBF_SYNC) {
+                crc = 0xFFFF;
+                state = HBF_STATE_LENGTH;
+            }
+            return HBF_PARSE_PENDING;
+
+        case HBF_STATE_LENGTH:
+            if (data > HBF_MAX_PAYLOAD) {
+                reset();
+                return HBF_PARSE_ERROR;
+            }
+            frame.length = data;
+            crc = hbfCrc16(crc, data);
+            state = HBF_STATE_TYPE;
+            return HBF_PARSE_PENDING;
+
+        case HBF_STATE_TYPE:
+            frame.type = data;
+            crc = hbfCrc16(crc, data);
+            state = HBF_STATE_COMMAND;
+            return HBF_PARSE_PENDING;
+
+        case HBF_STATE_COMMAND:
+            frame.command = data;
+            crc = hbfCrc16(crc, data);
+            index = 0;
+            state = (frame.length > 0) ? HBF_STATE_PAYLOAD : HBF_STATE_CRC_LOW;
+            return HBF_PARSE_PENDING;
+
+        case HBF_STATE_PAYLOAD:
+            frame.payload[index++] = data;
+            crc = hbfCrc16(crc, data);
+            if (index >= frame.length) state = HBF_STATE_CRC_LOW;
+            return HBF_PARSE_PENDING;
+
+        case HBF_STATE_CRC_LOW:
+            crcLow = data;
+            state = HBF_STATE_CRC_HIGH;
+            return HBF_PARSE_PENDING;
+
+        case HBF_STATE_CRC_HIGH: {
+            bool valid = (crcLow | ((uint16_t)data << 8)) == crc;
+            reset();
+            return valid ? HBF_PARSE_DONE : HBF_PARSE_ERROR;
+        }
+    }
+
+    reset();
+    return HBF_PARSE_ERROR;
+}
+
+// ========================== 编码 ==========================
+uint8_t hbfEncode(uint8_t type, uint8_t command, const uint8_t* payload, uint8_t length,
+                  uint8_t* out, uint8_t outSize) {
+    if (length > HBF_MAX_PAYLOAD || outSize < length + HBF_OVERHEAD) return 0;
+
+    uint8_t n = 0;
+    out[n++] = HBF_SYNC;
+    out[n++] = length;
+    out[n++] = type;
+    out[n++] = command;
+    for (uint8_t i = 0; i < length; i++) {
+        out[n++] = payload[i];
+    }
+
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 1; i < n; i++) {
+        crc = hbfCrc16(crc, out[i]);
+    }
+    out[n++] = crc & 0xFF;
+    out[n++] = crc >> 8;
+    return n;
+}
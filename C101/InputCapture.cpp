@@ -0,0 +1,248 @@
+#include "InputCapture.h"
+#include <avr/interrupt.h>
+
+// 静态成员变量定义
+InputCapture::IsrChannel InputCapture::isrChannels[ICAP_MAX_CHANNELS];
+InputCapture::Channel InputCapture::channels[ICAP_MAX_CHANNELS];
+volatile uint8_t InputCapture::channelCount = 0;
+InputEvent InputCapture::buffer[ICAP_BUFFER_SIZE];
+volatile uint8_t InputCapture::head = 0;
+volatile uint8_t InputCapture::tail = 0;
+volatile uint8_t InputCapture::overflowCount = 0;
+volatile uint8_t InputCapture::resyncMask = 0;
+bool InputCapture::initialized = false;
+
+// Timer0比较B中断：每次Timer0计数经过OCR0B时触发一次（约1.024ms）
+ISR(TIMER0_COMPB_vect) {
+    InputCapture::sampleFromISR();
+}
+
+void InputCapture::begin() {
+    if (initialized) return;
+
+    // Timer0已由Arduino内核配置为约1kHz溢出，这里只额外打开比较B中断
+    OCR0B = 0x80;
+    TIMSK0 |= _BV(OCIE0B);
+    initialized = true;
+
+    Serial.println(F("✅ InputCapture初始化完成（Timer0比较B采样）"));
+}
+
+bool InputCapture::watch(int pin, uint16_t minLowMs) {
+    if (findChannel(pin) >= 0) return true;
+    if (channelCount >= ICAP_MAX_CHANNELS) return false;
+
+    uint8_t port = digitalPinToPort(pin);
+    if (port == NOT_A_PIN) return false;
+
+    pinMode(pin, INPUT_PULLUP);
+
+    uint8_t index = channelCount;
+    IsrChannel& isr = isrChannels[index];
+    isr.inReg = portInputRegister(port);
+    isr.inMask = digitalPinToBitMask(pin);
+    isr.level = (*isr.inReg & isr.inMask) ? HIGH : LOW;
+    isr.stableCount = 0;
+    isr.outReg = NULL;
+    isr.outMask = 0;
+    isr.outLevel = LOW;
+    isr.triggerLevel = LOW;
+
+    Channel& ch = channels[index];
+    ch.pin = (int8_t)pin;
+    ch.level = isr.level;
+    ch.lastEdgeTime = millis();
+    ch.fallTime = ch.lastEdgeTime;
+    ch.minLowMs = minLowMs;
+    ch.reported = true;          // 启动时已处于LOW不算一次按压
+    ch.pressPending = false;
+    ch.pressTime = 0;
+
+    // 通道数据写完后再发布给ISR
+    channelCount = index + 1;
+    return true;
+}
+
+bool InputCapture::setDirectAction(int pin, bool triggerLevel, int outPin, bool outLevel) {
+    int index = findChannel(pin);
+    if (index < 0) return false;
+
+    uint8_t port = digitalPinToPort(outPin);
+    if (port == NOT_A_PIN) return false;
+
+    uint8_t oldSREG = SREG;
+    cli();
+    isrChannels[index].outReg = portOutputRegister(port);
+    isrChannels[index].outMask = digitalPinToBitMask(outPin);
+    isrChannels[index].outLevel = outLevel;
+    isrChannels[index].triggerLevel = triggerLevel;
+    SREG = oldSREG;
+    return true;
+}
+
+void InputCapture::sampleFromISR() {
+    uint8_t count = channelCount;
+
+    for (uint8_t i = 0; i < count; i++) {
+        IsrChannel& isr = isrChannels[i];
+        uint8_t level = (*isr.inReg & isr.inMask) ? HIGH : LOW;
+        if (level == isr.level) {
+            isr.stableCount = 0;   // 抖动回到原电平，重新计数
+            continue;
+        }
+        if (++isr.stableCount < ICAP_DEBOUNCE_SAMPLES) continue;
+        isr.stableCount = 0;
+        isr.level = level;
+
+        // 直接动作：不经过主循环，延迟上限约ICAP_DEBOUNCE_SAMPLES ms
+        if (isr.outReg != NULL && level == isr.triggerLevel) {
+            if (isr.outLevel) {
+                *isr.outReg |= isr.outMask;
+            } else {
+                *isr.outReg &= ~isr.outMask;
+            }
+        }
+
+        uint8_t next = (head + 1) & (ICAP_BUFFER_SIZE - 1);
+        if (next == tail) {
+            overflowCount++;
+            resyncMask |= (1 << i);   // 边沿丢失，主循环电平会反相，需要重新同步
+            continue;
+        }
+        buffer[head].channel = i;
+        buffer[head].level = level;
+        buffer[head].time = millis() - (ICAP_DEBOUNCE_SAMPLES - 1);  // 电平开始稳定的时刻
+        head = next;
+    }
+}
+
+void InputCapture::update() {
+    // 取出所有待处理事件
+    while (tail != head) {
+        InputEvent event = buffer[tail];
+        tail = (tail + 1) & (ICAP_BUFFER_SIZE - 1);
+        handleEvent(event);
+    }
+
+    // 溢出丢失边沿的通道：按ISR当前电平补一个边沿
+    if (resyncMask) {
+        uint8_t oldSREG = SREG;
+        cli();
+        uint8_t mask = resyncMask;
+        resyncMask = 0;
+        SREG = oldSREG;
+
+        for (uint8_t i = 0; i < channelCount; i++) {
+            if (!(mask & (1 << i))) continue;
+            InputEvent event;
+            event.channel = i;
+            event.level = isrChannels[i].level;   // 单字节，读取是原子的
+            event.time = millis();
+            if (event.level != channels[i].level) handleEvent(event);
+        }
+    }
+
+    // 仍处于LOW的通道：达到最短时间即锁存按压
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < channelCount; i++) {
+        Channel& ch = channels[i];
+        if (ch.level == LOW && !ch.reported && now - ch.fallTime >= ch.minLowMs) {
+            ch.reported = true;
+            ch.pressPending = true;
+            ch.pressTime = ch.fallTime;
+        }
+    }
+}
+
+void InputCapture::handleEvent(const InputEvent& event) {
+    if (event.channel >= channelCount) return;
+    Channel& ch = channels[event.channel];
+
+    if (event.level == LOW) {
+        ch.fallTime = event.time;
+        ch.reported = false;
+    } else if (!ch.reported && event.time - ch.fallTime >= ch.minLowMs) {
+        // 阻塞期间完成的短按：按下与释放都已带时间戳，按实际LOW时长判断
+        ch.reported = true;
+        ch.pressPending = true;
+        ch.pressTime = ch.fallTime;
+    }
+
+    ch.level = event.level;
+    ch.lastEdgeTime = event.time;
+}
+
+bool InputCapture::takePress(int pin, unsigned long* pressTime) {
+    int index = findChannel(pin);
+    if (index < 0 || !channels[index].pressPending) return false;
+
+    channels[index].pressPending = false;
+    if (pressTime != NULL) *pressTime = channels[index].pressTime;
+    return true;
+}
+
+void InputCapture::clearPress(int pin) {
+    int index = findChannel(pin);
+    if (index >= 0) {
+        channels[index].pressPending = false;
+    }
+}
+
+bool InputCapture::getLevel(int pin) {
+    int index = findChannel(pin);
+    return (index >= 0) ? channels[index].level : digitalRead(pin);
+}
+
+bool InputCapture::isHeldFor(int pin, bool level, unsigned long ms) {
+    int index = findChannel(pin);
+    if (index < 0 || channels[index].level != level) return false;
+    return millis() - channels[index].lastEdgeTime >= ms;
+}
+
+unsigned long InputCapture::getLastEdgeTime(int pin) {
+    int index = findChannel(pin);
+    return (index >= 0) ? channels[index].lastEdgeTime : 0;
+}
+
+uint8_t InputCapture::getChannelMask(int pin) {
+    int index = findChannel(pin);
+    return (index >= 0) ? (uint8_t)(1 << index) : 0;
+}
+
+uint8_t InputCapture::getPendingMask() {
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < channelCount; i++) {
+        if (channels[i].pressPending) mask |= (1 << i);
+    }
+    return mask;
+}
+
+uint8_t InputCapture::getOverflowCount() {
+    return overflowCount;
+}
+
+int InputCapture::findChannel(int pin) {
+    for (uint8_t i = 0; i < channelCount; i++) {
+        if (channels[i].pin == pin) return i;
+    }
+    return -1;
+}
+
+void InputCapture::printStatus() {
+    Serial.println(F("=== InputCapture状态 ==="));
+    Serial.print(F("监视通道: "));
+    Serial.print(channelCount);
+    Serial.print(F(", 缓冲溢出: "));
+    Serial.println(overflowCount);
+    for (uint8_t i = 0; i < channelCount; i++) {
+        Serial.print(F("  Pin"));
+        Serial.print(channels[i].pin);
+        Serial.print(F(": "));
+        Serial.print(channels[i].level ? F("HIGH") : F("LOW"));
+        Serial.print(F(", 上次边沿 "));
+        Serial.print(millis() - channels[i].lastEdgeTime);
+        Serial.print(F("ms前"));
+        if (isrChannels[i].outReg != NULL) Serial.print(F(" [直接动作]"));
+        Serial.println();
+    }
+}
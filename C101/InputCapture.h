@@ -0,0 +1,101 @@
+#ifndef INPUT_CAPTURE_H
+#define INPUT_CAPTURE_H
+
+#include <Arduino.h>
+
+// ========================== 中断输入捕获 ==========================
+// Mega2560上C101的按键/干簧管/读卡器引脚(22/24/31-37)位于PORTA/PORTC，
+// 这两个端口没有PCINT，因此借用Timer0比较B中断(与millis同一定时器，约1kHz)
+// 直接读端口寄存器采样。电平连续ICAP_DEBOUNCE_SAMPLES次采样一致才算边沿（ISR内去抖，
+// 抖动不占缓冲），每个边沿带时间戳写入单生产者/单消费者环形缓冲，主循环在update()中取出。
+// loop()阻塞(语音delay、以太网重连)期间边沿不丢失；缓冲溢出时主循环按ISR当前电平重新同步。
+
+#define ICAP_MAX_CHANNELS   8      // 最大监视引脚数
+#define ICAP_BUFFER_SIZE    16     // 环形缓冲容量（必须是2的幂）
+#define ICAP_DEBOUNCE_SAMPLES 3    // 去抖：连续相同采样次数（约1ms/次）
+
+// 边沿事件
+struct InputEvent {
+    uint8_t channel;               // 通道号
+    uint8_t level;                 // 边沿后的电平
+    unsigned long time;            // 边沿时间戳(ms)
+};
+
+class InputCapture {
+private:
+    // ISR侧数据（采样与直接动作）
+    struct IsrChannel {
+        volatile uint8_t* inReg;   // 输入端口寄存器(PINx)
+        uint8_t inMask;
+        uint8_t level;             // ISR去抖后的电平
+        uint8_t stableCount;       // 与level不同的连续采样次数
+        volatile uint8_t* outReg;  // 直接动作输出端口寄存器(PORTx)，NULL表示无动作
+        uint8_t outMask;
+        uint8_t outLevel;
+        uint8_t triggerLevel;      // 触发直接动作的边沿电平
+    };
+
+    // 主循环侧数据（去抖与按压锁存）
+    struct Channel {
+        int8_t pin;
+        bool level;
+        unsigned long lastEdgeTime;  // 最近一次边沿时间
+        unsigned long fallTime;      // 最近一次下降沿时间
+        uint16_t minLowMs;           // 有效按压的最短LOW时间
+        bool reported;               // 本次LOW已上报过按压
+        bool pressPending;           // 按压已锁存，等待takePress取走
+        unsigned long pressTime;     // 锁存按压的起始时间
+    };
+
+    static IsrChannel isrChannels[ICAP_MAX_CHANNELS];
+    static Channel channels[ICAP_MAX_CHANNELS];
+    static volatile uint8_t channelCount;
+
+    // 环形缓冲：head仅由ISR写，tail仅由主循环写
+    static InputEvent buffer[ICAP_BUFFER_SIZE];
+    static volatile uint8_t head;
+    static volatile uint8_t tail;
+    static volatile uint8_t overflowCount;
+    static volatile uint8_t resyncMask;      // 边沿因溢出丢失的通道位图，主循环重新同步电平
+    static bool initialized;
+
+    static int findChannel(int pin);
+    static void handleEvent(const InputEvent& event);
+
+public:
+    // 初始化（开启Timer0比较B中断）
+    static void begin();
+
+    // 监视引脚（INPUT_PULLUP，低电平有效），minLowMs为有效按压的最短LOW时间
+    static bool watch(int pin, uint16_t minLowMs = 0);
+
+    // 在ISR中直接执行的动作：引脚出现triggerLevel边沿时立即把outPin写为outLevel
+    static bool setDirectAction(int pin, bool triggerLevel, int outPin, bool outLevel);
+
+    // 消费端：取出环形缓冲中的事件并更新锁存状态（loop中调用）
+    static void update();
+
+    // 查询
+    static bool takePress(int pin, unsigned long* pressTime = NULL);  // 取走锁存的按压
+    static void clearPress(int pin);                                  // 丢弃旧按压
+    static bool getLevel(int pin);
+    static bool isHeldFor(int pin, bool level, unsigned long ms);
+    static unsigned long getLastEdgeTime(int pin);
+    static uint8_t getChannelMask(int pin);                           // 引脚对应的通道位
+    static uint8_t getPendingMask();                                  // 有待取按压的通道位图
+    static uint8_t getOverflowCount();
+
+    // ISR入口（内部使用）
+    static void sampleFromISR();
+
+    // 调试
+    static void printStatus();
+};
+
+// 便捷宏定义
+#define ICAP_BEGIN()                   InputCapture::begin()
+#define ICAP_UPDATE()                  InputCapture::update()
+#define ICAP_WATCH(pin, minLow)        InputCapture::watch(pin, minLow)
+#define ICAP_PRESSED(pin)              InputCapture::takePress(pin)
+
+#endif // INPUT_CAPTURE_H
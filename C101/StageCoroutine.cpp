@@ -0,0 +1,57 @@
+#include "StageCoroutine.h"
+#include "InputCapture.h"
+#include "BY_VoiceController_Unified.h"
+
+extern BY_VoiceController_Unified voice;
+
+void StageCoroutine::reset() {
+    line = 0;
+    waitType = CO_WAIT_NONE;
+    waitArg = 0;
+    wakeTime = 0;
+}
+
+bool StageCoroutine::isReady() const {
+    if (line == CO_LINE_DONE) return false;
+
+    switch (waitType) {
+        case CO_WAIT_MS:
+            return timedOut();
+        case CO_WAIT_INPUT:
+            return (InputCapture::getPendingMask() & waitArg) || timedOut();
+        case CO_WAIT_AUDIO:
+            return !voice.isBusy(waitArg) || timedOut();
+        default:
+            return true;
+    }
+}
+
+bool StageCoroutine::isDone() const {
+    return line == CO_LINE_DONE;
+}
+
+bool StageCoroutine::timedOut() const {
+    // wakeTime为0表示无超时
+    return wakeTime != 0 && (long)(millis() - wakeTime) >= 0;
+}
+
+void StageCoroutine::waitMs(unsigned long ms) {
+    waitUntil(millis() + ms);
+}
+
+void StageCoroutine::waitUntil(unsigned long time) {
+    waitType = CO_WAIT_MS;
+    wakeTime = (time == 0) ? 1 : time;
+}
+
+void StageCoroutine::waitInput(uint8_t channelMask, unsigned long timeoutMs) {
+    waitType = CO_WAIT_INPUT;
+    waitArg = channelMask;
+    wakeTime = (timeoutMs > 0) ? millis() + timeoutMs : 0;
+}
+
+void StageCoroutine::waitAudio(uint8_t channel, unsigned long timeoutMs) {
+    waitType = CO_WAIT_AUDIO;
+    waitArg = channel;
+    wakeTime = (timeoutMs > 0) ? millis() + timeoutMs : 0;
+}
@@ -0,0 +1,60 @@
+#ifndef STAGE_COROUTINE_H
+#define STAGE_COROUTINE_H
+
+#include <Arduino.h>
+
+// ========================== 环节协程（无栈） ==========================
+// 基于switch/__LINE__的protothread：环节逻辑按顺序书写，在CO_AWAIT_*处让出，
+// 下次从让出点继续。每个协程只保存8字节恢复状态。
+//
+// 使用约束：
+//   1. 局部变量不跨越等待点保留，需要保存的值放在环节状态结构体中
+//   2. 协程体内不能再使用switch语句（与case标签冲突）
+//   3. 协程函数返回类型为void
+//
+// 调度器在调用环节更新函数前先检查isReady()，等待条件未满足时直接跳过该环节。
+
+#define CO_LINE_DONE    0xFFFF      // 协程已结束
+
+// 等待类型
+enum CoWaitType : uint8_t {
+    CO_WAIT_NONE,       // 就绪，每次loop都执行
+    CO_WAIT_MS,         // 等待到wakeTime
+    CO_WAIT_INPUT,      // 等待InputCapture按压（可带超时）
+    CO_WAIT_AUDIO       // 等待语音通道播放结束（可带超时）
+};
+
+struct StageCoroutine {
+    uint16_t line;              // 恢复点（__LINE__），0=从头开始
+    uint8_t waitType;           // CoWaitType
+    uint8_t waitArg;            // CO_WAIT_INPUT: 通道位图；CO_WAIT_AUDIO: 语音通道号(1-4)
+    unsigned long wakeTime;     // 唤醒/超时时间
+
+    void reset();
+    bool isReady() const;       // 调度器调用：等待未满足时返回false
+    bool isDone() const;
+    bool timedOut() const;      // 恢复后判断是否因超时唤醒
+
+    // 由CO_AWAIT_*宏调用
+    void waitMs(unsigned long ms);
+    void waitUntil(unsigned long time);
+    void waitInput(uint8_t channelMask, unsigned long timeoutMs);
+    void waitAudio(uint8_t channel, unsigned long timeoutMs);
+};
+
+// 协程控制宏
+#define CO_BEGIN(co)        switch ((co).line) { case 0:
+#define CO_END(co)          } (co).line = CO_LINE_DONE; return
+#define CO_YIELD(co)        do { (co).line = __LINE__; return; case __LINE__: (co).waitType = CO_WAIT_NONE; } while (0)
+#define CO_EXIT(co)         do { (co).line = CO_LINE_DONE; return; } while (0)
+
+// 等待原语
+#define CO_AWAIT_MS(co, ms)                     do { (co).waitMs(ms); CO_YIELD(co); } while (0)
+#define CO_AWAIT_UNTIL_TIME(co, t)              do { (co).waitUntil(t); CO_YIELD(co); } while (0)
+#define CO_AWAIT_INPUT(co, mask, timeoutMs)     do { (co).waitInput(mask, timeoutMs); CO_YIELD(co); } while (0)
+#define CO_AWAIT_AUDIO_DONE(co, ch, timeoutMs)  do { (co).waitAudio(ch, timeoutMs); CO_YIELD(co); } while (0)
+
+// 通用条件等待（每次loop求值，不能被调度器跳过，尽量使用上面的原语）
+#define CO_AWAIT(co, cond)  do { (co).line = __LINE__; case __LINE__: if (!(cond)) return; } while (0)
+
+#endif // STAGE_COROUTINE_H
@@ -7,6 +7,7 @@
  */
 
 #include "UniversalHarbingerClient.h"
+#include "ArduinoSystemHelper.h"
 
 // ========================== 调试开关 ==========================
 // 注释掉这行可以关闭所有调试信息
@@ -20,6 +21,13 @@
   #define DEBUG_PRINTLN(x)
 #endif
 
+// 诊断统计：关闭HARBINGER_NET_STATS时计数语句一起编译掉
+#if HARBINGER_NET_STATS
+  #define NET_STAT(x) x
+#else
+  #define NET_STAT(x)
+#endif
+
 // ========================== 全局实例 ==========================
 UniversalHarbingerClient harbingerClient;
 
@@ -28,12 +36,72 @@ UniversalHarbingerClient::UniversalHarbingerClient() {
     connectionState = CONN_DISCONNECTED;
     serverPort = 0;
     lastHeartbeat = 0;
+    lastTxTime = 0;
+    lastRxTime = 0;
+    heartbeatSentAt = 0;
+    awaitingAck = false;
+    missedAcks = 0;
+    srtt8 = 0;
+    rttvar4 = 0;
+    rttValid = false;
+    socketConnected = false;
+    passStart = 0;
+    rxBuffer = "";
+#if HARBINGER_NET_STATS
+    lastRtt = 0;
+    heartbeatsSent = 0;
+    heartbeatsSkipped = 0;
+    acksMissed = 0;
+    spiOps = 0;
+    lastPassSpiOps = 0;
+    maxPassSpiOps = 0;
+    lastPassUs = 0;
+    maxPassUs = 0;
+    budgetOverruns = 0;
+#endif
+#if HARBINGER_GROUP_COMMANDS
+    groupPort = 0;
+    groupJoined = false;
+    groupSeqValid = false;
+    groupSeq = 0;
+    groupSeen = 0;
+    groupReceived = 0;
+    groupApplied = 0;
+    groupDuplicates = 0;
+#endif
+#if HARBINGER_CLOCK_SYNC
+    clockSampleCount = 0;
+    clockSampleNext = 0;
+    clockSynced = false;
+    clockRefLocal = 0;
+    clockOffset = 0;
+    clockRtt = 0;
+    clockDriftPpm = 0;
+    driftValid = false;
+    driftAnchorLocal = 0;
+    driftAnchorOffset = 0;
+    lastClockSample = 0;
+    for (uint8_t i = 0; i < SCHEDULE_SLOTS; i++) {
+        scheduledAt[i] = 0;
+    }
+    dispatchLateness = 0;
+    atReport = "";
+    scheduledExecuted = 0;
+    lastAtError = 0;
+#endif
     lastReconnectAttempt = 0;
     ethernetInitTime = 0;
     networkInitialized = false;
     firstConnectionAttempted = false;
     connectionCallback = nullptr;
     messageCallback = nullptr;
+    sendHook = nullptr;
+#if HARBINGER_BINARY_FRAMES
+    frameCallback = nullptr;
+    binaryFraming = false;
+#endif
+    lastLinkPoll = 0;
+    bootReported = false;
 }
 
 UniversalHarbingerClient::~UniversalHarbingerClient() {
@@ -71,21 +139,22 @@ bool UniversalHarbingerClient::begin(const String& controllerId, const String& d
         return false;
     }
     
-    // 等待网络稳定
-    delay(ETHERNET_STABILIZE_TIME);
-    
-    // 检查网络状态
-    IPAddress localIP = Ethernet.localIP();
+    // 不在这里等待网络稳定：链路在handleAllNetworkOperations中后台检查，
+    // 灯光、按键和语音不必等以太网
+    networkInitialized = true;
+    connectionState = CONN_STABILIZING;
+    ethernetInitTime = millis();
+    lastLinkPoll = 0;
+    markBootPhase(F("eth"));
     
-    if (Ethernet.linkStatus() != LinkOFF && localIP != IPAddress(0, 0, 0, 0)) {
-        networkInitialized = true;
-        connectionState = CONN_STABILIZING;
-        ethernetInitTime = millis();
-        return true;
-    } else {
-        connectionState = CONN_ERROR;
-        return false;
+#if HARBINGER_GROUP_COMMANDS
+    // 重新初始化（reset命令）时Ethernet.begin已关闭组播socket，重新加入
+    if (groupPort != 0) {
+        groupJoined = false;
+        joinGroup(groupIP, groupPort);
     }
+#endif
+    return true;
 }
 
 bool UniversalHarbingerClient::connect(IPAddress serverIP, uint16_t serverPort) {
@@ -106,17 +175,15 @@ bool UniversalHarbingerClient::connectToServer() {
     }
     lastReconnectAttempt = millis();
     
-    // 强制断开现有连接
+    // 强制断开现有连接（首次连接时没有旧socket，不必等待）
+    NET_STAT(spiOps += 3);   // connected + connect + connected
     if (client.connected()) {
         DEBUG_PRINTLN(F("断开现有连接"));
         client.stop();
+        client.flush();
         delay(100);
     }
     
-    // 确保socket完全关闭
-    client.flush();
-    delay(100);
-    
     DEBUG_PRINT(F("尝试连接到 "));
     DEBUG_PRINT(serverIP);
     DEBUG_PRINT(F(":"));
@@ -126,18 +193,40 @@ bool UniversalHarbingerClient::connectToServer() {
     client.setTimeout(5000);  // 5秒超时
     
     if (client.connect(serverIP, serverPort)) {
-        // 验证连接是否真正建立
-        delay(100);
+        // 验证连接是否真正建立（connect返回成功时socket已是ESTABLISHED，无需再等）
         if (client.connected()) {
             connectionState = CONN_CONNECTED;
+            socketConnected = true;
             
             DEBUG_PRINTLN(F("连接成功！"));
             
+            // 每次连接重新协商帧格式
+#if HARBINGER_BINARY_FRAMES
+            binaryFraming = false;
+            frameParser.reset();
+#endif
+            rxBuffer = "";
+            
             // 立即发送注册消息
+            markBootPhase(F("tcp"));
             sendRegistration();
             
-            // 重置心跳计时器
+            // 首个心跳不等满间隔，下一轮就发出（同时取得第一个RTT样本）
             lastHeartbeat = millis();
+            lastRxTime = millis() - HEARTBEAT_INTERVAL;
+            awaitingAck = false;
+            missedAcks = 0;
+            
+#if HARBINGER_CLOCK_SYNC
+            // 服务器可能已重启，时间基准重新同步（漂移是本地晶振的特性，保留）
+            clockSampleCount = 0;
+            clockSynced = false;
+#endif
+            
+#if HARBINGER_GROUP_COMMANDS
+            // 重启后的服务器从gseq=1重新编号，旧窗口会把新命令当成重复丢弃
+            groupSeqValid = false;
+#endif
             
             // 触发连接回调
             if (connectionCallback) {
@@ -157,6 +246,32 @@ bool UniversalHarbingerClient::connectToServer() {
     }
 }
 
+/**
+ * @brief 加入组播组：服务器把需要多个控制器同时响应的命令（全场熄灯、胜利闪烁）
+ *        作为一个数据报发给整组，与TCP会话并存，TCP断开时照常接收
+ */
+bool UniversalHarbingerClient::joinGroup(IPAddress group, uint16_t port) {
+#if HARBINGER_GROUP_COMMANDS
+    if (!networkInitialized) return false;
+    
+    if (groupJoined) {
+        groupUdp.stop();
+    }
+    groupIP = group;
+    groupPort = port;
+    groupJoined = groupUdp.beginMulticast(group, port);
+    
+    DEBUG_PRINT(groupJoined ? F("加入组播组 ") : F("加入组播组失败 "));
+    DEBUG_PRINT(group);
+    DEBUG_PRINT(F(":"));
+    DEBUG_PRINTLN(port);
+    return groupJoined;
+#else
+    DEBUG_PRINTLN(F("组播组命令未编译（HARBINGER_GROUP_COMMANDS为0）"));
+    return false;
+#endif
+}
+
 void UniversalHarbingerClient::disconnect() {
     DEBUG_PRINTLN(F("断开连接"));
     
@@ -169,6 +284,7 @@ void UniversalHarbingerClient::disconnect() {
     delay(100);
     
     connectionState = CONN_DISCONNECTED;
+    socketConnected = false;
     
     if (connectionCallback) {
         connectionCallback(false);
@@ -177,22 +293,8 @@ void UniversalHarbingerClient::disconnect() {
 
 // ========================== 状态查询 ==========================
 bool UniversalHarbingerClient::isConnected() const {
-    // 首先检查内部状态
-    if (connectionState < CONN_CONNECTED) {
-        return false;
-    }
-    
-    // 然后检查socket状态
-    bool socketConnected = client.connected();
-    
-    // 如果socket报告未连接，立即更新状态
-    if (!socketConnected && connectionState >= CONN_CONNECTED) {
-        // 注意：这里不能直接修改状态，因为是const方法
-        // 但可以返回false，让调用者知道连接已断开
-        return false;
-    }
-    
-    return socketConnected;
+    // socket状态由handleAllNetworkOperations每轮查询一次，这里不再走SPI
+    return connectionState >= CONN_CONNECTED && socketConnected;
 }
 
 ConnectionState UniversalHarbingerClient::getConnectionState() const {
@@ -206,10 +308,60 @@ String UniversalHarbingerClient::getLocalIP() const {
 
 String UniversalHarbingerClient::getServerInfo() const {
     String info = "服务器: " + String(serverIP[0]) + "." + String(serverIP[1]) + "." + String(serverIP[2]) + "." + String(serverIP[3]) + ":" + String(serverPort) + "\n";
-    info += "状态: " + String(client.connected() ? "已连接" : "未连接");
+    info += "状态: " + String(isConnected() ? "已连接" : "未连接");
     return info;
 }
 
+unsigned long UniversalHarbingerClient::getRtt() const {
+    return rttValid ? (unsigned long)((srtt8 + 4) >> 3) : 0;
+}
+
+unsigned long UniversalHarbingerClient::getRttJitter() const {
+    return rttValid ? (unsigned long)((rttvar4 + 2) >> 2) : 0;
+}
+
+#if HARBINGER_CLOCK_SYNC
+bool UniversalHarbingerClient::isClockSynced() const {
+    return clockSynced;
+}
+
+bool UniversalHarbingerClient::clockSampleDue(unsigned long now) const {
+    return !clockSynced || now - lastClockSample >= CLOCK_SYNC_INTERVAL;
+}
+
+unsigned long UniversalHarbingerClient::getServerTime() const {
+    unsigned long now = millis();
+    long elapsed = (long)(now - clockRefLocal);
+    return now + clockOffset + (long)(clockDriftPpm * 1e-6f * elapsed);
+}
+
+unsigned long UniversalHarbingerClient::serverToLocal(unsigned long serverMs) const {
+    // 先按固定偏移估算本地时刻，再用该时刻的漂移修正；漂移项变化很慢，一次足够
+    unsigned long local = serverMs - clockOffset;
+    long elapsed = (long)(local - clockRefLocal);
+    return serverMs - clockOffset - (long)(clockDriftPpm * 1e-6f * elapsed);
+}
+
+unsigned long UniversalHarbingerClient::getDispatchLateness() const {
+    return dispatchLateness > 0 ? dispatchLateness : 0;
+}
+#else
+// 未启用时钟同步：没有服务器时间基准，按本地时间处理
+bool UniversalHarbingerClient::isClockSynced() const { return false; }
+bool UniversalHarbingerClient::clockSampleDue(unsigned long now) const { return false; }
+unsigned long UniversalHarbingerClient::getServerTime() const { return millis(); }
+unsigned long UniversalHarbingerClient::serverToLocal(unsigned long serverMs) const { return serverMs; }
+unsigned long UniversalHarbingerClient::getDispatchLateness() const { return 0; }
+#endif
+
+unsigned long UniversalHarbingerClient::getAckTimeout() const {
+    if (!rttValid) return HEARTBEAT_ACK_TIMEOUT_INIT;
+    unsigned long timeout = getRtt() + 4 * getRttJitter();
+    if (timeout < HEARTBEAT_ACK_TIMEOUT_MIN) return HEARTBEAT_ACK_TIMEOUT_MIN;
+    if (timeout > HEARTBEAT_ACK_TIMEOUT_MAX) return HEARTBEAT_ACK_TIMEOUT_MAX;
+    return timeout;
+}
+
 // ========================== 回调设置 ==========================
 void UniversalHarbingerClient::setConnectionCallback(ConnectionChangeCallback callback) {
     this->connectionCallback = callback;
@@ -219,80 +371,435 @@ void UniversalHarbingerClient::setMessageCallback(MessageReceivedCallback callba
     this->messageCallback = callback;
 }
 
+void UniversalHarbingerClient::setFrameCallback(FrameReceivedCallback callback) {
+#if HARBINGER_BINARY_FRAMES
+    this->frameCallback = callback;
+#endif
+}
+
+void UniversalHarbingerClient::setSendHook(SendHookCallback hook) {
+    this->sendHook = hook;
+}
+
+void UniversalHarbingerClient::setRegisterParams(const String& params) {
+    this->registerParams = params;
+}
+
+void UniversalHarbingerClient::markBootPhase(const __FlashStringHelper* name) {
+    if (bootReported) return;   // 重连不是启动
+    if (bootPhases.length() > 0) bootPhases += ';';
+    bootPhases += name;
+    bootPhases += ':';
+    bootPhases += String(millis());
+}
+
 // ========================== 消息处理 ==========================
 void UniversalHarbingerClient::sendRegistration() {
     String deviceList = buildDeviceList();
     String msg = "$[INFO]@" + controllerId + "{^REGISTER^(type=" + deviceType + ",devices=" + 
-                deviceList + ",version=2.0,client_id=" + controllerId + ")}#";
+                deviceList + ",version=2.0,client_id=" + controllerId;
+#if HARBINGER_BINARY_FRAMES
+    if (frameCallback) {
+        msg += ",frame=" HBF_FRAME_TAG;   // 声明支持二进制帧，服务器在REGISTER_CONFIRM中确认
+    }
+#endif
+    if (registerParams.length() > 0) {
+        msg += "," + registerParams;
+    }
+    if (bootPhases.length() > 0) {
+        msg += ",boot=" + bootPhases;
+        msg += ",free_ram=" + String(ArduinoSystemHelper::freeMemory());   // 启动完成后的空闲RAM
+    }
+    msg += ")}#";
     
     DEBUG_PRINT(F("发送: "));
     DEBUG_PRINTLN(msg);
     
     client.print(msg);
+    NET_STAT(spiOps++);
+    lastTxTime = millis();
 }
 
 void UniversalHarbingerClient::sendHeartbeat() {
     if (!isConnected()) return;
     
-    if (millis() - lastHeartbeat < HEARTBEAT_INTERVAL) return;
-    lastHeartbeat = millis();
+    unsigned long now = millis();
+    
+    if (awaitingAck) {
+        if (now - heartbeatSentAt < getAckTimeout()) return;
+        awaitingAck = false;
+        
+        // 等待期间一个字节都没收到才算丢失；收到过数据说明对端活着，只是ACK还没到
+        if ((long)(lastRxTime - heartbeatSentAt) < 0) {
+            missedAcks++;
+            NET_STAT(acksMissed++);
+            DEBUG_PRINT(F("心跳ACK超时 "));
+            DEBUG_PRINTLN(missedAcks);
+            
+            // 半开连接时client.connected()仍为真，只能靠ACK判断
+            if (missedAcks >= HEARTBEAT_MAX_MISSED) {
+                DEBUG_PRINTLN(F("心跳ACK连续丢失，判定连接失效"));
+                connectionLost();
+                return;
+            }
+            // 丢失后立即补发，不等心跳间隔
+        } else if (now - lastTxTime < HEARTBEAT_INTERVAL && now - lastRxTime < HEARTBEAT_INTERVAL) {
+            return;
+        }
+    } else {
+        // 两个方向都有流量：连接显然活着，对端也知道我们活着，省掉这次心跳
+        // （时钟未同步或样本过旧时照发，心跳同时是时钟同步的样本）
+        if (now - lastTxTime < HEARTBEAT_INTERVAL && now - lastRxTime < HEARTBEAT_INTERVAL &&
+            !clockSampleDue(now)) {
+            if (now - lastHeartbeat >= HEARTBEAT_INTERVAL) {
+                lastHeartbeat = now;
+                NET_STAT(heartbeatsSkipped++);
+            }
+            return;
+        }
+    }
+    lastHeartbeat = now;
     
     String msg = "$[INFO]@" + controllerId + "{^HEARTBEAT^(client_id=" + 
-                controllerId + ",timestamp=" + String(millis()) + ",status=OK)}#";
+                controllerId + ",timestamp=" + String(now) + ",status=OK)}#";
     
     DEBUG_PRINT(F("发送: "));
     DEBUG_PRINTLN(msg);
     
     // 尝试发送，如果失败则断开连接
+    NET_STAT(spiOps++);
     if (!client.print(msg)) {
         DEBUG_PRINTLN(F("心跳发送失败，连接可能已断开"));
-        client.stop();
-        connectionState = CONN_CONNECTING;
-        lastReconnectAttempt = 0;
-        if (connectionCallback) {
-            connectionCallback(false);
+        connectionLost();
+        return;
+    }
+    lastTxTime = now;
+    heartbeatSentAt = now;
+    awaitingAck = true;
+    NET_STAT(heartbeatsSent++);
+}
+
+/**
+ * @brief HEARTBEAT_ACK：服务器回显timestamp时只接受待确认心跳的ACK，
+ *        未回显时按待确认心跳的发送时间计算RTT
+ */
+void UniversalHarbingerClient::checkHeartbeatAck(const String& message) {
+    if (message.indexOf("HEARTBEAT_ACK") == -1) return;
+    
+    missedAcks = 0;
+    if (!awaitingAck) return;   // 超时后才到的ACK不作为RTT样本
+    
+    int pos = message.indexOf("timestamp=");
+    if (pos != -1 && strtoul(message.c_str() + pos + 10, nullptr, 10) != heartbeatSentAt) {
+        return;                 // 更早心跳的迟到ACK
+    }
+    awaitingAck = false;
+    unsigned long now = millis();
+    updateRtt(now - heartbeatSentAt);
+    
+#if HARBINGER_CLOCK_SYNC
+    pos = message.indexOf("server_time=");
+    if (pos != -1) {
+        updateClock(strtoul(message.c_str() + pos + 12, nullptr, 10), heartbeatSentAt, now);
+    }
+#endif
+}
+
+#if HARBINGER_CLOCK_SYNC
+/**
+ * @brief 时钟同步（NTP式）：假定往返对称，服务器打时间戳的时刻是往返中点。
+ *        排队只会让RTT变大，RTT小的样本偏移准；相隔足够久的两个采用样本给出漂移
+ */
+void UniversalHarbingerClient::updateClock(unsigned long serverTime, unsigned long sentAt, unsigned long now) {
+    ClockSample& sample = clockSamples[clockSampleNext];
+    sample.rtt = now - sentAt;
+    sample.local = sentAt + sample.rtt / 2;
+    sample.offset = (long)(serverTime - sample.local);
+    clockSampleNext = (clockSampleNext + 1) % CLOCK_FILTER_SIZE;
+    if (clockSampleCount < CLOCK_FILTER_SIZE) clockSampleCount++;
+    lastClockSample = now;
+    
+    // 样本误差 = RTT/2 + 老化（漂移未知时按最大漂移计，已知时按残余漂移计），取最小者
+    float agePpm = driftValid ? CLOCK_RESIDUAL_PPM : CLOCK_DRIFT_MAX_PPM;
+    const ClockSample* best = NULL;
+    float bestError = 0;
+    for (uint8_t i = 0; i < clockSampleCount; i++) {
+        float error = clockSamples[i].rtt / 2.0f + (now - clockSamples[i].local) * agePpm * 1e-6f;
+        if (best == NULL || error < bestError) {
+            best = &clockSamples[i];
+            bestError = error;
         }
     }
+    
+    if (!clockSynced) {
+        driftAnchorLocal = best->local;
+        driftAnchorOffset = best->offset;
+    } else if ((long)(best->local - driftAnchorLocal) >= CLOCK_DRIFT_MIN_SPAN) {   // 采用的可能是更早的样本
+        float ppm = (best->offset - driftAnchorOffset) * 1e6f / (float)(best->local - driftAnchorLocal);
+        ppm = constrain(ppm, -CLOCK_DRIFT_MAX_PPM, CLOCK_DRIFT_MAX_PPM);
+        clockDriftPpm = driftValid ? clockDriftPpm + (ppm - clockDriftPpm) / 4 : ppm;
+        driftValid = true;
+        driftAnchorLocal = best->local;
+        driftAnchorOffset = best->offset;
+    }
+    
+    clockRefLocal = best->local;
+    clockOffset = best->offset;
+    clockRtt = best->rtt;
+    clockSynced = true;
+}
+#endif
+
+void UniversalHarbingerClient::updateRtt(unsigned long rtt) {
+    NET_STAT(lastRtt = rtt);
+    if (!rttValid) {
+        srtt8 = (long)rtt << 3;
+        rttvar4 = (long)rtt << 1;       // RTTVAR = RTT/2
+        rttValid = true;
+        return;
+    }
+    long err = (long)rtt - (srtt8 >> 3);
+    srtt8 += err;                       // SRTT += err/8
+    if (err < 0) err = -err;
+    rttvar4 += err - (rttvar4 >> 2);    // RTTVAR += (|err| - RTTVAR)/4
+}
+
+void UniversalHarbingerClient::connectionLost() {
+    client.stop();
+    NET_STAT(spiOps++);
+    socketConnected = false;
+    awaitingAck = false;
+    missedAcks = 0;
+    connectionState = CONN_CONNECTING;
+    lastReconnectAttempt = 0;
+    if (connectionCallback) {
+        connectionCallback(false);
+    }
 }
 
 void UniversalHarbingerClient::handleIncomingData() {
-    if (!client.connected()) return;
-    
-    static String buffer = "";
+    int available = client.available();
+    NET_STAT(spiOps++);
+    if (available <= 0) return;
+    lastRxTime = millis();
     
-    while (client.available()) {
-        char c = client.read();
+    // 成块读取；超出本轮预算时剩余数据留在W5100缓冲区，下一轮继续（至少读一块，保证前进）
+    uint8_t chunk[NETWORK_READ_CHUNK];
+    bool first = true;
+    while (available > 0) {
+        if (!first && micros() - passStart >= NETWORK_LOOP_BUDGET_US) {
+            NET_STAT(budgetOverruns++);
+            return;
+        }
+        first = false;
+        
+        int n = client.read(chunk, available < NETWORK_READ_CHUNK ? available : NETWORK_READ_CHUNK);
+        NET_STAT(spiOps++);
+        if (n <= 0) return;
+        available -= n;
         
-        // 忽略换行符和回车符
-        if (c == '\n' || c == '\r') {
-            continue;
+        for (int i = 0; i < n; i++) {
+            handleIncomingByte((char)chunk[i]);
         }
+    }
+}
+
+void UniversalHarbingerClient::handleIncomingByte(char c) {
+#if HARBINGER_BINARY_FRAMES
+    // 二进制帧：协商成功后，在两条ASCII消息之间以同步字节开始
+    if (binaryFraming && (frameParser.isReceiving() || (rxBuffer.length() == 0 && (uint8_t)c == HBF_SYNC))) {
+        int8_t result = frameParser.feed((uint8_t)c);
+        if (result == HBF_PARSE_DONE && frameCallback) {
+            frameCallback(frameParser.getFrame());
+        } else if (result == HBF_PARSE_ERROR) {
+            DEBUG_PRINTLN(F("二进制帧校验失败，已丢弃"));
+        }
+        return;
+    }
+#endif
+    
+    // 忽略换行符和回车符
+    if (c == '\n' || c == '\r') {
+        return;
+    }
+    
+    rxBuffer += c;
+    
+    // 检查是否收到完整消息 (以#结尾)
+    if (c == '#' && rxBuffer.startsWith("$")) {
+        dispatchMessage(rxBuffer);
+        rxBuffer = "";
+    }
+    
+    // 防止缓冲区溢出
+    if (rxBuffer.length() > MAX_MESSAGE_LENGTH) {
+        DEBUG_PRINT(F("消息过长: "));
+        DEBUG_PRINTLN(rxBuffer.length());
+        rxBuffer = "";
+    }
+}
+
+#if HARBINGER_GROUP_COMMANDS
+/**
+ * @brief 组播数据报：每个数据报是一条完整的ASCII消息，本轮预算内处理完所有已到达的数据报
+ */
+void UniversalHarbingerClient::handleGroupData() {
+    bool first = true;
+    while (first || micros() - passStart < NETWORK_LOOP_BUDGET_US) {
+        first = false;
         
-        buffer += c;
+        int size = groupUdp.parsePacket();
+        NET_STAT(spiOps++);
+        if (size <= 0) return;
+        groupReceived++;
+        if (size > MAX_MESSAGE_LENGTH) continue;   // 下一次parsePacket丢弃剩余内容
         
-        // 检查是否收到完整消息 (以#结尾)
-        if (c == '#' && buffer.startsWith("$")) {
-            // 触发消息回调
-            if (messageCallback) {
-                messageCallback(buffer);
+        String message;
+        message.reserve(size);
+        uint8_t chunk[NETWORK_READ_CHUNK];
+        int n;
+        while ((n = groupUdp.read(chunk, sizeof(chunk))) > 0) {
+            NET_STAT(spiOps++);
+            for (int i = 0; i < n; i++) {
+                message += (char)chunk[i];
             }
-            buffer = "";
         }
         
-        // 防止缓冲区溢出
-        if (buffer.length() > MAX_MESSAGE_LENGTH) {
-            DEBUG_PRINT(F("消息过长: "));
-            DEBUG_PRINTLN(buffer.length());
-            buffer = "";
+        message.trim();
+        if (message.startsWith("$") && message.endsWith("#")) {
+            dispatchMessage(message);
+        }
+    }
+}
+#endif
+
+void UniversalHarbingerClient::dispatchMessage(const String& message) {
+#if HARBINGER_GROUP_COMMANDS
+    // 组命令（带gseq）服务器可能经组播重复发送、也可能同时经TCP补发，只执行一次
+    if (message.indexOf("gseq=") != -1 && !acceptGroupMessage(message)) return;
+#endif
+    
+#if HARBINGER_CLOCK_SYNC
+    // at=<服务器时刻>：换算成本地时刻，到点才执行（到得太晚或未同步时立即执行并报告）
+    int pos = message.indexOf(",at=");
+    if (pos == -1) pos = message.indexOf("(at=");
+    if (pos != -1 && (message.indexOf("[HARD]") != -1 || message.indexOf("[GAME]") != -1)) {
+        if (!clockSynced) {
+            atReport = F(",at_error=nosync");
+            deliverMessage(message);
+            atReport = "";
+            return;
+        }
+        
+        unsigned long localAt = serverToLocal(strtoul(message.c_str() + pos + 4, nullptr, 10));
+        long ahead = (long)(localAt - millis());
+        if (ahead > 0 && ahead <= SCHEDULE_MAX_AHEAD) {
+            for (uint8_t i = 0; i < SCHEDULE_SLOTS; i++) {
+                if (scheduledMessages[i].length() == 0) {
+                    scheduledMessages[i] = message;
+                    scheduledAt[i] = localAt;
+                    return;
+                }
+            }
+            DEBUG_PRINTLN(F("定时消息槽位已满，立即执行"));
+        }
+        deliverScheduled(message, localAt);
+        return;
+    }
+#endif
+    
+    deliverMessage(message);
+}
+
+void UniversalHarbingerClient::deliverMessage(const String& message) {
+    checkRegisterConfirm(message);
+    checkHeartbeatAck(message);
+    
+    // 触发消息回调
+    if (messageCallback) {
+        messageCallback(message);
+    }
+}
+
+#if HARBINGER_CLOCK_SYNC
+/**
+ * @brief 执行定时消息：期间发出的GAME/HARD应答附带at_error（实际执行比约定时刻晚的毫秒数），
+ *        启动的环节按getDispatchLateness()把起点对齐到约定时刻
+ */
+void UniversalHarbingerClient::deliverScheduled(const String& message, unsigned long localAt) {
+    dispatchLateness = (long)(millis() - localAt);
+    lastAtError = dispatchLateness;
+    scheduledExecuted++;
+    atReport = ",at_error=" + String(dispatchLateness);
+    
+    deliverMessage(message);
+    
+    atReport = "";
+    dispatchLateness = 0;
+}
+
+void UniversalHarbingerClient::runScheduledMessages() {
+    for (uint8_t i = 0; i < SCHEDULE_SLOTS; i++) {
+        if (scheduledMessages[i].length() > 0 && (long)(millis() - scheduledAt[i]) >= 0) {
+            String message = scheduledMessages[i];
+            scheduledMessages[i] = "";
+            deliverScheduled(message, scheduledAt[i]);
         }
     }
 }
+#endif
+
+#if HARBINGER_GROUP_COMMANDS
+/**
+ * @brief 组命令过滤：targets=C101;C302 不含本控制器时忽略（缺省为整组），
+ *        最高序号以下GROUP_SEQ_WINDOW个序号按位图去重，乱序到达的未执行序号照常执行
+ */
+bool UniversalHarbingerClient::acceptGroupMessage(const String& message) {
+    int pos = message.indexOf("targets=");
+    if (pos != -1) {
+        int end = message.indexOf(',', pos);
+        if (end == -1) end = message.indexOf(')', pos);
+        String targets = ";" + message.substring(pos + 8, end) + ";";
+        if (targets.indexOf(";" + controllerId + ";") == -1) return false;
+    }
+    
+    uint32_t seq = strtoul(message.c_str() + message.indexOf("gseq=") + 5, nullptr, 10);
+    uint32_t back = groupSeq - seq;
+    if (groupSeqValid && (int32_t)back > 0 && back < GROUP_SEQ_WINDOW) {
+        // 窗口内较早的序号：乱序到达，未执行过的照常执行
+        uint32_t bit = 1UL << back;
+        if (groupSeen & bit) {
+            groupDuplicates++;
+            return false;
+        }
+        groupSeen |= bit;
+    } else if (groupSeqValid && back == 0) {
+        groupDuplicates++;
+        return false;
+    } else {
+        // 更新的序号：窗口前移；比窗口更早的视为服务器重启后的新序号，重新开始
+        uint32_t ahead = seq - groupSeq;
+        if (groupSeqValid && (int32_t)ahead > 0 && ahead < GROUP_SEQ_WINDOW) {
+            groupSeen = (groupSeen << ahead) | 1;
+        } else {
+            groupSeen = 1;
+        }
+        groupSeq = seq;
+        groupSeqValid = true;
+    }
+    groupApplied++;
+    return true;
+}
+#endif
 
 // ========================== 消息发送 ==========================
 bool UniversalHarbingerClient::sendMessage(const String& message) {
+    if (sendHook && sendHook((const uint8_t*)message.c_str(), message.length())) return true;
     if (!isConnected()) return false;
     
     client.print(message);
+    NET_STAT(spiOps++);
+    lastTxTime = millis();   // 任何发出的消息都等同于一次心跳
     return true;
 }
 
@@ -302,7 +809,11 @@ bool UniversalHarbingerClient::sendINFOMessage(const String& command, const Stri
 }
 
 bool UniversalHarbingerClient::sendGAMEResponse(const String& command, const String& result) {
+#if HARBINGER_CLOCK_SYNC
+    String msg = "$[GAME]@" + controllerId + "{^" + command + "^(result=" + result + atReport + ")}#";
+#else
     String msg = "$[GAME]@" + controllerId + "{^" + command + "^(result=" + result + ")}#";
+#endif
     
     DEBUG_PRINT(F("发送: "));
     DEBUG_PRINTLN(msg);
@@ -311,7 +822,11 @@ bool UniversalHarbingerClient::sendGAMEResponse(const String& command, const Str
 }
 
 bool UniversalHarbingerClient::sendHARDResponse(const String& command, const String& result) {
+#if HARBINGER_CLOCK_SYNC
+    String msg = "$[HARD]@" + controllerId + "{^" + command + "^(result=" + result + atReport + ")}#";
+#else
     String msg = "$[HARD]@" + controllerId + "{^" + command + "^(result=" + result + ")}#";
+#endif
     
     DEBUG_PRINT(F("发送: "));
     DEBUG_PRINTLN(msg);
@@ -319,15 +834,83 @@ bool UniversalHarbingerClient::sendHARDResponse(const String& command, const Str
     return sendMessage(msg);
 }
 
+#if HARBINGER_BINARY_FRAMES
+bool UniversalHarbingerClient::isBinaryFraming() const {
+    return binaryFraming;
+}
+
+bool UniversalHarbingerClient::sendFrame(uint8_t type, uint8_t command, const uint8_t* payload, uint8_t length) {
+    // 整帧一次写入，W5100只产生一个数据包
+    uint8_t frame[HBF_MAX_PAYLOAD + HBF_OVERHEAD];
+    uint8_t size = hbfEncode(type, command, payload, length, frame, sizeof(frame));
+    if (size == 0) return false;
+    
+    if (sendHook && sendHook(frame, size)) return true;
+    if (!binaryFraming || !isConnected()) return false;
+    
+    NET_STAT(spiOps++);
+    if (client.write(frame, size) != size) return false;
+    lastTxTime = millis();
+    return true;
+}
+#else
+// 未编译二进制帧：调用方走ASCII
+bool UniversalHarbingerClient::isBinaryFraming() const { return false; }
+bool UniversalHarbingerClient::sendFrame(uint8_t type, uint8_t command, const uint8_t* payload, uint8_t length) { return false; }
+#endif
+
+void UniversalHarbingerClient::checkRegisterConfirm(const String& message) {
+    if (message.indexOf("REGISTER_CONFIRM") == -1) return;
+    
+    registerParams = "";   // 附加参数只随确认过的REGISTER上报一次
+    bootPhases = "";
+    bootReported = true;
+    
+#if HARBINGER_BINARY_FRAMES
+    // 双方都声明支持才启用；服务器未回frame=时保持ASCII
+    binaryFraming = (frameCallback != nullptr) && message.indexOf("frame=" HBF_FRAME_TAG) != -1;
+    frameParser.reset();
+#endif
+    
+    DEBUG_PRINT(F("帧格式: "));
+    DEBUG_PRINTLN(isBinaryFraming() ? F("二进制") : F("ASCII"));
+}
+
 // ========================== 主循环处理 ==========================
 void UniversalHarbingerClient::handleAllNetworkOperations() {
+#if HARBINGER_NET_STATS
+    // 上一轮（含loop其他地方的发送）的socket调用次数
+    lastPassSpiOps = spiOps;
+    if (spiOps > maxPassSpiOps) maxPassSpiOps = spiOps;
+    spiOps = 0;
+#endif
+    passStart = micros();
+    
+#if HARBINGER_CLOCK_SYNC
+    // 定时消息最先检查，执行时刻只受loop周期影响
+    runScheduledMessages();
+#endif
+    
+#if HARBINGER_GROUP_COMMANDS
+    // 组播不依赖TCP会话，服务器断开期间组命令照常执行
+    if (groupJoined) {
+        handleGroupData();
+    }
+#endif
+    
     // 状态机处理连接
     switch (connectionState) {
         case CONN_STABILIZING:
-            // 等待网络稳定
-            if (millis() - ethernetInitTime >= ETHERNET_STABILIZE_TIME) {
-                connectionState = CONN_CONNECTING;
-                lastReconnectAttempt = 0;  // 重置重连计时器
+            // 等待链路：W5200/W5500链路一通就开始连接；W5100不报告链路状态，按ETHERNET_STABILIZE_TIME等待
+            if (millis() - lastLinkPoll >= ETHERNET_LINK_POLL_INTERVAL) {
+                lastLinkPoll = millis();
+                EthernetLinkStatus link = Ethernet.linkStatus();
+                if (link == LinkON ||
+                    (link == Unknown && millis() - ethernetInitTime >= ETHERNET_STABILIZE_TIME)) {
+                    markBootPhase(F("link"));
+                    connectionState = CONN_CONNECTING;
+                    lastReconnectAttempt = 0;  // 重置重连计时器
+                }
             }
             break;
             
@@ -337,8 +920,10 @@ void UniversalHarbingerClient::handleAllNetworkOperations() {
             break;
             
         case CONN_CONNECTED:
-            // 处理已连接状态
-            if (!client.connected()) {
+            // 处理已连接状态：每轮只查询一次socket状态，其他调用者读缓存
+            socketConnected = client.connected();
+            NET_STAT(spiOps++);
+            if (!socketConnected) {
                 DEBUG_PRINTLN(F("检测到连接断开"));
                 connectionState = CONN_CONNECTING;
                 lastReconnectAttempt = 0;  // 立即重连
@@ -346,22 +931,7 @@ void UniversalHarbingerClient::handleAllNetworkOperations() {
                     connectionCallback(false);
                 }
             } else {
-                // 额外检查：如果长时间没有收到服务器响应，认为连接已断开
-                if (millis() - lastHeartbeat > HEARTBEAT_INTERVAL * 3) {
-                    // 测试连接是否真的还活着
-                    if (client.available() == 0 && !client.connected()) {
-                        DEBUG_PRINTLN(F("连接超时，强制重连"));
-                        client.stop();
-                        connectionState = CONN_CONNECTING;
-                        lastReconnectAttempt = 0;
-                        if (connectionCallback) {
-                            connectionCallback(false);
-                        }
-                        break;
-                    }
-                }
-                
-                // 处理消息和心跳
+                // 处理消息和心跳（对端失联由心跳ACK判断，见sendHeartbeat）
                 handleIncomingData();
                 sendHeartbeat();
             }
@@ -377,6 +947,11 @@ void UniversalHarbingerClient::handleAllNetworkOperations() {
         default:
             break;
     }
+    
+#if HARBINGER_NET_STATS
+    lastPassUs = micros() - passStart;
+    if (lastPassUs > maxPassUs) maxPassUs = lastPassUs;
+#endif
 }
 
 // ========================== 工具方法 ==========================
@@ -403,4 +978,71 @@ void UniversalHarbingerClient::printStatus() {
     Serial.println(getLocalIP());
     Serial.print(F("连接: "));
     Serial.println(isConnected() ? F("ON") : F("OFF"));
+    Serial.print(F("帧格式: "));
+    Serial.println(isBinaryFraming() ? F("二进制") : F("ASCII"));
+    Serial.print(F("RTT: "));
+    Serial.print(getRtt());
+    Serial.print(F("ms  抖动: "));
+    Serial.print(getRttJitter());
+    Serial.print(F("ms  ACK超时: "));
+    Serial.print(getAckTimeout());
+    Serial.println(F("ms"));
+#if HARBINGER_NET_STATS
+    Serial.print(F("最近RTT: "));
+    Serial.print(lastRtt);
+    Serial.print(F("ms  心跳: 发出"));
+    Serial.print(heartbeatsSent);
+    Serial.print(F(" 省略"));
+    Serial.print(heartbeatsSkipped);
+    Serial.print(F(" ACK丢失"));
+    Serial.println(acksMissed);
+    Serial.print(F("SPI: 上轮"));
+    Serial.print(lastPassSpiOps);
+    Serial.print(F("次 最多"));
+    Serial.print(maxPassSpiOps);
+    Serial.print(F("次  耗时: 上轮"));
+    Serial.print(lastPassUs);
+    Serial.print(F("us 最长"));
+    Serial.print(maxPassUs);
+    Serial.print(F("us  预算"));
+    Serial.print(NETWORK_LOOP_BUDGET_US);
+    Serial.print(F("us 超出"));
+    Serial.println(budgetOverruns);
+#endif
+#if HARBINGER_GROUP_COMMANDS
+    if (groupJoined) {
+        Serial.print(F("组播: "));
+        Serial.print(groupIP);
+        Serial.print(F(":"));
+        Serial.print(groupPort);
+        Serial.print(F("  收到"));
+        Serial.print(groupReceived);
+        Serial.print(F(" 执行"));
+        Serial.print(groupApplied);
+        Serial.print(F(" 重复"));
+        Serial.print(groupDuplicates);
+        Serial.print(F("  序号"));
+        Serial.println(groupSeq);
+    }
+#endif
+#if HARBINGER_CLOCK_SYNC
+    Serial.print(F("时钟: "));
+    if (clockSynced) {
+        Serial.print(F("偏移"));
+        Serial.print(clockOffset);
+        Serial.print(F("ms 漂移"));
+        Serial.print(clockDriftPpm, 0);
+        Serial.print(F("ppm 误差≤"));
+        Serial.print(clockRtt / 2);
+        Serial.print(F("ms 样本"));
+        Serial.print(clockSampleCount);
+    } else {
+        Serial.print(F("未同步"));
+    }
+    Serial.print(F("  定时执行"));
+    Serial.print(scheduledExecuted);
+    Serial.print(F(" 最近误差"));
+    Serial.print(lastAtError);
+    Serial.println(F("ms"));
+#endif
 } 
\ No newline at end of file
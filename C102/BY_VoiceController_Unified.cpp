@@ -12,6 +12,15 @@
 
 BY_VoiceModule_Unified::BY_VoiceModule_Unified() {
     serialPort = nullptr;
+    preparedSong = 0;
+    preparedTime = 0;
+    queryMask = 0;
+    queryInFlight = 0;
+    queryTime = 0;
+    rxLength = 0;
+    framesSent = 0;
+    framesSuppressed = 0;
+    invalidateState();
 }
 
 void BY_VoiceModule_Unified::init(Stream* serial) {
@@ -43,6 +52,7 @@ void BY_VoiceModule_Unified::sendFrameData(byte* pData) {
     // 发送数据
     if (serialPort != nullptr) {
         serialPort->write(sendBuffer, datLen + 2);
+        framesSent++;
     }
 }
 
@@ -73,26 +83,39 @@ void BY_VoiceModule_Unified::sendCommand(byte cmdType, byte* param) {
 
 void BY_VoiceModule_Unified::play() {
     sendCommand(BY_Commands::CMD_PLAY);
+    preparedSong = 0;  // 选曲已被播放消耗
+    state.playState = BY_STATE_PLAYING;
 }
 
 void BY_VoiceModule_Unified::pause() {
     sendCommand(BY_Commands::CMD_PAUSE);
+    state.playState = BY_STATE_PAUSED;
 }
 
 void BY_VoiceModule_Unified::stop() {
     sendCommand(BY_Commands::CMD_STOP);
+    preparedSong = 0;
+    state.playState = BY_STATE_STOPPED;
 }
 
 void BY_VoiceModule_Unified::nextSong() {
     sendCommand(BY_Commands::CMD_NEXT);
+    preparedSong = 0;
+    state.track = -1;
+    state.playState = BY_STATE_PLAYING;
 }
 
 void BY_VoiceModule_Unified::prevSong() {
     sendCommand(BY_Commands::CMD_PREV);
+    preparedSong = 0;
+    state.track = -1;
+    state.playState = BY_STATE_PLAYING;
 }
 
 void BY_VoiceModule_Unified::reset() {
     sendCommand(BY_Commands::CMD_RESET);
+    preparedSong = 0;
+    invalidateState();  // 复位后模块恢复默认设置
 }
 
 void BY_VoiceModule_Unified::fastForward() {
@@ -107,6 +130,11 @@ void BY_VoiceModule_Unified::fastBackward() {
 
 void BY_VoiceModule_Unified::setVolume(byte volume) {
     if (volume > 30) volume = 30;
+    if (state.volume == volume) {
+        framesSuppressed++;
+        return;
+    }
+    state.volume = volume;
     byte param[2];
     param[0] = 4; // 数据长度
     param[1] = volume;
@@ -115,6 +143,11 @@ void BY_VoiceModule_Unified::setVolume(byte volume) {
 
 void BY_VoiceModule_Unified::setEQ(byte eq) {
     if (eq > 5) eq = 5;
+    if (state.eq == eq) {
+        framesSuppressed++;
+        return;
+    }
+    state.eq = eq;
     byte param[2];
     param[0] = 4; // 数据长度
     param[1] = eq;
@@ -123,6 +156,11 @@ void BY_VoiceModule_Unified::setEQ(byte eq) {
 
 void BY_VoiceModule_Unified::setCycle(byte cycle) {
     if (cycle > 4) cycle = 4;
+    if (state.cycle == cycle) {
+        framesSuppressed++;
+        return;
+    }
+    state.cycle = cycle;
     byte param[2];
     param[0] = 4; // 数据长度
     param[1] = cycle;
@@ -137,6 +175,8 @@ void BY_VoiceModule_Unified::selectSong(int songID) {
     param[1] = songID >> 8;
     param[2] = songID;
     sendCommand(BY_Commands::SEL_SONG, param);
+    preparedSong = 0;
+    state.track = songID;
 }
 
 void BY_VoiceModule_Unified::selectFolderSong(byte folderID, byte songID) {
@@ -145,20 +185,123 @@ void BY_VoiceModule_Unified::selectFolderSong(byte folderID, byte songID) {
     param[1] = folderID;
     param[2] = songID;
     sendCommand(BY_Commands::SEL_FdSong, param);
+    preparedSong = 0;
+    state.track = -1;  // 文件夹曲目与全局曲目号不对应
 }
 
 void BY_VoiceModule_Unified::playSong(int songID) {
-    selectSong(songID);
-    delay(100);  // 等待选择完成
+    if (preparedSong == songID && songID != 0) {
+        // 已预选：只在预选帧刚发出时补足剩余等待
+        unsigned long settled = millis() - preparedTime;
+        if (settled < BY_SELECT_SETTLE_MS) {
+            delay(BY_SELECT_SETTLE_MS - settled);
+        }
+    } else {
+        selectSong(songID);
+        delay(BY_SELECT_SETTLE_MS);  // 等待选择完成
+    }
     play();
 }
 
+void BY_VoiceModule_Unified::prepareSong(int songID) {
+    selectSong(songID);
+    if (songID >= 1 && songID <= 9999) {
+        preparedSong = songID;
+        preparedTime = millis();
+    }
+}
+
+// ========================== 状态缓存与查询 ==========================
+
+void BY_VoiceModule_Unified::invalidateState() {
+    state.volume = BY_VOLUME_UNKNOWN;
+    state.eq = 0xFF;
+    state.cycle = 0xFF;
+    state.playState = BY_STATE_UNKNOWN;
+    state.track = -1;
+}
+
+void BY_VoiceModule_Unified::requestQuery(uint8_t mask) {
+    queryMask |= (mask & BY_QUERY_ALL);
+}
+
+void BY_VoiceModule_Unified::update() {
+    if (serialPort == nullptr) return;
+    
+    // 按行接收应答（0xFF表示本行超长，整行丢弃）
+    while (serialPort->available() > 0) {
+        char c = (char)serialPort->read();
+        if (c == '\r' || c == '\n') {
+            if (rxLength > 0 && rxLength < BY_RX_BUFFER_SIZE) {
+                rxBuffer[rxLength] = '\0';
+                char* end;
+                long value = strtol(rxBuffer, &end, 16);
+                if (*end == '\0') {
+                    handleResponse(value);  // "OK"等非数值应答忽略
+                }
+            }
+            rxLength = 0;
+        } else if (rxLength < BY_RX_BUFFER_SIZE - 1) {
+            rxBuffer[rxLength++] = c;
+        } else {
+            rxLength = 0xFF;
+        }
+    }
+    
+    // 同一时间只有一条查询在等待应答
+    unsigned long now = millis();
+    if (queryInFlight != 0 && now - queryTime >= BY_QUERY_TIMEOUT_MS) {
+        queryInFlight = 0;
+    }
+    if (queryInFlight == 0 && queryMask != 0) {
+        uint8_t item = queryMask & (uint8_t)(-queryMask);  // 最低位
+        queryMask &= ~item;
+        
+        byte cmd;
+        switch (item) {
+            case BY_QUERY_STATUS: cmd = BY_Commands::QRY_STATUS; break;
+            case BY_QUERY_VOLUME: cmd = BY_Commands::QRY_VOL; break;
+            case BY_QUERY_EQ:     cmd = BY_Commands::QRY_EQ; break;
+            case BY_QUERY_CYCLE:  cmd = BY_Commands::QRY_CYCLE; break;
+            default:              cmd = BY_Commands::QRY_TRACK; break;
+        }
+        sendCommand(cmd);
+        queryInFlight = item;
+        queryTime = now;
+    }
+}
+
+void BY_VoiceModule_Unified::handleResponse(long value) {
+    switch (queryInFlight) {
+        case BY_QUERY_STATUS:
+            state.playState = (value <= BY_STATE_PAUSED) ? (uint8_t)value : BY_STATE_UNKNOWN;
+            break;
+        case BY_QUERY_VOLUME:
+            state.volume = (value <= 30) ? (uint8_t)value : BY_VOLUME_UNKNOWN;
+            break;
+        case BY_QUERY_EQ:
+            state.eq = (value <= 5) ? (uint8_t)value : 0xFF;
+            break;
+        case BY_QUERY_CYCLE:
+            state.cycle = (value <= 4) ? (uint8_t)value : 0xFF;
+            break;
+        case BY_QUERY_TRACK:
+            state.track = (int)value;
+            break;
+        default:
+            return;  // 没有等待中的查询
+    }
+    queryInFlight = 0;
+}
+
 // ========================== BY_VoiceController_Unified 实现 ==========================
 
 BY_VoiceController_Unified::BY_VoiceController_Unified() {
     softSerial = nullptr;
     initialized = false;
     lastStatusCheck = 0;
+    resetTime = 0;
+    resetSettling = false;
     
     // 默认引脚配置
     softRX = 2; softTX = 3;
@@ -168,11 +311,20 @@ BY_VoiceController_Unified::BY_VoiceController_Unified() {
     for (int i = 0; i < 4; i++) {
         busyStates[i] = false;
         lastBusyStates[i] = false;
+        pendingPrefetch[i] = 0;
+        pendingPlay[i] = 0;
+        lastPlayTime[i] = 0;
+        
+        volumes[i].desired = BY_VOLUME_UNKNOWN;
+        volumes[i].fading = false;
+        volumes[i].stopWhenDone = false;
+        volumes[i].lastFrameTime = 0;
     }
 }
 
 BY_VoiceController_Unified::~BY_VoiceController_Unified() {
     if (softSerial != nullptr) {
+        softSerial->end();
         delete softSerial;
     }
 }
@@ -213,11 +365,12 @@ void BY_VoiceController_Unified::setBusyPins(int pin1, int pin2, int pin3, int p
 bool BY_VoiceController_Unified::begin() {
     Serial.println(F("🚀 初始化统一语音控制器..."));
     
-    // 创建软串口 (按照BY_Demo验证过的配置)
+    // 创建通道4软串口：Timer3逐位发送，不关全局中断（RX引脚不再使用）
     if (softSerial != nullptr) {
+        softSerial->end();
         delete softSerial;
     }
-    softSerial = new SoftwareSerial(softRX, softTX);
+    softSerial = new TimerSerialTX(softTX);
     
     // 初始化串口
     Serial.println(F("🔗 初始化串口:"));
@@ -228,9 +381,7 @@ bool BY_VoiceController_Unified::begin() {
     Serial3.begin(9600);
     Serial.println(F("  ✅ Serial3 (通道3)"));
     softSerial->begin(9600);
-    Serial.print(F("  ✅ SoftwareSerial (通道4) RX="));
-    Serial.print(softRX);
-    Serial.print(F(", TX="));
+    Serial.print(F("  ✅ TimerSerialTX (通道4) TX="));
     Serial.println(softTX);
     
     // 初始化语音模块
@@ -242,7 +393,7 @@ bool BY_VoiceController_Unified::begin() {
     modules[2].init(&Serial3);
     Serial.println(F("  ✅ 通道3 → Serial3"));
     modules[3].init(softSerial);
-    Serial.println(F("  ✅ 通道4 → SoftwareSerial"));
+    Serial.println(F("  ✅ 通道4 → TimerSerialTX"));
     
     // 初始化Busy引脚
     Serial.println(F("📍 初始化Busy引脚:"));
@@ -254,33 +405,61 @@ bool BY_VoiceController_Unified::begin() {
         Serial.println(busyPins[i]);
     }
     
-    // 重置所有模块
+    // 重置所有模块：4路串口互不影响，复位帧同时发出，重启等待交给update
     Serial.println(F("🔄 重置所有语音模块..."));
     for (int i = 0; i < 4; i++) {
         modules[i].reset();
-        delay(500);
     }
+    resetTime = millis();
+    resetSettling = true;
     
     initialized = true;
-    Serial.println(F("✅ 统一语音控制器初始化完成"));
+    Serial.print(F("✅ 统一语音控制器初始化完成 (模块复位后台等待"));
+    Serial.print(BY_RESET_SETTLE_MS);
+    Serial.println(F("ms)"));
     
     return true;
 }
 
+bool BY_VoiceController_Unified::isReady() {
+    // 复位标志只由update()清除，保证排队的播放请求先于之后的新请求发出
+    return initialized && !resetSettling;
+}
+
 // ========================== 语音控制接口 ==========================
 
 void BY_VoiceController_Unified::play(int channel) {
     if (channel < 1 || channel > 4 || !initialized) return;
+    if (!isReady()) {
+        // 模块重启中发出的帧会丢失，排队到复位完成；已排队的曲目保持不变
+        if (pendingPlay[channel - 1] == 0) pendingPlay[channel - 1] = BY_PLAY_RESUME;
+        return;
+    }
     modules[channel - 1].play();
+    lastPlayTime[channel - 1] = millis();
 }
 
 void BY_VoiceController_Unified::stop(int channel) {
     if (channel < 1 || channel > 4 || !initialized) return;
+    if (!isReady()) {
+        pendingPlay[channel - 1] = 0;  // 复位后模块本就处于停止状态，只撤销排队的播放
+        return;
+    }
+    
+    // STOP后模块不保证保留选曲，已预选的歌曲重新排队
+    int prepared = modules[channel - 1].getPreparedSong();
     modules[channel - 1].stop();
+    if (prepared != 0 && pendingPrefetch[channel - 1] == 0) {
+        pendingPrefetch[channel - 1] = prepared;
+    }
 }
 
 void BY_VoiceController_Unified::pause(int channel) {
     if (channel < 1 || channel > 4 || !initialized) return;
+    if (!isReady()) {
+        pendingPlay[channel - 1] = 0;
+        return;
+    }
     modules[channel - 1].pause();
 }
 
@@ -296,12 +475,165 @@ void BY_VoiceController_Unified::prevSong(int channel) {
 
 void BY_VoiceController_Unified::setVolume(int channel, int volume) {
     if (channel < 1 || channel > 4 || !initialized) return;
-    modules[channel - 1].setVolume((byte)volume);
+    
+    VolumeState& v = volumes[channel - 1];
+    v.fading = false;
+    v.desired = (uint8_t)constrain(volume, 0, 30);
+    flushVolume(channel - 1, false);  // 限速窗口内则留给update补发
 }
 
 void BY_VoiceController_Unified::playSong(int channel, int songID) {
     if (channel < 1 || channel > 4 || !initialized) return;
+    if (pendingPrefetch[channel - 1] == songID) {
+        pendingPrefetch[channel - 1] = 0;  // 预选尚未发出，走普通选曲
+    }
+    if (!isReady()) {
+        pendingPlay[channel - 1] = songID;
+        return;
+    }
     modules[channel - 1].playSong(songID);
+    lastPlayTime[channel - 1] = millis();
+}
+
+void BY_VoiceController_Unified::setEQ(int channel, int eq) {
+    if (channel < 1 || channel > 4 || !initialized) return;
+    modules[channel - 1].setEQ((byte)constrain(eq, 0, 5));
+}
+
+void BY_VoiceController_Unified::setCycle(int channel, int cycle) {
+    if (channel < 1 || channel > 4 || !initialized) return;
+    modules[channel - 1].setCycle((byte)constrain(cycle, 0, 4));
+}
+
+// ========================== 音量渐变 ==========================
+
+void BY_VoiceController_Unified::fadeTo(int channel, int volume, unsigned long durationMs,
+                                        uint8_t curve, bool stopWhenDone) {
+    if (channel < 1 || channel > 4 || !initialized) return;
+    
+    VolumeState& v = volumes[channel - 1];
+    uint8_t target = (uint8_t)constrain(volume, 0, 30);
+    
+    // 起点未知时无法插值，直接跳到目标
+    if (durationMs == 0 || v.desired == BY_VOLUME_UNKNOWN) {
+        setVolume(channel, target);
+        if (stopWhenDone) stop(channel);
+        return;
+    }
+    
+    v.fadeStart = v.desired;
+    v.fadeTarget = target;
+    v.fadeCurve = curve;
+    v.fadeDuration = (uint16_t)min(durationMs, 65535UL);
+    v.fadeStartTime = millis();
+    v.stopWhenDone = stopWhenDone;
+    v.fading = true;
+}
+
+void BY_VoiceController_Unified::cancelFade(int channel) {
+    if (channel < 1 || channel > 4) return;
+    volumes[channel - 1].fading = false;
+}
+
+bool BY_VoiceController_Unified::isFading(int channel) {
+    if (channel < 1 || channel > 4) return false;
+    return volumes[channel - 1].fading;
+}
+
+int BY_VoiceController_Unified::getVolume(int channel) {
+    if (channel < 1 || channel > 4) return -1;
+    uint8_t vol = volumes[channel - 1].desired;
+    return (vol == BY_VOLUME_UNKNOWN) ? -1 : vol;
+}
+
+void BY_VoiceController_Unified::flushVolume(int index, bool force) {
+    if (!isReady()) return;  // 复位完成后由updateVolumes补发
+    
+    VolumeState& v = volumes[index];
+    uint8_t actual = modules[index].getState().volume;
+    if (v.desired == BY_VOLUME_UNKNOWN || v.desired == actual) return;  // 未变化不发帧
+    
+    unsigned long now = millis();
+    if (!force && actual != BY_VOLUME_UNKNOWN &&
+        now - v.lastFrameTime < BY_VOLUME_MIN_INTERVAL_MS) {
+        return;
+    }
+    
+    modules[index].setVolume(v.desired);
+    v.lastFrameTime = now;
+}
+
+void BY_VoiceController_Unified::updateVolumes() {
+    unsigned long now = millis();
+    
+    for (int i = 0; i < 4; i++) {
+        VolumeState& v = volumes[i];
+        
+        if (v.fading) {
+            unsigned long elapsed = now - v.fadeStartTime;
+            if (elapsed >= v.fadeDuration) {
+                v.desired = v.fadeTarget;
+                v.fading = false;
+                flushVolume(i, true);  // 终点音量不等限速窗口
+                if (v.stopWhenDone) {
+                    v.stopWhenDone = false;
+                    stop(i + 1);
+                }
+                continue;
+            }
+            
+            // 进度按1024定点计算后套用曲线
+            uint32_t p = (elapsed << 10) / v.fadeDuration;
+            if (v.fadeCurve == BY_FADE_EASE_IN) {
+                p = (p * p) >> 10;
+            } else if (v.fadeCurve == BY_FADE_EASE_OUT) {
+                p = 1024 - (((1024 - p) * (1024 - p)) >> 10);
+            }
+            int delta = (int)v.fadeTarget - (int)v.fadeStart;
+            v.desired = v.fadeStart + (int)(((long)delta * (long)p + (delta >= 0 ? 512 : -512)) / 1024);
+        }
+        
+        flushVolume(i, false);
+    }
+}
+
+// ========================== 预选控制 ==========================
+
+bool BY_VoiceController_Unified::isChannelIdle(int index) {
+    if (millis() - lastPlayTime[index] < BY_BUSY_SETTLE_MS) return false;
+    return digitalRead(busyPins[index]) != HIGH;
+}
+
+void BY_VoiceController_Unified::prefetchSong(int channel, int songID) {
+    if (channel < 1 || channel > 4 || !initialized) return;
+    if (songID < 1 || songID > 9999) return;
+    
+    int index = channel - 1;
+    if (modules[index].getPreparedSong() == songID) return;
+    
+    // 播放中或模块复位中选曲会丢失/打断当前音频，先挂起
+    if (isReady() && isChannelIdle(index)) {
+        modules[index].prepareSong(songID);
+        pendingPrefetch[index] = 0;
+    } else {
+        pendingPrefetch[index] = songID;
+    }
+}
+
+void BY_VoiceController_Unified::cancelPrefetch(int channel) {
+    if (channel < 1 || channel > 4) return;
+    pendingPrefetch[channel - 1] = 0;
+}
+
+void BY_VoiceController_Unified::cancelAllPrefetch() {
+    for (int i = 0; i < 4; i++) {
+        pendingPrefetch[i] = 0;
+    }
+}
+
+bool BY_VoiceController_Unified::isPrefetched(int channel, int songID) {
+    if (channel < 1 || channel > 4) return false;
+    return modules[channel - 1].getPreparedSong() == songID;
 }
 
 // ========================== 批量控制 ==========================
@@ -321,14 +653,28 @@ void BY_VoiceController_Unified::stopAll() {
 }
 
 void BY_VoiceController_Unified::setVolumeAll(int volume) {
+    // 各通道独立串口，音量帧由每通道限速控制，不需要间隔等待
     for (int i = 1; i <= 4; i++) {
         setVolume(i, volume);
-        delay(50);
     }
 }
 
 // ========================== 状态查询 ==========================
 
+const BY_ModuleState* BY_VoiceController_Unified::getState(int channel) {
+    if (channel < 1 || channel > 4) return nullptr;
+    return &modules[channel - 1].getState();
+}
+
+void BY_VoiceController_Unified::queryState(int channel, uint8_t mask) {
+    if (!initialized) return;
+    for (int i = 0; i < 3; i++) {  // 通道4只发送，收不到应答
+        if (channel == 0 || channel == i + 1) {
+            modules[i].requestQuery(mask);
+        }
+    }
+}
+
 bool BY_VoiceController_Unified::isBusy(int channel) {
     if (channel < 1 || channel > 4 || !initialized) return false;
     return digitalRead(busyPins[channel - 1]) == HIGH;  // 先改回HIGH，测试确认逻辑
@@ -337,6 +683,35 @@ bool BY_VoiceController_Unified::isBusy(int channel) {
 void BY_VoiceController_Unified::update() {
     if (!initialized) return;
     
+    // 模块复位中：不发音量/查询/预选帧，也不看Busy引脚
+    bool justSettled = false;
+    if (resetSettling) {
+        if (millis() - resetTime < BY_RESET_SETTLE_MS) return;
+        resetSettling = false;
+        justSettled = true;
+        Serial.println(F("✅ 语音模块复位完成"));
+    }
+    
+    // 音量渐变与限速补发、查询应答解析（每次loop）
+    updateVolumes();
+    for (int i = 0; i < 4; i++) {
+        modules[i].update();
+    }
+    
+    // 复位期间排队的播放请求在音量帧之后发出
+    if (justSettled) {
+        for (int i = 0; i < 4; i++) {
+            int song = pendingPlay[i];
+            if (song == 0) continue;
+            pendingPlay[i] = 0;
+            if (song == BY_PLAY_RESUME) {
+                play(i + 1);
+            } else {
+                playSong(i + 1, song);
+            }
+        }
+    }
+    
     unsigned long currentTime = millis();
     if (currentTime - lastStatusCheck >= STATUS_CHECK_INTERVAL) {
         lastStatusCheck = currentTime;
@@ -350,8 +725,17 @@ void BY_VoiceController_Unified::update() {
                 Serial.print(i + 1);
                 Serial.print(F(" 状态: "));
                 Serial.println(busyStates[i] ? F("播放中") : F("空闲"));
+                if (!busyStates[i] && modules[i].getState().playState == BY_STATE_PLAYING) {
+                    modules[i].setPlayState(BY_STATE_STOPPED);  // 播放自然结束
+                }
                 lastBusyStates[i] = busyStates[i];
             }
+            
+            // 通道空闲后发出挂起的预选
+            if (pendingPrefetch[i] != 0 && isChannelIdle(i)) {
+                modules[i].prepareSong(pendingPrefetch[i]);
+                pendingPrefetch[i] = 0;
+            }
         }
     }
 }
@@ -376,12 +760,32 @@ void BY_VoiceController_Unified::printStatus() {
         Serial.print(F("  Busy引脚: "));
         Serial.println(busyPins[i]);
         
+        // 缓存状态（?=未知）
+        const BY_ModuleState& st = modules[i].getState();
+        Serial.print(F("  缓存: 音量="));
+        if (st.volume == BY_VOLUME_UNKNOWN) Serial.print('?'); else Serial.print(st.volume);
+        Serial.print(F(" EQ="));
+        if (st.eq == 0xFF) Serial.print('?'); else Serial.print(st.eq);
+        Serial.print(F(" 循环="));
+        if (st.cycle == 0xFF) Serial.print('?'); else Serial.print(st.cycle);
+        Serial.print(F(" 曲目="));
+        if (st.track < 0) Serial.print('?'); else Serial.print(st.track);
+        Serial.print(F(" 状态="));
+        if (st.playState == BY_STATE_PLAYING) Serial.println(F("播放"));
+        else if (st.playState == BY_STATE_PAUSED) Serial.println(F("暂停"));
+        else if (st.playState == BY_STATE_STOPPED) Serial.println(F("停止"));
+        else Serial.println('?');
+        Serial.print(F("  帧: 已发"));
+        Serial.print(modules[i].getFramesSent());
+        Serial.print(F("，省略"));
+        Serial.println(modules[i].getFramesSuppressed());
+        
         // 串口信息
         Serial.print(F("  串口: "));
         if (i == 0) Serial.println(F("Serial1"));
         else if (i == 1) Serial.println(F("Serial2"));
         else if (i == 2) Serial.println(F("Serial3"));
-        else Serial.println(F("SoftwareSerial"));
+        else Serial.println(F("TimerSerialTX (Timer3，只发送)"));
     }
     
     Serial.print(F("软串口配置: RX="));
@@ -420,6 +824,13 @@ void BY_VoiceController_Unified::processSerialCommand(String command) {
         return;
     }
     
+    // 查询模块状态（应答到达后刷新缓存，再用status查看）
+    if (command == "query") {
+        queryState(0);
+        Serial.println(F("🔍 已向所有通道发出状态查询"));
+        return;
+    }
+    
     // 批量控制命令
     if (command == "stopall") {
         stopAll();
@@ -542,6 +953,7 @@ void BY_VoiceController_Unified::printHelp() {
     Serial.println(F(""));
     Serial.println(F("📊 系统命令:"));
     Serial.println(F("  status 或 s      : 显示系统状态"));
+    Serial.println(F("  query            : 查询模块音量/EQ/循环/曲目/状态"));
     Serial.println(F("  help 或 h        : 显示此帮助"));
     Serial.println(F("========================================================\n"));
 } 
\ No newline at end of file
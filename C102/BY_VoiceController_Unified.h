@@ -5,7 +5,7 @@
  * 创建日期: 2025-01-03
  * 
  * 功能:
- * - 支持4路语音模块控制 (3路硬件串口 + 1路软串口)
+ * - 支持4路语音模块控制 (3路硬件串口 + 1路定时器软串口，只发送)
  * - 灵活的引脚配置 (分别设置TX/RX和Busy引脚)
  * - 统一的API接口
  * - 完整的状态监控
@@ -16,7 +16,57 @@
 #define BY_VOICECONTROLLER_UNIFIED_H
 
 #include <Arduino.h>
-#include <SoftwareSerial.h>
+#include "TimerSerialTX.h"
+
+// ========================== 音频预选配置 ==========================
+// 预选：提前发送选曲帧，到点只发一个PLAY帧，省去选曲后的等待
+#define BY_SELECT_SETTLE_MS     100     // 选曲后到可以播放的等待时间(ms)
+#define BY_BUSY_SETTLE_MS       500     // 播放命令后Busy引脚稳定前视为占用(ms)
+#define BY_RESET_SETTLE_MS      500     // 复位帧发出后模块重启的时间(ms)，期间不发帧，播放/音量/预选排队到复位完成后发出
+#define BY_PLAY_RESUME          -1      // pendingPlay：复位期间收到不带曲目的play()
+
+// ========================== 音量渐变配置 ==========================
+// 音量帧按通道限速：窗口内的多次设置只保留最后一次，数值未变化的帧不发送
+#define BY_VOLUME_MIN_INTERVAL_MS   100     // 同一通道两个音量帧的最小间隔(ms)，即每秒最多10帧
+#define BY_VOLUME_UNKNOWN           0xFF    // 模块当前音量未知（上电后未设置过）
+
+// 渐变曲线
+enum BY_FadeCurve : uint8_t {
+    BY_FADE_LINEAR = 0,     // 线性
+    BY_FADE_EASE_IN,        // 先慢后快
+    BY_FADE_EASE_OUT        // 先快后慢
+};
+
+// ========================== 状态缓存与查询配置 ==========================
+// 每个模块缓存音量/EQ/循环模式/曲目/播放状态，由发出的命令和查询应答更新；
+// 不会改变模块状态的设置帧直接丢弃
+#define BY_QUERY_TIMEOUT_MS     200     // 查询应答超时(ms)，超时后发下一条查询
+#define BY_RX_BUFFER_SIZE       12      // 应答行缓冲（应答为十六进制ASCII加CRLF）
+
+// 播放状态
+enum BY_PlayState : uint8_t {
+    BY_STATE_STOPPED = 0,
+    BY_STATE_PLAYING = 1,
+    BY_STATE_PAUSED = 2,
+    BY_STATE_UNKNOWN = 0xFF
+};
+
+// 查询项位图
+#define BY_QUERY_STATUS         0x01
+#define BY_QUERY_VOLUME         0x02
+#define BY_QUERY_EQ             0x04
+#define BY_QUERY_CYCLE          0x08
+#define BY_QUERY_TRACK          0x10
+#define BY_QUERY_ALL            0x1F
+
+// 模块状态缓存（0xFF / -1 表示未知）
+struct BY_ModuleState {
+    uint8_t volume;
+    uint8_t eq;
+    uint8_t cycle;
+    uint8_t playState;             // BY_PlayState
+    int track;                     // 当前曲目
+};
 
 // ========================== BY命令定义 ==========================
 struct BY_Commands {
@@ -34,6 +84,13 @@ struct BY_Commands {
     static const byte CMD_FBCK = 0x0B;
     static const byte CMD_STOP = 0x0E;
     
+    // 查询指令（BY8x01手册，应答为十六进制ASCII）
+    static const byte QRY_STATUS = 0x10;   // 0=停止 1=播放 2=暂停
+    static const byte QRY_VOL = 0x11;
+    static const byte QRY_EQ = 0x12;
+    static const byte QRY_CYCLE = 0x13;
+    static const byte QRY_TRACK = 0x19;    // TF卡当前曲目
+    
     // 3byte参数命令
     static const byte SET_VOL = 0x31;      // 0-30
     static const byte SET_EQ = 0x32;       // 0-5
@@ -54,6 +111,20 @@ class BY_VoiceModule_Unified {
 private:
     Stream* serialPort;
     byte sendBuffer[8] = {0x7E}; // 发送缓冲区
+    int preparedSong;            // 已预选的歌曲ID，0=无
+    unsigned long preparedTime;  // 预选帧发出时间
+    
+    // 状态缓存与查询
+    BY_ModuleState state;
+    uint8_t queryMask;           // 待发出的查询项
+    uint8_t queryInFlight;       // 等待应答的查询项，0=无
+    unsigned long queryTime;
+    char rxBuffer[BY_RX_BUFFER_SIZE];
+    uint8_t rxLength;
+    uint16_t framesSent;         // 已发出的帧数
+    uint16_t framesSuppressed;   // 因状态未变化而丢弃的帧数
+    
+    void handleResponse(long value);
     
     // CRC计算 (XOR方式)
     byte calculateCRC(byte* p, byte cNum);
@@ -85,14 +156,27 @@ public:
     void setCycle(byte cycle);     // 0-4
     void selectSong(int songID);   // 1-9999
     void selectFolderSong(byte folderID, byte songID);
-    void playSong(int songID);     // 选择并播放
+    void playSong(int songID);     // 选择并播放（已预选则只发PLAY）
+    
+    // 预选
+    void prepareSong(int songID);  // 只选曲不播放
+    int getPreparedSong() const { return preparedSong; }
+    
+    // 状态缓存
+    const BY_ModuleState& getState() const { return state; }
+    void invalidateState();        // 模块可能已复位时调用，之后的设置帧都会发出
+    void setPlayState(uint8_t playState) { state.playState = playState; }  // Busy引脚检测到播放结束时同步
+    void requestQuery(uint8_t mask);
+    void update();                 // 发出查询并解析应答（loop中调用）
+    uint16_t getFramesSent() const { return framesSent; }
+    uint16_t getFramesSuppressed() const { return framesSuppressed; }
 };
 
 // ========================== 统一语音控制器类 ==========================
 class BY_VoiceController_Unified {
 private:
     BY_VoiceModule_Unified modules[4];    // 4个语音模块
-    SoftwareSerial* softSerial;           // 软串口指针
+    TimerSerialTX* softSerial;            // 通道4定时器软串口（只发送）
     bool initialized;
     
     // 配置参数
@@ -102,7 +186,31 @@ private:
     // 状态监控
     bool busyStates[4];
     bool lastBusyStates[4];
+    
+    // 预选队列：通道播放中时先挂起，空闲后在update中发出
+    int pendingPrefetch[4];               // 待预选的歌曲ID，0=无
+    int pendingPlay[4];                   // 复位期间收到的播放请求：歌曲ID，BY_PLAY_RESUME=只发PLAY，0=无
+    unsigned long lastPlayTime[4];        // 最近一次播放命令时间
+    bool isChannelIdle(int index);
+    
+    // 音量状态：desired为期望音量，sent为最近一次发出的音量，update中按限速补发
+    struct VolumeState {
+        uint8_t desired;                  // 期望音量
+        uint8_t fadeStart;                // 渐变起始音量
+        uint8_t fadeTarget;               // 渐变目标音量
+        uint8_t fadeCurve;                // BY_FadeCurve
+        bool fading;
+        bool stopWhenDone;                // 渐变结束后停止播放
+        uint16_t fadeDuration;
+        unsigned long fadeStartTime;
+        unsigned long lastFrameTime;      // 最近一次音量帧发出时间
+    };
+    VolumeState volumes[4];
+    void updateVolumes();
+    void flushVolume(int index, bool force);
     unsigned long lastStatusCheck;
+    unsigned long resetTime;              // 复位帧发出时间
+    bool resetSettling;                   // 模块复位中（begin后BY_RESET_SETTLE_MS内）
     static const unsigned long STATUS_CHECK_INTERVAL = 100;
 
 public:
@@ -120,8 +228,9 @@ public:
     // 批量设置所有Busy引脚
     void setBusyPins(int pin1, int pin2, int pin3, int pin4);
     
-    // 初始化系统 (在设置完引脚后调用)
+    // 初始化系统 (在设置完引脚后调用)，模块复位在后台完成，不阻塞启动
     bool begin();
+    bool isReady();                               // 模块复位已完成（之前的播放请求已排队）
     
     // ========================== 语音控制接口 ==========================
     
@@ -131,9 +240,24 @@ public:
     void pause(int channel);
     void nextSong(int channel);
     void prevSong(int channel);
-    void setVolume(int channel, int volume);
+    void setVolume(int channel, int volume);        // 限速发送，窗口内的旧值被覆盖
+    void setEQ(int channel, int eq);                // 与缓存相同时不发帧
+    void setCycle(int channel, int cycle);
     void playSong(int channel, int songID);
     
+    // 音量渐变（由update驱动，不阻塞）
+    void fadeTo(int channel, int volume, unsigned long durationMs,
+                uint8_t curve = BY_FADE_LINEAR, bool stopWhenDone = false);
+    void cancelFade(int channel);                   // 停在当前音量
+    bool isFading(int channel);
+    int getVolume(int channel);                     // 期望音量，未知返回-1
+    
+    // 预选控制（环节提前声明即将播放的音频）
+    void prefetchSong(int channel, int songID);   // 空闲时立即选曲，播放中则等空闲后再选
+    void cancelPrefetch(int channel);
+    void cancelAllPrefetch();
+    bool isPrefetched(int channel, int songID);   // 选曲帧已发出
+    
     // 批量控制
     void playAll();
     void stopAll();
@@ -142,6 +266,8 @@ public:
     // ========================== 状态查询接口 ==========================
     
     bool isBusy(int channel);
+    const BY_ModuleState* getState(int channel);   // 缓存的模块状态
+    void queryState(int channel, uint8_t mask = BY_QUERY_ALL);  // channel=0表示全部通道
     void update();              // 状态更新 (在loop中调用)
     void printStatus();         // 打印状态信息
     
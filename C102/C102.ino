@@ -32,6 +32,7 @@
 #define DEBUG 1
 #define CONTROLLER_ID "C102"
 #define ENABLE_NETWORK true   // 网络开关
+#define ENABLE_GROUP_MULTICAST false // 组播组命令（多控制器同步效果），需要ENABLE_NETWORK；额外占用一个W5100 socket且数据报无认证，仅在隔离的展厅网络中开启
 #define ENABLE_VOICE true     // 语音控制开关
 
 // ========================== 全局实例 ==========================
@@ -39,8 +40,12 @@ BY_VoiceController_Unified voice;  // 统一语音控制器实例
 
 void setup() {
     // 初始化串口
-    Serial.begin(SERIAL_BAUDRATE);
-    while (!Serial && millis() < 3000); // 等待串口就绪，最多3秒
+    Serial.begin(SERIAL_BAUDRATE);   // Mega的硬件串口无需等待USB枚举
+    
+    // ========================== 硬件初始化 ==========================
+    // 最先执行：Busy引脚上拉，上电后立即处于确定状态
+    initC102Hardware();  // 初始化C102特定的硬件引脚
+    harbingerClient.markBootPhase(F("hw"));
 
     Serial.println(F("=== C102 4路语音控制器启动 ==="));
 
@@ -69,6 +74,7 @@ void setup() {
         } else {
             Serial.println(F("❌ 统一语音控制器初始化失败"));
         }
+        harbingerClient.markBootPhase(F("voice"));   // 复位帧已发出，模块重启与以太网初始化重叠进行
         
         Serial.println(F("语音命令格式：c1p(播放) c1s(停止) c1:11(播放歌曲11)"));
         Serial.println(F("测试命令：c1:11, c2:11, c3:11, c4:11"));
@@ -83,19 +89,19 @@ void setup() {
         IPAddress serverIP(192, 168, 10, 10);
         if (systemHelper.initNetwork(serverIP, 9000)) {
             Serial.println(F("网络初始化成功"));
+            if (ENABLE_GROUP_MULTICAST) {
+                IPAddress groupIP(239, 255, 10, 10);
+                harbingerClient.joinGroup(groupIP);
+            }
         } else {
             Serial.println(F("网络初始化失败"));
         }
     }
     
-    // ========================== 硬件初始化 ==========================
-    Serial.println(F("初始化硬件..."));
-    
-    // 使用配置文件的硬件初始化函数
-    initC102Hardware();  // 初始化C102特定的硬件引脚
     Serial.println(F("✓ 4路音频模块硬件配置完成"));
     
     Serial.println(F("所有组件初始化完成"));
+    harbingerClient.markBootPhase(F("setup"));   // 以太网链路和服务器连接在loop中后台完成
     Serial.println(F("输入 'help' 查看所有命令"));
 }
 
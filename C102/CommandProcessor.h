@@ -9,6 +9,7 @@
  * - 支持多种命令格式
  * - 集成PWM控制和游戏状态管理
  * - 简化的命令接口
+ * - 固定名字命令走编译期哈希命令表(CommandTable)
  * =============================================================================
  */
 
@@ -45,49 +46,35 @@ public:
      */
     bool processCommand(const String& input);
     
-    // ========================== 具体命令处理器 ==========================
-    /**
-     * @brief 处理PWM相关命令
-     * @param command 命令名
-     * @param params 参数
-     * @return true=处理成功
-     */
-    bool processPWMCommand(const String& command, const String& params);
-    
-    /**
-     * @brief 处理游戏协议命令
-     * @param command 命令名
-     * @param params 参数
-     * @return true=处理成功
-     */
-    bool processGameCommand(const String& command, const String& params);
+    // ========================== 模式命令处理器 ==========================
+    // 固定名字的命令在CommandProcessor.cpp的命令表中登记，这里只处理带编号的模式命令
     
     /**
-     * @brief 处理系统命令
+     * @brief 处理简化PWM命令 (p24, b24, s24, pa/ba/sa, f/fo/ft/fs)
      * @param command 命令名
      * @param params 参数
      * @return true=处理成功
      */
-    bool processSystemCommand(const String& command, const String& params);
+    bool processSimplePWMCommand(const String& command, const String& params);
     
     /**
-     * @brief 处理简化PWM命令
+     * @brief 处理数字IO命令 (o24h, pulse24, t24h, i24)
      * @param command 命令名
      * @param params 参数
      * @return true=处理成功
      */
-    bool processSimplePWMCommand(const String& command, const String& params);
+    bool processDigitalIOCommand(const String& command, const String& params);
     
     /**
-     * @brief 处理数字IO命令
+     * @brief 处理环节编号命令 (001-0, stage_001_1)
      * @param command 命令名
      * @param params 参数
      * @return true=处理成功
      */
-    bool processDigitalIOCommand(const String& command, const String& params);
+    bool processGameCommand(const String& command, const String& params);
     
     /**
-     * @brief 处理音频控制命令
+     * @brief 处理音频通道命令 (c1p, c2s, c1v20, c1:1234, c1n, c1b)
      * @param command 命令名
      * @param params 参数
      * @return true=处理成功
@@ -132,15 +119,6 @@ private:
      */
     bool parseCommand(const String& input, String& command, String& params);
     
-    /**
-     * @brief 解析PWM参数
-     * @param params 参数字符串
-     * @param pin 输出引脚号
-     * @param value 输出值
-     * @return true=解析成功
-     */
-    bool parsePWMParams(const String& params, int& pin, int& value);
-    
     /**
      * @brief 解析简化命令参数
      * @param params 参数字符串
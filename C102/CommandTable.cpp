@@ -0,0 +1,129 @@
+#include "CommandTable.h"
+
+// ========================== 哈希与查找 ==========================
+uint16_t commandHash(const char* name) {
+    uint16_t h = 5381;
+    while (*name) {
+        h = (uint16_t)((uint16_t)(h << 5) + h) ^ (uint8_t)*name++;
+    }
+    return h;
+}
+
+bool findCommand(const CommandTable& table, const String& name, CommandEntry& entry) {
+    CommandTable t;
+    memcpy_P(&t, &table, sizeof(CommandTable));
+
+    const char* text = name.c_str();
+    uint16_t hash = commandHash(text);
+
+    // 在哈希排序索引上二分，找到第一个哈希不小于目标的位置
+    uint8_t lo = 0;
+    uint8_t hi = t.count;
+    while (lo < hi) {
+        uint8_t mid = (lo + hi) >> 1;
+        uint8_t row = pgm_read_byte(&t.order[mid]);
+        if (pgm_read_word(&t.entries[row].hash) < hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    // 哈希相同的表项相邻，逐个确认名字（允许哈希冲突）
+    for (; lo < t.count; lo++) {
+        uint8_t row = pgm_read_byte(&t.order[lo]);
+        if (pgm_read_word(&t.entries[row].hash) != hash) break;
+        if (pgm_read_byte(&t.entries[row].kind) != CMD_KIND_EXEC) continue;
+        if (strcmp_P(text, (const char*)pgm_read_word(&t.entries[row].text)) != 0) continue;
+
+        memcpy_P(&entry, &t.entries[row], sizeof(CommandEntry));
+        return true;
+    }
+    return false;
+}
+
+// 文本块中下一段（名字 -> 用法 -> 帮助）
+static const char* nextText(const char* text) {
+    return text + strlen_P(text) + 1;
+}
+
+// ========================== 参数解析 ==========================
+static bool isArgSeparator(char c) {
+    return c == ',' || c == ' ' || c == '\t';
+}
+
+// 一次扫描参数串，不产生临时String
+static uint8_t parseArgs(const char* text, uint8_t maxArgs, uint8_t floatMask, CommandArgs& args) {
+    uint8_t n = 0;
+    while (n < maxArgs) {
+        while (isArgSeparator(*text)) text++;
+        if (*text == '\0') break;
+
+        if (floatMask & CMD_ARG_FLOAT(n)) {
+            args.value[n].f = atof(text);
+        } else {
+            args.value[n].i = atol(text);
+        }
+        n++;
+
+        while (*text != '\0' && !isArgSeparator(*text)) text++;
+    }
+    return n;
+}
+
+int8_t dispatchCommand(const CommandTable& table, const String& command, const String& params) {
+    CommandEntry entry;
+    if (!findCommand(table, command, entry)) {
+        return CMD_NOT_FOUND;
+    }
+
+    uint8_t minArgs = entry.argSpec & 0x0F;
+    uint8_t maxArgs = entry.argSpec >> 4;
+    if (maxArgs > CMD_MAX_ARGS) maxArgs = CMD_MAX_ARGS;
+
+    CommandArgs args;
+    args.command = &command;
+    args.params = &params;
+    args.count = parseArgs(params.c_str(), maxArgs, entry.floatMask, args);
+
+    if (args.count < minArgs) {
+        Serial.print(F("❌ 参数不足，用法: "));
+        Serial.print((const __FlashStringHelper*)entry.text);
+        Serial.println((const __FlashStringHelper*)nextText(entry.text));
+        return CMD_FAILED;
+    }
+
+    return entry.handler(args) ? CMD_OK : CMD_FAILED;
+}
+
+// ========================== 帮助生成 ==========================
+void printCommandHelp(const CommandTable& table) {
+    CommandTable t;
+    memcpy_P(&t, &table, sizeof(CommandTable));
+
+    for (uint8_t i = 0; i < t.count; i++) {
+        uint8_t kind = pgm_read_byte(&t.entries[i].kind);
+        const char* name = (const char*)pgm_read_word(&t.entries[i].text);
+        const char* usage = nextText(name);
+        const char* help = nextText(usage);
+
+        if (kind == CMD_KIND_TITLE) {
+            if (i > 0) Serial.println();
+            Serial.println((const __FlashStringHelper*)help);
+            continue;
+        }
+        if (pgm_read_byte(help) == '\0') continue;  // 别名不单独列出
+
+        Serial.print(F("  "));
+        Serial.print((const __FlashStringHelper*)name);
+        Serial.print((const __FlashStringHelper*)usage);
+
+        uint8_t width = strlen_P(name) + strlen_P(usage);
+        do {
+            Serial.print(' ');
+        } while (++width < CMD_HELP_COLUMN);
+
+        Serial.print(F("- "));
+        Serial.println((const __FlashStringHelper*)help);
+    }
+}
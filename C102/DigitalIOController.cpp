@@ -144,17 +144,35 @@ unsigned long DigitalOutputChannel::getRemainingTime() const {
 
 // ========================== DigitalInputChannel 实现 ==========================
 
+PulseMeasure DigitalInputChannel::pulsePool[DIO_MAX_PULSE_CHANNELS];
+
 DigitalInputChannel::DigitalInputChannel() : pin(-1), mode(INPUT_SINGLE), lastValue(LOW), currentValue(LOW),
                                               lastSampleTime(0), sampleInterval(100), hasChanged(false),
-                                              isActive(false), bufferIndex(0), sampleCount(0) {
-    memset(sampleBuffer, 0, sizeof(sampleBuffer));
-}
+                                              isActive(false), history(0), sampleCount(0),
+                                              stableSamples(DIO_DEFAULT_STABLE_SAMPLES), pulse(NULL) {}
 
 bool DigitalInputChannel::start(int p, InputMode m, unsigned long intervalMs) {
+    if (m == INPUT_PULSE) {
+        // 脉冲模式从池中借用测量状态，池满则拒绝启动
+        if (pulse == NULL) {
+            for (uint8_t i = 0; i < DIO_MAX_PULSE_CHANNELS; i++) {
+                if (!pulsePool[i].inUse) {
+                    pulse = &pulsePool[i];
+                    pulse->inUse = true;
+                    break;
+                }
+            }
+            if (pulse == NULL) return false;
+        }
+    } else {
+        releasePulse();
+    }
+    
     pin = (int8_t)p;
     mode = m;
-    sampleInterval = intervalMs;
-    pinMode(pin, INPUT);
+    setSampleInterval(intervalMs);
+    // 脉冲模式用于干簧管/按键等低电平有效触点，统一使用内部上拉
+    pinMode(pin, (mode == INPUT_PULSE) ? INPUT_PULLUP : INPUT);
     
     // 读取初始值
     currentValue = digitalRead(pin);
@@ -163,27 +181,80 @@ bool DigitalInputChannel::start(int p, InputMode m, unsigned long intervalMs) {
     isActive = true;
     lastSampleTime = MillisTimeSource::getCurrentTime();
     
+    // 用初始值填满历史，避免启动时误判边沿
+    history = currentValue ? 0xFFFFFFFFUL : 0;
+    sampleCount = (mode == INPUT_PULSE) ? DIO_HISTORY_BITS : 0;
+    if (pulse != NULL) {
+        pulse->lastEdgeTime = lastSampleTime;
+        pulse->lastHighWidth = 0;
+        pulse->lastLowWidth = 0;
+        pulse->edgeCount = 0;
+    }
+    
     return true;
 }
 
 void DigitalInputChannel::stop() {
     isActive = false;
+    releasePulse();
+}
+
+void DigitalInputChannel::releasePulse() {
+    if (pulse != NULL) {
+        pulse->inUse = false;
+        pulse = NULL;
+    }
+}
+
+void DigitalInputChannel::pushSample(bool value) {
+    history = (history << 1) | (value ? 1UL : 0UL);
+    if (sampleCount < DIO_HISTORY_BITS) sampleCount++;
+}
+
+void DigitalInputChannel::sampleDebounced(unsigned long now) {
+    pushSample(digitalRead(pin));
+    
+    // 最近stableSamples个采样全部一致才认为电平稳定
+    uint32_t mask = (stableSamples >= DIO_HISTORY_BITS) ? 0xFFFFFFFFUL : ((1UL << stableSamples) - 1);
+    uint32_t recent = history & mask;
+    if (recent != 0 && recent != mask) return;
+    
+    bool stable = (recent != 0);
+    if (stable == currentValue) return;
+    
+    // 边沿时间戳回溯到第一个稳定采样，消除去抖延迟带来的误差
+    unsigned long edgeTime = now - (unsigned long)(stableSamples - 1) * sampleInterval;
+    if ((long)(edgeTime - pulse->lastEdgeTime) < 0) edgeTime = pulse->lastEdgeTime;
+    unsigned long width = edgeTime - pulse->lastEdgeTime;
+    if (width > 65535UL) width = 65535UL;
+    if (currentValue) {
+        pulse->lastHighWidth = (uint16_t)width;
+    } else {
+        pulse->lastLowWidth = (uint16_t)width;
+    }
+    
+    lastValue = currentValue;
+    currentValue = stable;
+    pulse->lastEdgeTime = edgeTime;
+    pulse->edgeCount++;
+    hasChanged = true;
 }
 
 bool DigitalInputChannel::readValue() {
     if (!isActive || pin < 0) return false;
     
+    // 脉冲模式只返回去抖后的稳定电平，采样由update()按固定间隔完成
+    if (mode == INPUT_PULSE) return currentValue;
+    
     lastValue = currentValue;
     currentValue = digitalRead(pin);
     
     if (currentValue != lastValue) {
         hasChanged = true;
         
-        // 更新采样缓冲区
+        // 更新采样历史（连续模式只记录变化）
         if (mode == INPUT_CONTINUOUS) {
-            sampleBuffer[bufferIndex] = currentValue ? 1 : 0;
-            bufferIndex = (bufferIndex + 1) % 8;
-            if (sampleCount < 8) sampleCount++;
+            pushSample(currentValue);
         }
     }
     
@@ -199,30 +270,75 @@ void DigitalInputChannel::resetChangeFlag() {
 }
 
 void DigitalInputChannel::setSampleInterval(unsigned long intervalMs) {
-    sampleInterval = intervalMs;
+    sampleInterval = (intervalMs > 65535UL) ? 65535 : (uint16_t)intervalMs;
+}
+
+void DigitalInputChannel::setStableSamples(uint8_t count) {
+    if (count < 1) count = 1;
+    if (count > DIO_HISTORY_BITS) count = DIO_HISTORY_BITS;
+    stableSamples = count;
 }
 
 uint8_t DigitalInputChannel::getSampleHistory(bool* buffer, uint8_t maxCount) {
     uint8_t count = min(sampleCount, maxCount);
     
+    // 按时间顺序输出（最旧在前）
     for (uint8_t i = 0; i < count; i++) {
-        uint8_t index = (bufferIndex - count + i + 8) % 8;
-        buffer[i] = sampleBuffer[index] ? true : false;
+        buffer[i] = (history >> (count - 1 - i)) & 1UL;
     }
     
     return count;
 }
 
+uint32_t DigitalInputChannel::getHistoryBits() const {
+    return history;
+}
+
+bool DigitalInputChannel::isHeldFor(bool level, unsigned long ms) const {
+    if (!isActive || pulse == NULL || currentValue != level) return false;
+    return getHoldDuration() >= ms;
+}
+
+unsigned long DigitalInputChannel::getHoldDuration() const {
+    if (pulse == NULL) return 0;
+    return MillisTimeSource::getCurrentTime() - pulse->lastEdgeTime;
+}
+
+unsigned long DigitalInputChannel::getLastEdgeTime() const {
+    return (pulse != NULL) ? pulse->lastEdgeTime : 0;
+}
+
+uint16_t DigitalInputChannel::getPulseWidth(bool level) const {
+    if (pulse == NULL) return 0;
+    return level ? pulse->lastHighWidth : pulse->lastLowWidth;
+}
+
+uint16_t DigitalInputChannel::getEdgeCount() const {
+    return (pulse != NULL) ? pulse->edgeCount : 0;
+}
+
+float DigitalInputChannel::getFrequency() const {
+    if (pulse == NULL) return 0.0f;
+    unsigned long period = (unsigned long)pulse->lastHighWidth + pulse->lastLowWidth;
+    if (pulse->lastHighWidth == 0 || pulse->lastLowWidth == 0 || period == 0) return 0.0f;
+    return 1000.0f / period;
+}
+
 void DigitalInputChannel::update() {
     if (!isActive || pin < 0) return;
     
     unsigned long now = MillisTimeSource::getCurrentTime();
     
-    if (mode == INPUT_CONTINUOUS || mode == INPUT_CHANGE) {
-        if (now - lastSampleTime >= sampleInterval) {
-            lastSampleTime = now;
-            readValue();
-        }
+    if (now - lastSampleTime < sampleInterval) return;
+    
+    if (pulse != NULL) {
+        // 固定步进保持采样节拍，计时误差不累积
+        lastSampleTime += sampleInterval;
+        if (now - lastSampleTime >= sampleInterval) lastSampleTime = now;
+        sampleDebounced(lastSampleTime);
+    } else if (mode == INPUT_CONTINUOUS || mode == INPUT_CHANGE) {
+        lastSampleTime = now;
+        readValue();
     }
 }
 
@@ -382,7 +498,7 @@ bool DigitalIOController::startInput(int pin, InputMode mode, unsigned long inte
     
     // 创建新通道
     if (inputChannelCount < MAX_INPUT_CHANNELS) {
-        inputChannels[inputChannelCount].start(pin, mode, intervalMs);
+        if (!inputChannels[inputChannelCount].start(pin, mode, intervalMs)) return false;  // 脉冲测量池已满
         inputChannelCount++;
         return true;
     }
@@ -427,6 +543,32 @@ void DigitalIOController::stopAllInputs() {
     inputChannelCount = 0;
 }
 
+bool DigitalIOController::startPulseInput(int pin, unsigned long intervalMs, uint8_t stableSamples) {
+    if (!startInput(pin, INPUT_PULSE, intervalMs)) return false;
+    inputChannels[findInputChannelByPin(pin)].setStableSamples(stableSamples);
+    return true;
+}
+
+bool DigitalIOController::isInputHeldFor(int pin, bool level, unsigned long ms) {
+    int channelIndex = findInputChannelByPin(pin);
+    return (channelIndex >= 0) ? inputChannels[channelIndex].isHeldFor(level, ms) : false;
+}
+
+unsigned long DigitalIOController::getInputHoldDuration(int pin) {
+    int channelIndex = findInputChannelByPin(pin);
+    return (channelIndex >= 0) ? inputChannels[channelIndex].getHoldDuration() : 0;
+}
+
+uint16_t DigitalIOController::getInputPulseWidth(int pin, bool level) {
+    int channelIndex = findInputChannelByPin(pin);
+    return (channelIndex >= 0) ? inputChannels[channelIndex].getPulseWidth(level) : 0;
+}
+
+float DigitalIOController::getInputFrequency(int pin) {
+    int channelIndex = findInputChannelByPin(pin);
+    return (channelIndex >= 0) ? inputChannels[channelIndex].getFrequency() : 0.0f;
+}
+
 void DigitalIOController::setOutputPattern(int* pins, bool* levels, uint8_t count) {
     for (uint8_t i = 0; i < count; i++) {
         setOutput(pins[i], levels[i]);
@@ -22,9 +22,11 @@ GameFlowManager gameFlowManager;
 GameFlowManager::GameFlowManager() {
     // 初始化并行环节数组
     activeStageCount = 0;
+    runningMask = 0;
     globalStopped = false;
     
     // 初始化兼容性变量
+    compatType = STAGE_TYPE_NONE;
     currentStageId = "";
     stageStartTime = 0;
     stageRunning = false;
@@ -34,6 +36,10 @@ GameFlowManager::GameFlowManager() {
     for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
         stages[i] = StageState();
     }
+    for (int i = 0; i < STAGE_TYPE_COUNT; i++) {
+        typeSlot[i] = STAGE_SLOT_NONE;
+        resetStageTypeState(i);
+    }
 }
 
 void GameFlowManager::begin() {
@@ -46,39 +52,159 @@ void GameFlowManager::begin() {
 }
 
 // ========================== 私有辅助方法 ==========================
+// 环节ID驻留表（Flash），下标即StageType
+static const char STAGE_NAMES[STAGE_TYPE_COUNT][6] PROGMEM = {
+    "000_0", "001_2", "002_0"
+};
+
+// 环节音频提示表（Flash）：每个环节到点播放的通道和歌曲
+struct StageAudioCue {
+    uint8_t type;
+    uint8_t channel;
+    uint16_t songId;
+};
+
+static const StageAudioCue STAGE_AUDIO_CUES[] PROGMEM = {
+    {STAGE_TYPE_000_0, STAGE_000_0_CHANNEL,  STAGE_000_0_SONG_ID},
+    {STAGE_TYPE_001_2, STAGE_001_2_CHANNEL,  STAGE_001_2_SONG_ID},
+    {STAGE_TYPE_002_0, STAGE_002_0_CHANNEL1, STAGE_002_0_SONG_ID1},
+    {STAGE_TYPE_002_0, STAGE_002_0_CHANNEL2, STAGE_002_0_SONG_ID2}
+};
+
+// 环节ID两端可忽略的字符：引号和空白（串口命令行尾的\r\n、制表符等）
+static bool isStageIdPadding(char c) {
+    return c == '"' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+uint8_t GameFlowManager::internStageId(const char* stageId, unsigned int length) {
+    // 跳过引号和空白（兼容服务器带引号的step参数）
+    while (length > 0 && isStageIdPadding(*stageId)) {
+        stageId++;
+        length--;
+    }
+    while (length > 0 && isStageIdPadding(stageId[length - 1])) {
+        length--;
+    }
+    
+    if (length != sizeof(STAGE_NAMES[0]) - 1) {
+        return STAGE_TYPE_NONE;
+    }
+    for (uint8_t type = 0; type < STAGE_TYPE_COUNT; type++) {
+        if (memcmp_P(stageId, STAGE_NAMES[type], length) == 0) {
+            return type;
+        }
+    }
+    return STAGE_TYPE_NONE;
+}
+
+uint8_t GameFlowManager::internStageId(const String& stageId) {
+    return internStageId(stageId.c_str(), stageId.length());
+}
+
+const __FlashStringHelper* GameFlowManager::getStageName(uint8_t type) {
+    if (type >= STAGE_TYPE_COUNT) {
+        return F("");
+    }
+    return (const __FlashStringHelper*)STAGE_NAMES[type];
+}
+
 int GameFlowManager::findStageIndex(const String& stageId) {
+    return findStageIndex(internStageId(stageId));
+}
+
+int GameFlowManager::findStageIndex(uint8_t type) const {
+    if (type >= STAGE_TYPE_COUNT || typeSlot[type] == STAGE_SLOT_NONE) {
+        return -1;
+    }
+    return typeSlot[type];
+}
+
+int GameFlowManager::findEmptySlot() const {
     for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-        if (stages[i].running && stages[i].stageId == stageId) {
+        if (!isSlotRunning(i)) {
             return i;
         }
     }
     return -1;
 }
 
-int GameFlowManager::findEmptySlot() {
-    for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-        if (!stages[i].running) {
-            return i;
+bool GameFlowManager::isSlotRunning(int index) const {
+    return (runningMask >> index) & 1;
+}
+
+void GameFlowManager::releaseSlot(int index) {
+    if (!isSlotRunning(index)) {
+        return;
+    }
+    
+    uint8_t type = stages[index].type;
+    if (type < STAGE_TYPE_COUNT) {
+        typeSlot[type] = STAGE_SLOT_NONE;
+    }
+    if (type == STAGE_TYPE_001_2) {
+        voice.cancelFade(STAGE_001_2_FADE_CHANNEL);  // 环节停止时淡出一并停止
+    }
+    stages[index].type = STAGE_TYPE_NONE;
+    stages[index].jumpRequested = false;
+    runningMask &= ~(1u << index);
+    activeStageCount--;
+}
+
+void GameFlowManager::resetStageTypeState(uint8_t type) {
+    switch (type) {
+        case STAGE_TYPE_000_0: memset(&state000, 0, sizeof(state000)); break;
+        case STAGE_TYPE_001_2: memset(&state001_2, 0, sizeof(state001_2)); break;
+        case STAGE_TYPE_002_0: memset(&state002, 0, sizeof(state002)); break;
+        default: break;
+    }
+}
+
+bool GameFlowManager::hasStageCue(uint8_t type, uint8_t channel) {
+    for (uint8_t i = 0; i < sizeof(STAGE_AUDIO_CUES) / sizeof(STAGE_AUDIO_CUES[0]); i++) {
+        if (pgm_read_byte(&STAGE_AUDIO_CUES[i].type) == type &&
+            pgm_read_byte(&STAGE_AUDIO_CUES[i].channel) == channel) {
+            return true;
         }
     }
-    return -1;
+    return false;
 }
 
-void GameFlowManager::updateCompatibilityVars() {
-    // 更新兼容性变量，使其指向第一个活跃环节
-    stageRunning = (activeStageCount > 0);
+void GameFlowManager::prefetchStageCues(uint8_t type, uint8_t currentType, uint8_t channel) {
+    if (type >= STAGE_TYPE_COUNT) return;
     
-    if (activeStageCount > 0) {
-        // 找到第一个运行中的环节
-        for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-            if (stages[i].running) {
-                currentStageId = stages[i].stageId;
-                stageStartTime = stages[i].startTime;
-                jumpRequested = stages[i].jumpRequested;
-                break;
-            }
+    for (uint8_t i = 0; i < sizeof(STAGE_AUDIO_CUES) / sizeof(STAGE_AUDIO_CUES[0]); i++) {
+        if (pgm_read_byte(&STAGE_AUDIO_CUES[i].type) != type) continue;
+        uint8_t cueChannel = pgm_read_byte(&STAGE_AUDIO_CUES[i].channel);
+        if (channel != 0) {
+            if (cueChannel != channel) continue;  // 本环节提示刚播出，只预选该通道
+        } else if (hasStageCue(currentType, cueChannel)) {
+            continue;  // 本环节该通道提示尚未播出，预选会覆盖它的选曲
         }
-    } else {
+        uint16_t songId = pgm_read_word(&STAGE_AUDIO_CUES[i].songId);
+        voice.prefetchSong(cueChannel, songId);
+        Serial.print(F("🎯 预选"));
+        Serial.print(getStageName(type));
+        Serial.print(F("音频: 通道"));
+        Serial.print(cueChannel);
+        Serial.print(F(" → "));
+        Serial.println(songId);
+    }
+}
+
+void GameFlowManager::updateCompatibilityVars() {
+    // 只在启停/跳转标志变化时调用，兼容性变量指向第一个活跃环节
+    stageRunning = (runningMask != 0);
+    
+    if (runningMask != 0) {
+        int first = __builtin_ctz(runningMask);
+        if (compatType != stages[first].type) {
+            compatType = stages[first].type;
+            currentStageId = getStageName(compatType);
+        }
+        stageStartTime = stages[first].startTime;
+        jumpRequested = stages[first].jumpRequested;
+    } else if (compatType != STAGE_TYPE_NONE) {
+        compatType = STAGE_TYPE_NONE;
         currentStageId = "";
         stageStartTime = 0;
         jumpRequested = false;
@@ -87,13 +213,20 @@ void GameFlowManager::updateCompatibilityVars() {
 
 // ========================== 环节控制 ==========================
 bool GameFlowManager::startStage(const String& stageId) {
-    // 标准化环节ID
-    String normalizedId = normalizeStageId(stageId);
-    
+    uint8_t type = internStageId(stageId);
+    if (type == STAGE_TYPE_NONE) {
+        Serial.print(F("❌ 未定义的C102环节: "));
+        Serial.println(stageId);
+        return false;
+    }
+    return startStageType(type);
+}
+
+bool GameFlowManager::startStageType(uint8_t type) {
     // 检查环节是否已经在运行
-    if (findStageIndex(normalizedId) >= 0) {
+    if (findStageIndex(type) >= 0) {
         Serial.print(F("⚠️ 环节已在运行: "));
-        Serial.println(normalizedId);
+        Serial.println(getStageName(type));
         return false;
     }
     
@@ -108,26 +241,23 @@ bool GameFlowManager::startStage(const String& stageId) {
     Serial.print(F("=== 启动C102音频环节[槽位"));
     Serial.print(slot);
     Serial.print(F("]: "));
-    Serial.print(stageId);
-    if (normalizedId != stageId) {
-        Serial.print(F(" (标准化为: "));
-        Serial.print(normalizedId);
-        Serial.print(F(")"));
-    }
+    Serial.print(getStageName(type));
     Serial.println(F(" ==="));
     
     // 重置全局停止标志
     globalStopped = false;
     
     // 初始化环节状态
-    stages[slot].stageId = normalizedId;
-    stages[slot].startTime = millis();
-    stages[slot].running = true;
+    stages[slot].type = type;
+    stages[slot].startTime = millis() - harbingerClient.getDispatchLateness();  // at=定时启动时对齐到约定时刻
     stages[slot].jumpRequested = false;
-    memset(&stages[slot].state, 0, sizeof(stages[slot].state));
+    resetStageTypeState(type);
+    typeSlot[type] = slot;
+    runningMask |= (1u << slot);
+    activeStageCount++;
     
     // 根据环节ID执行对应逻辑
-    if (normalizedId == "000_0") {
+    if (type == STAGE_TYPE_000_0) {
         Serial.println(F("🎵 环节000_0：通道"));
         Serial.print(STAGE_000_0_CHANNEL);
         Serial.println(F("号音频(初始化环节，不自动跳转)"));
@@ -149,14 +279,14 @@ bool GameFlowManager::startStage(const String& stageId) {
         Serial.println(F("✅ C102的000_0环节引脚状态配置完成"));
         
         // 初始化环节特定状态
-        stages[slot].state.stage000.channelStarted = false;
-        stages[slot].state.stage000.lastCheckTime = 0;
+        state000.channelStarted = false;
+        state000.lastCheckTime = 0;
         
+        prefetchStageCues(STAGE_000_0_PREFETCH, STAGE_TYPE_000_0, 0);
         Serial.println(F("⏳ 等待通道到达启动时间..."));
-        activeStageCount++;
         updateCompatibilityVars();
         return true;
-    } else if (normalizedId == "001_2") {
+    } else if (type == STAGE_TYPE_001_2) {
         Serial.print(F("🎵 环节001_2：通道"));
         Serial.print(STAGE_001_2_CHANNEL);
         Serial.print(F("播放"));
@@ -173,20 +303,19 @@ bool GameFlowManager::startStage(const String& stageId) {
         Serial.print(STAGE_001_2_FADE_DURATION);
         Serial.println(F("ms)"));
         
-        // 设置第2路初始音量
+        // 第2路从初始音量淡出，结束后停止播放（由语音控制器按限速驱动）
         voice.setVolume(STAGE_001_2_FADE_CHANNEL, STAGE_001_2_FADE_START_VOL);
+        voice.fadeTo(STAGE_001_2_FADE_CHANNEL, STAGE_001_2_FADE_END_VOL, STAGE_001_2_FADE_DURATION,
+                     STAGE_001_2_FADE_CURVE, true);
         
         // 初始化环节特定状态
-        stages[slot].state.stage001_2.channelStarted = false;
-        stages[slot].state.stage001_2.lastVolumeUpdate = 0;
-        stages[slot].state.stage001_2.currentVolume = STAGE_001_2_FADE_START_VOL;
-        stages[slot].state.stage001_2.volumeUpdateComplete = false;
+        state001_2.channelStarted = false;
         
+        prefetchStageCues(STAGE_001_2_PREFETCH, STAGE_TYPE_001_2, 0);
         Serial.println(F("⏳ 等待通道到达启动时间..."));
-        activeStageCount++;
         updateCompatibilityVars();
         return true;
-    } else if (normalizedId == "002_0") {
+    } else if (type == STAGE_TYPE_002_0) {
         Serial.print(F("🎵 环节002_0：通道"));
         Serial.print(STAGE_002_0_CHANNEL1);
         Serial.print(F("播放"));
@@ -208,18 +337,18 @@ bool GameFlowManager::startStage(const String& stageId) {
         Serial.println(F("音量为默认值"));
         
         // 初始化环节特定状态
-        stages[slot].state.stage002.channel1Started = false;
-        stages[slot].state.stage002.channel2Started = false;
-        stages[slot].state.stage002.multiJumpTriggered = false;
+        state002.channel1Started = false;
+        state002.channel2Started = false;
+        state002.multiJumpTriggered = false;
         
+        prefetchStageCues(STAGE_002_0_PREFETCH, STAGE_TYPE_002_0, 0);
         Serial.println(F("⏳ 等待各通道到达启动时间..."));
-        activeStageCount++;
         updateCompatibilityVars();
         return true;
     } else {
         Serial.print(F("❌ 未定义的C102环节: "));
-        Serial.println(normalizedId);
-        stages[slot].running = false;
+        Serial.println(getStageName(type));
+        releaseSlot(slot);
         return false;
     }
 }
@@ -230,34 +359,28 @@ bool GameFlowManager::startMultipleStages(const String& stageIds) {
     Serial.println(F(" ==="));
     
     int successCount = 0;
-    int startPos = 0;
-    
-    // 解析逗号分隔的环节ID列表
-    while (startPos < stageIds.length()) {
-        int commaPos = stageIds.indexOf(',', startPos);
-        String stageId;
-        
-        if (commaPos < 0) {
-            // 最后一个环节
-            stageId = stageIds.substring(startPos);
-        } else {
-            // 中间的环节
-            stageId = stageIds.substring(startPos, commaPos);
+    const char* ids = stageIds.c_str();
+    unsigned int length = stageIds.length();
+    unsigned int tokenStart = 0;
+    
+    // 单遍扫描逗号分隔的环节ID列表，原地驻留，不生成子串
+    for (unsigned int i = 0; i <= length; i++) {
+        if (i < length && ids[i] != ',') {
+            continue;
         }
         
-        // 去除前后空格
-        stageId.trim();
-        
-        if (stageId.length() > 0) {
-            if (startStage(stageId)) {
+        unsigned int tokenLength = i - tokenStart;
+        uint8_t type = internStageId(ids + tokenStart, tokenLength);
+        if (type != STAGE_TYPE_NONE) {
+            if (startStageType(type)) {
                 successCount++;
             }
+        } else if (tokenLength > 0) {
+            Serial.print(F("❌ 未定义的C102环节: "));
+            Serial.write((const uint8_t*)(ids + tokenStart), tokenLength);
+            Serial.println();
         }
-        
-        if (commaPos < 0) {
-            break;
-        }
-        startPos = commaPos + 1;
+        tokenStart = i + 1;
     }
     
     Serial.print(F("✅ 成功启动"));
@@ -269,39 +392,30 @@ bool GameFlowManager::startMultipleStages(const String& stageIds) {
 }
 
 void GameFlowManager::stopStage(const String& stageId) {
-    String normalizedId = normalizeStageId(stageId);
-    int index = findStageIndex(normalizedId);
+    int index = findStageIndex(stageId);
     
     if (index >= 0) {
         Serial.print(F("⏹️ 停止环节[槽位"));
         Serial.print(index);
         Serial.print(F("]: "));
-        Serial.println(normalizedId);
+        Serial.println(getStageName(stages[index].type));
         
-        stages[index].running = false;
-        stages[index].stageId = "";
-        activeStageCount--;
+        releaseSlot(index);
         updateCompatibilityVars();
     }
 }
 
 void GameFlowManager::stopCurrentStage() {
     // 兼容旧接口：停止第一个活跃环节
-    if (activeStageCount > 0) {
-        for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-            if (stages[i].running) {
-                Serial.print(F("⏹️ 结束当前环节[槽位"));
-                Serial.print(i);
-                Serial.print(F("]: "));
-                Serial.println(stages[i].stageId);
-                
-                stages[i].running = false;
-                stages[i].stageId = "";
-                activeStageCount--;
-                updateCompatibilityVars();
-                break;
-            }
-        }
+    if (runningMask != 0) {
+        int i = __builtin_ctz(runningMask);
+        Serial.print(F("⏹️ 结束当前环节[槽位"));
+        Serial.print(i);
+        Serial.print(F("]: "));
+        Serial.println(getStageName(stages[i].type));
+        
+        releaseSlot(i);
+        updateCompatibilityVars();
     }
 }
 
@@ -322,11 +436,11 @@ void GameFlowManager::stopAllStages() {
     for (int channel = 1; channel <= 4; channel++) {
         voice.stop(channel);
     }
+    voice.cancelAllPrefetch();  // 放弃未发出的预选
     
     // 重置所有环节状态
-    for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-        stages[i].running = false;
-        stages[i].stageId = "";
+    while (runningMask != 0) {
+        releaseSlot(__builtin_ctz(runningMask));
     }
     activeStageCount = 0;
     updateCompatibilityVars();
@@ -347,9 +461,7 @@ bool GameFlowManager::isStageRunning() const {
 }
 
 bool GameFlowManager::isStageRunning(const String& stageId) {
-    String normalizedId = normalizeStageId(stageId);
-    int index = findStageIndex(normalizedId);
-    return (index >= 0 && stages[index].running);
+    return findStageIndex(stageId) >= 0;
 }
 
 unsigned long GameFlowManager::getStageElapsedTime() const {
@@ -360,9 +472,8 @@ unsigned long GameFlowManager::getStageElapsedTime() const {
 }
 
 unsigned long GameFlowManager::getStageElapsedTime(const String& stageId) {
-    String normalizedId = normalizeStageId(stageId);
-    int index = findStageIndex(normalizedId);
-    if (index >= 0 && stages[index].running) {
+    int index = findStageIndex(stageId);
+    if (index >= 0) {
         return millis() - stages[index].startTime;
     }
     return 0;
@@ -375,18 +486,15 @@ int GameFlowManager::getActiveStageCount() const {
 void GameFlowManager::getActiveStages(String stages[], int maxCount) {
     int count = 0;
     for (int i = 0; i < MAX_PARALLEL_STAGES && count < maxCount; i++) {
-        if (this->stages[i].running) {
-            stages[count++] = this->stages[i].stageId;
+        if (isSlotRunning(i)) {
+            stages[count++] = getStageName(this->stages[i].type);
         }
     }
 }
 
 // ========================== 环节列表 ==========================
 bool GameFlowManager::isValidStageId(const String& stageId) {
-    String normalizedId = normalizeStageId(stageId);
-    return (normalizedId == "000_0" || 
-            normalizedId == "001_2" || 
-            normalizedId == "002_0");
+    return internStageId(stageId) != STAGE_TYPE_NONE;
 }
 
 void GameFlowManager::printAvailableStages() {
@@ -431,7 +539,7 @@ void GameFlowManager::printAvailableStages() {
 
 // ========================== 更新和调试功能 ==========================
 void GameFlowManager::update() {
-    if (activeStageCount == 0) {
+    if (runningMask == 0) {
         return;
     }
     
@@ -440,24 +548,22 @@ void GameFlowManager::update() {
         return;
     }
     
-    // 更新所有运行中的环节
-    for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-        if (stages[i].running) {
-            const String& stageId = stages[i].stageId;
-            
-            // 根据环节ID调用对应的更新方法
-            if (stageId == "000_0") {
-                updateStep000(i);
-            } else if (stageId == "001_2") {
-                updateStep001_2(i);
-            } else if (stageId == "002_0") {
-                updateStep002(i);
-            }
+    // 按运行位图更新环节（兼容性变量只在启停/跳转时更新）
+    uint16_t pending = runningMask;
+    while (pending != 0) {
+        int i = __builtin_ctz(pending);
+        pending &= pending - 1;
+        if (!isSlotRunning(i)) {
+            continue;
+        }
+        
+        switch (stages[i].type) {
+            case STAGE_TYPE_000_0: updateStep000(i); break;
+            case STAGE_TYPE_001_2: updateStep001_2(i); break;
+            case STAGE_TYPE_002_0: updateStep002(i); break;
+            default: break;
         }
     }
-    
-    // 更新兼容性变量
-    updateCompatibilityVars();
 }
 
 void GameFlowManager::printStatus() {
@@ -472,11 +578,11 @@ void GameFlowManager::printStatus() {
     if (activeStageCount > 0) {
         Serial.println(F("--- 运行中的环节 ---"));
         for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-            if (stages[i].running) {
+            if (isSlotRunning(i)) {
                 Serial.print(F("[槽位"));
                 Serial.print(i);
                 Serial.print(F("] "));
-                Serial.print(stages[i].stageId);
+                Serial.print(getStageName(stages[i].type));
                 Serial.print(F(" - 运行时间: "));
                 Serial.print(millis() - stages[i].startTime);
                 Serial.print(F("ms"));
@@ -498,8 +604,8 @@ void GameFlowManager::requestStageJump(const String& nextStage) {
     // 兼容旧接口：使用第一个活跃环节
     if (activeStageCount > 0) {
         for (int i = 0; i < MAX_PARALLEL_STAGES; i++) {
-            if (stages[i].running && !stages[i].jumpRequested) {
-                requestMultiStageJump(stages[i].stageId, nextStage);
+            if (isSlotRunning(i) && !stages[i].jumpRequested) {
+                requestMultiStageJump(getStageName(stages[i].type), nextStage);
                 break;
             }
         }
@@ -526,6 +632,7 @@ void GameFlowManager::requestMultiStageJump(const String& currentStep, const Str
     int index = findStageIndex(currentStep);
     if (index >= 0) {
         stages[index].jumpRequested = true;
+        updateCompatibilityVars();
     }
 }
 
@@ -551,6 +658,7 @@ void GameFlowManager::notifyStageComplete(const String& currentStep, const Strin
     // 标记该环节已请求跳转
     if (index >= 0) {
         stages[index].jumpRequested = true;
+        updateCompatibilityVars();
     }
 }
 
@@ -572,12 +680,13 @@ void GameFlowManager::notifyStageComplete(const String& currentStep, unsigned lo
     // 标记该环节已请求跳转
     if (index >= 0) {
         stages[index].jumpRequested = true;
+        updateCompatibilityVars();
     }
 }
 
 // C102音频环节更新方法
 void GameFlowManager::updateStep000(int index) {
-    if (index < 0 || index >= MAX_PARALLEL_STAGES || !stages[index].running) {
+    if (index < 0 || index >= MAX_PARALLEL_STAGES || !isSlotRunning(index)) {
         return;
     }
     
@@ -590,9 +699,10 @@ void GameFlowManager::updateStep000(int index) {
     }
     
     // 检查通道是否到启动时间
-    if (!stage.state.stage000.channelStarted && elapsed >= STAGE_000_0_START) {
+    if (!state000.channelStarted && elapsed >= STAGE_000_0_START) {
         voice.playSong(STAGE_000_0_CHANNEL, STAGE_000_0_SONG_ID);
-        stage.state.stage000.channelStarted = true;
+        state000.channelStarted = true;
+        prefetchStageCues(STAGE_000_0_PREFETCH, STAGE_TYPE_000_0, STAGE_000_0_CHANNEL);
         Serial.print(F("🎵 [槽位"));
         Serial.print(index);
         Serial.print(F("] "));
@@ -607,8 +717,8 @@ void GameFlowManager::updateStep000(int index) {
     // 继续音频循环播放，直到收到其他命令
     
     // 持续检查音频状态，如果停止了就重新播放（只在播放稳定期后开始检测）
-    if (stage.state.stage000.channelStarted && elapsed >= STAGE_000_0_STABLE_TIME) {
-        if (elapsed - stage.state.stage000.lastCheckTime >= STAGE_000_0_CHECK_INTERVAL) {
+    if (state000.channelStarted && elapsed >= STAGE_000_0_STABLE_TIME) {
+        if (elapsed - state000.lastCheckTime >= STAGE_000_0_CHECK_INTERVAL) {
             // 检查音频状态，只有空闲时才重新播放
             if (!voice.isBusy(STAGE_000_0_CHANNEL)) {
                 voice.playSong(STAGE_000_0_CHANNEL, STAGE_000_0_SONG_ID);
@@ -619,13 +729,13 @@ void GameFlowManager::updateStep000(int index) {
                 Serial.print(F("音频播放完成，重新播放"));
                 Serial.println(STAGE_000_0_SONG_ID);
             }
-            stage.state.stage000.lastCheckTime = elapsed;
+            state000.lastCheckTime = elapsed;
         }
     }
 }
 
 void GameFlowManager::updateStep001_2(int index) {
-    if (index < 0 || index >= MAX_PARALLEL_STAGES || !stages[index].running) {
+    if (index < 0 || index >= MAX_PARALLEL_STAGES || !isSlotRunning(index)) {
         return;
     }
     
@@ -638,9 +748,10 @@ void GameFlowManager::updateStep001_2(int index) {
     }
     
     // 检查通道是否到启动时间
-    if (!stage.state.stage001_2.channelStarted && elapsed >= STAGE_001_2_START) {
+    if (!state001_2.channelStarted && elapsed >= STAGE_001_2_START) {
         voice.playSong(STAGE_001_2_CHANNEL, STAGE_001_2_SONG_ID);
-        stage.state.stage001_2.channelStarted = true;
+        state001_2.channelStarted = true;
+        prefetchStageCues(STAGE_001_2_PREFETCH, STAGE_TYPE_001_2, STAGE_001_2_CHANNEL);
         Serial.print(F("🎵 [槽位"));
         Serial.print(index);
         Serial.print(F("] "));
@@ -651,49 +762,6 @@ void GameFlowManager::updateStep001_2(int index) {
         Serial.println(STAGE_001_2_SONG_ID);
     }
     
-    // 音量淡出控制：3秒内从30减到0，每100ms减1
-    if (elapsed <= STAGE_001_2_FADE_DURATION) {
-        if (!stage.state.stage001_2.volumeUpdateComplete && 
-            elapsed - stage.state.stage001_2.lastVolumeUpdate >= STAGE_001_2_FADE_INTERVAL) {
-            // 计算当前应该的音量：30 - (elapsed / 100)
-            int targetVolume = STAGE_001_2_FADE_START_VOL - (elapsed / STAGE_001_2_FADE_INTERVAL);
-            if (targetVolume < STAGE_001_2_FADE_END_VOL) {
-                targetVolume = STAGE_001_2_FADE_END_VOL;
-            }
-            
-            if (stage.state.stage001_2.currentVolume != targetVolume) {
-                stage.state.stage001_2.currentVolume = targetVolume;
-                voice.setVolume(STAGE_001_2_FADE_CHANNEL, targetVolume);
-                stage.state.stage001_2.lastVolumeUpdate = elapsed;
-                
-                Serial.print(F("🔊 [槽位"));
-                Serial.print(index);
-                Serial.print(F("] 通道"));
-                Serial.print(STAGE_001_2_FADE_CHANNEL);
-                Serial.print(F("音量调整为"));
-                Serial.print(targetVolume);
-                Serial.print(F("("));
-                Serial.print(elapsed);
-                Serial.println(F("ms)"));
-            }
-            
-            if (targetVolume == STAGE_001_2_FADE_END_VOL) {
-                stage.state.stage001_2.volumeUpdateComplete = true;
-            }
-        }
-    } else if (elapsed >= STAGE_001_2_FADE_DURATION && 
-               elapsed < STAGE_001_2_FADE_DURATION + 200 && 
-               stage.state.stage001_2.volumeUpdateComplete) {
-        // 3秒后停止第2路音频（只执行一次）
-        voice.stop(STAGE_001_2_FADE_CHANNEL);
-        stage.state.stage001_2.volumeUpdateComplete = false; // 防止重复执行
-        Serial.print(F("⏹️ [槽位"));
-        Serial.print(index);
-        Serial.print(F("] 通道"));
-        Serial.print(STAGE_001_2_FADE_CHANNEL);
-        Serial.println(F("音频停止"));
-    }
-    
     // 83.347秒后跳转到下一环节
     if (!stage.jumpRequested && elapsed >= STAGE_001_2_DURATION) {
         // 重置第2通道音量为默认值
@@ -714,6 +782,7 @@ void GameFlowManager::updateStep001_2(int index) {
                 Serial.print(STAGE_001_2_NEXT_STAGE);
                 Serial.println(F("已在运行"));
                 stage.jumpRequested = true;  // 标记为已处理，避免重复检查
+                updateCompatibilityVars();
             }
         } else {
             Serial.print(F("⏰ [槽位"));
@@ -725,7 +794,7 @@ void GameFlowManager::updateStep001_2(int index) {
 }
 
 void GameFlowManager::updateStep002(int index) {
-    if (index < 0 || index >= MAX_PARALLEL_STAGES || !stages[index].running) {
+    if (index < 0 || index >= MAX_PARALLEL_STAGES || !isSlotRunning(index)) {
         return;
     }
     
@@ -738,9 +807,10 @@ void GameFlowManager::updateStep002(int index) {
     }
     
     // 检查通道1是否到启动时间
-    if (!stage.state.stage002.channel1Started && elapsed >= STAGE_002_0_CHANNEL1_START) {
+    if (!state002.channel1Started && elapsed >= STAGE_002_0_CHANNEL1_START) {
         voice.playSong(STAGE_002_0_CHANNEL1, STAGE_002_0_SONG_ID1);
-        stage.state.stage002.channel1Started = true;
+        state002.channel1Started = true;
+        prefetchStageCues(STAGE_002_0_PREFETCH, STAGE_TYPE_002_0, STAGE_002_0_CHANNEL1);
         Serial.print(F("🎵 [槽位"));
         Serial.print(index);
         Serial.print(F("] "));
@@ -752,9 +822,10 @@ void GameFlowManager::updateStep002(int index) {
     }
     
     // 检查通道2是否到启动时间
-    if (!stage.state.stage002.channel2Started && elapsed >= STAGE_002_0_CHANNEL2_START) {
+    if (!state002.channel2Started && elapsed >= STAGE_002_0_CHANNEL2_START) {
         voice.playSong(STAGE_002_0_CHANNEL2, STAGE_002_0_SONG_ID2);
-        stage.state.stage002.channel2Started = true;
+        state002.channel2Started = true;
+        prefetchStageCues(STAGE_002_0_PREFETCH, STAGE_TYPE_002_0, STAGE_002_0_CHANNEL2);
         Serial.print(F("🎵 [槽位"));
         Serial.print(index);
         Serial.print(F("] "));
@@ -782,34 +853,18 @@ void GameFlowManager::updateStep002(int index) {
                 Serial.print(STAGE_002_0_NEXT_STAGE);
                 Serial.println(F("已在运行"));
                 stage.jumpRequested = true;  // 标记为已处理，避免重复检查
+                updateCompatibilityVars();
             }
         } else {
             Serial.print(F("⏰ [槽位"));
             Serial.print(index);
             Serial.println(F("] 环节002_0完成（不进行跳转通知）"));
             stage.jumpRequested = true;  // 标记为已完成，避免重复执行
+            updateCompatibilityVars();
         }
     }
 }
 
-// 工具方法
-String GameFlowManager::normalizeStageId(const String& stageId) {
-    String normalized = stageId;
-    
-    // 移除引号
-    normalized.replace("\"", "");
-    
-    // C102音频格式保持下划线格式：000_0, 001_2, 002_0
-    // 不需要转换，直接返回
-    
-    Serial.print(F("🔧 环节ID标准化: "));
-    Serial.print(stageId);
-    Serial.print(F(" -> "));
-    Serial.println(normalized);
-    
-    return normalized;
-}
-
 // ========================== 音量管理方法 ==========================
 void GameFlowManager::initializeAllVolumes() {
     Serial.println(F("🔊 初始化所有通道音量..."));
@@ -819,7 +874,6 @@ void GameFlowManager::initializeAllVolumes() {
         Serial.print(channel);
         Serial.print(F("音量设置为"));
         Serial.println(DEFAULT_VOLUME);
-        delay(50); // 避免命令发送过快
     }
     Serial.println(F("✅ 所有通道音量初始化完成"));
 }
@@ -842,7 +896,6 @@ void GameFlowManager::resetAllVolumes() {
         Serial.print(channel);
         Serial.print(F("音量重置为"));
         Serial.println(DEFAULT_VOLUME);
-        delay(50); // 避免命令发送过快
     }
     Serial.println(F("✅ 所有通道音量重置完成"));
 }
\ No newline at end of file
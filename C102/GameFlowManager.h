@@ -19,7 +19,21 @@
 #include <Arduino.h>
 
 // ========================== 并行环节配置 ==========================
-#define MAX_PARALLEL_STAGES 4  // 最大并行环节数（根据需要调整）
+#define MAX_PARALLEL_STAGES 8  // 最大并行环节数（根据需要调整，最多16）
+#define STAGE_SLOT_NONE     0xFF
+
+#if MAX_PARALLEL_STAGES > 16
+#error "MAX_PARALLEL_STAGES超出runningMask位数"
+#endif
+
+// 环节类型（驻留ID）：环节ID字符串只在入口解析一次，之后按类型号调度
+enum StageType : uint8_t {
+    STAGE_TYPE_000_0 = 0,
+    STAGE_TYPE_001_2,
+    STAGE_TYPE_002_0,
+    STAGE_TYPE_COUNT,
+    STAGE_TYPE_NONE = 0xFF
+};
 
 // ========================== 音量管理配置 ==========================
 #define DEFAULT_VOLUME 30       // 默认音量值
@@ -65,7 +79,7 @@
 #define STAGE_001_2_FADE_START_VOL  30       // 起始音量
 #define STAGE_001_2_FADE_END_VOL    0        // 结束音量
 #define STAGE_001_2_FADE_DURATION   3000     // 3秒淡出时间
-#define STAGE_001_2_FADE_INTERVAL   100      // 100ms调整一次音量(30步*100ms=3000ms)
+#define STAGE_001_2_FADE_CURVE      BY_FADE_LINEAR  // 淡出曲线
 #define STAGE_001_2_DURATION        90347    // 90.347秒总时长
 #define STAGE_001_2_NEXT_STAGE      "002_0"  // 跳转目标环节
 
@@ -81,48 +95,52 @@
 #define STAGE_002_0_DURATION        60000    // 60秒默认时长（可根据实际音频长度调整）
 #define STAGE_002_0_NEXT_STAGE      ""       // 跳转目标环节（空字符串表示只报告完成，不跳转）
 
+// ========================== 音频预选声明 ==========================
+// 环节启动时预选下一环节在其他通道上的音频；与本环节同通道的音频等本环节该通道提示播出后再预选，
+// 避免覆盖本环节尚未播放的选曲（通道播放中则等空闲后再选曲），下一环节到点只发PLAY帧
+#define STAGE_000_0_PREFETCH        STAGE_TYPE_001_2   // 000_0等待服务器启动001_2
+#define STAGE_001_2_PREFETCH        STAGE_TYPE_002_0   // 与STAGE_001_2_NEXT_STAGE一致
+#define STAGE_002_0_PREFETCH        STAGE_TYPE_NONE
+
 class GameFlowManager {
 private:
-    // 环节状态结构体
+    // 环节槽位：只保存所有环节共用的调度字段，扩大槽位数不随环节状态增长
     struct StageState {
-        String stageId;              // 环节ID
-        unsigned long startTime;     // 开始时间
-        bool running;                // 是否运行中
+        uint8_t type;                // 环节类型（StageType驻留ID）
         bool jumpRequested;          // 是否已请求跳转
-        
-        // 环节特定状态（使用union节省内存）
-        union {
-            struct {  // 000_0环节状态
-                bool channelStarted;
-                unsigned long lastCheckTime;
-            } stage000;
-            
-            struct {  // 001_2环节状态
-                bool channelStarted;
-                unsigned long lastVolumeUpdate;
-                int currentVolume;
-                bool volumeUpdateComplete;
-            } stage001_2;
-            
-            struct {  // 002_0环节状态
-                bool channel1Started;
-                bool channel2Started;
-                bool multiJumpTriggered;  // 多环节跳转是否已触发
-            } stage002;
-        } state;
+        unsigned long startTime;     // 开始时间
         
         // 构造函数
-        StageState() : stageId(""), startTime(0), running(false), jumpRequested(false) {
-            memset(&state, 0, sizeof(state));
-        }
+        StageState() : type(STAGE_TYPE_NONE), jumpRequested(false), startTime(0) {}
     };
     
-    // 并行环节数组
+    // 并行环节槽位池
     StageState stages[MAX_PARALLEL_STAGES];
+    uint16_t runningMask;                    // 运行中槽位位图（bit i = 槽位i）
+    uint8_t typeSlot[STAGE_TYPE_COUNT];      // 环节类型 -> 槽位（STAGE_SLOT_NONE表示未运行）
+    
+    // ========================== 环节专属状态 ==========================
+    // 同一环节类型同时只运行一个实例，状态按类型独立分配，各自只占用本环节所需大小
+    struct {  // 000_0环节状态
+        bool channelStarted;
+        unsigned long lastCheckTime;
+    } state000;
+    
+    struct {  // 001_2环节状态
+        bool channelStarted;
+    } state001_2;
+    
+    struct {  // 002_0环节状态
+        bool channel1Started;
+        bool channel2Started;
+        bool multiJumpTriggered;  // 多环节跳转是否已触发
+    } state002;
+    
     int activeStageCount;            // 当前活跃环节数
     bool globalStopped;              // 全局停止标志
     
-    // 兼容旧接口的当前环节引用
+    // 兼容旧接口的当前环节引用（仅在运行集合或跳转标志变化时更新）
+    uint8_t compatType;              // currentStageId对应的环节类型
     String currentStageId;           // 当前环节ID（指向第一个活跃环节）
     unsigned long stageStartTime;    // 环节开始时间（指向第一个活跃环节）
     bool stageRunning;               // 环节是否运行中（任意环节运行即为true）
@@ -130,7 +148,16 @@ private:
     
     // 查找环节索引
     int findStageIndex(const String& stageId);
-    int findEmptySlot();
+    int findStageIndex(uint8_t type) const;
+    int findEmptySlot() const;
+    bool isSlotRunning(int index) const;
+    
+    // 环节启停（按类型/槽位）
+    bool startStageType(uint8_t type);
+    void releaseSlot(int index);
+    void resetStageTypeState(uint8_t type);
+    void prefetchStageCues(uint8_t type, uint8_t currentType, uint8_t channel);  // 预选下一环节音频（channel=0：跳过本环节占用的通道）
+    static bool hasStageCue(uint8_t type, uint8_t channel);  // 环节在该通道上是否有音频提示
     
     // 环节完成通知
     void notifyStageComplete(const String& currentStep, const String& nextStep, unsigned long duration);
@@ -142,7 +169,9 @@ private:
     void updateStep002(int index);            // 更新002_0环节
     
     // 工具方法
-    String normalizeStageId(const String& stageId);  // 标准化环节ID格式
+    static uint8_t internStageId(const char* stageId, unsigned int length);  // 环节ID -> StageType
+    static uint8_t internStageId(const String& stageId);
+    static const __FlashStringHelper* getStageName(uint8_t type);         // StageType -> 环节ID
     void updateCompatibilityVars();                  // 更新兼容性变量
     
     // 音量管理方法
@@ -0,0 +1,92 @@
+/**
+ * =============================================================================
+ * Harbinger二进制帧 - HarbingerFrame.h
+ * 描述信息: 可选的紧凑二进制帧格式，REGISTER时双方声明 frame=bin1 后启用，
+ *          ASCII协议始终保留作为回退。服务器端编解码见 tools/harbinger_frame.py
+ *
+ * 帧格式（多字节字段均为小端）:
+ *   SYNC(0xA5) | LEN | TYPE | CMD | PAYLOAD[LEN] | CRC16
+ *   CRC-16/CCITT-FALSE(多项式0x1021，初值0xFFFF)，覆盖LEN到PAYLOAD末尾
+ *
+ * 元器件用数字编号：REGISTER时devices列表中的位置(从0开始)
+ * =============================================================================
+ */
+
+#ifndef HARBINGER_FRAME_H
+#define HARBINGER_FRAME_H
+
+#include <Arduino.h>
+
+// ========================== 帧配置 ==========================
+#define HBF_SYNC                0xA5
+#define HBF_MAX_PAYLOAD         192     // MULTI每项6字节，可容纳31项
+#define HBF_OVERHEAD            6       // SYNC + LEN + TYPE + CMD + CRC16
+#define HBF_FRAME_TAG           "bin1"  // REGISTER / REGISTER_CONFIRM中的 frame= 取值
+
+// 消息类型（对应ASCII的[INFO]/[GAME]/[HARD]）
+#define HBF_TYPE_INFO           1
+#define HBF_TYPE_GAME           2
+#define HBF_TYPE_HARD           3
+
+// HARD命令（服务器 -> 控制器）
+#define HBF_HARD_SINGLE         0x01    // 1个条目
+#define HBF_HARD_MULTI          0x02    // N个条目，全部校验通过才提交
+#define HBF_HARD_EMERGENCY      0x03    // scope(1)
+
+// HARD响应（控制器 -> 服务器）
+#define HBF_HARD_ACK            0x81    // cmd(1) total(1) success(1) committed(1) item_results(4, bit i=第i项)
+#define HBF_HARD_ERROR          0x82    // cmd(1) code(1)
+
+// HARD条目: first(1) last(1) action(1) brightness(1, 0-100) cycle_ms(2)
+#define HBF_HARD_ITEM_SIZE      6
+
+// 错误码
+#define HBF_ERR_UNKNOWN_COMMAND 1
+#define HBF_ERR_BAD_LENGTH      2
+
+// 解析结果
+#define HBF_PARSE_PENDING       0
+#define HBF_PARSE_DONE          1
+#define HBF_PARSE_ERROR         -1
+
+struct HarbingerFrame {
+    uint8_t type;
+    uint8_t command;
+    uint8_t length;
+    uint8_t payload[HBF_MAX_PAYLOAD];
+
+    uint16_t readWord(uint8_t offset) const {
+        return payload[offset] | ((uint16_t)payload[offset + 1] << 8);
+    }
+};
+
+// ========================== 流式解析器 ==========================
+// 逐字节喂入，收齐一帧并通过CRC后返回HBF_PARSE_DONE
+class HarbingerFrameParser {
+private:
+    uint8_t state;
+    uint8_t index;
+    uint16_t crc;
+    uint8_t crcLow;
+    HarbingerFrame frame;
+
+public:
+    HarbingerFrameParser();
+
+    void reset();
+    bool isReceiving() const { return state != 0; }
+    int8_t feed(uint8_t data);
+    const HarbingerFrame& getFrame() const { return frame; }
+};
+
+// ========================== 编码 ==========================
+uint16_t hbfCrc16(uint16_t crc, uint8_t data);
+
+/**
+ * @brief 编码一帧到out
+ * @return 帧总长度，0表示缓冲不足或负载过长
+ */
+uint8_t hbfEncode(uint8_t type, uint8_t command, const uint8_t* payload, uint8_t length,
+                  uint8_t* out, uint8_t outSize);
+
+#endif // HARBINGER_FRAME_H
@@ -47,6 +47,8 @@ void HardProtocolHandler::processHardMessage(const String& message) {
         handleHardMulti(params);
     } else if (command == "EMERGENCY") {
         handleHardEmergency(params);
+    } else if (command == "STATUS") {
+        handleHardStatus(params);
     } else {
         #ifdef DEBUG
         Serial.print(F("未知HARD命令: "));
@@ -140,6 +142,52 @@ void HardProtocolHandler::handleHardEmergency(const String& params) {
     sendHardEmergencyAck(scope);
 }
 
+// 音频通道状态：返回缓存值（-1=未知），refresh=1时同时向模块发出查询，下次STATUS即为最新值
+void HardProtocolHandler::handleHardStatus(const String& params) {
+    String componentId = extractParam(params, "component_id");
+    bool refresh = extractParamValue(params, "refresh", 0) != 0;
+    
+    int firstChannel = 1;
+    int lastChannel = 4;
+    if (componentId.length() > 0) {
+        if (!validateComponentId(componentId) || componentId.substring(3, 5) != "MA") {
+            sendHardError("无效的元器件ID: " + componentId);
+            return;
+        }
+        firstChannel = lastChannel = componentId.substring(5, 7).toInt();
+        if (firstChannel < 1 || firstChannel > 4) {
+            sendHardError("无效的音频通道: " + componentId);
+            return;
+        }
+    }
+    
+    String result = "";
+    for (int channel = firstChannel; channel <= lastChannel; channel++) {
+        const BY_ModuleState* st = voice.getState(channel);
+        if (st == nullptr) continue;
+        
+        if (result.length() > 0) result += ";";
+        result += "channel=" + String(channel);
+        result += ",volume=" + String(st->volume == BY_VOLUME_UNKNOWN ? -1 : (int)st->volume);
+        result += ",eq=" + String(st->eq == 0xFF ? -1 : (int)st->eq);
+        result += ",cycle=" + String(st->cycle == 0xFF ? -1 : (int)st->cycle);
+        result += ",track=" + String(st->track);
+        result += ",state=" + String(st->playState == BY_STATE_UNKNOWN ? -1 : (int)st->playState);
+        result += ",busy=" + String(voice.isBusy(channel) ? 1 : 0);
+        
+        if (refresh) {
+            voice.queryState(channel);
+        }
+    }
+    
+    #ifdef DEBUG
+    Serial.print(F("音频状态: "));
+    Serial.println(result);
+    #endif
+    
+    sendHardStatusAck(result);
+}
+
 bool HardProtocolHandler::executeComponentControl(const String& componentId, const String& action, const String& controlParams) {
     String componentType = componentId.substring(3, 5);
     
@@ -342,6 +390,10 @@ void HardProtocolHandler::sendHardEmergencyAck(const String& scope) {
     harbingerClient.sendHARDResponse("EMERGENCY_ACK", result);
 }
 
+void HardProtocolHandler::sendHardStatusAck(const String& result) {
+    harbingerClient.sendHARDResponse("STATUS_ACK", result);
+}
+
 void HardProtocolHandler::sendHardError(const String& errorMsg) {
     harbingerClient.sendHARDResponse("ERROR", "message=" + errorMsg);
 } 
\ No newline at end of file
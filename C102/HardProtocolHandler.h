@@ -16,6 +16,7 @@ private:
     void handleHardSingle(const String& params);
     void handleHardMulti(const String& params);
     void handleHardEmergency(const String& params);
+    void handleHardStatus(const String& params);
     
     // 组件控制函数
     bool executeComponentControl(const String& componentId, const String& action, const String& controlParams);
@@ -27,6 +28,7 @@ private:
     void sendHardSingleAck(const String& componentId, const String& action);
     void sendHardMultiAck(int total, int success);
     void sendHardEmergencyAck(const String& scope);
+    void sendHardStatusAck(const String& result);
     void sendHardError(const String& errorMsg);
     
     // 验证和辅助函数
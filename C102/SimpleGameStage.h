@@ -85,7 +85,7 @@ public:
     
     // === 专用快捷方法（最常用的几种） ===
     void ledBreathing(unsigned long startTime, unsigned long duration, int pin, float cycleSeconds = 2.0);
-    void ledFlash(unsigned long startTime, unsigned long duration, int pin, int intervalMs = 100);
+    void ledFlash(unsigned long startTime, unsigned long duration, int pin, int intervalMs = 100, int offMs = 0);
     void pwmRamp(unsigned long startTime, unsigned long duration, int pin, int fromValue, int toValue);
     void digitalPulse(unsigned long startTime, unsigned long duration, int pin);
     void jumpToStage(unsigned long startTime, int nextStage);                    // 数字版本（向后兼容）
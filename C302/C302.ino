@@ -21,6 +21,9 @@
 #include "ArduinoSystemHelper.h"
 #include "UniversalHarbingerClient.h"
 #include "GameProtocolHandler.h"
+#include "HardProtocolHandler.h"
+#include "EventTrace.h"
+#include "GameCheckpoint.h"
 #include "C302_SimpleConfig.h"
 
 // ========================== 配置 ==========================
@@ -28,12 +31,17 @@
 #define DEBUG 1
 #define CONTROLLER_ID "C302"
 #define ENABLE_NETWORK true  // 网络开关
+#define ENABLE_GROUP_MULTICAST false // 组播组命令（多控制器同步效果），需要ENABLE_NETWORK；额外占用一个W5100 socket且数据报无认证，仅在隔离的展厅网络中开启
 
 void setup() {
     // 初始化串口
-    Serial.begin(SERIAL_BAUDRATE);
-    while (!Serial && millis() < 3000); // 等待串口就绪，最多3秒
-  
+    Serial.begin(SERIAL_BAUDRATE);   // Mega的硬件串口无需等待USB枚举
+    
+    // ========================== C302硬件初始化 ==========================
+    // 最先执行：灯光输出拉低、按键上拉，上电后立即处于安全状态
+    initC302Hardware();
+    harbingerClient.markBootPhase(F("hw"));
+    
     // 初始化各个组件
     MPWM_BEGIN();              // PWM系统 (核心)
     DIO_BEGIN();               // 数字IO控制器
@@ -41,52 +49,59 @@ void setup() {
     gameStageManager.begin();  // 游戏环节状态机
     gameFlowManager.begin();   // 游戏流程管理器
     gameProtocolHandler.begin(); // 游戏协议处理器
+    hardProtocolHandler.begin(CONTROLLER_ID); // 硬件协议处理器
+    
+    // 录制/回放：回放时由EventTrace送入录制的输入，网络发送经钩子记录
+    EventTrace::setReplayHandlers(handleSerialLine, onNetworkMessage, onNetworkFrame);
+    harbingerClient.setSendHook(EventTrace::onSend);
+    
+    // 断电恢复：在以太网初始化之前恢复环节，恢复信息随首次REGISTER上报
+    if (GameCheckpoint::restore()) {
+        harbingerClient.setRegisterParams(GameCheckpoint::getRecoveryParams());
+    }
+    harbingerClient.markBootPhase(F("game"));
     
     // 网络初始化（可选）
     if (ENABLE_NETWORK) {
         Serial.println(F("初始化网络系统..."));
         systemHelper.begin(CONTROLLER_ID, 0);  // 无硬件设备配置
         systemHelper.setMessageCallback(onNetworkMessage);  // 必须在initNetwork之前设置
+        harbingerClient.setFrameCallback(onNetworkFrame);    // 声明支持HARD二进制帧
         
         IPAddress serverIP(192, 168, 10, 10);
         if (systemHelper.initNetwork(serverIP, 9000)) {
             Serial.println(F("网络初始化成功"));
+            if (ENABLE_GROUP_MULTICAST) {
+                IPAddress groupIP(239, 255, 10, 10);
+                harbingerClient.joinGroup(groupIP);
+            }
   } else {
             Serial.println(F("网络初始化失败"));
   }
 }
 
-    // ========================== C302硬件初始化 ==========================
-    Serial.println(F("初始化C302硬件..."));
-    
-    // 使用配置文件中的硬件初始化函数
-    initC302Hardware();
-    
     Serial.print(F("C302硬件初始化完成 - "));
     Serial.print(C302_DEVICE_COUNT);
     Serial.print(F("个设备 + 25个按键 ("));
     Serial.print(C302_DEVICE_COUNT + 25);
     Serial.println(F("个引脚)"));
     Serial.println(F("所有组件初始化完成"));
-
+    harbingerClient.markBootPhase(F("setup"));   // 以太网链路和服务器连接在loop中后台完成
 }
 
 void loop() {
+    EventTrace::loopTick();           // 录制/回放时统计loop耗时
+    
 // ========================== 串口命令处理 ==========================
-    if (Serial.available()) {
+    if (EventTrace::isReplaying()) {
+        EventTrace::replayUpdate();   // 回放：串口只传记录，按虚拟时钟送入到点的输入
+    } else if (Serial.available()) {
   String command = Serial.readStringUntil('\n');
   command.trim();
   
         if (command.length() > 0) {
-            Serial.print(F(">>> "));
-            Serial.println(command);
-            
-            // 直接交给命令处理器处理
-            bool processed = commandProcessor.processCommand(command);
-            
-            if (!processed) {
-                Serial.println(F("未知命令，输入 'help' 查看帮助"));
-            }
+            EventTrace::recordSerialLine(command);
+            handleSerialLine(command);
       }
     }
     
@@ -94,24 +109,42 @@ void loop() {
     MPWM_UPDATE();                    // PWM更新 (必须调用)
     DIO_UPDATE();                     // 数字IO更新 (必须调用)
     
-    // 网络更新（如果启用）
-    if (ENABLE_NETWORK) {
+    // 网络更新（如果启用，回放时网络不收不发）
+    if (ENABLE_NETWORK && !EventTrace::isReplaying()) {
         systemHelper.checkNetworkHealth();
         harbingerClient.handleAllNetworkOperations();
     }
     
     // ========================== 游戏流程执行 ==========================
     gameFlowManager.update();  // 游戏流程更新（按键检测等）
+    GameCheckpoint::update();  // 进度检查点（非阻塞写EEPROM）
+}
+
+// ========================== 串口命令 ==========================
+void handleSerialLine(const String& command) {
+    Serial.print(F(">>> "));
+    Serial.println(command);
+    
+    // 直接交给命令处理器处理
+    bool processed = commandProcessor.processCommand(command);
+    
+    if (!processed) {
+        Serial.println(F("未知命令，输入 'help' 查看帮助"));
+    }
 }
 
 // ========================== 网络消息回调 ==========================
 void onNetworkMessage(String message) {
+    EventTrace::recordMessage(message);
+    
     Serial.print(F("收到网络消息: "));
     Serial.println(message);
     
     // 将GAME消息委托给专用处理器
     if (message.indexOf("[GAME]") != -1) {
         gameProtocolHandler.processGameMessage(message);
+    } else if (message.indexOf("[HARD]") != -1) {
+        hardProtocolHandler.processHardMessage(message);
     } else {
         // 简单处理其他消息类型
         if (message.indexOf("REGISTER_CONFIRM") != -1) {
@@ -122,5 +155,11 @@ void onNetworkMessage(String message) {
     }
 }
 
-
-
+// ========================== 二进制帧回调 ==========================
+void onNetworkFrame(const HarbingerFrame& frame) {
+    EventTrace::recordFrame(frame);
+    
+    if (frame.type == HBF_TYPE_HARD) {
+        hardProtocolHandler.processHardFrame(frame);
+    }
+}
@@ -7,11 +7,14 @@
  */
 
 #include "CommandProcessor.h"
+#include "CommandTable.h"
 #include "MillisPWM.h"
 #include "UniversalHarbingerClient.h"
 #include "DigitalIOController.h"
 #include "GameFlowManager.h"
 #include "GameStageStateMachine.h"
+#include "EventTrace.h"
+#include "GameCheckpoint.h"
 
 // ========================== 全局实例 ==========================
 CommandProcessor commandProcessor;
@@ -28,6 +31,246 @@ void CommandProcessor::begin() {
     #endif
 }
 
+// ========================== 命令表处理函数 ==========================
+// 参数已由CommandTable按表项规格解析完毕
+
+static bool cmdPwmSet(const CommandArgs& args) {
+    MillisPWM::setBrightness(args.intAt(0), args.intAt(1));
+    return true;
+}
+
+static bool cmdPwmBreathing(const CommandArgs& args) {
+    MillisPWM::startBreathing(args.intAt(0), args.intAt(1) / 1000.0);
+    return true;
+}
+
+static bool cmdPwmStop(const CommandArgs& args) {
+    MillisPWM::stop(args.intAt(0));
+    return true;
+}
+
+static bool cmdPwmStopAll(const CommandArgs& args) {
+    MillisPWM::stopAll();
+    return true;
+}
+
+static bool cmdPwmRangeBreathing(const CommandArgs& args) {
+    // startPin,endPin,minCycle,maxCycle(秒)
+    MillisPWM::startRangeBreathing(args.intAt(0), args.intAt(1), args.floatAt(2), args.floatAt(3));
+    return true;
+}
+
+static bool cmdPwmFadeIn(const CommandArgs& args) {
+    // pin,targetValue,durationMs 或 pin,durationMs (目标值默认255)
+    if (args.count == 3) {
+        MillisPWM::fadeIn(args.intAt(0), args.intAt(1), args.intAt(2));
+    } else {
+        MillisPWM::fadeIn(args.intAt(0), 255, args.intAt(1));
+    }
+    return true;
+}
+
+static bool cmdPwmFadeOut(const CommandArgs& args) {
+    MillisPWM::fadeOut(args.intAt(0), args.intAt(1));
+    return true;
+}
+
+static bool cmdPwmFadeTo(const CommandArgs& args) {
+    MillisPWM::fadeTo(args.intAt(0), args.intAt(1), args.intAt(2));
+    return true;
+}
+
+static bool cmdPwmStopFade(const CommandArgs& args) {
+    MillisPWM::stopFade(args.intAt(0));
+    return true;
+}
+
+static bool cmdDioStatus(const CommandArgs& args) {
+    Serial.print(F("活跃输出通道: "));
+    Serial.println(DigitalIOController::getActiveOutputCount());
+    Serial.print(F("活跃输入通道: "));
+    Serial.println(DigitalIOController::getActiveInputCount());
+    Serial.print(F("系统运行时间: "));
+    Serial.println(DigitalIOController::getSystemUptime());
+    return true;
+}
+
+static bool cmdDioStopAll(const CommandArgs& args) {
+    DigitalIOController::stopAllOutputs();
+    DigitalIOController::stopAllInputs();
+    return true;
+}
+
+static bool cmdGameProtocol(const CommandArgs& args) {
+    // UGP协议命令原样转交状态机
+    return gameStateMachine.processGameCommand(*args.command, *args.params);
+}
+
+static bool cmdStartStage(const CommandArgs& args) {
+    // 环节测试命令 - 委托给GameFlowManager处理
+    return gameFlowManager.startStage(*args.command);
+}
+
+static bool cmdGameStop(const CommandArgs& args) {
+    gameFlowManager.stopAllStages();
+    return true;
+}
+
+static bool cmdGameStatus(const CommandArgs& args) {
+    gameFlowManager.printStatus();
+    return true;
+}
+
+static bool cmdGameStages(const CommandArgs& args) {
+    gameFlowManager.printAvailableStages();
+    return true;
+}
+
+static bool cmdGameDebug(const CommandArgs& args) {
+    gameStage.printAllSegments();
+    return true;
+}
+
+static bool cmdHelp(const CommandArgs& args) {
+    commandProcessor.showHelp();
+    return true;
+}
+
+static bool cmdStatus(const CommandArgs& args) {
+    commandProcessor.showStatus();
+    return true;
+}
+
+static bool cmdReset(const CommandArgs& args) {
+    // 重置所有系统
+    MillisPWM::stopAll();
+    gameStateMachine.setState(GAME_IDLE);
+    #ifdef DEBUG
+    Serial.println(F("CommandProcessor: 系统已重置"));
+    #endif
+    return true;
+}
+
+static bool cmdDebug(const CommandArgs& args) {
+    #ifdef DEBUG
+    Serial.println(F("=== 调试信息 ==="));
+    gameStateMachine.printStatus();
+    Serial.print(F("活跃PWM通道: "));
+    Serial.println(MillisPWM::getActiveCount());
+    #endif
+    return true;
+}
+
+static bool cmdTraceOn(const CommandArgs& args) {
+    EventTrace::startCapture();
+    return true;
+}
+
+static bool cmdTraceOff(const CommandArgs& args) {
+    EventTrace::stopCapture();
+    return true;
+}
+
+static bool cmdTraceReplay(const CommandArgs& args) {
+    return EventTrace::startReplay();
+}
+
+static bool cmdTraceStatus(const CommandArgs& args) {
+    EventTrace::printStatus();
+    return true;
+}
+
+static bool cmdCheckpointStatus(const CommandArgs& args) {
+    GameCheckpoint::printStatus();
+    return true;
+}
+
+static bool cmdCheckpointClear(const CommandArgs& args) {
+    GameCheckpoint::clear();
+    Serial.println(F("✅ 检查点已清除"));
+    return true;
+}
+
+// ========================== 命令表 ==========================
+// 表顺序即帮助顺序；模式命令(p24、o24h等)只登记帮助，由processCommand中的模式解析处理
+#define COMMAND_LIST(X) \
+    CMD_TITLE(X, "简化PWM命令:") \
+    CMD_PATTERN(X, "p<pin>", " <value>", "设置PWM (如: p24 128)") \
+    CMD_PATTERN(X, "b<pin>", " <period>", "呼吸灯毫秒 (如: b24 1000)") \
+    CMD_PATTERN(X, "s<pin>", "", "停止PWM (如: s24)") \
+    \
+    CMD_TITLE(X, "简化Fade渐变命令:") \
+    CMD_PATTERN(X, "f<pin>", " <duration>", "淡入到最亮 (如: f24 1000)") \
+    CMD_PATTERN(X, "fo<pin>", " <duration>", "淡出到0 (如: fo24 1000)") \
+    CMD_PATTERN(X, "ft<pin>", " <target> <dur>", "渐变到指定亮度 (如: ft24 128 1000)") \
+    CMD_PATTERN(X, "fs<pin>", "", "停止渐变 (如: fs24)") \
+    \
+    CMD_TITLE(X, "批量PWM命令 (连续10个引脚):") \
+    CMD_PATTERN(X, "pa<pin>", " <value>", "批量设置PWM (如: pa20 128)") \
+    CMD_PATTERN(X, "ba<pin>", " <period>", "批量呼吸灯 (如: ba10 1000)") \
+    CMD_PATTERN(X, "sa<pin>", "", "批量停止 (如: sa20)") \
+    \
+    CMD_TITLE(X, "完整PWM命令:") \
+    CMD_ENTRY(X, "pwm_set", CMD_ARGS(2, 2), cmdPwmSet, ":<pin>,<value>", "设置亮度") \
+    CMD_ENTRY(X, "pwm_breathing", CMD_ARGS(2, 2), cmdPwmBreathing, ":<pin>,<period_ms>", "呼吸灯") \
+    CMD_ENTRY_F(X, "pwm_range_breathing", CMD_ARGS(4, 4), CMD_ARG_FLOAT(2) | CMD_ARG_FLOAT(3), \
+                cmdPwmRangeBreathing, ":<start>,<end>,<min>,<max>", "范围呼吸灯(周期秒)") \
+    CMD_ENTRY(X, "pwm_stop", CMD_ARGS(1, 1), cmdPwmStop, ":<pin>", "停止") \
+    CMD_ENTRY(X, "pwm_stop_all", CMD_NO_ARGS, cmdPwmStopAll, "", "停止全部") \
+    \
+    CMD_TITLE(X, "完整Fade命令:") \
+    CMD_ENTRY(X, "pwm_fadein", CMD_ARGS(2, 3), cmdPwmFadeIn, ":<pin>,[target,]<duration>", "淡入") \
+    CMD_ENTRY(X, "pwm_fadeout", CMD_ARGS(2, 2), cmdPwmFadeOut, ":<pin>,<duration>", "淡出") \
+    CMD_ENTRY(X, "pwm_fadeto", CMD_ARGS(3, 3), cmdPwmFadeTo, ":<pin>,<target>,<duration>", "渐变至") \
+    CMD_ENTRY(X, "pwm_stop_fade", CMD_ARGS(1, 1), cmdPwmStopFade, ":<pin>", "停止渐变") \
+    \
+    CMD_TITLE(X, "数字IO命令:") \
+    CMD_PATTERN(X, "o<pin>h/l", "", "输出高/低电平 (如: o24h)") \
+    CMD_PATTERN(X, "pulse<pin>", ":<width>", "脉冲输出 (如: pulse24:1000)") \
+    CMD_PATTERN(X, "t<pin>h/l", ":<delay>:<duration>", "定时输出 (如: t24h:500:2000)") \
+    CMD_PATTERN(X, "i<pin>", "", "监控输入变化 (如: i25)") \
+    CMD_ENTRY(X, "dio_status", CMD_NO_ARGS, cmdDioStatus, "", "数字IO状态") \
+    CMD_ENTRY(X, "dio_stop_all", CMD_NO_ARGS, cmdDioStopAll, "", "停止所有数字IO") \
+    \
+    CMD_TITLE(X, "游戏命令:") \
+    CMD_ENTRY(X, "INIT", CMD_NO_ARGS, cmdGameProtocol, "", "游戏初始化") \
+    CMD_ENTRY(X, "START", CMD_NO_ARGS, cmdGameProtocol, "", "开始游戏") \
+    CMD_ENTRY(X, "STOP", CMD_NO_ARGS, cmdGameProtocol, "", "停止游戏") \
+    CMD_ENTRY(X, "PAUSE", CMD_NO_ARGS, cmdGameProtocol, "", "暂停游戏") \
+    CMD_ENTRY(X, "RESUME", CMD_NO_ARGS, cmdGameProtocol, "", "恢复游戏") \
+    CMD_ENTRY(X, "EMERGENCY_STOP", CMD_NO_ARGS, cmdGameProtocol, "", "紧急停止") \
+    CMD_ENTRY(X, "072-0", CMD_NO_ARGS, cmdStartStage, "", "启动环节072-0 (引脚24亮起)") \
+    CMD_ALIAS(X, "stage_072_0", CMD_NO_ARGS, cmdStartStage) \
+    CMD_ENTRY(X, "072-0.5", CMD_NO_ARGS, cmdStartStage, "", "启动环节072-0.5 (引脚26亮起)") \
+    CMD_ALIAS(X, "stage_072_0_5", CMD_NO_ARGS, cmdStartStage) \
+    CMD_ENTRY(X, "072-4", CMD_NO_ARGS, cmdStartStage, "", "启动环节072-4 (引脚28亮起)") \
+    CMD_ALIAS(X, "stage_072_4", CMD_NO_ARGS, cmdStartStage) \
+    CMD_ENTRY(X, "game_stop", CMD_NO_ARGS, cmdGameStop, "", "停止所有游戏环节") \
+    CMD_ALIAS(X, "stop_game", CMD_NO_ARGS, cmdGameStop) \
+    CMD_ENTRY(X, "game_status", CMD_NO_ARGS, cmdGameStatus, "", "查看游戏流程状态") \
+    CMD_ENTRY(X, "game_stages", CMD_NO_ARGS, cmdGameStages, "", "查看所有可用环节") \
+    CMD_ENTRY(X, "game_debug", CMD_NO_ARGS, cmdGameDebug, "", "显示时间段调试信息") \
+    CMD_ALIAS(X, "debug_segments", CMD_NO_ARGS, cmdGameDebug) \
+    \
+    CMD_TITLE(X, "系统命令:") \
+    CMD_ENTRY(X, "help", CMD_NO_ARGS, cmdHelp, "", "显示帮助 (或 h)") \
+    CMD_ALIAS(X, "h", CMD_NO_ARGS, cmdHelp) \
+    CMD_ENTRY(X, "status", CMD_NO_ARGS, cmdStatus, "", "显示状态") \
+    CMD_ENTRY(X, "reset", CMD_NO_ARGS, cmdReset, "", "重置系统") \
+    CMD_ENTRY(X, "debug", CMD_NO_ARGS, cmdDebug, "", "调试信息") \
+    \
+    CMD_TITLE(X, "录制/回放命令:") \
+    CMD_ENTRY(X, "trace_on", CMD_NO_ARGS, cmdTraceOn, "", "开始录制外部事件") \
+    CMD_ENTRY(X, "trace_off", CMD_NO_ARGS, cmdTraceOff, "", "结束录制") \
+    CMD_ENTRY(X, "trace_replay", CMD_NO_ARGS, cmdTraceReplay, "", "进入回放 (由主机送入记录)") \
+    CMD_ENTRY(X, "trace_status", CMD_NO_ARGS, cmdTraceStatus, "", "录制/回放状态") \
+    \
+    CMD_TITLE(X, "断电恢复命令:") \
+    CMD_ENTRY(X, "checkpoint_status", CMD_NO_ARGS, cmdCheckpointStatus, "", "查看进度检查点") \
+    CMD_ENTRY(X, "checkpoint_clear", CMD_NO_ARGS, cmdCheckpointClear, "", "清除检查点 (上电不再恢复)")
+
+CMD_DEFINE_TABLE(COMMAND_TABLE, COMMAND_LIST);
+
 // ========================== 命令处理 ==========================
 bool CommandProcessor::processCommand(const String& input) {
     if (!initialized || input.length() == 0) return false;
@@ -39,31 +282,22 @@ bool CommandProcessor::processCommand(const String& input) {
     
     debugPrint("处理命令: " + command + " 参数: " + params);
     
-    // 优先处理简化PWM命令 (p24, b24, s24)
-    if (processSimplePWMCommand(command, params)) {
-        return true;
+    // 命令表：一次哈希 + 一次名字确认
+    int8_t result = dispatchCommand(COMMAND_TABLE, command, params);
+    if (result != CMD_NOT_FOUND) {
+        return result == CMD_OK;
     }
     
-    // PWM相关命令
-    if (processPWMCommand(command, params)) {
+    // 模式命令：简化PWM (p24, b24, s24)
+    if (processSimplePWMCommand(command, params)) {
         return true;
     }
     
-    // 数字IO命令
+    // 模式命令：数字IO (o24h, pulse24, t24h, i24)
     if (processDigitalIOCommand(command, params)) {
         return true;
     }
     
-    // 游戏协议命令
-    if (processGameCommand(command, params)) {
-        return true;
-    }
-    
-    // 系统命令
-    if (processSystemCommand(command, params)) {
-        return true;
-    }
-    
     // 自定义命令回调
     if (customCommandCallback) {
         customCommandCallback(command, params);
@@ -74,132 +308,7 @@ bool CommandProcessor::processCommand(const String& input) {
     return false;
 }
 
-// ========================== 具体命令处理器 ==========================
-bool CommandProcessor::processPWMCommand(const String& command, const String& params) {
-    int pin, value;
-    
-    if (command == "pwm_set") {
-        if (parsePWMParams(params, pin, value)) {
-            MillisPWM::setBrightness(pin, value);
-            return true;
-        }
-        
-    } else if (command == "pwm_breathing") {
-        if (parsePWMParams(params, pin, value)) {
-            float cyclePeriodSeconds = value / 1000.0;
-            MillisPWM::startBreathing(pin, cyclePeriodSeconds);
-            return true;
-        }
-        
-    } else if (command == "pwm_stop") {
-        if (parsePWMParams(params, pin, value)) {
-            MillisPWM::stop(pin);
-            return true;
-        }
-        
-    } else if (command == "pwm_stop_all") {
-        MillisPWM::stopAll();
-        return true;
-        
-    } else if (command == "pwm_range_breathing") {
-        // 解析范围参数 startPin,endPin,minCycle,maxCycle
-        int commaPos1 = params.indexOf(',');
-        int commaPos2 = params.indexOf(',', commaPos1 + 1);
-        int commaPos3 = params.indexOf(',', commaPos2 + 1);
-        
-        if (commaPos1 > 0 && commaPos2 > commaPos1 && commaPos3 > commaPos2) {
-            int startPin = params.substring(0, commaPos1).toInt();
-            int endPin = params.substring(commaPos1 + 1, commaPos2).toInt();
-            float minCycle = params.substring(commaPos2 + 1, commaPos3).toFloat();
-            float maxCycle = params.substring(commaPos3 + 1).toFloat();
-            
-            MillisPWM::startRangeBreathing(startPin, endPin, minCycle, maxCycle);
-            return true;
-        }
-        
-    // ========================== Fade渐变命令 ==========================
-    } else if (command == "pwm_fadein") {
-        // 解析参数 pin,targetValue,durationMs 或 pin,durationMs
-        int commaPos1 = params.indexOf(',');
-        int commaPos2 = params.indexOf(',', commaPos1 + 1);
-        
-        if (commaPos1 > 0) {
-            int pin = params.substring(0, commaPos1).toInt();
-            if (commaPos2 > commaPos1) {
-                // 三个参数: pin,targetValue,durationMs
-                int targetValue = params.substring(commaPos1 + 1, commaPos2).toInt();
-                int durationMs = params.substring(commaPos2 + 1).toInt();
-                MillisPWM::fadeIn(pin, targetValue, durationMs);
-            } else {
-                // 两个参数: pin,durationMs (目标值默认255)
-                int durationMs = params.substring(commaPos1 + 1).toInt();
-                MillisPWM::fadeIn(pin, 255, durationMs);
-            }
-            return true;
-        }
-        
-    } else if (command == "pwm_fadeout") {
-        // 解析参数 pin,durationMs
-        if (parsePWMParams(params, pin, value)) {
-            MillisPWM::fadeOut(pin, value);
-            return true;
-        }
-        
-    } else if (command == "pwm_fadeto") {
-        // 解析参数 pin,targetValue,durationMs
-        int commaPos1 = params.indexOf(',');
-        int commaPos2 = params.indexOf(',', commaPos1 + 1);
-        
-        if (commaPos1 > 0 && commaPos2 > commaPos1) {
-            int pin = params.substring(0, commaPos1).toInt();
-            int targetValue = params.substring(commaPos1 + 1, commaPos2).toInt();
-            int durationMs = params.substring(commaPos2 + 1).toInt();
-            MillisPWM::fadeTo(pin, targetValue, durationMs);
-            return true;
-        }
-        
-    } else if (command == "pwm_stop_fade") {
-        if (parsePWMParams(params, pin, value)) {
-            MillisPWM::stopFade(pin);
-            return true;
-        }
-    }
-    
-    return false;
-}
-
-bool CommandProcessor::processGameCommand(const String& command, const String& params) {
-    // UGP协议命令
-    if (command == "INIT" || command == "START" || command == "STOP" || 
-        command == "PAUSE" || command == "RESUME" || command == "EMERGENCY_STOP") {
-        return gameStateMachine.processGameCommand(command, params);
-    }
-    
-    // 环节测试命令 - 委托给GameFlowManager处理
-    if (command == "stage_072_0" || command == "072-0" || 
-        command == "stage_072_0_5" || command == "072-0.5" || 
-        command == "stage_072_4" || command == "072-4") {
-        return gameFlowManager.startStage(command);
-    }
-    
-    // 游戏流程控制命令
-    if (command == "game_stop" || command == "stop_game") {
-        gameFlowManager.stopAllStages();
-        return true;
-    } else if (command == "game_status") {
-        gameFlowManager.printStatus();
-        return true;
-    } else if (command == "game_stages") {
-        gameFlowManager.printAvailableStages();
-        return true;
-    } else if (command == "game_debug" || command == "debug_segments") {
-        gameStage.printAllSegments();
-        return true;
-    }
-    
-    return false;
-}
-
+// ========================== 模式命令处理器 ==========================
 bool CommandProcessor::processDigitalIOCommand(const String& command, const String& params) {
     // 重构完整命令字符串传递给DigitalIOController
     String fullCommand = command;
@@ -207,91 +316,7 @@ bool CommandProcessor::processDigitalIOCommand(const String& command, const Stri
         fullCommand += ":" + params;
     }
     
-    if (DigitalIOController::processCommand(fullCommand)) {
-        return true;
-    }
-    
-    // 自定义数字IO命令
-    int pin, value;
-    
-    // 输出命令: o24h (引脚24输出高电平)
-    if (command.startsWith("o") && command.length() >= 3) {
-        int pin = command.substring(1, command.length()-1).toInt();
-        bool level = command.endsWith("h") || command.endsWith("H");
-        return DigitalIOController::setOutput(pin, level);
-        
-    // 脉冲命令: p24:1000 (引脚24脉冲1秒) - 注意与PWM命令区分
-    } else if (command.indexOf(':') > 0 && command.startsWith("pulse")) {
-        int colonPos = command.indexOf(':');
-        int pin = command.substring(5, colonPos).toInt();
-        unsigned long width = command.substring(colonPos + 1).toInt();
-        return DigitalIOController::pulseOutput(pin, width);
-        
-    // 定时命令: t24h:500:2000 (引脚24，高电平，延迟500ms，持续2000ms)
-    } else if (command.startsWith("t") && command.indexOf(':') > 0) {
-        int colon1 = command.indexOf(':');
-        int colon2 = command.indexOf(':', colon1 + 1);
-        if (colon2 > 0) {
-            String pinLevel = command.substring(1, colon1);
-            int pin = pinLevel.substring(0, pinLevel.length()-1).toInt();
-            bool level = pinLevel.endsWith("h") || pinLevel.endsWith("H");
-            unsigned long delay = command.substring(colon1 + 1, colon2).toInt();
-            unsigned long duration = command.substring(colon2 + 1).toInt();
-            return DigitalIOController::scheduleOutput(pin, level, delay, duration);
-        }
-        
-    // 输入监控命令: i24 (监控引脚24)
-    } else if (command.startsWith("i") && command.length() >= 3) {
-        int pin = command.substring(1).toInt();
-        return DigitalIOController::startInput(pin, INPUT_CHANGE, 100);
-        
-    // 数字IO状态查询
-    } else if (command == "dio_status") {
-        Serial.print(F("活跃输出通道: "));
-        Serial.println(DigitalIOController::getActiveOutputCount());
-        Serial.print(F("活跃输入通道: "));
-        Serial.println(DigitalIOController::getActiveInputCount());
-        Serial.print(F("系统运行时间: "));
-        Serial.println(DigitalIOController::getSystemUptime());
-        return true;
-        
-    // 停止所有数字IO
-    } else if (command == "dio_stop_all") {
-        DigitalIOController::stopAllOutputs();
-        DigitalIOController::stopAllInputs();
-        return true;
-    }
-    
-    return false;
-}
-
-bool CommandProcessor::processSystemCommand(const String& command, const String& params) {
-    if (command == "help" || command == "h") {
-        showHelp();
-        return true;
-        
-    } else if (command == "status") {
-        showStatus();
-        return true;
-        
-    } else if (command == "reset") {
-        // 重置所有系统
-        MillisPWM::stopAll();
-        gameStateMachine.setState(GAME_IDLE);
-        debugPrint("系统已重置");
-        return true;
-        
-    } else if (command == "debug") {
-        #ifdef DEBUG
-        Serial.println(F("=== 调试信息 ==="));
-        gameStateMachine.printStatus();
-        Serial.print(F("活跃PWM通道: "));
-        Serial.println(MillisPWM::getActiveCount());
-        #endif
-        return true;
-    }
-    
-    return false;
+    return DigitalIOController::processCommand(fullCommand);
 }
 
 bool CommandProcessor::processSimplePWMCommand(const String& command, const String& params) {
@@ -403,63 +428,7 @@ bool CommandProcessor::processSimplePWMCommand(const String& command, const Stri
 // ========================== 帮助和状态 ==========================
 void CommandProcessor::showHelp() {
     Serial.println(F("=== 命令帮助 ==="));
-    Serial.println(F("简化PWM命令:"));
-    Serial.println(F("  p<pin> <value>   - 设置PWM (如: p24 128)"));
-    Serial.println(F("  b<pin> <period>  - 呼吸灯毫秒 (如: b24 1000)"));
-    Serial.println(F("  s<pin>           - 停止PWM (如: s24)"));
-    Serial.println();
-    Serial.println(F("简化Fade渐变命令:"));
-    Serial.println(F("  f<pin> <duration>      - 淡入到最亮 (如: f24 1000)"));
-    Serial.println(F("  fo<pin> <duration>     - 淡出到0 (如: fo24 1000)"));
-    Serial.println(F("  ft<pin> <target> <dur> - 渐变到指定亮度 (如: ft24 128 1000)"));
-    Serial.println(F("  fs<pin>                - 停止渐变 (如: fs24)"));
-    Serial.println();
-    Serial.println(F("批量PWM命令 (连续10个引脚):"));
-    Serial.println(F("  pa<pin> <value>  - 批量设置PWM (如: pa20 128)"));
-    Serial.println(F("  ba<pin> <period> - 批量呼吸灯 (如: ba10 1000)"));
-    Serial.println(F("  sa<pin>          - 批量停止 (如: sa20)"));
-    Serial.println();
-    Serial.println(F("完整PWM命令:"));
-    Serial.println(F("  pwm_set:<pin>,<value>"));
-    Serial.println(F("  pwm_breathing:<pin>,<period_ms>"));
-    Serial.println(F("  pwm_stop:<pin>"));
-    Serial.println(F("  pwm_stop_all"));
-    Serial.println();
-    Serial.println(F("完整Fade命令:"));
-    Serial.println(F("  pwm_fadein:<pin>,<target>,<duration>   - 淡入"));
-    Serial.println(F("  pwm_fadeout:<pin>,<duration>           - 淡出"));
-    Serial.println(F("  pwm_fadeto:<pin>,<target>,<duration>   - 渐变至"));
-    Serial.println(F("  pwm_stop_fade:<pin>                    - 停止渐变"));
-    Serial.println();
-    Serial.println(F("数字IO命令:"));
-    Serial.println(F("  o<pin>h/l            - 输出高/低电平 (如: o24h)"));
-    Serial.println(F("  pulse<pin>:<width>   - 脉冲输出 (如: pulse24:1000)"));
-    Serial.println(F("  t<pin>h/l:<delay>:<duration> - 定时输出 (如: t24h:500:2000)"));
-    Serial.println(F("  i<pin>               - 监控输入变化 (如: i25)"));
-    Serial.println(F("  dio_status           - 数字IO状态"));
-    Serial.println(F("  dio_stop_all         - 停止所有数字IO"));
-    Serial.println();
-    Serial.println(F("游戏命令:"));
-    Serial.println(F("  INIT, START, STOP, PAUSE, RESUME"));
-    Serial.println(F("  072-0         - 启动环节072-0 (引脚24亮起)"));
-    Serial.println(F("  072-0.5       - 启动环节072-0.5 (引脚26亮起)"));
-    Serial.println(F("  072-4         - 启动环节072-4 (引脚28亮起)"));
-    Serial.println(F("  game_stop     - 停止所有游戏环节"));
-    Serial.println(F("  game_status   - 查看游戏流程状态"));
-    Serial.println(F("  game_stages   - 查看所有可用环节"));
-    Serial.println(F("  game_debug    - 显示时间段调试信息"));
-    Serial.println();
-    Serial.println(F("系统命令:"));
-    Serial.println(F("  h/help    - 显示帮助"));
-    Serial.println(F("  status    - 显示状态"));
-    Serial.println(F("  reset     - 重置系统"));
-    Serial.println(F("  debug     - 调试信息"));
-    Serial.println(F("  time      - 显示系统时间"));
-    Serial.println(F("  test_unified - 统一输出管理器测试"));
-    Serial.println();
-    Serial.println(F("网络命令 (如果启用):"));
-    Serial.println(F("  network   - 显示网络状态"));
-    Serial.println(F("  send <msg> - 发送测试消息"));
+    printCommandHelp(COMMAND_TABLE);
 }
 
 void CommandProcessor::showStatus() {
@@ -526,24 +495,6 @@ bool CommandProcessor::parseCommand(const String& input, String& command, String
     return true;
 }
 
-bool CommandProcessor::parsePWMParams(const String& params, int& pin, int& value) {
-    int commaPos = params.indexOf(',');
-    int spacePos = params.indexOf(' ');
-    
-    // 支持逗号和空格分隔
-    int separatorPos = -1;
-    if (commaPos > 0) separatorPos = commaPos;
-    else if (spacePos > 0) separatorPos = spacePos;
-    
-    if (separatorPos > 0) {
-        pin = params.substring(0, separatorPos).toInt();
-        value = params.substring(separatorPos + 1).toInt();
-        return true;
-    }
-    
-    return false;
-}
-
 bool CommandProcessor::parseSimpleParams(const String& params, int& pin, int& value) {
     // 简化命令的参数解析
     String trimmedParams = params;
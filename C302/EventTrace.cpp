@@ -0,0 +1,407 @@
+#include "EventTrace.h"
+#include "MillisPWM.h"
+
+// ========================== 静态成员 ==========================
+uint8_t EventTrace::mode = TRACE_MODE_OFF;
+unsigned long EventTrace::traceStart = 0;
+unsigned long EventTrace::virtualNow = 0;
+unsigned long (*EventTrace::savedTimeSource)() = nullptr;
+uint16_t EventTrace::eventCount = 0;
+
+unsigned long EventTrace::lastTickUs = 0;
+unsigned long EventTrace::excludedUs = 0;
+unsigned long EventTrace::windowStart = 0;
+uint16_t EventTrace::windowLoops = 0;
+unsigned long EventTrace::windowTotalUs = 0;
+unsigned long EventTrace::windowMaxUs = 0;
+unsigned long EventTrace::totalLoops = 0;
+unsigned long EventTrace::totalUs = 0;
+unsigned long EventTrace::maxUs = 0;
+
+uint8_t EventTrace::pinKnown[(TRACE_MAX_PINS + 7) / 8];
+uint8_t EventTrace::pinLevel[(TRACE_MAX_PINS + 7) / 8];
+
+HarbingerFrameParser EventTrace::parser;
+bool EventTrace::pending = false;
+uint8_t* EventTrace::assembly = nullptr;
+uint16_t EventTrace::assemblyLength = 0;
+EventTrace::LineHandler EventTrace::lineHandler = nullptr;
+EventTrace::MessageHandler EventTrace::messageHandler = nullptr;
+EventTrace::FrameHandler EventTrace::frameHandler = nullptr;
+
+// 小端读写
+static void putLong(uint8_t* out, uint32_t value) {
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+}
+
+static void putWord(uint8_t* out, unsigned long value) {
+    if (value > 0xFFFF) value = 0xFFFF;
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+static uint32_t getLong(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// ========================== 时间 ==========================
+unsigned long EventTrace::elapsed() {
+    return MillisTimeSource::getCurrentTime() - traceStart;
+}
+
+unsigned long EventTrace::virtualTime() {
+    return virtualNow;
+}
+
+// ========================== 记录输出 ==========================
+void EventTrace::writeRecord(uint8_t code, const uint8_t* head, uint8_t headLength,
+                             const uint8_t* data, uint16_t length) {
+    if (mode == TRACE_MODE_OFF) return;
+
+    // 逐字节写串口并累计CRC，不需要整帧缓冲
+    uint8_t header[8];
+    uint16_t total = headLength + length;
+    uint16_t pos = 0;
+    putLong(header + 4, elapsed());
+
+    do {
+        uint8_t chunk = (total - pos > TRACE_TEXT_CHUNK) ? TRACE_TEXT_CHUNK : total - pos;
+        header[0] = HBF_SYNC;
+        header[1] = chunk + 4;
+        header[2] = TRACE_FRAME_TYPE;
+        header[3] = (pos + chunk < total) ? TRACE_TEXT_CONT : code;
+
+        uint16_t crc = 0xFFFF;
+        for (uint8_t i = 1; i < sizeof(header); i++) {
+            crc = hbfCrc16(crc, header[i]);
+        }
+        Serial.write(header, sizeof(header));
+
+        for (uint8_t i = 0; i < chunk; i++, pos++) {
+            uint8_t value = (pos < headLength) ? head[pos] : data[pos - headLength];
+            crc = hbfCrc16(crc, value);
+            Serial.write(value);
+        }
+        Serial.write((uint8_t)(crc & 0xFF));
+        Serial.write((uint8_t)(crc >> 8));
+    } while (pos < total);
+}
+
+void EventTrace::writeSummary() {
+    uint8_t data[14];
+    putWord(data, eventCount);
+    putLong(data + 2, totalLoops);
+    putLong(data + 6, totalUs);
+    putLong(data + 10, maxUs);
+    writeRecord(TRACE_SUMMARY, nullptr, 0, data, sizeof(data));
+}
+
+void EventTrace::resetStats() {
+    eventCount = 0;
+    lastTickUs = 0;
+    excludedUs = 0;
+    windowStart = 0;
+    windowLoops = 0;
+    windowTotalUs = 0;
+    windowMaxUs = 0;
+    totalLoops = 0;
+    totalUs = 0;
+    maxUs = 0;
+}
+
+// ========================== 模式控制 ==========================
+void EventTrace::setReplayHandlers(LineHandler onLine, MessageHandler onMessage, FrameHandler onFrame) {
+    lineHandler = onLine;
+    messageHandler = onMessage;
+    frameHandler = onFrame;
+}
+
+void EventTrace::startCapture() {
+    if (mode != TRACE_MODE_OFF) return;
+
+    mode = TRACE_MODE_CAPTURE;
+    traceStart = MillisTimeSource::getCurrentTime();
+    resetStats();
+    memset(pinKnown, 0, sizeof(pinKnown));   // 每个引脚第一次读取时记录初始电平
+
+    // 固定随机序列，回放时用同一个种子
+    uint8_t seed[4];
+    uint32_t value = micros();
+    randomSeed(value);
+    putLong(seed, value);
+    writeRecord(TRACE_BEGIN, nullptr, 0, seed, sizeof(seed));
+
+    Serial.println(F("⏺ 开始录制"));
+}
+
+void EventTrace::stopCapture() {
+    if (mode != TRACE_MODE_CAPTURE) return;
+
+    writeSummary();
+    mode = TRACE_MODE_OFF;
+    Serial.print(F("⏹ 录制结束，事件数: "));
+    Serial.println(eventCount);
+}
+
+bool EventTrace::startReplay() {
+    if (mode != TRACE_MODE_OFF) return false;
+
+    assembly = (uint8_t*)malloc(TRACE_ASSEMBLY_SIZE);
+    if (!assembly) {
+        Serial.println(F("❌ 内存不足，无法回放"));
+        return false;
+    }
+    assemblyLength = 0;
+    pending = false;
+    parser.reset();
+
+    // 按键为INPUT_PULLUP，未录到的引脚按松开(HIGH)处理
+    memset(pinLevel, 0xFF, sizeof(pinLevel));
+
+    savedTimeSource = MillisTimeSource::getTime;
+    virtualNow = MillisTimeSource::getCurrentTime();
+    MillisTimeSource::setTimeSource(virtualTime);
+    traceStart = virtualNow;
+    resetStats();
+    mode = TRACE_MODE_REPLAY;
+
+    Serial.println(F("▶ 开始回放，等待主机送入记录"));
+    return true;
+}
+
+void EventTrace::stopReplay(bool completed) {
+    writeSummary();
+    MillisTimeSource::setTimeSource(savedTimeSource);
+    mode = TRACE_MODE_OFF;
+
+    free(assembly);
+    assembly = nullptr;
+    assemblyLength = 0;
+    pending = false;
+    parser.reset();
+
+    Serial.println(completed ? F("⏹ 回放完成") : F("⏹ 回放中止"));
+}
+
+// ========================== 主循环 ==========================
+void EventTrace::loopTick() {
+    if (mode == TRACE_MODE_OFF) return;
+
+    unsigned long now = micros();
+    if (lastTickUs != 0) {
+        unsigned long cost = now - lastTickUs;
+        cost = (cost > excludedUs) ? cost - excludedUs : 0;
+        windowLoops++;
+        windowTotalUs += cost;
+        if (cost > windowMaxUs) windowMaxUs = cost;
+        totalLoops++;
+        totalUs += cost;
+        if (cost > maxUs) maxUs = cost;
+    }
+    excludedUs = 0;
+    lastTickUs = now;
+
+    if (windowLoops > 0 && elapsed() - windowStart >= TRACE_LOOP_WINDOW_MS) {
+        uint8_t data[6];
+        putWord(data, windowLoops);
+        putWord(data + 2, windowTotalUs / windowLoops);
+        putWord(data + 4, windowMaxUs);
+        writeRecord(TRACE_LOOP, nullptr, 0, data, sizeof(data));
+
+        windowStart = elapsed();
+        windowLoops = 0;
+        windowTotalUs = 0;
+        windowMaxUs = 0;
+        excludedUs = micros() - now;         // 统计记录本身的串口输出不算进下一个loop
+    }
+}
+
+void EventTrace::replayUpdate() {
+    if (mode != TRACE_MODE_REPLAY) return;
+
+    virtualNow += TRACE_REPLAY_STEP_MS;
+
+    // 送入所有已到点的记录；未到点的留在parser中等下一个loop，TRACE_END到点即结束
+    while (mode == TRACE_MODE_REPLAY) {
+        if (!pending && !pullNext()) return;
+
+        const HarbingerFrame& record = parser.getFrame();
+        if (getLong(record.payload) > elapsed()) return;
+
+        pending = false;
+        if (record.command == TRACE_END) {
+            stopReplay(true);
+            return;
+        }
+        dispatch(record);
+    }
+}
+
+bool EventTrace::pullNext() {
+    unsigned long waitStart = micros();
+    writeRecord(TRACE_PULL, nullptr, 0, nullptr, 0);
+
+    // 虚拟时钟冻结，阻塞等待主机送来一条完整记录
+    uint8_t result = TRACE_PULL;
+    unsigned long lastByte = millis();
+    while (result == TRACE_PULL) {
+        if (millis() - lastByte > TRACE_PULL_TIMEOUT) break;
+        if (!Serial.available()) continue;
+        lastByte = millis();
+
+        if (parser.feed(Serial.read()) != HBF_PARSE_DONE) continue;
+        const HarbingerFrame& record = parser.getFrame();
+        if (record.type != TRACE_FRAME_TYPE || record.length < 4) continue;
+
+        if (record.command == TRACE_TEXT_CONT) {
+            append(record.payload + 4, record.length - 4);
+            writeRecord(TRACE_PULL, nullptr, 0, nullptr, 0);
+            continue;
+        }
+        result = record.command;
+    }
+    excludedUs += micros() - waitStart;
+
+    if (result == TRACE_PULL) {
+        Serial.println(F("⚠️ 回放超时: 主机未送入记录"));
+        stopReplay(false);
+        return false;
+    }
+    pending = true;
+    return true;
+}
+
+void EventTrace::append(const uint8_t* data, uint16_t length) {
+    // 留1字节给文本结尾0，超出部分截断
+    while (length-- > 0 && assemblyLength < TRACE_ASSEMBLY_SIZE - 1) {
+        assembly[assemblyLength++] = *data++;
+    }
+    assembly[assemblyLength] = 0;
+}
+
+void EventTrace::dispatch(const HarbingerFrame& record) {
+    append(record.payload + 4, record.length - 4);
+    uint16_t length = assemblyLength;
+    assemblyLength = 0;
+    eventCount++;
+
+    switch (record.command) {
+        case TRACE_BEGIN:
+            if (length >= 4) randomSeed(getLong(assembly));
+            break;
+
+        case TRACE_SERIAL_LINE:
+            if (lineHandler) lineHandler(String((const char*)assembly));
+            break;
+
+        case TRACE_NET_MESSAGE:
+            if (messageHandler) messageHandler(String((const char*)assembly));
+            break;
+
+        case TRACE_NET_FRAME: {
+            if (!frameHandler || length < 2 || length - 2 > HBF_MAX_PAYLOAD) break;
+            HarbingerFrame frame;
+            frame.type = assembly[0];
+            frame.command = assembly[1];
+            frame.length = length - 2;
+            memcpy(frame.payload, assembly + 2, frame.length);
+            frameHandler(frame);
+            break;
+        }
+
+        case TRACE_INPUT_EDGE:
+            if (length >= 2 && assembly[0] < TRACE_MAX_PINS) {
+                uint8_t pin = assembly[0];
+                if (assembly[1]) pinLevel[pin / 8] |= (1 << (pin % 8));
+                else pinLevel[pin / 8] &= ~(1 << (pin % 8));
+            }
+            break;
+
+        default:
+            eventCount--;                    // 不认识的记录直接跳过
+            break;
+    }
+}
+
+// ========================== 输入 ==========================
+void EventTrace::recordSerialLine(const String& line) {
+    // trace_*命令本身不录，回放时不会中途停掉自己
+    if (mode != TRACE_MODE_CAPTURE || line.startsWith("trace_")) return;
+    writeRecord(TRACE_SERIAL_LINE, nullptr, 0, (const uint8_t*)line.c_str(), line.length());
+    eventCount++;
+}
+
+void EventTrace::recordMessage(const String& message) {
+    if (mode != TRACE_MODE_CAPTURE) return;
+    writeRecord(TRACE_NET_MESSAGE, nullptr, 0, (const uint8_t*)message.c_str(), message.length());
+    eventCount++;
+}
+
+void EventTrace::recordFrame(const HarbingerFrame& frame) {
+    if (mode != TRACE_MODE_CAPTURE) return;
+    uint8_t head[2] = { frame.type, frame.command };
+    writeRecord(TRACE_NET_FRAME, head, sizeof(head), frame.payload, frame.length);
+    eventCount++;
+}
+
+int EventTrace::readInput(uint8_t pin) {
+    if (pin >= TRACE_MAX_PINS || mode == TRACE_MODE_OFF) {
+        return digitalRead(pin);
+    }
+
+    uint8_t index = pin / 8;
+    uint8_t bit = 1 << (pin % 8);
+    if (mode == TRACE_MODE_REPLAY) {
+        return (pinLevel[index] & bit) ? HIGH : LOW;
+    }
+
+    int level = digitalRead(pin);
+    bool last = (pinLevel[index] & bit) != 0;
+    if (!(pinKnown[index] & bit) || last != (level == HIGH)) {
+        pinKnown[index] |= bit;
+        if (level == HIGH) pinLevel[index] |= bit;
+        else pinLevel[index] &= ~bit;
+
+        uint8_t data[2] = { pin, (uint8_t)(level == HIGH) };
+        writeRecord(TRACE_INPUT_EDGE, nullptr, 0, data, sizeof(data));
+        eventCount++;
+    }
+    return level;
+}
+
+// ========================== 输出 ==========================
+bool EventTrace::onSend(const uint8_t* data, uint16_t length) {
+    if (mode == TRACE_MODE_OFF) return false;
+    writeRecord(TRACE_NET_SEND, nullptr, 0, data, length);
+    return mode == TRACE_MODE_REPLAY;        // 回放时不真正发出
+}
+
+void EventTrace::recordStage(const String& stageId) {
+    writeRecord(TRACE_STAGE, nullptr, 0, (const uint8_t*)stageId.c_str(), stageId.length());
+}
+
+// ========================== 状态 ==========================
+void EventTrace::printStatus() {
+    Serial.println(F("=== 录制/回放状态 ==="));
+    Serial.print(F("模式: "));
+    if (mode == TRACE_MODE_CAPTURE) Serial.println(F("录制中"));
+    else if (mode == TRACE_MODE_REPLAY) Serial.println(F("回放中"));
+    else Serial.println(F("关闭"));
+    if (mode == TRACE_MODE_OFF) return;
+
+    Serial.print(F("已运行: "));
+    Serial.print(elapsed());
+    Serial.println(F("ms"));
+    Serial.print(F("事件数: "));
+    Serial.println(eventCount);
+    Serial.print(F("loop次数: "));
+    Serial.print(totalLoops);
+    Serial.print(F("  平均: "));
+    Serial.print(totalLoops ? totalUs / totalLoops : 0);
+    Serial.print(F("us  最大: "));
+    Serial.print(maxUs);
+    Serial.println(F("us"));
+}
@@ -0,0 +1,139 @@
+/**
+ * =============================================================================
+ * EventTrace - 外部事件录制/回放
+ * 版本: 1.0
+ *
+ * 功能:
+ * - 录制: 串口命令行、网络消息/二进制帧、按键输入沿连同时间戳，以HarbingerFrame
+ *   帧格式混在调试输出中写到串口；发出的网络消息、环节启动、loop耗时作为输出一起记录
+ * - 回放: 主机把录制的输入记录按序送回，控制器用MillisTimeSource接入虚拟时钟
+ *   (每个loop前进TRACE_REPLAY_STEP_MS)，到点后交给同一套GameFlowManager/SimpleGameStage
+ *   处理；网络不收不发，输出记录照常上报，主机据此对比输出时刻和loop耗时
+ * - 主机端录制/回放/对比见 tools/harbinger_trace.py
+ *
+ * 记录格式: HarbingerFrame，TYPE=TRACE_FRAME_TYPE，CMD=记录类型，
+ *          PAYLOAD = 时间戳(4，小端，相对录制/回放开始的毫秒) + 数据
+ *          超过一帧的数据先发若干TRACE_TEXT_CONT段，最后一段用真实记录类型
+ *
+ * 录制与回放都应从刚上电的状态开始（主机打开串口时Mega会自动复位）
+ * =============================================================================
+ */
+
+#ifndef EVENT_TRACE_H
+#define EVENT_TRACE_H
+
+#include <Arduino.h>
+#include "HarbingerFrame.h"
+
+// ========================== 配置 ==========================
+#define TRACE_REPLAY_STEP_MS    1       // 回放时每个loop虚拟时钟前进的毫秒数
+#define TRACE_LOOP_WINDOW_MS    1000    // loop耗时统计窗口
+#define TRACE_PULL_TIMEOUT      3000    // 回放时等待主机送下一条记录的超时(ms)
+#define TRACE_ASSEMBLY_SIZE     416     // 回放时拼接超长记录的缓冲（仅回放期间分配）
+#define TRACE_MAX_PINS          70      // Mega2560数字引脚数（含A0-A15）
+#define TRACE_TEXT_CHUNK        (HBF_MAX_PAYLOAD - 4)
+
+// ========================== 记录类型 ==========================
+#define TRACE_FRAME_TYPE        0x54    // 'T'，与网络帧类型(1-3)区分
+
+// 输入记录（回放时由主机按序送回）
+#define TRACE_BEGIN             0x01    // seed(4)
+#define TRACE_SERIAL_LINE       0x02    // 命令行文本
+#define TRACE_NET_MESSAGE       0x03    // 收到的ASCII消息
+#define TRACE_NET_FRAME         0x04    // 收到的二进制帧: type(1) cmd(1) payload
+#define TRACE_INPUT_EDGE        0x05    // pin(1) level(1)
+#define TRACE_BUSY_EDGE         0x06    // channel(1) level(1)，语音控制器预留
+#define TRACE_TEXT_CONT         0x0F    // 超长记录的前段
+
+// 输出记录
+#define TRACE_NET_SEND          0x41    // 发出的ASCII消息或二进制帧原文
+#define TRACE_STAGE             0x42    // 环节启动: 环节ID
+#define TRACE_LOOP              0x43    // loops(2) avg_us(2) max_us(2)
+
+// 回放控制
+#define TRACE_PULL              0x61    // 控制器 -> 主机: 请求下一条输入记录
+#define TRACE_END               0x62    // 主机 -> 控制器: 输入记录已送完，回放运行到该记录的时间戳为止
+#define TRACE_SUMMARY           0x63    // 控制器 -> 主机: events(2) loops(4) total_us(4) max_us(4)
+
+// 运行模式
+#define TRACE_MODE_OFF          0
+#define TRACE_MODE_CAPTURE      1
+#define TRACE_MODE_REPLAY       2
+
+class EventTrace {
+public:
+    typedef void (*LineHandler)(const String& line);
+    typedef void (*MessageHandler)(String message);
+    typedef void (*FrameHandler)(const HarbingerFrame& frame);
+
+private:
+    static uint8_t mode;
+    static unsigned long traceStart;         // 录制/回放起点（MillisTimeSource时间）
+    static unsigned long virtualNow;         // 回放虚拟时钟
+    static unsigned long (*savedTimeSource)();
+    static uint16_t eventCount;
+
+    // loop耗时
+    static unsigned long lastTickUs;
+    static unsigned long excludedUs;         // 回放时等待主机的时间，不计入loop耗时
+    static unsigned long windowStart;
+    static uint16_t windowLoops;
+    static unsigned long windowTotalUs;
+    static unsigned long windowMaxUs;
+    static unsigned long totalLoops;
+    static unsigned long totalUs;
+    static unsigned long maxUs;
+
+    // 输入沿：每个引脚1位
+    static uint8_t pinKnown[(TRACE_MAX_PINS + 7) / 8];
+    static uint8_t pinLevel[(TRACE_MAX_PINS + 7) / 8];
+
+    // 回放
+    static HarbingerFrameParser parser;
+    static bool pending;                     // parser中有一条已收齐、未到点的记录
+    static uint8_t* assembly;
+    static uint16_t assemblyLength;
+    static LineHandler lineHandler;
+    static MessageHandler messageHandler;
+    static FrameHandler frameHandler;
+
+    static unsigned long elapsed();
+    static unsigned long virtualTime();
+
+    static void writeRecord(uint8_t code, const uint8_t* head, uint8_t headLength,
+                            const uint8_t* data, uint16_t length);
+    static void writeSummary();
+    static void resetStats();
+    static void append(const uint8_t* data, uint16_t length);
+    static bool pullNext();
+    static void dispatch(const HarbingerFrame& record);
+    static void stopReplay(bool completed);
+
+public:
+    // ========================== 模式控制 ==========================
+    static void setReplayHandlers(LineHandler onLine, MessageHandler onMessage, FrameHandler onFrame);
+    static void startCapture();
+    static void stopCapture();
+    static bool startReplay();
+
+    static bool isCapturing() { return mode == TRACE_MODE_CAPTURE; }
+    static bool isReplaying() { return mode == TRACE_MODE_REPLAY; }
+
+    // ========================== 主循环 ==========================
+    static void loopTick();                  // loop开头调用：统计上一个loop的耗时
+    static void replayUpdate();              // 回放时代替串口/网络输入：推进虚拟时钟并送入到点的记录
+
+    // ========================== 输入 ==========================
+    static void recordSerialLine(const String& line);
+    static void recordMessage(const String& message);
+    static void recordFrame(const HarbingerFrame& frame);
+    static int readInput(uint8_t pin);       // 代替digitalRead：录制时记录电平变化，回放时返回录制的电平
+
+    // ========================== 输出 ==========================
+    static bool onSend(const uint8_t* data, uint16_t length);   // UniversalHarbingerClient发送钩子
+    static void recordStage(const String& stageId);
+
+    static void printStatus();
+};
+
+#endif // EVENT_TRACE_H
@@ -0,0 +1,260 @@
+/**
+ * =============================================================================
+ * GameCheckpoint - 游戏进度断电恢复实现
+ * =============================================================================
+ */
+
+#include "GameCheckpoint.h"
+#include "GameFlowManager.h"
+#include "SimpleGameStage.h"
+#include "HarbingerFrame.h"
+#include "EventTrace.h"
+#include "UniversalHarbingerClient.h"
+#include <avr/eeprom.h>
+#include <stddef.h>
+
+// 检查点区必须放得下全部槽：AVR上sizeof(CheckpointSlot)=59，64槽共3776字节，Mega2560的EEPROM为4096字节
+#ifdef E2END
+static_assert(CHECKPOINT_EEPROM_BASE + CHECKPOINT_SLOT_COUNT * sizeof(CheckpointSlot) <= E2END + 1UL,
+              "checkpoint slots exceed EEPROM");
+#endif
+
+// ========================== 静态成员初始化 ==========================
+uint32_t GameCheckpoint::sequence = 0;
+uint8_t GameCheckpoint::nextSlot = 0;
+CheckpointState GameCheckpoint::written;
+CheckpointSlot GameCheckpoint::pendingSlot;
+uint8_t GameCheckpoint::writeIndex = sizeof(CheckpointSlot);
+unsigned long GameCheckpoint::lastCheck = 0;
+unsigned long GameCheckpoint::lastElapsedWrite = 0;
+bool GameCheckpoint::verifyPending = false;
+uint32_t GameCheckpoint::restoredServerTime = 0;
+String GameCheckpoint::recoveryParams = "";
+
+// ========================== 内部方法 ==========================
+uint16_t GameCheckpoint::slotAddress(uint8_t slot) {
+    return CHECKPOINT_EEPROM_BASE + (uint16_t)slot * sizeof(CheckpointSlot);
+}
+
+uint16_t GameCheckpoint::slotCrc(const CheckpointSlot& slot) {
+    const uint8_t* data = (const uint8_t*)&slot;
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < offsetof(CheckpointSlot, crc); i++) {
+        crc = hbfCrc16(crc, data[i]);
+    }
+    return crc;
+}
+
+/**
+ * @brief 比较游戏进度（忽略环节已运行时间和服务器时间，它们由定时刷新单独处理）
+ */
+bool GameCheckpoint::sameProgress(const CheckpointState& a, const CheckpointState& b) {
+    CheckpointState x = a;
+    x.stageElapsed = b.stageElapsed;
+    x.serverTime = b.serverTime;
+    return memcmp(&x, &b, sizeof(CheckpointState)) == 0;
+}
+
+void GameCheckpoint::beginWrite(const CheckpointState& state) {
+    pendingSlot.sequence = sequence + 1;
+    pendingSlot.state = state;
+    pendingSlot.state.serverTime = harbingerClient.isClockSynced() ? harbingerClient.getServerTime() : 0;
+    pendingSlot.crc = slotCrc(pendingSlot);
+    written = state;
+    writeIndex = 0;
+}
+
+/**
+ * @brief 写一个字节：EEPROM忙时直接返回，内容相同的字节跳过不计
+ */
+void GameCheckpoint::writeStep() {
+    if (!eeprom_is_ready()) return;
+
+    const uint8_t* data = (const uint8_t*)&pendingSlot;
+    uint16_t address = slotAddress(nextSlot);
+
+    while (writeIndex < sizeof(CheckpointSlot)) {
+        uint8_t* target = (uint8_t*)(address + writeIndex);
+        uint8_t value = data[writeIndex++];
+        if (eeprom_read_byte(target) != value) {
+            eeprom_write_byte(target, value);   // 启动写入后立即返回，约3.3ms后完成
+            break;
+        }
+    }
+
+    if (writeIndex >= sizeof(CheckpointSlot)) {
+        // 整个槽写完（最后一个字节可能仍在写入中，下次writeStep前会等eeprom_is_ready）
+        sequence = pendingSlot.sequence;
+        nextSlot = (nextSlot + 1) % CHECKPOINT_SLOT_COUNT;
+    }
+}
+
+// ========================== 恢复 ==========================
+bool GameCheckpoint::restore() {
+    CheckpointSlot slot;
+    int8_t latest = -1;
+
+    memset(&written, 0, sizeof(written));
+    sequence = 0;
+
+    // 找出CRC正确、序号最大的槽（全0xFF为从未写过）
+    for (uint8_t i = 0; i < CHECKPOINT_SLOT_COUNT; i++) {
+        eeprom_read_block(&slot, (const void*)slotAddress(i), sizeof(slot));
+        if (slot.sequence == 0xFFFFFFFFUL || slot.crc != slotCrc(slot)) continue;
+        if (latest < 0 || slot.sequence > sequence) {
+            latest = i;
+            sequence = slot.sequence;
+            written = slot.state;
+        }
+    }
+
+    nextSlot = (latest < 0) ? 0 : (latest + 1) % CHECKPOINT_SLOT_COUNT;
+    lastCheck = millis();
+    lastElapsedWrite = millis();
+
+    Serial.print(F("💾 检查点: "));
+    if (latest < 0) {
+        Serial.println(F("无"));
+    } else {
+        Serial.print(F("槽"));
+        Serial.print(latest);
+        Serial.print(F(" 序号"));
+        Serial.print(sequence);
+        Serial.print(F(" 环节"));
+        Serial.println(written.stageId[0] ? written.stageId : "-");
+    }
+
+    if (latest < 0 || written.stageId[0] == '\0') return false;
+
+    // 断电时长此时未知（没有RTC），按上电到现在的时间估算，误差在一个刷新间隔以内；
+    // 时钟同步后由verifyRestore核对断电时长，过期则撤销
+    unsigned long elapsed = written.stageElapsed + millis();
+    if (!gameFlowManager.restoreCheckpoint(written, elapsed)) return false;
+
+    verifyPending = true;
+    restoredServerTime = written.serverTime;
+    recoveryParams = "recovered_stage=" + String(written.stageId) +
+                     ",recovered_elapsed=" + String(elapsed);
+    if (written.sessionId[0] != '\0') {
+        recoveryParams += ",session_id=" + String(written.sessionId);
+    }
+    return true;
+}
+
+/**
+ * @brief 恢复后首次时钟同步时核对断电时长：没有RTC，只能借服务器时钟判断检查点是否过期
+ */
+void GameCheckpoint::verifyRestore() {
+    verifyPending = false;
+
+    // 本次上电时刻的服务器时间 - 检查点写入时的服务器时间 ≈ 断电时长（误差一个刷新间隔）
+    uint32_t bootServerTime = harbingerClient.getServerTime() - millis();
+    long offTime = (long)(bootServerTime - restoredServerTime);
+
+    Serial.print(F("💾 断电时长: "));
+    if (restoredServerTime == 0) {
+        Serial.println(F("未知（检查点写入时时钟未同步），保留恢复"));
+        return;
+    }
+    if (offTime >= 0 && offTime <= CHECKPOINT_MAX_OFF_TIME) {
+        Serial.print(offTime);
+        Serial.println(F("ms，保留恢复"));
+        return;
+    }
+
+    // 过期，或服务器时间倒退（服务器已重启，无法判断）：放弃恢复
+    Serial.print(offTime);
+    Serial.println(F("ms，检查点过期，放弃恢复"));
+    harbingerClient.sendINFOMessage("RECOVERY_DISCARDED", recoveryParams + ",off_time=" + String(offTime));
+    gameStage.stopStage();
+    gameFlowManager.stopAllStages();
+    harbingerClient.setRegisterParams("");
+    clear();
+}
+
+// ========================== 主循环 ==========================
+void GameCheckpoint::update() {
+    if (EventTrace::isReplaying()) return;   // 回放是虚拟时钟下的演练，不写检查点
+
+    if (verifyPending && harbingerClient.isClockSynced()) {
+        verifyRestore();
+    }
+
+    if (isWriting()) {
+        writeStep();
+        return;
+    }
+
+    unsigned long now = millis();
+    if (now - lastCheck < CHECKPOINT_CHECK_INTERVAL) return;
+    lastCheck = now;
+
+    CheckpointState state;
+    gameFlowManager.saveCheckpoint(state);
+
+    if (!sameProgress(state, written)) {
+        beginWrite(state);
+        lastElapsedWrite = now;
+    } else if (state.stageId[0] != '\0' && gameStage.isRunning() &&
+               now - lastElapsedWrite >= CHECKPOINT_ELAPSED_INTERVAL) {
+        // 定时环节运行中：刷新已运行时间，恢复时从这里继续
+        beginWrite(state);
+        lastElapsedWrite = now;
+    }
+}
+
+void GameCheckpoint::clear() {
+    CheckpointState empty;
+    memset(&empty, 0, sizeof(empty));
+    beginWrite(empty);
+    recoveryParams = "";
+}
+
+// ========================== 状态查询 ==========================
+String GameCheckpoint::getRecoveryParams() {
+    return recoveryParams;
+}
+
+bool GameCheckpoint::isWriting() {
+    return writeIndex < sizeof(CheckpointSlot);
+}
+
+void GameCheckpoint::printStatus() {
+    Serial.println(F("=== 断电恢复检查点 ==="));
+    Serial.print(F("序号: "));
+    Serial.print(sequence);
+    Serial.print(F("  下一槽: "));
+    Serial.print(nextSlot);
+    Serial.print(F("/"));
+    Serial.print(CHECKPOINT_SLOT_COUNT);
+    Serial.print(F("  槽大小: "));
+    Serial.print(sizeof(CheckpointSlot));
+    Serial.println(F("字节"));
+
+    Serial.print(F("环节: "));
+    Serial.print(written.stageId[0] ? written.stageId : "-");
+    Serial.print(F("  已运行: "));
+    Serial.print(written.stageElapsed);
+    Serial.print(F("ms  服务器时间: "));
+    Serial.print(written.serverTime);
+    Serial.print(F("ms  Level: "));
+    Serial.print(written.level);
+    Serial.print(F("  成功/错误: "));
+    Serial.print(written.successCount);
+    Serial.print(F("/"));
+    Serial.println(written.errorCount);
+
+    Serial.print(F("写入: "));
+    if (isWriting()) {
+        Serial.print(writeIndex);
+        Serial.print(F("/"));
+        Serial.println(sizeof(CheckpointSlot));
+    } else {
+        Serial.println(F("空闲"));
+    }
+
+    if (recoveryParams.length() > 0) {
+        Serial.print(F("本次上电已恢复: "));
+        Serial.println(recoveryParams);
+    }
+}
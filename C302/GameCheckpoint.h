@@ -0,0 +1,109 @@
+/**
+ * =============================================================================
+ * GameCheckpoint - 游戏进度断电恢复
+ * 版本: 1.0
+ *
+ * 功能:
+ * - 游戏状态（环节、Level、错误/成功次数、旋转方向、亮灯掩码、会话ID）变化时
+ *   写入EEPROM检查点；定时环节运行中每CHECKPOINT_ELAPSED_INTERVAL刷新一次已运行时间
+ *   （15秒 × 64槽，每槽约16分钟写一次，10万次擦写寿命约合3年连续环节运行）
+ * - 磨损均衡：CHECKPOINT_SLOT_COUNT个槽轮流写，序号最大且CRC正确的槽为最新
+ *   写到一半复位时CRC不对，自动退回上一个槽
+ * - 非阻塞写入：EEPROM每字节约3.3ms，每个loop只在EEPROM空闲时写一个字节，
+ *   内容相同的字节跳过
+ * - 上电时恢复环节并从断电前的已运行时间继续，恢复信息随REGISTER上报服务器；
+ *   已过的STAGE_JUMP不重放（断电前已发出，重放时网络未就绪也会丢失）
+ * - 过期保护：检查点记录写入时的服务器时间，恢复后时钟同步时核对断电时长，
+ *   超过CHECKPOINT_MAX_OFF_TIME（或服务器已重启无法判断）则放弃恢复并清除检查点
+ * =============================================================================
+ */
+
+#ifndef GAME_CHECKPOINT_H
+#define GAME_CHECKPOINT_H
+
+#include <Arduino.h>
+
+// ========================== 配置 ==========================
+#define CHECKPOINT_EEPROM_BASE          0       // 检查点区起始地址
+#define CHECKPOINT_SLOT_COUNT           64      // 轮换槽数量（64 * 59字节，Mega2560共4KB）
+#define CHECKPOINT_CHECK_INTERVAL       250     // 状态比较间隔(ms)
+#define CHECKPOINT_ELAPSED_INTERVAL     15000   // 定时环节运行中刷新已运行时间的间隔(ms)，决定EEPROM寿命
+#define CHECKPOINT_MAX_OFF_TIME         600000  // 断电超过该时长(ms)的检查点不再恢复
+#define CHECKPOINT_STAGE_SIZE           10      // 环节ID长度(含结尾0)，如"072-0.5"
+#define CHECKPOINT_SESSION_SIZE         24      // 会话ID长度(含结尾0)
+
+// 状态标志
+#define CHECKPOINT_FLAG_GAME_ACTIVE     0x01
+#define CHECKPOINT_FLAG_REFRESH_WAS_5   0x02
+#define CHECKPOINT_FLAG_SOURCE_SUCCESS  0x04
+#define CHECKPOINT_FLAG_SOURCE_ERROR    0x08
+
+// 需要恢复的游戏状态（由GameFlowManager填写/应用）
+struct CheckpointState {
+    char stageId[CHECKPOINT_STAGE_SIZE];        // 运行中的环节，空=无游戏
+    char sessionId[CHECKPOINT_SESSION_SIZE];
+    uint32_t litMask;                           // 亮灯掩码（物理按键坐标）
+    uint32_t stageElapsed;                      // 写入时环节已运行时间(ms)
+    uint32_t serverTime;                        // 写入时的服务器时间(ms)，0=时钟未同步
+    int8_t level;
+    int8_t errorCount;
+    int8_t successCount;
+    int8_t rotation;
+    int8_t lastRotation;
+    int8_t lastPressedButton;
+    uint8_t flags;
+};
+
+struct CheckpointSlot {
+    uint32_t sequence;                          // 写入序号，最大者为最新
+    CheckpointState state;
+    uint16_t crc;                               // CRC-16/CCITT，覆盖sequence和state
+};
+
+class GameCheckpoint {
+private:
+    static uint32_t sequence;                   // 最新有效槽的序号
+    static uint8_t nextSlot;                    // 下一个写入槽
+    static CheckpointState written;             // 最近一次写入（或正在写入）的状态
+    static CheckpointSlot pendingSlot;          // 正在写入的槽内容
+    static uint8_t writeIndex;                  // 已写字节数，sizeof(CheckpointSlot)=空闲
+    static unsigned long lastCheck;
+    static unsigned long lastElapsedWrite;
+    static bool verifyPending;                  // 已恢复，等时钟同步后核对断电时长
+    static uint32_t restoredServerTime;         // 恢复所用检查点的服务器时间
+    static String recoveryParams;               // 本次上电恢复的进度，随REGISTER上报
+
+    static uint16_t slotAddress(uint8_t slot);
+    static uint16_t slotCrc(const CheckpointSlot& slot);
+    static bool sameProgress(const CheckpointState& a, const CheckpointState& b);
+    static void beginWrite(const CheckpointState& state);
+    static void writeStep();
+    static void verifyRestore();
+
+public:
+    /**
+     * @brief 上电时调用：找出最新检查点，有运行中的环节则交给GameFlowManager恢复
+     * @return true=已恢复游戏进度
+     */
+    static bool restore();
+
+    /**
+     * @brief loop中调用：比较状态、推进非阻塞写入
+     */
+    static void update();
+
+    /**
+     * @brief 清除检查点（写入空状态）
+     */
+    static void clear();
+
+    /**
+     * @brief REGISTER附加参数，如 "recovered_stage=072-7,recovered_elapsed=1840"，未恢复时为空
+     */
+    static String getRecoveryParams();
+
+    static bool isWriting();
+    static void printStatus();
+};
+
+#endif // GAME_CHECKPOINT_H
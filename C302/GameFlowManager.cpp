@@ -12,6 +12,9 @@
 #include "UniversalHarbingerClient.h"
 #include "GameStageStateMachine.h"
 #include "SimpleGameStage.h"
+#include "MapLightEffects.h"
+#include "EventTrace.h"
+#include "GameCheckpoint.h"
 
 // 外部全局实例
 extern UniversalHarbingerClient harbingerClient;
@@ -35,20 +38,45 @@ int GameFlowManager::successCount = 0;          // 成功次数从0开始 (新
 bool GameFlowManager::gameActive = false;       // 游戏默认非激活状态
 int GameFlowManager::currentLevel = 1;          // 默认从Level 1开始
 String GameFlowManager::lastCompletionSource = ""; // 上次完成来源
+uint32_t GameFlowManager::litMask = 0;          // 默认全灭
 
 // 刷新步骤循环追踪变量定义
 bool GameFlowManager::lastRefreshWas5 = false;  // 默认从-5开始，所以初始为false（下次是-5）
 
-// 频闪状态机变量定义
-bool GameFlowManager::strobeActive = false;
-bool GameFlowManager::strobeState = false;
-unsigned long GameFlowManager::strobeNextTime = 0;
-unsigned long GameFlowManager::strobeEndTime = 0;
-
 // 矩阵旋转系统变量定义
 int GameFlowManager::currentRotation = 0;       // 默认无旋转
 int GameFlowManager::lastRotation = -1;         // 初始化为-1表示无历史
 
+// ========================== 遗迹地图位棋盘常量表 ==========================
+
+// 每个按键的相邻掩码（编译期生成）
+#define MAP_ADJ(i) MAP_NEIGHBORS(MAP_CELL_BIT(i))
+static const uint32_t MAP_ADJACENT_MASKS[MAP_CELL_COUNT] PROGMEM = {
+    MAP_ADJ(0), MAP_ADJ(1), MAP_ADJ(2), MAP_ADJ(3), MAP_ADJ(4),
+    MAP_ADJ(5), MAP_ADJ(6), MAP_ADJ(7), MAP_ADJ(8), MAP_ADJ(9),
+    MAP_ADJ(10), MAP_ADJ(11), MAP_ADJ(12), MAP_ADJ(13), MAP_ADJ(14),
+    MAP_ADJ(15), MAP_ADJ(16), MAP_ADJ(17), MAP_ADJ(18), MAP_ADJ(19),
+    MAP_ADJ(20), MAP_ADJ(21), MAP_ADJ(22), MAP_ADJ(23), MAP_ADJ(24)
+};
+#undef MAP_ADJ
+
+// 旋转置换表：MAP_ROTATION_TABLE[rotation][原始索引] = 旋转后索引（索引0-24）
+// 0=原始, 1=90°顺时针, 2=180°, 3=270°顺时针
+const uint8_t MAP_ROTATION_TABLE[4][MAP_CELL_COUNT] PROGMEM = {
+    { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24},
+    { 4,  9, 14, 19, 24,  3,  8, 13, 18, 23,  2,  7, 12, 17, 22,  1,  6, 11, 16, 21,  0,  5, 10, 15, 20},
+    {24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10,  9,  8,  7,  6,  5,  4,  3,  2,  1,  0},
+    {20, 15, 10,  5,  0, 21, 16, 11,  6,  1, 22, 17, 12,  7,  2, 23, 18, 13,  8,  3, 24, 19, 14,  9,  4}
+};
+
+// 各Level原始亮灯掩码（未旋转）
+static const uint32_t MAP_LEVEL_MASKS[4] PROGMEM = {
+    MAP_FULL_MASK & ~0x00007C00UL,   // Level 1: 除中间一排(11-15)外都亮
+    MAP_CELL_BIT(6),                 // Level 2: 只有第7个按键亮着
+    MAP_CELL_BIT(1) | MAP_CELL_BIT(8) | MAP_CELL_BIT(16) | MAP_CELL_BIT(17),  // Level 3: 第2,9,17,18个
+    MAP_CELL_BIT(1)                  // Level 4: 只有第2个按键亮着
+};
+
 // ========================== 构造和初始化 ==========================
 GameFlowManager::GameFlowManager() {
     currentStageId = "";
@@ -93,8 +121,9 @@ bool GameFlowManager::startStage(const String& stageId) {
     // 不停止当前状态，保持所有效果的连续性
     // 只更新环节管理信息
     currentStageId = normalizedId;
-    stageStartTime = millis();
+    stageStartTime = MillisTimeSource::getCurrentTime() - harbingerClient.getDispatchLateness();  // at=定时启动时对齐到约定时刻
     stageRunning = true;
+    EventTrace::recordStage(normalizedId);
     
     // 根据环节ID执行对应逻辑
     if (normalizedId == "072-0") {
@@ -169,6 +198,9 @@ void GameFlowManager::stopAllStages() {
     // 停止所有数字IO效果
     DigitalIOController::stopAllOutputs();
     
+    // 停止空间光效（灯已由stopAll熄灭）
+    MapLightEffects::stop(false);
+    
     // 重置环节状态
     stageRunning = false;
     currentStageId = "";
@@ -192,7 +224,7 @@ bool GameFlowManager::isStageRunning() const {
 
 unsigned long GameFlowManager::getStageElapsedTime() const {
     if (!stageRunning) return 0;
-    return millis() - stageStartTime;
+    return MillisTimeSource::getCurrentTime() - stageStartTime;
 }
 
 // ========================== 环节列表 ==========================
@@ -238,40 +270,20 @@ void GameFlowManager::update() {
     // 第一步：检查所有输入状态，设置全局标记
     checkInputs();
     
-    // 第二步：处理频闪状态机
-    if (strobeActive) {
-        unsigned long now = millis();
-        if (now >= strobeNextTime) {
-            if (now >= strobeEndTime) {
-                // 频闪结束
-                strobeActive = false;
-                MillisPWM::setBrightness(22, 0);  // 左侧蜡烛灭
-                MillisPWM::setBrightness(23, 0);  // 右侧蜡烛灭
-                Serial.println(F("🕯️ 蜡烛频闪结束"));
-            } else {
-                // 切换频闪状态
-                strobeState = !strobeState;
-                int brightness = strobeState ? 255 : 0;
-                MillisPWM::setBrightness(22, brightness);  // 左侧蜡烛
-                MillisPWM::setBrightness(23, brightness);  // 右侧蜡烛
-                
-                // 计算下次切换时间
-                strobeNextTime = now + (strobeState ? CANDLE_STROBE_ON_TIME : CANDLE_STROBE_OFF_TIME);
-            }
-        }
-    }
-    
-    // 第三步：处理所有输入事件
+    // 第二步：处理所有输入事件
     processInputEvents();
     
-    // 第四步：更新时刻表系统（用于072-7/8/9的定时效果）
+    // 第三步：更新时刻表系统（用于072-7/8/9的定时效果）
     gameStage.update();
+    
+    // 第四步：更新空间光效（072-5/6刷新光效、HARD EFFECT命令）
+    MapLightEffects::update();
 }
 
 void GameFlowManager::checkInputs() {
     // 检查引脚25按键状态（只在072-0环节中监听）
     if (stageRunning && currentStageId == "072-0") {
-        bool currentState = digitalRead(25);
+        bool currentState = EventTrace::readInput(25);
         
         // 检测下降沿（按键按下）
         if (lastPin25State == HIGH && currentState == LOW) {
@@ -287,7 +299,7 @@ void GameFlowManager::checkInputs() {
             int buttonNumber = i + 1;  // 按键编号1-25
             int inputPin = getButtonInputPin(buttonNumber);  // 获取输入引脚
             
-            bool currentState = digitalRead(inputPin);
+            bool currentState = EventTrace::readInput(inputPin);
             
             // 检测下降沿（按键按下）
             if (lastButtonState[i] == HIGH && currentState == LOW) {
@@ -570,60 +582,11 @@ void GameFlowManager::defineStage072_5() {
     // 清空之前的时刻表
     gameStage.clearStage();
     
-    // 首先关闭所有按键
-    for (int i = 1; i <= 25; i++) {
-        int pin = getButtonPin(i);
-        MillisPWM::setBrightness(pin, 0);
-    }
-    
     Serial.println(F("  - 开始1秒轮播光效序列"));
     
-    // 根据图片时间轴实现轮播序列
-    // 0-200ms: 遗迹地图白色方形按键1按键亮
-    gameStage.duration(0, 200, getButtonPin(1), PWM_SET, 255);
-    
-    // 100-300ms: 遗迹地图2、6白色方形按键1按键亮  
-    gameStage.duration(100, 200, getButtonPin(2), PWM_SET, 255);
-    gameStage.duration(100, 200, getButtonPin(6), PWM_SET, 255);
-    
-    // 200-400ms: 遗迹地图3、7、11白色方形按键1按键亮
-    gameStage.duration(200, 200, getButtonPin(3), PWM_SET, 255);
-    gameStage.duration(200, 200, getButtonPin(7), PWM_SET, 255);
-    gameStage.duration(200, 200, getButtonPin(11), PWM_SET, 255);
-    
-    // 300-500ms: 遗迹地图4、8、12、16白色方形按键1按键亮
-    gameStage.duration(300, 200, getButtonPin(4), PWM_SET, 255);
-    gameStage.duration(300, 200, getButtonPin(8), PWM_SET, 255);
-    gameStage.duration(300, 200, getButtonPin(12), PWM_SET, 255);
-    gameStage.duration(300, 200, getButtonPin(16), PWM_SET, 255);
-    
-    // 400-600ms: 遗迹地图5、9、13、17、21白色方形按键1按键亮
-    gameStage.duration(400, 200, getButtonPin(5), PWM_SET, 255);
-    gameStage.duration(400, 200, getButtonPin(9), PWM_SET, 255);
-    gameStage.duration(400, 200, getButtonPin(13), PWM_SET, 255);
-    gameStage.duration(400, 200, getButtonPin(17), PWM_SET, 255);
-    gameStage.duration(400, 200, getButtonPin(21), PWM_SET, 255);
-    
-    // 500-700ms: 遗迹地图10、14、18、22白色方形按键1按键亮
-    gameStage.duration(500, 200, getButtonPin(10), PWM_SET, 255);
-    gameStage.duration(500, 200, getButtonPin(14), PWM_SET, 255);
-    gameStage.duration(500, 200, getButtonPin(18), PWM_SET, 255);
-    gameStage.duration(500, 200, getButtonPin(22), PWM_SET, 255);
-    
-    // 600-800ms: 遗迹地图15、19、23白色方形按键1按键亮
-    gameStage.duration(600, 200, getButtonPin(15), PWM_SET, 255);
-    gameStage.duration(600, 200, getButtonPin(19), PWM_SET, 255);
-    gameStage.duration(600, 200, getButtonPin(23), PWM_SET, 255);
-    
-    // 700-900ms: 遗迹地图20、24白色方形按键1按键亮
-    gameStage.duration(700, 200, getButtonPin(20), PWM_SET, 255);
-    gameStage.duration(700, 200, getButtonPin(24), PWM_SET, 255);
-    
-    // 800-1000ms: 遗迹地图25白色方形按键1按键亮
-    gameStage.duration(800, 200, getButtonPin(25), PWM_SET, 255);
-    
-    // 1000ms: 副本大卡 (正确或错误轮播) - 所有按键关闭
-    gameStage.instant(1000, -1, LED_OFF);  // 使用特殊标记关闭所有按键
+    // 斜向波浪：从物理按键1斜向扫到按键25（不随关卡旋转），每条斜线延迟100ms、点亮200ms
+    // 最远斜线延迟8 * 100ms + 200ms = 1000ms，光效结束时自动熄灭所有按键
+    MAP_FX_WAVE_PHYSICAL(1, 100, 200);
     
     // 1秒后跳转到下一个目标步骤
     String targetStage = getRefreshTargetStage();
@@ -643,60 +606,11 @@ void GameFlowManager::defineStage072_6() {
     // 清空之前的时刻表
     gameStage.clearStage();
     
-    // 首先关闭所有按键
-    for (int i = 1; i <= 25; i++) {
-        int pin = getButtonPin(i);
-        MillisPWM::setBrightness(pin, 0);
-    }
-    
     Serial.println(F("  - 开始1秒轮播光效序列"));
     
-    // 根据图片时间轴实现轮播序列（与072-5不同的组合）
-    // 0-200ms: 遗迹地图白色方形按键5按键亮
-    gameStage.duration(0, 200, getButtonPin(5), PWM_SET, 255);
-    
-    // 100-300ms: 遗迹地图4、10白色方形按键按键亮
-    gameStage.duration(100, 200, getButtonPin(4), PWM_SET, 255);
-    gameStage.duration(100, 200, getButtonPin(10), PWM_SET, 255);
-    
-    // 200-400ms: 遗迹地图3、9、6白色方形按键按键亮
-    gameStage.duration(200, 200, getButtonPin(3), PWM_SET, 255);
-    gameStage.duration(200, 200, getButtonPin(9), PWM_SET, 255);
-    gameStage.duration(200, 200, getButtonPin(6), PWM_SET, 255);
-    
-    // 300-500ms: 遗迹地图2、8、14、20白色方形按键按键亮
-    gameStage.duration(300, 200, getButtonPin(2), PWM_SET, 255);
-    gameStage.duration(300, 200, getButtonPin(8), PWM_SET, 255);
-    gameStage.duration(300, 200, getButtonPin(14), PWM_SET, 255);
-    gameStage.duration(300, 200, getButtonPin(20), PWM_SET, 255);
-    
-    // 400-600ms: 遗迹地图1、7、13、19、25白色方形按键按键亮
-    gameStage.duration(400, 200, getButtonPin(1), PWM_SET, 255);
-    gameStage.duration(400, 200, getButtonPin(7), PWM_SET, 255);
-    gameStage.duration(400, 200, getButtonPin(13), PWM_SET, 255);
-    gameStage.duration(400, 200, getButtonPin(19), PWM_SET, 255);
-    gameStage.duration(400, 200, getButtonPin(25), PWM_SET, 255);
-    
-    // 500-700ms: 遗迹地图6、12、18、24白色方形按键按键亮
-    gameStage.duration(500, 200, getButtonPin(6), PWM_SET, 255);
-    gameStage.duration(500, 200, getButtonPin(12), PWM_SET, 255);
-    gameStage.duration(500, 200, getButtonPin(18), PWM_SET, 255);
-    gameStage.duration(500, 200, getButtonPin(24), PWM_SET, 255);
-    
-    // 600-800ms: 遗迹地图11、17、23白色方形按键按键亮
-    gameStage.duration(600, 200, getButtonPin(11), PWM_SET, 255);
-    gameStage.duration(600, 200, getButtonPin(17), PWM_SET, 255);
-    gameStage.duration(600, 200, getButtonPin(23), PWM_SET, 255);
-    
-    // 700-900ms: 遗迹地图16、22白色方形按键按键亮
-    gameStage.duration(700, 200, getButtonPin(16), PWM_SET, 255);
-    gameStage.duration(700, 200, getButtonPin(22), PWM_SET, 255);
-    
-    // 800-1000ms: 遗迹地图21白色方形按键按键亮
-    gameStage.duration(800, 200, getButtonPin(21), PWM_SET, 255);
-    
-    // 1000ms: 副本大卡 (正确或错误轮播) - 所有按键关闭
-    gameStage.instant(1000, -1, LED_OFF);  // 使用特殊标记关闭所有按键
+    // 斜向波浪：从物理按键5斜向扫到按键21（不随关卡旋转），每条斜线延迟100ms、点亮200ms
+    // 最远斜线延迟8 * 100ms + 200ms = 1000ms，光效结束时自动熄灭所有按键
+    MAP_FX_WAVE_PHYSICAL(5, 100, 200);
     
     // 1秒后跳转到下一个目标步骤
     String targetStage = getRefreshTargetStage();
@@ -710,6 +624,29 @@ void GameFlowManager::defineStage072_6() {
     Serial.println(F(")"));
 }
 
+/**
+ * @brief 最后按下按键的错误闪烁：慢闪3次后快闪6次，最后熄灭
+ * 闪烁由PWM通道按截止时间切换，每个阶段只占一个时刻表时间段
+ */
+void GameFlowManager::executeLastButtonEffect() {
+    if (lastPressedButton <= 0) return;
+    
+    int pin = getButtonPin(lastPressedButton);
+    if (pin == -1) return;
+    
+    Serial.print(F("  - 最后按键"));
+    Serial.print(lastPressedButton);
+    Serial.println(F("闪烁效果"));
+    
+    // 慢闪阶段: 亮400ms，灭400ms，循环3次
+    gameStage.ledFlash(0, ERROR_SLOW_FLASH_END, pin,
+                       ERROR_SLOW_FLASH_ON_TIME, ERROR_SLOW_FLASH_OFF_TIME);
+    
+    // 快闪阶段: 亮50ms，灭50ms，循环6次（结束时熄灭）
+    gameStage.ledFlash(ERROR_SLOW_FLASH_END, ERROR_FAST_FLASH_END - ERROR_SLOW_FLASH_END, pin,
+                       ERROR_FAST_FLASH_ON_TIME, ERROR_FAST_FLASH_OFF_TIME);
+}
+
 void GameFlowManager::defineStage072_7() {
     Serial.println(F("📍 环节 072-7：游戏失败效果1"));
     
@@ -717,31 +654,7 @@ void GameFlowManager::defineStage072_7() {
     gameStage.clearStage();
     
     // 执行最后按下按键的闪烁效果
-    if (lastPressedButton > 0) {
-        int pin = getButtonPin(lastPressedButton);
-        if (pin != -1) {
-            Serial.print(F("  - 最后按键"));
-            Serial.print(lastPressedButton);
-            Serial.println(F("闪烁效果"));
-            
-            // 慢闪阶段: 亮400ms，灭400ms，循环3次
-            for (int i = 0; i < ERROR_SLOW_FLASH_CYCLES; i++) {
-                unsigned long cycleStart = i * (ERROR_SLOW_FLASH_ON_TIME + ERROR_SLOW_FLASH_OFF_TIME);
-                gameStage.duration(cycleStart, ERROR_SLOW_FLASH_ON_TIME, pin, PWM_SET, 255);      // 亮400ms
-                gameStage.duration(cycleStart + ERROR_SLOW_FLASH_ON_TIME, ERROR_SLOW_FLASH_OFF_TIME, pin, PWM_SET, 0);  // 灭400ms
-            }
-            
-            // 快闪阶段: 亮50ms，灭50ms，循环6次
-            for (int i = 0; i < ERROR_FAST_FLASH_CYCLES; i++) {
-                unsigned long cycleStart = ERROR_SLOW_FLASH_END + i * (ERROR_FAST_FLASH_ON_TIME + ERROR_FAST_FLASH_OFF_TIME);
-                gameStage.duration(cycleStart, ERROR_FAST_FLASH_ON_TIME, pin, PWM_SET, 255);  // 亮50ms
-                gameStage.duration(cycleStart + ERROR_FAST_FLASH_ON_TIME, ERROR_FAST_FLASH_OFF_TIME, pin, PWM_SET, 0);    // 灭50ms
-            }
-            
-            // 频闪完成，确保按键熄灭
-            gameStage.instant(ERROR_FAST_FLASH_END, pin, PWM_SET, 0);
-        }
-    }
+    executeLastButtonEffect();
     
     // 跳转到指定环节
     String nextRefreshStage = getNextRefreshStage();
@@ -764,31 +677,7 @@ void GameFlowManager::defineStage072_8() {
     gameStage.clearStage();
     
     // 执行最后按下按键的闪烁效果
-    if (lastPressedButton > 0) {
-        int pin = getButtonPin(lastPressedButton);
-        if (pin != -1) {
-            Serial.print(F("  - 最后按键"));
-            Serial.print(lastPressedButton);
-            Serial.println(F("闪烁效果"));
-            
-            // 慢闪阶段: 亮400ms，灭400ms，循环3次
-            for (int i = 0; i < ERROR_SLOW_FLASH_CYCLES; i++) {
-                unsigned long cycleStart = i * (ERROR_SLOW_FLASH_ON_TIME + ERROR_SLOW_FLASH_OFF_TIME);
-                gameStage.duration(cycleStart, ERROR_SLOW_FLASH_ON_TIME, pin, PWM_SET, 255);      // 亮400ms
-                gameStage.duration(cycleStart + ERROR_SLOW_FLASH_ON_TIME, ERROR_SLOW_FLASH_OFF_TIME, pin, PWM_SET, 0);  // 灭400ms
-            }
-            
-            // 快闪阶段: 亮50ms，灭50ms，循环6次
-            for (int i = 0; i < ERROR_FAST_FLASH_CYCLES; i++) {
-                unsigned long cycleStart = ERROR_SLOW_FLASH_END + i * (ERROR_FAST_FLASH_ON_TIME + ERROR_FAST_FLASH_OFF_TIME);
-                gameStage.duration(cycleStart, ERROR_FAST_FLASH_ON_TIME, pin, PWM_SET, 255);  // 亮50ms
-                gameStage.duration(cycleStart + ERROR_FAST_FLASH_ON_TIME, ERROR_FAST_FLASH_OFF_TIME, pin, PWM_SET, 0);    // 灭50ms
-            }
-            
-            // 频闪完成，确保按键熄灭
-            gameStage.instant(ERROR_FAST_FLASH_END, pin, PWM_SET, 0);
-        }
-    }
+    executeLastButtonEffect();
     
     // 跳转到指定环节
     String nextRefreshStage = getNextRefreshStage();
@@ -811,31 +700,7 @@ void GameFlowManager::defineStage072_9() {
     gameStage.clearStage();
     
     // 执行最后按下按键的闪烁效果
-    if (lastPressedButton > 0) {
-        int pin = getButtonPin(lastPressedButton);
-        if (pin != -1) {
-            Serial.print(F("  - 最后按键"));
-            Serial.print(lastPressedButton);
-            Serial.println(F("闪烁效果"));
-            
-            // 慢闪阶段: 亮400ms，灭400ms，循环3次
-            for (int i = 0; i < ERROR_SLOW_FLASH_CYCLES; i++) {
-                unsigned long cycleStart = i * (ERROR_SLOW_FLASH_ON_TIME + ERROR_SLOW_FLASH_OFF_TIME);
-                gameStage.duration(cycleStart, ERROR_SLOW_FLASH_ON_TIME, pin, PWM_SET, 255);      // 亮400ms
-                gameStage.duration(cycleStart + ERROR_SLOW_FLASH_ON_TIME, ERROR_SLOW_FLASH_OFF_TIME, pin, PWM_SET, 0);  // 灭400ms
-            }
-            
-            // 快闪阶段: 亮50ms，灭50ms，循环6次
-            for (int i = 0; i < ERROR_FAST_FLASH_CYCLES; i++) {
-                unsigned long cycleStart = ERROR_SLOW_FLASH_END + i * (ERROR_FAST_FLASH_ON_TIME + ERROR_FAST_FLASH_OFF_TIME);
-                gameStage.duration(cycleStart, ERROR_FAST_FLASH_ON_TIME, pin, PWM_SET, 255);  // 亮50ms
-                gameStage.duration(cycleStart + ERROR_FAST_FLASH_ON_TIME, ERROR_FAST_FLASH_OFF_TIME, pin, PWM_SET, 0);    // 灭50ms
-            }
-            
-            // 频闪完成，确保按键熄灭
-            gameStage.instant(ERROR_FAST_FLASH_END, pin, PWM_SET, 0);
-        }
-    }
+    executeLastButtonEffect();
     
     // 跳转到指定环节
     String nextRefreshStage = getNextRefreshStage();
@@ -887,16 +752,16 @@ void GameFlowManager::defineStage080_0() {
     gameStage.instant(CANDLE_LEFT_ON_TIME, 22, PWM_SET, 255);   // 左侧蜡烛13320ms点亮
     gameStage.instant(CANDLE_RIGHT_ON_TIME, 23, PWM_SET, 255);  // 右侧蜡烛13320ms点亮
     
+    // 阶段4: 蜡烛高频闪烁 (15164-19566ms)，由PWM通道频闪模式执行，结束时熄灭
+    Serial.println(F("  - 阶段4: 蜡烛高频闪烁"));
+    gameStage.ledFlash(CANDLE_STROBE_START, CANDLE_STROBE_END - CANDLE_STROBE_START, 22,
+                       CANDLE_STROBE_ON_TIME, CANDLE_STROBE_OFF_TIME);  // 左侧蜡烛
+    gameStage.ledFlash(CANDLE_STROBE_START, CANDLE_STROBE_END - CANDLE_STROBE_START, 23,
+                       CANDLE_STROBE_ON_TIME, CANDLE_STROBE_OFF_TIME);  // 右侧蜡烛
+    
     // 启动时刻表
     gameStage.startStage(80);  // 使用特殊的stage ID
     
-    // 阶段4: 启动蜡烛高频闪烁状态机 (15164-19566ms)
-    Serial.println(F("  - 阶段4: 启动蜡烛高频闪烁状态机"));
-    strobeActive = true;
-    strobeState = false;  // 开始时为熄灭状态
-    strobeNextTime = millis() + CANDLE_STROBE_START;  // 15164ms后开始频闪
-    strobeEndTime = millis() + CANDLE_STROBE_END;     // 19566ms后结束频闪
-    
     Serial.println(F("🎉 环节 080-0 启动完成 (含高频闪烁效果)"));
     Serial.println(F("  - 总时长: ~20秒"));
     Serial.println(F("  - 全场闪烁: 3次 (800ms亮/800ms灭)"));
@@ -941,8 +806,9 @@ void GameFlowManager::notifyStageComplete(const String& currentStep, const Strin
  * @brief 停止动态效果，保持静态状态
  */
 void GameFlowManager::stopDynamicEffects() {
-    // 停止时刻表系统
+    // 停止时刻表系统和空间光效
     gameStage.clearStage();
+    MapLightEffects::stop(false);
     
     Serial.println(F("🛑 停止动态效果，保持静态状态"));
 }
@@ -969,12 +835,6 @@ void GameFlowManager::resetGameState() {
     // 清除完成来源标记
     lastCompletionSource = "";
     
-    // 重置频闪状态机
-    strobeActive = false;
-    strobeState = false;
-    strobeNextTime = 0;
-    strobeEndTime = 0;
-    
     // 矩阵旋转系统：完全不重置，保持历史记录避免重复
     // currentRotation 和 lastRotation 都保持不变
     
@@ -1026,75 +886,6 @@ int GameFlowManager::getButtonPin(int buttonNumber) {
     }
 }
 
-/**
- * @brief 设置Level 1的初始状态
- * Level 1: 除中间一排(第13排，即按键11,12,13,14,15)灭着，其他都亮
- */
-void GameFlowManager::setupLevel1() {
-    Serial.println(F("  - Level 1: 除中间一排外都亮着"));
-    
-    for (int i = 1; i <= 25; i++) {
-        int pin = getButtonPin(i);
-        // 中间一排(11,12,13,14,15)灭着，其他亮着
-        if (i >= 11 && i <= 15) {
-            MillisPWM::setBrightness(pin, 0);    // 灭着
-        } else {
-            MillisPWM::setBrightness(pin, 255);  // 亮着
-        }
-    }
-}
-
-/**
- * @brief 设置Level 2的初始状态
- * Level 2: 只有第7个按键亮着，其他都灭
- */
-void GameFlowManager::setupLevel2() {
-    Serial.println(F("  - Level 2: 只有第7个按键亮着"));
-    
-    for (int i = 1; i <= 25; i++) {
-        int pin = getButtonPin(i);
-        if (i == 7) {
-            MillisPWM::setBrightness(pin, 255);  // 第7个亮着
-        } else {
-            MillisPWM::setBrightness(pin, 0);    // 其他灭着
-        }
-    }
-}
-
-/**
- * @brief 设置Level 3的初始状态
- * Level 3: 只有第2,9,17,18个按键亮着，其他都灭
- */
-void GameFlowManager::setupLevel3() {
-    Serial.println(F("  - Level 3: 第2,9,17,18个按键亮着"));
-    
-    for (int i = 1; i <= 25; i++) {
-        int pin = getButtonPin(i);
-        if (i == 2 || i == 9 || i == 17 || i == 18) {
-            MillisPWM::setBrightness(pin, 255);  // 指定按键亮着
-        } else {
-            MillisPWM::setBrightness(pin, 0);    // 其他灭着
-        }
-    }
-}
-
-/**
- * @brief 设置Level 4的初始状态
- * Level 4: 只有第2个按键亮着，其他都灭
- */
-void GameFlowManager::setupLevel4() {
-    Serial.println(F("  - Level 4: 只有第2个按键亮着"));
-    
-    for (int i = 1; i <= 25; i++) {
-        int pin = getButtonPin(i);
-        if (i == 2) {
-            MillisPWM::setBrightness(pin, 255);  // 第2个亮着
-        } else {
-            MillisPWM::setBrightness(pin, 0);    // 其他灭着
-        }
-    }
-}
-
 /**
  * @brief 检查两个按键是否相邻（5x5网格，只考虑上下左右）
  * @param button1 按键1编号 (1-25)
@@ -1106,18 +897,8 @@ bool GameFlowManager::areButtonsAdjacent(int button1, int button2) {
         return false;
     }
     
-    // 转换为5x5网格坐标 (0-4, 0-4)
-    int row1 = (button1 - 1) / 5;
-    int col1 = (button1 - 1) % 5;
-    int row2 = (button2 - 1) / 5;
-    int col2 = (button2 - 1) % 5;
-    
-    // 检查是否相邻（上下左右，不包括斜角）
-    int rowDiff = abs(row1 - row2);
-    int colDiff = abs(col1 - col2);
-    
-    // 相邻条件：行差+列差=1（曼哈顿距离为1）
-    return (rowDiff + colDiff == 1);
+    // 查相邻掩码表（上下左右，不包括斜角）
+    return (pgm_read_dword(&MAP_ADJACENT_MASKS[button1 - 1]) & MAP_CELL_BIT(button2 - 1)) != 0;
 }
 
 /**
@@ -1170,15 +951,14 @@ void GameFlowManager::handleMapButtonPress(int buttonNumber) {
     Serial.print(F(" → 逻辑按键"));
     Serial.println(logicalButton);
     
-    // 获取按键对应的输出引脚
-    int outputPin = getButtonPin(buttonNumber);
-    if (outputPin == -1) {
+    if (buttonNumber < 1 || buttonNumber > 25) {
         Serial.println(F("❌ 无效的按键编号"));
         return;
     }
-    
+    uint32_t pressBit = MAP_CELL_BIT(buttonNumber - 1);
+
     // 检查按键是否已经亮着（游戏失败条件）
-    if (isButtonLit(buttonNumber)) {
+    if (litMask & pressBit) {
         Serial.print(F("❌ 按键"));
         Serial.print(buttonNumber);
         Serial.println(F("已经亮着！游戏失败！"));
@@ -1187,39 +967,38 @@ void GameFlowManager::handleMapButtonPress(int buttonNumber) {
     }
     
     // 检查相邻性（如果不是第一个按键）
-    // 在逻辑坐标系中检查相邻性
-    if (lastPressedButton != 0) {
+    // 旋转不改变相邻关系，直接用物理按键的相邻掩码判断
+    if (lastPressedButton != 0 &&
+        !(pgm_read_dword(&MAP_ADJACENT_MASKS[lastPressedButton - 1]) & pressBit)) {
         int lastLogicalButton = reverseRotateButtonNumber(lastPressedButton, currentRotation);
-        if (!areButtonsAdjacent(lastLogicalButton, logicalButton)) {
-            Serial.print(F("❌ 按键"));
-            Serial.print(buttonNumber);
-            Serial.print(F("(逻辑"));
-            Serial.print(logicalButton);
-            Serial.print(F(")与上一个按键"));
-            Serial.print(lastPressedButton);
-            Serial.print(F("(逻辑"));
-            Serial.print(lastLogicalButton);
-            Serial.println(F(")不相邻！游戏失败！"));
-            handleGameError(buttonNumber);
-            return;
-        }
+        Serial.print(F("❌ 按键"));
+        Serial.print(buttonNumber);
+        Serial.print(F("(逻辑"));
+        Serial.print(logicalButton);
+        Serial.print(F(")与上一个按键"));
+        Serial.print(lastPressedButton);
+        Serial.print(F("(逻辑"));
+        Serial.print(lastLogicalButton);
+        Serial.println(F(")不相邻！游戏失败！"));
+        handleGameError(buttonNumber);
+        return;
     }
     
     // 合法移动：点亮按键
-    MillisPWM::setBrightness(outputPin, 255);
+    applyLitMask(litMask | pressBit);
     lastPressedButton = buttonNumber;  // 记录物理按键编号
     
     Serial.print(F("✅ 按键"));
     Serial.print(buttonNumber);
     Serial.print(F("已点亮 (引脚"));
-    Serial.print(outputPin);
+    Serial.print(getButtonPin(buttonNumber));
     Serial.println(F(")"));
     
     // 检查游戏是否完成（所有按键都亮了）
     if (checkGameComplete()) {
         Serial.println(F("🎉 恭喜！遗迹地图游戏完成！"));
-                 handleGameComplete();
-     }
+        handleGameComplete();
+    }
 }
 
 /**
@@ -1228,12 +1007,34 @@ void GameFlowManager::handleMapButtonPress(int buttonNumber) {
  * @return 是否已经亮着
  */
 bool GameFlowManager::isButtonLit(int buttonNumber) {
-    int outputPin = getButtonPin(buttonNumber);
-    if (outputPin == -1) return false;
+    if (buttonNumber < 1 || buttonNumber > 25) return false;
+    return (litMask & MAP_CELL_BIT(buttonNumber - 1)) != 0;
+}
+
+/**
+ * @brief 载入亮灯掩码，重写全部25个灯（Level初始化时灯光状态未知）
+ * @param mask 物理按键坐标的亮灯掩码
+ */
+void GameFlowManager::loadLitMask(uint32_t mask) {
+    litMask = ~mask & MAP_FULL_MASK;  // 让每一位都视为变化
+    applyLitMask(mask);
+}
+
+/**
+ * @brief 按掩码差异批量更新亮灯，只写变化的按键
+ * @param newMask 新的亮灯掩码（物理按键坐标）
+ */
+void GameFlowManager::applyLitMask(uint32_t newMask) {
+    newMask &= MAP_FULL_MASK;
+    uint32_t changed = litMask ^ newMask;
     
-    // 通过PWM系统检查亮度是否大于0
-    uint8_t brightness = MillisPWM::getBrightness(outputPin);
-    return brightness > 0;
+    for (uint8_t i = 0; changed != 0; i++, changed >>= 1) {
+        if (changed & 1) {
+            MillisPWM::setBrightness(getButtonPin(i + 1), (newMask & MAP_CELL_BIT(i)) ? 255 : 0);
+        }
+    }
+    
+    litMask = newMask;
 }
 
 /**
@@ -1285,12 +1086,7 @@ void GameFlowManager::handleGameError(int failedButton) {
  * @return 是否完成
  */
 bool GameFlowManager::checkGameComplete() {
-    for (int i = 1; i <= 25; i++) {
-        if (!isButtonLit(i)) {
-            return false;  // 还有按键没亮
-        }
-    }
-    return true;  // 所有按键都亮了
+    return litMask == MAP_FULL_MASK;
 }
 
 /**
@@ -1574,41 +1370,7 @@ int GameFlowManager::rotateButtonNumber(int originalButton, int rotation) {
         return originalButton;  // 无效按键编号，直接返回
     }
     
-    // 转换为0-24的索引
-    int index = originalButton - 1;
-    
-    // 转换为5x5矩阵坐标 (row, col)
-    int row = index / 5;
-    int col = index % 5;
-    
-    int newRow, newCol;
-    
-    // 根据旋转方向计算新坐标
-    switch (rotation) {
-        case 0:  // 原始 (0°)
-            newRow = row;
-            newCol = col;
-            break;
-        case 1:  // 90° 顺时针旋转
-            newRow = col;
-            newCol = 4 - row;
-            break;
-        case 2:  // 180° 旋转
-            newRow = 4 - row;
-            newCol = 4 - col;
-            break;
-        case 3:  // 270° 顺时针旋转 (或90°逆时针)
-            newRow = 4 - col;
-            newCol = row;
-            break;
-        default:
-            newRow = row;
-            newCol = col;
-            break;
-    }
-    
-    // 转换回按键编号 (1-25)
-    return newRow * 5 + newCol + 1;
+    return pgm_read_byte(&MAP_ROTATION_TABLE[rotation & 3][originalButton - 1]) + 1;
 }
 
 /**
@@ -1618,31 +1380,26 @@ int GameFlowManager::rotateButtonNumber(int originalButton, int rotation) {
  * @return 原始按键编号 (1-25)
  */
 int GameFlowManager::reverseRotateButtonNumber(int rotatedButton, int rotation) {
-    if (rotatedButton < 1 || rotatedButton > 25) {
-        return rotatedButton;  // 无效按键编号，直接返回
-    }
+    // 反向旋转：90°↔270°，0°和180°不变
+    return rotateButtonNumber(rotatedButton, (4 - rotation) & 3);
+}
+
+/**
+ * @brief 对整个掩码应用旋转
+ * @param mask 原始坐标的亮灯掩码
+ * @param rotation 旋转方向 (0=原始, 1=90°, 2=180°, 3=270°)
+ * @return 旋转后的亮灯掩码
+ */
+uint32_t GameFlowManager::rotateMask(uint32_t mask, int rotation) {
+    const uint8_t* table = MAP_ROTATION_TABLE[rotation & 3];
+    uint32_t rotated = 0;
     
-    // 反向旋转：使用相反的旋转方向
-    int reverseRotation;
-    switch (rotation) {
-        case 0:  // 原始 → 原始
-            reverseRotation = 0;
-            break;
-        case 1:  // 90° → 270°
-            reverseRotation = 3;
-            break;
-        case 2:  // 180° → 180°
-            reverseRotation = 2;
-            break;
-        case 3:  // 270° → 90°
-            reverseRotation = 1;
-            break;
-        default:
-            reverseRotation = 0;
-            break;
+    for (uint8_t i = 0; mask != 0; i++, mask >>= 1) {
+        if (mask & 1) {
+            rotated |= MAP_CELL_BIT(pgm_read_byte(&table[i]));
+        }
     }
-    
-    return rotateButtonNumber(rotatedButton, reverseRotation);
+    return rotated;
 }
 
 /**
@@ -1658,59 +1415,115 @@ void GameFlowManager::applyRotationToLevel(int level, int rotation) {
     Serial.print(rotationNames[rotation]);
     Serial.println(F("旋转"));
     
-    // 先关闭所有LED
-    for (int i = 1; i <= 25; i++) {
-        int pin = getButtonPin(i);
-        MillisPWM::setBrightness(pin, 0);
+    if (level < 1 || level > 4) {
+        Serial.println(F("❌ 无效的Level"));
+        return;
     }
     
-    // 根据Level获取原始亮灯模式，然后应用旋转
-    switch (level) {
-        case 1: {
-            // Level 1原始: 除中间一排(11,12,13,14,15)外都亮
-            for (int originalButton = 1; originalButton <= 25; originalButton++) {
-                // 检查原始按键是否应该亮着
-                bool shouldLight = !(originalButton >= 11 && originalButton <= 15);
-                
-                if (shouldLight) {
-                    // 计算旋转后的按键位置
-                    int rotatedButton = rotateButtonNumber(originalButton, rotation);
-                    int pin = getButtonPin(rotatedButton);
-                    MillisPWM::setBrightness(pin, 255);
-                }
-            }
-            break;
-        }
-        case 2: {
-            // Level 2原始: 只有第7个按键亮着
-            int originalButton = 7;
-            int rotatedButton = rotateButtonNumber(originalButton, rotation);
-            int pin = getButtonPin(rotatedButton);
-            MillisPWM::setBrightness(pin, 255);
-            break;
-        }
-        case 3: {
-            // Level 3原始: 第2,9,17,18个按键亮着
-            int originalButtons[] = {2, 9, 17, 18};
-            for (int i = 0; i < 4; i++) {
-                int rotatedButton = rotateButtonNumber(originalButtons[i], rotation);
-                int pin = getButtonPin(rotatedButton);
-                MillisPWM::setBrightness(pin, 255);
-            }
-            break;
-        }
-        case 4: {
-            // Level 4原始: 只有第2个按键亮着
-            int originalButton = 2;
-            int rotatedButton = rotateButtonNumber(originalButton, rotation);
-            int pin = getButtonPin(rotatedButton);
-            MillisPWM::setBrightness(pin, 255);
-            break;
-        }
-        default:
-            Serial.println(F("❌ 无效的Level"));
-            break;
-    }
+    // 取Level原始掩码，旋转后一次性写入全部25个灯
+    uint32_t levelMask = pgm_read_dword(&MAP_LEVEL_MASKS[level - 1]);
+    loadLitMask(rotateMask(levelMask, rotation));
+    MapLightEffects::setRotation(rotation);
     
     Serial.println(F("✅ 旋转应用完成"));
-} 
\ No newline at end of file
+} 
+
+// ========================== 断电恢复 ==========================
+/**
+ * @brief 填写需要持久化的游戏状态（GameCheckpoint定时调用）
+ * @param state 输出：当前游戏状态
+ */
+void GameFlowManager::saveCheckpoint(CheckpointState& state) {
+    memset(&state, 0, sizeof(state));
+    
+    if (stageRunning) {
+        strncpy(state.stageId, currentStageId.c_str(), CHECKPOINT_STAGE_SIZE - 1);
+        state.stageElapsed = getStageElapsedTime();
+    }
+    strncpy(state.sessionId, gameStageManager.getSessionId().c_str(), CHECKPOINT_SESSION_SIZE - 1);
+    
+    state.litMask = litMask;
+    state.level = currentLevel;
+    state.errorCount = errorCount;
+    state.successCount = successCount;
+    state.rotation = currentRotation;
+    state.lastRotation = lastRotation;
+    state.lastPressedButton = lastPressedButton;
+    
+    if (gameActive) state.flags |= CHECKPOINT_FLAG_GAME_ACTIVE;
+    if (lastRefreshWas5) state.flags |= CHECKPOINT_FLAG_REFRESH_WAS_5;
+    if (lastCompletionSource == "success") state.flags |= CHECKPOINT_FLAG_SOURCE_SUCCESS;
+    if (lastCompletionSource == "error") state.flags |= CHECKPOINT_FLAG_SOURCE_ERROR;
+}
+
+/**
+ * @brief 上电时恢复游戏状态，并让环节从断电前的位置继续
+ * @param state 检查点中的游戏状态
+ * @param elapsedMs 环节已运行时间（检查点时间 + 本次上电到现在的时间）
+ * @return true=已恢复运行中的环节
+ */
+bool GameFlowManager::restoreCheckpoint(const CheckpointState& state, unsigned long elapsedMs) {
+    String stageId = String(state.stageId);
+    if (stageId.length() == 0 || !isValidStageId(stageId)) {
+        return false;
+    }
+    
+    Serial.print(F("♻️ 恢复游戏进度: "));
+    Serial.print(stageId);
+    Serial.print(F(" (已运行"));
+    Serial.print(elapsedMs);
+    Serial.println(F("ms)"));
+    
+    // 游戏变量
+    currentLevel = state.level;
+    errorCount = state.errorCount;
+    successCount = state.successCount;
+    currentRotation = state.rotation & 3;
+    lastRotation = state.lastRotation;
+    lastPressedButton = state.lastPressedButton;
+    gameActive = (state.flags & CHECKPOINT_FLAG_GAME_ACTIVE) != 0;
+    lastRefreshWas5 = (state.flags & CHECKPOINT_FLAG_REFRESH_WAS_5) != 0;
+    if (state.flags & CHECKPOINT_FLAG_SOURCE_SUCCESS) {
+        lastCompletionSource = "success";
+    } else if (state.flags & CHECKPOINT_FLAG_SOURCE_ERROR) {
+        lastCompletionSource = "error";
+    } else {
+        lastCompletionSource = "";
+    }
+    MapLightEffects::setRotation(currentRotation);
+    
+    if (state.sessionId[0] != '\0') {
+        gameStageManager.setSessionId(String(state.sessionId));
+    }
+    
+    // 蜡烛灯在072-0点亮后一直保持，直到080-0最终胜利
+    if (stageId != "080-0") {
+        MillisPWM::setBrightness(22, 255);  // C03LK01
+        MillisPWM::setBrightness(23, 255);  // C03LK02
+    }
+    
+    // 按键灯恢复到断电前（定时环节的光效会在此基础上继续）
+    loadLitMask(state.litMask);
+    
+    unsigned long now = MillisTimeSource::getCurrentTime();
+    
+    if (stageId == "072-0.5") {
+        // 游戏进行中：不重新生成旋转，保留已点亮的按键
+        currentStageId = stageId;
+        stageStartTime = now - elapsedMs;
+        stageRunning = true;
+        EventTrace::recordStage(stageId);
+        Serial.println(F("✅ 遗迹地图已恢复"));
+        return true;
+    }
+    
+    // 定时环节：重新定义时刻表并把起点前移，已过的时间段在下一次update时补执行
+    if (!startStage(stageId)) {
+        return false;
+    }
+    stageStartTime = now - elapsedMs;
+    if (gameStage.isRunning()) {
+        gameStage.resumeAt(elapsedMs);
+    }
+    return true;
+}
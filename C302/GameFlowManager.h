@@ -69,6 +69,28 @@
 #define ERROR_SLOW_FLASH_CYCLES     3        // 慢闪循环次数
 #define ERROR_FAST_FLASH_CYCLES     6        // 快闪循环次数
 
+// ========================== 遗迹地图位棋盘 ==========================
+// 
+// 5x5按键矩阵用25位掩码表示：bit(i) 对应按键 i+1（行优先，i = row*5 + col）
+//
+
+#define MAP_GRID_SIZE               5
+#define MAP_CELL_COUNT              25
+#define MAP_FULL_MASK               0x01FFFFFFUL   // 25个按键全亮
+#define MAP_COL_FIRST_MASK          0x00108421UL   // 第1列 (按键1,6,11,16,21)
+#define MAP_COL_LAST_MASK           0x01084210UL   // 第5列 (按键5,10,15,20,25)
+#define MAP_CELL_BIT(i)             (1UL << (i))   // i: 0-24
+
+// 上下左右四邻域（编译期常量，左右移位时屏蔽跨行的位）
+#define MAP_NEIGHBORS(m)            ((((m) << MAP_GRID_SIZE) | ((m) >> MAP_GRID_SIZE) | \
+                                      (((m) << 1) & ~MAP_COL_FIRST_MASK) | \
+                                      (((m) >> 1) & ~MAP_COL_LAST_MASK)) & MAP_FULL_MASK)
+
+// 旋转置换表（PROGMEM，定义见GameFlowManager.cpp，MapLightEffects共用）
+extern const uint8_t MAP_ROTATION_TABLE[4][MAP_CELL_COUNT] PROGMEM;
+
+struct CheckpointState;   // 断电恢复状态，定义见GameCheckpoint.h
+
 class GameFlowManager {
 private:
     String currentStageId;           // 当前环节ID
@@ -93,6 +115,7 @@ private:
     static bool gameActive;                  // 游戏是否激活状态
     static int currentLevel;                 // 当前游戏关卡(1-4)
     static String lastCompletionSource;      // 上次完成来源("error"/"success")
+    static uint32_t litMask;                 // 当前亮灯掩码（物理按键坐标）
     
     // 矩阵旋转系统
     static int currentRotation;              // 当前旋转方向 (0=原始, 1=90°, 2=180°, 3=270°)
@@ -107,12 +130,6 @@ private:
     static String autoJumpFromStage;         // 跳转源环节
     static String autoJumpToStage;           // 跳转目标环节
     
-    // 频闪状态机（用于080-0蜡烛高频闪烁）
-    static bool strobeActive;                // 频闪是否激活
-    static bool strobeState;                 // 当前频闪状态（true=亮，false=灭）
-    static unsigned long strobeNextTime;     // 下次状态切换时间
-    static unsigned long strobeEndTime;      // 频闪结束时间
-    
     // 环节完成通知
     void notifyStageComplete(const String& currentStep, const String& nextStep, unsigned long duration);
     
@@ -143,10 +160,6 @@ private:
     
     // 遗迹地图游戏辅助方法（私有）
     int getButtonInputPin(int buttonNumber);         // 获取按键对应的输入引脚号
-    void setupLevel1();                              // 设置Level 1初始状态
-    void setupLevel2();                              // 设置Level 2初始状态
-    void setupLevel3();                              // 设置Level 3初始状态
-    void setupLevel4();                              // 设置Level 4初始状态
     bool areButtonsAdjacent(int button1, int button2); // 检查按键是否相邻
     void handleMapButtonPress(int buttonNumber);     // 处理遗迹地图按键按下事件
     bool isButtonLit(int buttonNumber);              // 检查按键是否已经亮着
@@ -154,12 +167,15 @@ private:
     bool checkGameComplete();                        // 检查游戏是否完成
     void handleGameComplete();                       // 处理游戏完成
     void executeLastButtonEffect();                  // 执行最后按下按键的闪烁效果
+    void loadLitMask(uint32_t mask);                 // 载入亮灯掩码（全部25个灯重写）
+    void applyLitMask(uint32_t newMask);             // 按掩码差异批量更新亮灯
     void scheduleAutoJump(const String& fromStage, const String& toStage, unsigned long delayMs); // 安排自动跳转
     
     // 矩阵旋转系统（私有）
     int generateRandomRotation();                    // 生成不重复的随机旋转方向
     int rotateButtonNumber(int originalButton, int rotation); // 根据旋转方向转换按键编号
     int reverseRotateButtonNumber(int rotatedButton, int rotation); // 反向旋转：从旋转后坐标获取原始坐标
+    uint32_t rotateMask(uint32_t mask, int rotation);        // 对整个掩码应用旋转
     void applyRotationToLevel(int level, int rotation);      // 对指定Level应用旋转
 
 public:
@@ -207,6 +223,10 @@ public:
     String getRefreshTargetStage();                  // 获取刷新后的目标步骤
     void setCompletionSource(const String& source);  // 设置完成来源("error"/"success")
     
+    // ========================== 断电恢复 ==========================
+    void saveCheckpoint(CheckpointState& state);     // 填写需要持久化的游戏状态
+    bool restoreCheckpoint(const CheckpointState& state, unsigned long elapsedMs); // 恢复状态并从elapsedMs处继续环节
+    
     // ========================== 工具方法（公有） ==========================
     int getButtonPin(int buttonNumber);              // 获取按键对应的输出引脚号
 };
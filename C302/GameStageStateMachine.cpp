@@ -7,6 +7,7 @@
  */
 
 #include "GameStageStateMachine.h"
+#include "MillisPWM.h"
 
 // 全局实例
 GameStageStateMachine gameStageManager;
@@ -23,7 +24,7 @@ GameStageStateMachine::GameStageStateMachine() :
 void GameStageStateMachine::begin() {
     currentStage = "IDLE";
     currentSessionId = "";
-    stageStartTime = millis();
+    stageStartTime = MillisTimeSource::getCurrentTime();
     initialized = true;
     
     #ifdef DEBUG
@@ -38,7 +39,7 @@ void GameStageStateMachine::setStage(const String& stage) {
     if (currentStage != stage) {
         String oldStage = currentStage;
         currentStage = stage;
-        stageStartTime = millis();
+        stageStartTime = MillisTimeSource::getCurrentTime();
         
         #ifdef DEBUG
         Serial.print(F("环节变更: "));
@@ -96,7 +97,7 @@ unsigned long GameStageStateMachine::getStageStartTime() const {
 
 unsigned long GameStageStateMachine::getStageElapsedTime() const {
     if (!initialized) return 0;
-    return millis() - stageStartTime;
+    return MillisTimeSource::getCurrentTime() - stageStartTime;
 }
 
 // ========================== 状态查询 ==========================
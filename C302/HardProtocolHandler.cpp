@@ -1,4 +1,6 @@
 #include "HardProtocolHandler.h"
+#include "C302_SimpleConfig.h"
+#include "MapLightEffects.h"
 
 // 全局实例
 HardProtocolHandler hardProtocolHandler;
@@ -44,6 +46,8 @@ void HardProtocolHandler::processHardMessage(const String& message) {
         handleHardMulti(params);
     } else if (command == "EMERGENCY") {
         handleHardEmergency(params);
+    } else if (command == "EFFECT") {
+        handleHardEffect(params);
     } else {
         #ifdef DEBUG
         Serial.print(F("未知HARD命令: "));
@@ -83,37 +87,83 @@ void HardProtocolHandler::handleHardSingle(const String& params) {
 }
 
 void HardProtocolHandler::handleHardMulti(const String& params) {
-    String componentList = extractParam(params, "component_list");
-    String actionList = extractParam(params, "action_list");
-    String paramsList = extractParam(params, "params_list");
-    
-    int componentCount = countItems(componentList);
-    int actionCount = countItems(actionList);
-    
-    if (componentCount != actionCount || componentCount == 0) {
+    ListCursor components, actions, itemParams;
+    if (!findListParam(params, "component_list", HARD_LIST_SEPARATOR, components) ||
+        !findListParam(params, "action_list", HARD_LIST_SEPARATOR, actions)) {
         sendHardError("参数列表长度不匹配");
         return;
     }
+    findListParam(params, "params_list", HARD_PARAMS_SEPARATOR, itemParams);  // 可选
     
-    if (componentCount > 10) {
-        sendHardError("超出批量限制(最大10个)");
-        return;
-    }
+    // 第一阶段：单遍解析三个列表并按设备暂存，不触碰任何输出
+    StagedOutput staged[HARD_DEVICE_COUNT];
+    uint32_t stagedMask = 0;        // 已暂存的设备位图
+    uint32_t itemResults = 0;       // 逐项校验结果（bit i = 第i项）
+    int itemCount = 0;
+    int failedCount = 0;
     
-    int successCount = 0;
-    for (int i = 0; i < componentCount; i++) {
-        String componentId = getListItem(componentList, i);
-        String action = getListItem(actionList, i);
-        String controlParams = getListItem(paramsList, i);
+    const char* action = NULL;
+    uint8_t actionLength = 0;
+    const char* control = NULL;
+    uint8_t controlLength = 0;
+    bool broadcastAction = false;   // action_list只有一项时作用于全部元器件
+    bool broadcastParams = itemParams.isEmpty();
+    
+    const char* component;
+    uint8_t componentLength;
+    while (components.next(component, componentLength)) {
+        if (!broadcastAction) {
+            if (!actions.next(action, actionLength)) {
+                sendHardError("参数列表长度不匹配");
+                return;
+            }
+            broadcastAction = (itemCount == 0 && actions.isEmpty());
+        }
+        if (!broadcastParams) {
+            if (!itemParams.next(control, controlLength)) {
+                control = NULL;     // 参数不足的项使用默认值
+                controlLength = 0;
+            }
+            broadcastParams = (itemCount == 0 && itemParams.isEmpty());
+        }
+        if (itemCount >= HARD_MAX_MULTI_ITEMS) {
+            sendHardError("条目过多，请使用范围或二进制MULTI");
+            return;
+        }
+        itemCount++;
+        
+        StagedOutput out;
+        uint32_t deviceMask = resolveDeviceRange(component, componentLength);
+        if (deviceMask == 0 || !stageOutput(out, parseAction(action, actionLength), control, controlLength)) {
+            failedCount++;
+            continue;
+        }
+        itemResults |= (1UL << (itemCount - 1));
         
-        if (validateComponentId(componentId)) {
-            if (executeComponentControl(componentId, action, controlParams)) {
-                successCount++;
+        // 同一设备出现多次时以最后一项为准
+        for (uint8_t device = 0; device < HARD_DEVICE_COUNT; device++) {
+            if (deviceMask & (1UL << device)) {
+                staged[device] = out;
             }
         }
+        stagedMask |= deviceMask;
     }
     
-    sendHardMultiAck(componentCount, successCount);
+    if (itemCount == 0 || (!broadcastAction && !actions.isEmpty())) {
+        sendHardError("参数列表长度不匹配");
+        return;
+    }
+    
+    // 任一项无效则整批不执行，逐项结果指出哪些条目校验失败
+    if (failedCount > 0) {
+        sendHardMultiAck(itemCount, itemCount - failedCount, itemResults, false);
+        return;
+    }
+    
+    // 第二阶段：一次性提交全部通道
+    commitStaged(staged, stagedMask);
+    
+    sendHardMultiAck(itemCount, itemCount, itemResults, true);
 }
 
 void HardProtocolHandler::handleHardEmergency(const String& params) {
@@ -126,21 +176,158 @@ void HardProtocolHandler::handleHardEmergency(const String& params) {
     #endif
     
     if (scope == "all") {
-        systemHelper.stopAllDevices();
-        MillisPWM::stopAll();
+        applyEmergency(HARD_SCOPE_ALL);
     } else if (scope == "lighting") {
-        MillisPWM::stopAll();
+        applyEmergency(HARD_SCOPE_LIGHTING);
     } else if (scope == "power") {
-        systemHelper.stopAllDevices();
+        applyEmergency(HARD_SCOPE_POWER);
     }
     
     sendHardEmergencyAck(scope);
 }
 
+void HardProtocolHandler::applyEmergency(uint8_t scope) {
+    if (scope == HARD_SCOPE_ALL || scope == HARD_SCOPE_POWER) {
+        systemHelper.stopAllDevices();
+    }
+    if (scope == HARD_SCOPE_ALL || scope == HARD_SCOPE_LIGHTING) {
+        MapLightEffects::stop(false);
+        MillisPWM::stopAll();
+    }
+}
+
+// ========================== 二进制帧处理 ==========================
+void HardProtocolHandler::processHardFrame(const HarbingerFrame& frame) {
+    if (frame.type != HBF_TYPE_HARD) return;
+    
+    #ifdef DEBUG
+    Serial.print(F("HARD二进制帧: cmd=0x"));
+    Serial.print(frame.command, HEX);
+    Serial.print(F(" len="));
+    Serial.println(frame.length);
+    #endif
+    
+    switch (frame.command) {
+        case HBF_HARD_SINGLE:
+        case HBF_HARD_MULTI:
+            handleFrameItems(frame);
+            break;
+            
+        case HBF_HARD_EMERGENCY:
+            if (frame.length != 1 || frame.payload[0] > HARD_SCOPE_POWER) {
+                sendFrameError(frame.command, HBF_ERR_BAD_LENGTH);
+                return;
+            }
+            applyEmergency(frame.payload[0]);
+            sendFrameAck(frame.command, 1, 1, 0, true);
+            break;
+            
+        default:
+            sendFrameError(frame.command, HBF_ERR_UNKNOWN_COMMAND);
+            break;
+    }
+}
+
+// 条目: first, last, action, brightness(0-100), cycle_ms(小端)；与ASCII MULTI相同的全有或全无语义
+void HardProtocolHandler::handleFrameItems(const HarbingerFrame& frame) {
+    uint8_t itemCount = frame.length / HBF_HARD_ITEM_SIZE;
+    if (itemCount == 0 || frame.length % HBF_HARD_ITEM_SIZE != 0 ||
+        (frame.command == HBF_HARD_SINGLE && itemCount != 1)) {
+        sendFrameError(frame.command, HBF_ERR_BAD_LENGTH);
+        return;
+    }
+    
+    StagedOutput staged[HARD_DEVICE_COUNT];
+    uint32_t stagedMask = 0;
+    uint32_t itemResults = 0;       // HBF_MAX_PAYLOAD限制最多31项
+    uint8_t failedCount = 0;
+    
+    for (uint8_t i = 0; i < itemCount; i++) {
+        uint8_t offset = i * HBF_HARD_ITEM_SIZE;
+        uint8_t first = frame.payload[offset];
+        uint8_t last = frame.payload[offset + 1];
+        uint8_t action = frame.payload[offset + 2];
+        
+        if (first > last || last >= HARD_DEVICE_COUNT ||
+            action == HARD_ACTION_INVALID || action > HARD_ACTION_BREATH) {
+            failedCount++;
+            continue;
+        }
+        
+        StagedOutput out;
+        out.action = action;
+        out.brightness = min(frame.payload[offset + 3], (uint8_t)100);
+        out.cycleMs = constrain(frame.readWord(offset + 4), 100, 65000);
+        
+        for (uint8_t device = first; device <= last; device++) {
+            staged[device] = out;
+            stagedMask |= (1UL << device);
+        }
+        itemResults |= (1UL << i);
+    }
+    
+    if (failedCount == 0) {
+        commitStaged(staged, stagedMask);
+    }
+    sendFrameAck(frame.command, itemCount, itemCount - failedCount, itemResults, failedCount == 0);
+}
+
+void HardProtocolHandler::commitStaged(const StagedOutput* staged, uint32_t mask) {
+    for (uint8_t device = 0; device < HARD_DEVICE_COUNT; device++) {
+        if (mask & (1UL << device)) {
+            commitOutput(device, staged[device]);
+        }
+    }
+    // 随后立即刷新一次PWM输出，所有灯在同一轮切换
+    MillisPWM::update();
+}
+
+// 遗迹地图空间光效: pattern=ripple,origin=13,step=150,on=300[,period=..][,duration=..][,brightness=0-100]
+// restore=1 光效结束后恢复原来的灯光（crossfade=渐变ms）
+// pattern=stop 停止当前光效并熄灭按键灯
+void HardProtocolHandler::handleHardEffect(const String& params) {
+    String pattern = extractParam(params, "pattern");
+    
+    if (pattern == "stop") {
+        MapLightEffects::stop();
+        sendHardEffectAck(pattern, true);
+        return;
+    }
+    
+    uint8_t type = MapLightEffects::parseType(pattern);
+    if (type == MAP_FX_NONE) {
+        sendHardError("未知光效: " + pattern);
+        return;
+    }
+    
+    int origin = extractParamValue(params, "origin", 1);
+    int step = extractParamValue(params, "step", 100);
+    int on = extractParamValue(params, "on", 200);
+    long period = constrain(extractParam(params, "period").toInt(), 0L, 65535L);      // 空串toInt()为0
+    long duration = constrain(extractParam(params, "duration").toInt(), 0L, 65535L);
+    int brightness = constrain(extractParamValue(params, "brightness", 100), 0, 100);
+    
+    #ifdef DEBUG
+    Serial.print(F("空间光效: "));
+    Serial.print(pattern);
+    Serial.print(F(" 起点"));
+    Serial.println(origin);
+    #endif
+    
+    if (extractParamValue(params, "restore", 0) == 1) {
+        MapLightEffects::restoreOnEnd(constrain(extractParamValue(params, "crossfade", 0), 0, 10000));
+    }
+    
+    bool started = step >= 0 && on > 0 &&
+                   MapLightEffects::start(type, origin, step, on, period, duration,
+                                          (uint8_t)(brightness * 255 / 100));
+    sendHardEffectAck(pattern, started);
+}
+
 bool HardProtocolHandler::executeComponentControl(const String& componentId, const String& action, const String& controlParams) {
     String componentType = componentId.substring(3, 5);
     
-    if (componentType == "LK" || componentType == "LD" || componentType == "LR") {
+    if (componentType == "LK" || componentType == "LD" || componentType == "LR" || componentType == "IL") {
         return controlLighting(componentId, action, controlParams);
     } else if (componentType == "AL" || componentType == "RL") {
         return controlPower(componentId, action, controlParams);
@@ -226,37 +413,140 @@ bool HardProtocolHandler::validateComponentId(const String& componentId) {
 }
 
 int HardProtocolHandler::getComponentPin(const String& componentId) {
-    if (componentId.endsWith("01")) return 22;
-    if (componentId.endsWith("02")) return 23;
-    return -1;
+    int device = resolveDevice(componentId.c_str(), componentId.length());
+    return (device >= 0) ? C302_DEVICE_PINS[device] : -1;
 }
 
-int HardProtocolHandler::countItems(const String& list) {
-    if (list.length() == 0) return 0;
-    int count = 1;
-    for (int i = 0; i < list.length(); i++) {
-        if (list.charAt(i) == ',') count++;
+// ========================== MULTI批量辅助函数 ==========================
+bool HardProtocolHandler::ListCursor::next(const char*& item, uint8_t& length) {
+    if (isEmpty()) return false;
+    
+    const char* p = pos;
+    while (p < end && *p != separator) p++;
+    
+    item = pos;
+    length = (uint8_t)min((int)(p - pos), 255);
+    pos = (p < end) ? p + 1 : end;
+    return true;
+}
+
+bool HardProtocolHandler::findListParam(const String& params, const char* paramName, char separator, ListCursor& cursor) {
+    cursor.pos = NULL;
+    cursor.end = NULL;
+    cursor.separator = separator;
+    
+    const char* text = params.c_str();
+    const char* textEnd = text + params.length();
+    uint8_t nameLength = strlen(paramName);
+    
+    // 参数名只在开头或逗号之后匹配
+    const char* p = text;
+    while (p + nameLength < textEnd) {
+        if ((p == text || p[-1] == ',') && strncmp(p, paramName, nameLength) == 0 && p[nameLength] == '=') {
+            break;
+        }
+        p++;
     }
-    return count;
+    if (p + nameLength >= textEnd) return false;
+    
+    // 列表值到下一个",key="为止（列表项本身不含'='）
+    const char* value = p + nameLength + 1;
+    const char* q = value;
+    while (q < textEnd) {
+        if (*q == ',') {
+            const char* k = q + 1;
+            while (k < textEnd && (isLowerCase(*k) || *k == '_')) k++;
+            if (k > q + 1 && k < textEnd && *k == '=') break;
+        }
+        q++;
+    }
+    
+    cursor.pos = value;
+    cursor.end = q;
+    return value < q;
 }
 
-String HardProtocolHandler::getListItem(const String& list, int index) {
-    if (index < 0) return "";
+float HardProtocolHandler::findItemParam(const char* controlParams, uint8_t length, const char* paramName, float defaultValue) {
+    if (controlParams == NULL) return defaultValue;
     
-    int start = 0;
-    int currentIndex = 0;
+    const char* end = controlParams + length;
+    uint8_t nameLength = strlen(paramName);
     
-    while (currentIndex < index && start < list.length()) {
-        int commaPos = list.indexOf(',', start);
-        if (commaPos == -1) return "";
-        start = commaPos + 1;
-        currentIndex++;
+    for (const char* p = controlParams; p + nameLength < end; p++) {
+        if ((p == controlParams || p[-1] == '&') && strncmp(p, paramName, nameLength) == 0 && p[nameLength] == '=') {
+            char value[12];
+            uint8_t n = 0;
+            for (const char* v = p + nameLength + 1; v < end && *v != '&' && n < sizeof(value) - 1; v++) {
+                value[n++] = *v;
+            }
+            value[n] = '\0';
+            return (n > 0) ? atof(value) : defaultValue;
+        }
     }
+    return defaultValue;
+}
+
+int HardProtocolHandler::resolveDevice(const char* componentId, uint8_t length) {
+    // 格式：C03 + 类型(LK/IL) + 两位序号
+    if (length != 7 || componentId[0] != 'C' || componentId[1] != '0' || componentId[2] != '3') return -1;
+    if (!isDigit(componentId[5]) || !isDigit(componentId[6])) return -1;
+    
+    int number = (componentId[5] - '0') * 10 + (componentId[6] - '0');
+    if (componentId[3] == 'L' && componentId[4] == 'K' && number >= 1 && number <= 2) {
+        return number - 1;              // 蜡烛灯：设备0-1
+    }
+    if (componentId[3] == 'I' && componentId[4] == 'L' && number >= 1 && number <= 25) {
+        return 2 + number - 1;          // 按键灯：设备2-26
+    }
+    return -1;
+}
+
+uint32_t HardProtocolHandler::resolveDeviceRange(const char* token, uint8_t length) {
+    const char* dash = (const char*)memchr(token, HARD_RANGE_SEPARATOR, length);
+    
+    int first, last;
+    if (dash == NULL) {
+        first = last = resolveDevice(token, length);
+    } else {
+        first = resolveDevice(token, dash - token);
+        last = resolveDevice(dash + 1, length - (dash - token) - 1);
+    }
+    if (first < 0 || last < 0 || first > last) return 0;
+    
+    uint32_t mask = 0;
+    for (int device = first; device <= last; device++) {
+        mask |= (1UL << device);
+    }
+    return mask;
+}
+
+uint8_t HardProtocolHandler::parseAction(const char* action, uint8_t length) {
+    if (action == NULL) return HARD_ACTION_INVALID;
+    if (length == 2 && strncmp(action, "on", 2) == 0) return HARD_ACTION_ON;
+    if (length == 3 && strncmp(action, "off", 3) == 0) return HARD_ACTION_OFF;
+    if (length == 6 && strncmp(action, "breath", 6) == 0) return HARD_ACTION_BREATH;
+    return HARD_ACTION_INVALID;
+}
+
+bool HardProtocolHandler::stageOutput(StagedOutput& out, uint8_t action, const char* controlParams, uint8_t length) {
+    if (action == HARD_ACTION_INVALID) return false;
     
-    int end = list.indexOf(',', start);
-    if (end == -1) end = list.length();
+    out.action = action;
+    out.brightness = (uint8_t)constrain(findItemParam(controlParams, length, "brightness", 100.0f), 0, 100);
+    out.cycleMs = (uint16_t)constrain(findItemParam(controlParams, length, "cycle", 2.0f) * 1000.0f, 100, 65000);
+    return true;
+}
+
+void HardProtocolHandler::commitOutput(int device, const StagedOutput& out) {
+    int pin = C302_DEVICE_PINS[device];
     
-    return list.substring(start, end);
+    if (out.action == HARD_ACTION_ON) {
+        MillisPWM::setBrightnessPercent(pin, out.brightness);
+    } else if (out.action == HARD_ACTION_OFF) {
+        MillisPWM::stop(pin);
+    } else if (out.action == HARD_ACTION_BREATH) {
+        MillisPWM::startBreathing(pin, out.cycleMs / 1000.0f);
+    }
 }
 
 // ========================== HARD协议响应函数 ==========================
@@ -265,8 +555,13 @@ void HardProtocolHandler::sendHardSingleAck(const String& componentId, const Str
     harbingerClient.sendHARDResponse("SINGLE_ACK", result);
 }
 
-void HardProtocolHandler::sendHardMultiAck(int total, int success) {
-    String result = "total=" + String(total) + ",success=" + String(success) + ",status=completed";
+void HardProtocolHandler::sendHardMultiAck(int total, int success, uint32_t itemResults, bool committed) {
+    // item_results按请求顺序每项一位：1=通过，0=校验失败
+    String result = "total=" + String(total) + ",success=" + String(success) + ",item_results=";
+    for (int i = 0; i < total; i++) {
+        result += (itemResults & (1UL << i)) ? '1' : '0';
+    }
+    result += committed ? ",status=completed" : ",status=rejected";
     harbingerClient.sendHARDResponse("MULTI_ACK", result);
 }
 
@@ -275,6 +570,24 @@ void HardProtocolHandler::sendHardEmergencyAck(const String& scope) {
     harbingerClient.sendHARDResponse("EMERGENCY_ACK", result);
 }
 
+void HardProtocolHandler::sendHardEffectAck(const String& pattern, bool started) {
+    String result = "pattern=" + pattern + (started ? ",status=started" : ",status=rejected");
+    harbingerClient.sendHARDResponse("EFFECT_ACK", result);
+}
+
+void HardProtocolHandler::sendFrameAck(uint8_t command, uint8_t total, uint8_t success, uint32_t itemResults, bool committed) {
+    uint8_t payload[8] = {
+        command, total, success, (uint8_t)(committed ? 1 : 0),
+        (uint8_t)itemResults, (uint8_t)(itemResults >> 8), (uint8_t)(itemResults >> 16), (uint8_t)(itemResults >> 24)
+    };
+    harbingerClient.sendFrame(HBF_TYPE_HARD, HBF_HARD_ACK, payload, sizeof(payload));
+}
+
+void HardProtocolHandler::sendFrameError(uint8_t command, uint8_t code) {
+    uint8_t payload[2] = { command, code };
+    harbingerClient.sendFrame(HBF_TYPE_HARD, HBF_HARD_ERROR, payload, sizeof(payload));
+}
+
 void HardProtocolHandler::sendHardError(const String& errorMsg) {
     harbingerClient.sendHARDResponse("ERROR", "message=" + errorMsg);
 } 
\ No newline at end of file
@@ -7,14 +7,61 @@
 #include "UniversalHarbingerClient.h"
 #include "TimeManager.h"
 
+// ========================== HARD MULTI配置 ==========================
+// MULTI批次按设备暂存，全部校验通过后一次性提交，应答按请求顺序逐项给出校验结果
+#define HARD_DEVICE_COUNT       27      // C302设备数：2个蜡烛灯 + 25个按键灯
+#define HARD_MAX_MULTI_ITEMS    32      // 每批最多条目数（逐项结果位图宽度）；长列表用范围或二进制MULTI帧
+#define HARD_LIST_SEPARATOR     ','     // component_list/action_list分隔符
+#define HARD_PARAMS_SEPARATOR   ';'     // params_list分隔符（单项内多个参数用&连接）
+#define HARD_RANGE_SEPARATOR    '-'     // 设备范围：C03IL01-C03IL25
+
+// 紧急停止范围（二进制帧scope字节取值相同）
+enum HardScope : uint8_t {
+    HARD_SCOPE_ALL = 0,
+    HARD_SCOPE_LIGHTING,
+    HARD_SCOPE_POWER,
+    HARD_SCOPE_INVALID = 0xFF
+};
+
+// 元器件动作（二进制帧action字节取值相同）
+enum HardAction : uint8_t {
+    HARD_ACTION_INVALID = 0,
+    HARD_ACTION_ON,
+    HARD_ACTION_OFF,
+    HARD_ACTION_BREATH
+};
+
 class HardProtocolHandler {
 private:
     String controllerId;
     
+    // 列表单遍迭代器：在原始参数串上移动，不生成子串
+    struct ListCursor {
+        const char* pos;
+        const char* end;
+        char separator;
+        
+        bool isEmpty() const { return pos == NULL || pos >= end; }
+        bool next(const char*& item, uint8_t& length);
+    };
+    
+    // 暂存的设备输出
+    struct StagedOutput {
+        uint8_t action;             // HardAction
+        uint8_t brightness;         // 亮度百分比(0-100)
+        uint16_t cycleMs;           // 呼吸周期(ms)
+    };
+    
     // 内部处理函数
     void handleHardSingle(const String& params);
     void handleHardMulti(const String& params);
     void handleHardEmergency(const String& params);
+    void handleHardEffect(const String& params);
+    
+    // 二进制帧处理（设备编号即REGISTER devices列表中的位置）
+    void handleFrameItems(const HarbingerFrame& frame);
+    void applyEmergency(uint8_t scope);
+    static void commitStaged(const StagedOutput* staged, uint32_t mask);
     
     // 组件控制函数
     bool executeComponentControl(const String& componentId, const String& action, const String& controlParams);
@@ -23,25 +70,34 @@ private:
     
     // 响应发送函数
     void sendHardSingleAck(const String& componentId, const String& action);
-    void sendHardMultiAck(int total, int success);
+    void sendHardMultiAck(int total, int success, uint32_t itemResults, bool committed);
     void sendHardEmergencyAck(const String& scope);
+    void sendHardEffectAck(const String& pattern, bool started);
     void sendHardError(const String& errorMsg);
+    void sendFrameAck(uint8_t command, uint8_t total, uint8_t success, uint32_t itemResults, bool committed);
+    void sendFrameError(uint8_t command, uint8_t code);
     
     // 验证和辅助函数
     bool validateComponentId(const String& componentId);
     int getComponentPin(const String& componentId);
+    static int resolveDevice(const char* componentId, uint8_t length);          // 设备ID -> 设备序号
+    static uint32_t resolveDeviceRange(const char* token, uint8_t length);     // 设备ID/范围 -> 设备位图
+    static uint8_t parseAction(const char* action, uint8_t length);
+    static bool stageOutput(StagedOutput& out, uint8_t action, const char* controlParams, uint8_t length);
+    static void commitOutput(int device, const StagedOutput& out);
     
     // 参数解析辅助函数
     String extractParams(const String& message);
     String extractParam(const String& params, const String& paramName);
     int extractParamValue(const String& controlParams, const String& paramName, int defaultValue);
     float extractParamValue(const String& controlParams, const String& paramName, float defaultValue);
-    int countItems(const String& list);
-    String getListItem(const String& list, int index);
+    bool findListParam(const String& params, const char* paramName, char separator, ListCursor& cursor);
+    static float findItemParam(const char* controlParams, uint8_t length, const char* paramName, float defaultValue);
 
 public:
     void begin(const String& controllerIdStr);
     void processHardMessage(const String& message);
+    void processHardFrame(const HarbingerFrame& frame);
 };
 
 // 全局实例
@@ -0,0 +1,178 @@
+#include "MapLightEffects.h"
+#include "MillisPWM.h"
+
+// 静态成员变量定义
+uint8_t MapLightEffects::type = MAP_FX_NONE;
+uint8_t MapLightEffects::originRow = 0;
+uint8_t MapLightEffects::originCol = 0;
+uint8_t MapLightEffects::rotation = 0;
+bool MapLightEffects::physical = false;
+uint8_t MapLightEffects::brightness = 255;
+uint16_t MapLightEffects::stepMs = 0;
+uint16_t MapLightEffects::onMs = 0;
+uint16_t MapLightEffects::periodMs = 0;
+uint16_t MapLightEffects::durationMs = 0;
+uint16_t MapLightEffects::seed = 0;
+unsigned long MapLightEffects::startTime = 0;
+unsigned long MapLightEffects::lastFrameTime = 0;
+uint32_t MapLightEffects::outputMask = 0;
+bool MapLightEffects::restorePending = false;
+uint16_t MapLightEffects::restoreFadeMs = 0;
+
+void MapLightEffects::setRotation(uint8_t newRotation) {
+    rotation = newRotation & 3;
+}
+
+bool MapLightEffects::start(uint8_t effectType, uint8_t originButton, uint16_t step, uint16_t on,
+                            uint16_t period, uint16_t duration, uint8_t level, bool physicalCoords) {
+    if (effectType == MAP_FX_NONE || effectType > MAP_FX_SPARKLE ||
+        originButton < 1 || originButton > MAP_CELL_COUNT ||
+        on == 0 || (effectType == MAP_FX_SPARKLE && step == 0)) {
+        if (type == MAP_FX_NONE) restorePending = false;  // 未启动则放弃刚保存的场景
+        return false;
+    }
+
+    // 先熄灭全部按键灯，之后只按掩码差异写入
+    for (int i = 1; i <= MAP_CELL_COUNT; i++) {
+        MillisPWM::setBrightness(gameFlowManager.getButtonPin(i), 0);
+    }
+    outputMask = 0;
+
+    type = effectType;
+    physical = physicalCoords;
+    originRow = (originButton - 1) / MAP_GRID_SIZE;
+    originCol = (originButton - 1) % MAP_GRID_SIZE;
+    brightness = level;
+    stepMs = step;
+    onMs = on;
+    periodMs = period;
+    durationMs = duration;
+    seed = random(0, 0xFFFF);
+
+    // 单次光效：时长 = 最远距离 * stepMs + onMs
+    if (durationMs == 0 && periodMs == 0 && type != MAP_FX_SPARKLE) {
+        uint8_t maxDistance = 0;
+        for (uint8_t row = 0; row < MAP_GRID_SIZE; row++) {
+            for (uint8_t col = 0; col < MAP_GRID_SIZE; col++) {
+                uint8_t distance = cellDistance(row, col);
+                if (distance > maxDistance) maxDistance = distance;
+            }
+        }
+        unsigned long total = (unsigned long)maxDistance * stepMs + onMs;
+        durationMs = (total > 0xFFFF) ? 0xFFFF : total;
+    }
+
+    startTime = MillisTimeSource::getCurrentTime();
+    lastFrameTime = startTime - MAP_FX_FRAME_MS;  // 立即渲染第一帧
+    update();
+    return true;
+}
+
+void MapLightEffects::stop(bool clearLamps) {
+    if (type == MAP_FX_NONE) return;
+    type = MAP_FX_NONE;
+    
+    if (clearLamps && restorePending) {
+        MillisPWM::restoreScene(MAP_FX_SCENE_SLOT, restoreFadeMs);
+    } else if (clearLamps) {
+        writeMask(0);
+    }
+    restorePending = false;
+    outputMask = 0;
+}
+
+void MapLightEffects::restoreOnEnd(uint16_t crossfadeMs) {
+    // 已有叠加在运行时保留最早的场景，不把光效画面存进去
+    if (!restorePending) {
+        MillisPWM::saveScene(MAP_FX_SCENE_SLOT);
+        restorePending = true;
+    }
+    restoreFadeMs = crossfadeMs;
+}
+
+void MapLightEffects::update() {
+    if (type == MAP_FX_NONE) return;
+
+    unsigned long now = MillisTimeSource::getCurrentTime();
+    if (now - lastFrameTime < MAP_FX_FRAME_MS) return;
+    lastFrameTime = now;
+
+    unsigned long elapsed = now - startTime;
+    if (durationMs > 0 && elapsed >= durationMs) {
+        stop(true);
+        return;
+    }
+
+    writeMask(renderMask(elapsed));
+}
+
+bool MapLightEffects::isActive() {
+    return type != MAP_FX_NONE;
+}
+
+uint8_t MapLightEffects::parseType(const String& name) {
+    if (name == "diagonal" || name == "wave") return MAP_FX_DIAGONAL;
+    if (name == "ripple") return MAP_FX_RIPPLE;
+    if (name == "row") return MAP_FX_ROW;
+    if (name == "column" || name == "col") return MAP_FX_COLUMN;
+    if (name == "sparkle") return MAP_FX_SPARKLE;
+    return MAP_FX_NONE;
+}
+
+uint8_t MapLightEffects::cellDistance(uint8_t row, uint8_t col) {
+    uint8_t rowDiff = (row > originRow) ? row - originRow : originRow - row;
+    uint8_t colDiff = (col > originCol) ? col - originCol : originCol - col;
+
+    switch (type) {
+        case MAP_FX_DIAGONAL: return rowDiff + colDiff;
+        case MAP_FX_RIPPLE:   return (rowDiff > colDiff) ? rowDiff : colDiff;
+        case MAP_FX_ROW:      return rowDiff;
+        case MAP_FX_COLUMN:   return colDiff;
+        default:              return 0;
+    }
+}
+
+bool MapLightEffects::sparkleLit(uint8_t cell, uint16_t slot) {
+    // xorshift16混合：同一时间槽内结果稳定，不需要保存每个灯的状态
+    uint16_t x = seed ^ (slot * 0x9E37U) ^ ((uint16_t)(cell + 1) * 0x2F1BU);
+    x ^= x << 7;
+    x ^= x >> 9;
+    x ^= x << 8;
+    return (x % stepMs) < onMs;
+}
+
+uint32_t MapLightEffects::renderMask(unsigned long elapsed) {
+    const uint8_t* table = MAP_ROTATION_TABLE[physical ? 0 : rotation];
+    uint16_t slot = (type == MAP_FX_SPARKLE) ? (uint16_t)(elapsed / stepMs) : 0;
+    uint32_t mask = 0;
+    uint8_t cell = 0;
+
+    for (uint8_t row = 0; row < MAP_GRID_SIZE; row++) {
+        for (uint8_t col = 0; col < MAP_GRID_SIZE; col++, cell++) {
+            bool lit;
+            if (type == MAP_FX_SPARKLE) {
+                lit = sparkleLit(cell, slot);
+            } else {
+                long phase = (long)elapsed - (long)cellDistance(row, col) * stepMs;
+                if (phase >= 0 && periodMs > 0) phase %= periodMs;
+                lit = (phase >= 0 && phase < onMs);
+            }
+
+            // 逻辑格 → 物理按键
+            if (lit) mask |= MAP_CELL_BIT(pgm_read_byte(&table[cell]));
+        }
+    }
+    return mask;
+}
+
+void MapLightEffects::writeMask(uint32_t newMask) {
+    uint32_t changed = outputMask ^ newMask;
+
+    for (uint8_t i = 0; changed != 0; i++, changed >>= 1) {
+        if (changed & 1) {
+            MillisPWM::setBrightness(gameFlowManager.getButtonPin(i + 1),
+                                     (newMask & MAP_CELL_BIT(i)) ? brightness : 0);
+        }
+    }
+    outputMask = newMask;
+}
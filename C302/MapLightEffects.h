@@ -0,0 +1,83 @@
+#ifndef MAP_LIGHT_EFFECTS_H
+#define MAP_LIGHT_EFFECTS_H
+
+#include <Arduino.h>
+#include "GameFlowManager.h"
+
+// ========================== 遗迹地图空间光效 ==========================
+// 按5x5逻辑坐标渲染参数化光效，输出时经当前旋转映射到物理按键灯（physical光效除外）。
+// 所有灯共用一个时钟：每个逻辑格只算一次"距离"，相位 = 已运行时间 - 距离 * stepMs，
+// 相位落在[0, onMs)内即点亮。不占用时刻表时间段，整个光效状态约20字节。
+//
+// 距离定义（origin为起点按键 1-25）：
+//   DIAGONAL  曼哈顿距离  —— 从角落出发即斜向波浪，从中间出发为菱形扩散
+//   RIPPLE    切比雪夫距离 —— 方形涟漪
+//   ROW       行差       —— 逐行扫过
+//   COLUMN    列差       —— 逐列扫过
+//   SPARKLE   无距离     —— 每stepMs每个灯重新随机，点亮概率 onMs/stepMs
+
+#define MAP_FX_FRAME_MS         10      // 渲染间隔(ms)
+#define MAP_FX_SCENE_SLOT       0       // 叠加光效使用的MillisPWM场景槽
+
+enum MapEffectType : uint8_t {
+    MAP_FX_NONE = 0,
+    MAP_FX_DIAGONAL,
+    MAP_FX_RIPPLE,
+    MAP_FX_ROW,
+    MAP_FX_COLUMN,
+    MAP_FX_SPARKLE
+};
+
+class MapLightEffects {
+private:
+    static uint8_t type;                 // MapEffectType
+    static uint8_t originRow;            // 起点逻辑行(0-4)
+    static uint8_t originCol;            // 起点逻辑列(0-4)
+    static uint8_t rotation;             // 当前旋转方向 (0=原始, 1=90°, 2=180°, 3=270°)
+    static bool physical;                // 本光效按物理按键坐标渲染，不经旋转映射
+    static uint8_t brightness;           // 点亮亮度(0-255)
+    static uint16_t stepMs;              // 每单位距离的延迟
+    static uint16_t onMs;                // 每个灯的点亮时长
+    static uint16_t periodMs;            // 重复周期，0=单次
+    static uint16_t durationMs;          // 总时长，0=单次扫完自动结束
+    static uint16_t seed;                // 闪烁随机种子
+    static unsigned long startTime;      // 共享时钟起点
+    static unsigned long lastFrameTime;  // 上次渲染时间
+    static uint32_t outputMask;          // 当前已点亮的物理按键掩码
+    static bool restorePending;          // 结束时恢复叠加前的灯光场景
+    static uint16_t restoreFadeMs;       // 恢复时的渐变时长
+
+    static uint8_t cellDistance(uint8_t row, uint8_t col);
+    static bool sparkleLit(uint8_t cell, uint16_t slot);
+    static uint32_t renderMask(unsigned long elapsed);
+    static void writeMask(uint32_t newMask);
+
+public:
+    // 旋转方向（由GameFlowManager在载入Level时同步）
+    static void setRotation(uint8_t newRotation);
+
+    // 启动光效（同时只运行一个，新光效替换旧光效）
+    // physicalCoords=true：起点和扫向按物理按键固定（如刷新环节的固定表演），不随关卡旋转
+    static bool start(uint8_t effectType, uint8_t originButton, uint16_t step, uint16_t on,
+                      uint16_t period = 0, uint16_t duration = 0, uint8_t level = 255,
+                      bool physicalCoords = false);
+    static void stop(bool clearLamps = true);     // clearLamps=false时也放弃场景恢复
+    
+    // 叠加模式：在start前调用，保存当前灯光场景，光效结束或stop()时恢复
+    static void restoreOnEnd(uint16_t crossfadeMs = 0);
+
+    // 更新（loop中调用）
+    static void update();
+
+    // 查询
+    static bool isActive();
+    static uint8_t parseType(const String& name);   // "diagonal"/"ripple"/"row"/"column"/"sparkle"
+};
+
+// 便捷宏定义
+#define MAP_FX_WAVE(origin, step, on)      MapLightEffects::start(MAP_FX_DIAGONAL, origin, step, on)
+#define MAP_FX_WAVE_PHYSICAL(button, step, on) MapLightEffects::start(MAP_FX_DIAGONAL, button, step, on, 0, 0, 255, true)
+#define MAP_FX_RIPPLE_FROM(origin, step, on) MapLightEffects::start(MAP_FX_RIPPLE, origin, step, on)
+#define MAP_FX_STOP()                      MapLightEffects::stop()
+
+#endif // MAP_LIGHT_EFFECTS_H
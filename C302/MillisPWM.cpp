@@ -7,6 +7,7 @@
  */
 
 #include "MillisPWM.h"
+#include "CommandTable.h"
 
 // 时间源函数指针定义
 unsigned long (*MillisTimeSource::getTime)() = nullptr;
@@ -16,10 +17,78 @@ PWMChannel MillisPWM::channels[MPWM_MAX_CHANNELS];
 uint8_t MillisPWM::breathingTable[MPWM_BREATHING_TABLE_SIZE];
 bool MillisPWM::initialized = false;
 int MillisPWM::channelCount = 0;
+uint8_t MillisPWM::lastPassEdges = 0;
+uint8_t MillisPWM::maxPassEdges = 0;
+#if MPWM_SCENE_SLOTS > 0
+MPWMScene MillisPWM::scenes[MPWM_SCENE_SLOTS];
+#endif
 
 // 性能统计
 static unsigned long updateCount = 0;
 
+// ========================== 硬件PWM定时器检测 ==========================
+#if MPWM_HW_PWM && defined(digitalPinToTimer)
+// 定时器仍处于Arduino内核初始化的PWM模式(WGMn0置位)才可用；
+// 被其他模块改为CTC/普通模式的定时器(如TimerSerialTX占用的Timer3)改走软件PWM
+static bool hardwareTimerAvailable(uint8_t timer) {
+    switch (timer) {
+        case NOT_ON_TIMER:
+            return false;
+        case TIMER2A:
+        case TIMER2B:
+            return TCCR2A & _BV(WGM20);
+#if defined(TCCR1A)
+        case TIMER1A:
+        case TIMER1B:
+#if defined(TIMER1C)
+        case TIMER1C:
+#endif
+            return TCCR1A & _BV(WGM10);
+#endif
+#if defined(TCCR3A)
+        case TIMER3A:
+        case TIMER3B:
+        case TIMER3C:
+            return TCCR3A & _BV(WGM30);
+#endif
+#if defined(TCCR4A)
+        case TIMER4A:
+        case TIMER4B:
+        case TIMER4C:
+            return TCCR4A & _BV(WGM40);
+#endif
+#if defined(TCCR5A)
+        case TIMER5A:
+        case TIMER5B:
+        case TIMER5C:
+            return TCCR5A & _BV(WGM50);
+#endif
+        default:
+            return true;
+    }
+}
+
+// 各定时器是否处于PWM模式的位图(bit n = Timer n)；update()据此发现定时器被其他模块改动
+static uint8_t hardwareTimerMask() {
+    uint8_t mask = (TCCR2A & _BV(WGM20)) ? _BV(2) : 0;
+#if defined(TCCR1A)
+    if (TCCR1A & _BV(WGM10)) mask |= _BV(1);
+#endif
+#if defined(TCCR3A)
+    if (TCCR3A & _BV(WGM30)) mask |= _BV(3);
+#endif
+#if defined(TCCR4A)
+    if (TCCR4A & _BV(WGM40)) mask |= _BV(4);
+#endif
+#if defined(TCCR5A)
+    if (TCCR5A & _BV(WGM50)) mask |= _BV(5);
+#endif
+    return mask;
+}
+
+static uint8_t lastTimerMask = 0;
+#endif
+
 // ========================== PWMChannel 实现 ==========================
 
 PWMChannel::PWMChannel() : pin(-1), dutyCycle(0), pwmPeriod(MPWM_DEFAULT_PERIOD), 
@@ -29,7 +98,10 @@ PWMChannel::PWMChannel() : pin(-1), dutyCycle(0), pwmPeriod(MPWM_DEFAULT_PERIOD)
                            fadeStartValue(0), fadeTargetValue(0), fadeDuration(1000),
                            fadeStartTime(0), fadeLastUpdate(0), unstableEnabled(false),
                            baseVoltage(180), currentVoltage(180), targetVoltage(180),
-                           flickerIntensity(0), inDropout(false), instabilityLevel(3) {
+                           flickerIntensity(0), inDropout(false), instabilityLevel(3),
+                           flashEnabled(false), flashPhaseOn(false), flashOnLevel(255),
+                           flashOffLevel(0), flashOnMs(0), flashOffMs(0), flashRemaining(0),
+                           flashDeadline(0), hardwarePwm(false), hwDuty(-1) {
     updateTiming();
     lastVoltageChange = 0;
     lastFlicker = 0;
@@ -41,24 +113,47 @@ void PWMChannel::updateTiming() {
     onTime = (pwmPeriod * dutyCycle) / 255;
 }
 
-bool PWMChannel::start(int p, uint8_t duty, unsigned long periodMs) {
+bool PWMChannel::start(int p, uint8_t duty, unsigned long periodMs, unsigned long phaseMs) {
     pin = (int8_t)p;  // 转换为int8_t
     dutyCycle = duty;
-    pwmPeriod = (uint16_t)min(periodMs, 65535UL);  // 限制在uint16_t范围内
+    pwmPeriod = (uint16_t)constrain(periodMs, 1UL, 65535UL);  // 限制在uint16_t范围内
     updateTiming();
     pinMode(pin, OUTPUT);
     isActive = true;
-    lastToggle = MillisTimeSource::getCurrentTime();
+#if MPWM_HW_PWM && defined(digitalPinToTimer)
+    hardwarePwm = MPWM_HW_PIN_ALLOWED(pin) && hardwareTimerAvailable(digitalPinToTimer(pin));
+#else
+    hardwarePwm = false;
+#endif
+    hwDuty = -1;
+    // 第一个周期从 now + phase 开始，各通道的上升沿错开
+    lastToggle = MillisTimeSource::getCurrentTime() + (phaseMs % pwmPeriod) - pwmPeriod;
     currentState = false;
     digitalWrite(pin, LOW);
     return true;
 }
 
+void PWMChannel::refreshBackend() {
+#if MPWM_HW_PWM && defined(digitalPinToTimer)
+    bool hw = MPWM_HW_PIN_ALLOWED(pin) && hardwareTimerAvailable(digitalPinToTimer(pin));
+    if (hw == hardwarePwm) return;
+    
+    hardwarePwm = hw;
+    hwDuty = -1;
+    if (!hw) {
+        // digitalWrite断开比较输出，之后由软件PWM按当前占空比接管
+        currentState = false;
+        digitalWrite(pin, LOW);
+    }
+#endif
+}
+
 void PWMChannel::stop() {
     if (isActive && pin >= 0) {
         digitalWrite(pin, LOW);
         isActive = false;
         breathingEnabled = false;
+        flashEnabled = false;
     }
 }
 
@@ -70,7 +165,7 @@ void PWMChannel::setDutyCycle(uint8_t duty) {
 }
 
 void PWMChannel::setPeriod(unsigned long periodMs) {
-    pwmPeriod = (uint16_t)min(periodMs, 65535UL);  // 限制在uint16_t范围内
+    pwmPeriod = (uint16_t)constrain(periodMs, 1UL, 65535UL);  // 限制在uint16_t范围内
     updateTiming();
 }
 
@@ -156,6 +251,51 @@ void PWMChannel::updateFade() {
     setDutyCycle(currentValue);
 }
 
+// ========================== 频闪功能实现 ==========================
+void PWMChannel::startFlash(unsigned long onMs, unsigned long offMs, uint16_t count,
+                            uint8_t onLevel, uint8_t offLevel) {
+    if (!isActive) return;
+    
+    flashEnabled = true;
+    flashPhaseOn = true;
+    flashOnLevel = onLevel;
+    flashOffLevel = offLevel;
+    flashOnMs = (uint16_t)constrain(onMs, 1UL, 65535UL);    // 至少1ms，避免原地连续切换
+    flashOffMs = (uint16_t)constrain(offMs, 1UL, 65535UL);
+    flashRemaining = count;
+    flashDeadline = MillisTimeSource::getCurrentTime() + flashOnMs;
+    
+    // 立即进入点亮阶段
+    setDutyCycle(flashOnLevel);
+}
+
+void PWMChannel::stopFlash() {
+    flashEnabled = false;
+}
+
+void PWMChannel::updateFlash() {
+    if (!flashEnabled || !isActive) return;
+    
+    unsigned long now = MillisTimeSource::getCurrentTime();
+    
+    // 截止时间在上一个截止时间上累加，update迟到时补齐错过的切换
+    while ((long)(now - flashDeadline) >= 0) {
+        if (flashPhaseOn) {
+            flashPhaseOn = false;
+            setDutyCycle(flashOffLevel);
+            if (flashRemaining > 0 && --flashRemaining == 0) {
+                flashEnabled = false;  // 次数用完，停在熄灭电平
+                return;
+            }
+            flashDeadline += flashOffMs;
+        } else {
+            flashPhaseOn = true;
+            setDutyCycle(flashOnLevel);
+            flashDeadline += flashOnMs;
+        }
+    }
+}
+
 void PWMChannel::startUnstable(uint8_t baseVolt, uint8_t level) {
     unstableEnabled = true;
     baseVoltage = baseVolt;
@@ -284,8 +424,11 @@ void PWMChannel::updateUnstable() {
     }
 }
 
-void PWMChannel::update() {
-    if (!isActive || pin < 0) return;
+uint8_t PWMChannel::update() {
+    if (!isActive || pin < 0) return 0;
+    
+    // 频闪优先（启动频闪时已停止其他效果）
+    updateFlash();
     
     // 先更新fade渐变
     updateFade();
@@ -300,39 +443,41 @@ void PWMChannel::update() {
         updateUnstable();
     }
     
-    // PWM控制逻辑
-    if (dutyCycle == 0) {
-        if (currentState) {
-            currentState = false;
-            digitalWrite(pin, LOW);
+    // 硬件PWM：占空比变化时才写比较寄存器，周期由定时器决定，不产生软件边沿
+    if (hardwarePwm) {
+        if (hwDuty != dutyCycle) {
+            hwDuty = dutyCycle;
+            analogWrite(pin, dutyCycle);
         }
-        return;
+        return 0;
     }
     
-    if (dutyCycle == 255) {
-        if (!currentState) {
-            currentState = true;
-            digitalWrite(pin, HIGH);
+    // 软件PWM控制逻辑
+    bool desired;
+    if (dutyCycle == 0) {
+        desired = false;
+    } else if (dutyCycle == 255) {
+        desired = true;
+    } else {
+        unsigned long now = MillisTimeSource::getCurrentTime();
+        unsigned long elapsed = now - lastToggle;
+        
+        if (elapsed >= pwmPeriod) {
+            // 周期起点按周期累加而不是对齐到本次loop，保持通道间的相位错开
+            lastToggle += pwmPeriod;
+            if (now - lastToggle >= pwmPeriod) {
+                // loop阻塞超过一个周期：跳到当前周期，相位不变
+                lastToggle = now - (now - lastToggle) % pwmPeriod;
+            }
+            elapsed = now - lastToggle;
         }
-        return;
+        desired = elapsed < onTime;
     }
     
-    unsigned long now = MillisTimeSource::getCurrentTime();
-    unsigned long elapsed = now - lastToggle;
-    
-    if (elapsed >= pwmPeriod) {
-        lastToggle = now;
-        if (onTime > 0) {
-            currentState = true;
-            digitalWrite(pin, HIGH);
-        } else {
-            currentState = false;
-            digitalWrite(pin, LOW);
-        }
-    } else if (elapsed >= onTime && currentState) {
-        currentState = false;
-        digitalWrite(pin, LOW);
-    }
+    if (desired == currentState) return 0;
+    currentState = desired;
+    digitalWrite(pin, desired ? HIGH : LOW);
+    return 1;
 }
 
 // 状态查询
@@ -342,6 +487,43 @@ unsigned long PWMChannel::getPeriod() const { return pwmPeriod; }
 bool PWMChannel::isBreathing() const { return breathingEnabled; }
 bool PWMChannel::isUnstable() const { return unstableEnabled; }
 bool PWMChannel::isFading() const { return fadeEnabled; }
+bool PWMChannel::isFlashing() const { return flashEnabled; }
+bool PWMChannel::isHardwarePwm() const { return hardwarePwm; }
+
+#if MPWM_SCENE_SLOTS > 0
+void PWMChannel::saveScene(MPWMSceneEntry& entry) const {
+    entry.pin = pin;
+    entry.duty = dutyCycle;
+    entry.level = 0;
+    entry.a = 0;
+    entry.b = 0;
+    entry.c = 0;
+    
+    // 优先级与update()一致：频闪 > 渐变 > 呼吸 > 电压不稳定
+    if (flashEnabled) {
+        entry.mode = MPWM_SCENE_FLASH;
+        entry.duty = flashOnLevel;
+        entry.level = flashOffLevel;
+        entry.a = flashOnMs;
+        entry.b = flashOffMs;
+        entry.c = flashRemaining;
+    } else if (fadeEnabled) {
+        unsigned long elapsed = MillisTimeSource::getCurrentTime() - fadeStartTime;
+        entry.mode = MPWM_SCENE_FADE;
+        entry.level = fadeTargetValue;
+        entry.a = (elapsed < fadeDuration) ? fadeDuration - elapsed : 0;
+    } else if (breathingEnabled) {
+        entry.mode = MPWM_SCENE_BREATHING;
+        entry.a = breathingCyclePeriod;
+    } else if (unstableEnabled) {
+        entry.mode = MPWM_SCENE_UNSTABLE;
+        entry.level = baseVoltage;
+        entry.a = instabilityLevel;
+    } else {
+        entry.mode = MPWM_SCENE_STATIC;
+    }
+}
+#endif
 
 // ========================== MillisPWM 实现 ==========================
 
@@ -397,9 +579,9 @@ bool MillisPWM::start(int pin, uint8_t dutyCycle, unsigned long periodMs) {
         return true;
     }
     
-    // 创建新通道
+    // 创建新通道（按通道序号分配相位）
     if (channelCount < MPWM_MAX_CHANNELS) {
-        channels[channelCount].start(pin, dutyCycle, periodMs);
+        channels[channelCount].start(pin, dutyCycle, periodMs, (unsigned long)channelCount * MPWM_PHASE_STEP);
         channelCount++;
         return true;
     }
@@ -431,6 +613,7 @@ void MillisPWM::setBrightness(int pin, uint8_t brightness) {
     int channelIndex = findChannelByPin(pin);
     if (channelIndex >= 0) {
         channels[channelIndex].stopBreathing(); // 停止呼吸模式
+        channels[channelIndex].stopFlash();     // 停止频闪
         channels[channelIndex].setDutyCycle(brightness);
     }
 }
@@ -454,6 +637,7 @@ bool MillisPWM::startBreathing(int pin, float cyclePeriodSeconds, float startDel
     if (channelIndex >= 0) {
         unsigned long cyclePeriodMs = (unsigned long)(cyclePeriodSeconds * 1000);
         unsigned long startDelayMs = (unsigned long)(startDelaySeconds * 1000);
+        channels[channelIndex].stopFlash();
         channels[channelIndex].startBreathing(cyclePeriodMs, startDelayMs);
         return true;
     }
@@ -479,6 +663,7 @@ bool MillisPWM::fadeIn(int pin, uint8_t targetValue, unsigned long durationMs) {
     if (channelIndex >= 0) {
         channels[channelIndex].stopBreathing(); // 停止呼吸模式
         channels[channelIndex].stopFade();      // 停止之前的fade
+        channels[channelIndex].stopFlash();     // 停止频闪
         channels[channelIndex].fadeIn(targetValue, durationMs);
         return true;
     }
@@ -500,6 +685,7 @@ bool MillisPWM::fadeOut(int pin, unsigned long durationMs) {
     if (channelIndex >= 0) {
         channels[channelIndex].stopBreathing(); // 停止呼吸模式
         channels[channelIndex].stopFade();      // 停止之前的fade
+        channels[channelIndex].stopFlash();     // 停止频闪
         channels[channelIndex].fadeOut(durationMs);
         return true;
     }
@@ -521,6 +707,7 @@ bool MillisPWM::fadeTo(int pin, uint8_t targetValue, unsigned long durationMs) {
     if (channelIndex >= 0) {
         channels[channelIndex].stopBreathing(); // 停止呼吸模式
         channels[channelIndex].stopFade();      // 停止之前的fade
+        channels[channelIndex].stopFlash();     // 停止频闪
         channels[channelIndex].fadeTo(targetValue, durationMs);
         return true;
     }
@@ -535,6 +722,116 @@ void MillisPWM::stopFade(int pin) {
     }
 }
 
+// ========================== 频闪控制静态方法 ==========================
+bool MillisPWM::startFlash(int pin, unsigned long onMs, unsigned long offMs, uint16_t count,
+                           uint8_t onLevel, uint8_t offLevel) {
+    // 如果PWM通道不存在，先创建
+    if (findChannelByPin(pin) < 0) {
+        if (!start(pin, offLevel)) return false;
+    }
+    
+    int channelIndex = findChannelByPin(pin);
+    if (channelIndex >= 0) {
+        channels[channelIndex].stopBreathing(); // 停止呼吸模式
+        channels[channelIndex].stopFade();      // 停止fade
+        channels[channelIndex].stopUnstable();  // 停止电压不稳定
+        channels[channelIndex].startFlash(onMs, offMs, count, onLevel, offLevel);
+        return true;
+    }
+    
+    return false;
+}
+
+void MillisPWM::stopFlash(int pin) {
+    int channelIndex = findChannelByPin(pin);
+    if (channelIndex >= 0) {
+        channels[channelIndex].stopFlash();
+    }
+}
+
+// ========================== 灯光场景 ==========================
+#if MPWM_SCENE_SLOTS > 0
+bool MillisPWM::saveScene(uint8_t slot) {
+    if (slot >= MPWM_SCENE_SLOTS) return false;
+    
+    MPWMScene& scene = scenes[slot];
+    scene.count = 0;
+    for (int i = 0; i < channelCount; i++) {
+        if (channels[i].getIsActive()) {
+            channels[i].saveScene(scene.entries[scene.count++]);
+        }
+    }
+    return true;
+}
+
+bool MillisPWM::restoreScene(uint8_t slot, unsigned long crossfadeMs) {
+    if (slot >= MPWM_SCENE_SLOTS) return false;
+    const MPWMScene& scene = scenes[slot];
+    
+    // 场景中没有的通道：熄灭（保留通道槽位，不调用stop避免槽位泄漏）
+    for (int i = 0; i < channelCount; i++) {
+        if (!channels[i].getIsActive()) continue;
+        
+        bool inScene = false;
+        for (uint8_t e = 0; e < scene.count && !inScene; e++) {
+            inScene = (scene.entries[e].pin == channels[i].pin);
+        }
+        if (inScene) continue;
+        
+        channels[i].stopUnstable();
+        if (crossfadeMs > 0) {
+            fadeTo(channels[i].pin, 0, crossfadeMs);
+        } else {
+            setBrightness(channels[i].pin, 0);
+        }
+    }
+    
+    // 场景中的通道：按保存时的模式恢复
+    for (uint8_t e = 0; e < scene.count; e++) {
+        const MPWMSceneEntry& entry = scene.entries[e];
+        if (entry.mode != MPWM_SCENE_UNSTABLE) {
+            stopUnstable(entry.pin);  // 其他设置函数不会停止电压不稳定
+        }
+        
+        switch (entry.mode) {
+            case MPWM_SCENE_BREATHING:
+                startBreathing(entry.pin, entry.a / 1000.0);
+                break;
+            case MPWM_SCENE_FADE:
+                fadeTo(entry.pin, entry.level, max((unsigned long)entry.a, crossfadeMs));
+                break;
+            case MPWM_SCENE_FLASH:
+                startFlash(entry.pin, entry.a, entry.b, entry.c, entry.duty, entry.level);
+                break;
+            case MPWM_SCENE_UNSTABLE:
+                startUnstable(entry.pin, entry.level, entry.a);
+                break;
+            default:
+                if (crossfadeMs > 0) {
+                    fadeTo(entry.pin, entry.duty, crossfadeMs);
+                } else {
+                    setBrightness(entry.pin, entry.duty);
+                }
+                break;
+        }
+    }
+    
+    // 所有通道在同一次更新中切换
+    update();
+    return true;
+}
+
+bool MillisPWM::hasScene(uint8_t slot) {
+    return slot < MPWM_SCENE_SLOTS && scenes[slot].count > 0;
+}
+
+void MillisPWM::clearScene(uint8_t slot) {
+    if (slot < MPWM_SCENE_SLOTS) {
+        scenes[slot].count = 0;
+    }
+}
+#endif
+
 bool MillisPWM::startUnstable(int pin, uint8_t baseVoltage, uint8_t instabilityLevel) {
     // 如果PWM通道不存在，先创建
     if (findChannelByPin(pin) < 0) {
@@ -544,6 +841,7 @@ bool MillisPWM::startUnstable(int pin, uint8_t baseVoltage, uint8_t instabilityL
     int channelIndex = findChannelByPin(pin);
     if (channelIndex >= 0) {
         channels[channelIndex].stopBreathing(); // 停止呼吸模式
+        channels[channelIndex].stopFlash();     // 停止频闪
         channels[channelIndex].startUnstable(baseVoltage, instabilityLevel);
         return true;
     }
@@ -608,6 +906,16 @@ bool MillisPWM::isFading(int pin) {
     return (channelIndex >= 0) ? channels[channelIndex].isFading() : false;
 }
 
+bool MillisPWM::isFlashing(int pin) {
+    int channelIndex = findChannelByPin(pin);
+    return (channelIndex >= 0) ? channels[channelIndex].isFlashing() : false;
+}
+
+bool MillisPWM::isHardwarePwm(int pin) {
+    int channelIndex = findChannelByPin(pin);
+    return (channelIndex >= 0) ? channels[channelIndex].isHardwarePwm() : false;
+}
+
 int MillisPWM::getActiveCount() {
     int count = 0;
     for (int i = 0; i < channelCount; i++) {
@@ -640,13 +948,36 @@ int MillisPWM::getFadingCount() {
     return count;
 }
 
+int MillisPWM::getFlashingCount() {
+    int count = 0;
+    for (int i = 0; i < channelCount; i++) {
+        if (channels[i].isFlashing()) count++;
+    }
+    return count;
+}
+
 void MillisPWM::update() {
+#if MPWM_HW_PWM && defined(digitalPinToTimer)
+    // 通道启动后定时器才被占用（如TimerSerialTX::begin改写Timer3）时，相关通道在这里改回软件PWM
+    uint8_t timerMask = hardwareTimerMask();
+    if (timerMask != lastTimerMask) {
+        lastTimerMask = timerMask;
+        for (int i = 0; i < channelCount; i++) {
+            if (channels[i].getIsActive()) channels[i].refreshBackend();
+        }
+    }
+#endif
+    
+    uint8_t edges = 0;
     for (int i = 0; i < channelCount; i++) {
         if (channels[i].getIsActive()) {
-            channels[i].update();
+            edges += channels[i].update();
             updateCount++;
         }
     }
+    
+    lastPassEdges = edges;
+    if (edges > maxPassEdges) maxPassEdges = edges;
 }
 
 unsigned long MillisPWM::getUpdateCount() {
@@ -657,6 +988,19 @@ void MillisPWM::resetUpdateCount() {
     updateCount = 0;
 }
 
+uint8_t MillisPWM::getLastPassEdges() {
+    return lastPassEdges;
+}
+
+uint8_t MillisPWM::getMaxPassEdges() {
+    return maxPassEdges;
+}
+
+void MillisPWM::resetEdgeStats() {
+    lastPassEdges = 0;
+    maxPassEdges = 0;
+}
+
 uint8_t MillisPWM::getBreathingValue(uint8_t index) {
     if (index >= MPWM_BREATHING_TABLE_SIZE) index = MPWM_BREATHING_TABLE_SIZE - 1;
     return breathingTable[index];
@@ -691,53 +1035,109 @@ void MillisPWM::printDetailedStatus() {
 }
 
 void MillisPWM::printSimpleStatus() {
-    // 此函数已移除打印功能，如需状态信息请调用相应的getter方法
+    // 一行概要；更新次数与翻转统计为上次status以来的窗口值，打印后清零
+    Serial.print(F("📊 PWM 活跃="));
+    Serial.print(getActiveCount());
+    Serial.print(F(" 呼吸="));
+    Serial.print(getBreathingCount());
+    Serial.print(F(" 渐变="));
+    Serial.print(getFadingCount());
+    Serial.print(F(" 更新="));
+    Serial.print(getUpdateCount());
+    Serial.print(F(" 翻转(上次/最大)="));
+    Serial.print(getLastPassEdges());
+    Serial.print('/');
+    Serial.println(getMaxPassEdges());
+    
     resetUpdateCount();
+    resetEdgeStats();
+}
+
+// ========================== 智能命令表 ==========================
+// processCommand调用期间有效的引脚范围
+static int cmdStartPin = 22;
+static int cmdEndPin = 52;
+
+static bool cmdPinInRange(long pin) {
+    return pin >= cmdStartPin && pin <= cmdEndPin;
+}
+
+static bool cmdStartAll(const CommandArgs& args) {
+    MillisPWM::startStaggeredBreathing(cmdStartPin, cmdEndPin);
+    return true;
+}
+
+static bool cmdStopAll(const CommandArgs& args) {
+    MillisPWM::stopAll();
+    return true;
+}
+
+static bool cmdStatus(const CommandArgs& args) {
+    MillisPWM::printSimpleStatus();
+    return true;
 }
 
-bool MillisPWM::processCommand(String command, int startPin, int endPin) {
-    command.trim();
+static bool cmdDetail(const CommandArgs& args) {
+    MillisPWM::printDetailedStatus();
+    return true;
+}
+
+static bool cmdBright(const CommandArgs& args) {
+    // pin <引脚> <亮度> / bright <引脚> <亮度>
+    long pin = args.intAt(0);
+    long brightness = args.intAt(1);
+    if (!cmdPinInRange(pin) || brightness < 0 || brightness > 255) return false;
+    MillisPWM::setBrightness(pin, (uint8_t)brightness);
+    return true;
+}
+
+static bool cmdBreathing(const CommandArgs& args) {
+    long pin = args.intAt(0);
+    if (!cmdPinInRange(pin)) return false;
+    MillisPWM::startBreathing(pin, 2.0);
+    return true;
+}
+
+#if MPWM_SCENE_SLOTS > 0
+static bool cmdSceneSave(const CommandArgs& args) {
+    return MillisPWM::saveScene(args.intAt(0));
+}
+
+static bool cmdSceneRestore(const CommandArgs& args) {
+    // scene_restore <槽号> [渐变ms]
+    return MillisPWM::restoreScene(args.intAt(0), args.intAt(1));
+}
+
+#define MPWM_SCENE_COMMANDS(X) \
+    CMD_ENTRY(X, "scene_save", CMD_ARGS(1, 1), cmdSceneSave, " <slot>", "保存场景") \
+    CMD_ENTRY(X, "scene_restore", CMD_ARGS(1, 2), cmdSceneRestore, " <slot> [fade_ms]", "恢复场景")
+#else
+#define MPWM_SCENE_COMMANDS(X)      // 未启用场景槽：命令表中不出现scene_*
+#endif
+
+#define MPWM_COMMAND_LIST(X) \
+    CMD_ENTRY(X, "start_all", CMD_NO_ARGS, cmdStartAll, "", "范围内错开呼吸") \
+    CMD_ENTRY(X, "stop_all", CMD_NO_ARGS, cmdStopAll, "", "停止全部") \
+    CMD_ENTRY(X, "status", CMD_NO_ARGS, cmdStatus, "", "状态") \
+    CMD_ENTRY(X, "detail", CMD_NO_ARGS, cmdDetail, "", "详细状态") \
+    CMD_ENTRY(X, "pin", CMD_ARGS(2, 2), cmdBright, " <pin> <value>", "设置亮度") \
+    CMD_ALIAS(X, "bright", CMD_ARGS(2, 2), cmdBright) \
+    CMD_ENTRY(X, "breathing", CMD_ARGS(1, 1), cmdBreathing, " <pin>", "2秒呼吸") \
+    MPWM_SCENE_COMMANDS(X)
+
+CMD_DEFINE_TABLE(MPWM_COMMAND_TABLE, MPWM_COMMAND_LIST);
+
+bool MillisPWM::processCommand(const String& command, int startPin, int endPin) {
+    // 命令名与参数以第一个空格分隔
+    int start = 0;
+    while (start < (int)command.length() && command[start] == ' ') start++;
+    int space = command.indexOf(' ', start);
     
-    if (command == "start_all") {
-        startStaggeredBreathing(startPin, endPin);
-        return true;
-    } else if (command == "stop_all") {
-        stopAll();
-        return true;
-    } else if (command == "status") {
-        printSimpleStatus();
-        return true;
-    } else if (command == "detail") {
-        printDetailedStatus();
-        return true;
-    } else if (command.startsWith("pin ")) {
-        int space1 = command.indexOf(' ');
-        int space2 = command.indexOf(' ', space1 + 1);
-        if (space1 > 0 && space2 > 0) {
-            int pin = command.substring(space1 + 1, space2).toInt();
-            int brightness = command.substring(space2 + 1).toInt();
-            if (pin >= startPin && pin <= endPin && brightness >= 0 && brightness <= 255) {
-                setBrightness(pin, (uint8_t)brightness);
-                return true;
-            }
-        }
-    } else if (command.startsWith("breathing ")) {
-        int pin = command.substring(10).toInt();
-        if (pin >= startPin && pin <= endPin) {
-            startBreathing(pin, 2.0);
-            return true;
-        }
-    } else if (command.startsWith("bright ")) {
-        int space = command.indexOf(' ', 7);
-        if (space > 0) {
-            int pin = command.substring(7, space).toInt();
-            int brightness = command.substring(space + 1).toInt();
-            if (pin >= startPin && pin <= endPin && brightness >= 0 && brightness <= 255) {
-                setBrightness(pin, (uint8_t)brightness);
-                return true;
-            }
-        }
-    }
+    String name = (space > 0) ? command.substring(start, space) : command.substring(start);
+    String params = (space > 0) ? command.substring(space + 1) : String();
+    name.trim();
     
-    return false; // 未识别的命令
+    cmdStartPin = startPin;
+    cmdEndPin = endPin;
+    return dispatchCommand(MPWM_COMMAND_TABLE, name, params) == CMD_OK;
 } 
\ No newline at end of file
@@ -34,6 +34,49 @@ public:
 #define MPWM_MAX_CHANNELS 30        // 最大PWM通道数 (从50减少到30)
 #define MPWM_DEFAULT_PERIOD 10      // 默认PWM周期(ms) - 50Hz
 #define MPWM_BREATHING_TABLE_SIZE 100 // 呼吸灯查找表大小 (从200减少到100)
+#define MPWM_PHASE_STEP 3           // 相邻通道的相位间隔(ms)，新通道按序号错开周期起点
+
+// 硬件PWM：带定时器比较输出的引脚(Mega2560: 2-13, 44-46)直接用analogWrite，
+// 不占CPU、无loop抖动；其余引脚仍走软件PWM。效果(fade/呼吸/不稳定/频闪)只改占空比，两种后端一致
+#ifndef MPWM_HW_PWM
+#define MPWM_HW_PWM 1               // 0=全部走软件PWM
+#endif
+// Timer0(引脚4/13)负责millis，C101的InputCapture还占用OCR0B，这两个引脚保留软件PWM；
+// 其他定时器若已被改为非PWM模式（如TimerSerialTX占用Timer3）也在运行时自动退回软件PWM
+#define MPWM_HW_PIN_ALLOWED(pin)    ((pin) != 4 && (pin) != 13)
+#ifndef MPWM_SCENE_SLOTS
+#define MPWM_SCENE_SLOTS 1          // C302只用槽0(MAP_FX_SCENE_SLOT)；scenes为静态数组，每槽常驻约301字节RAM
+#endif
+
+// 场景中单个通道的模式
+enum MPWMSceneMode : uint8_t {
+    MPWM_SCENE_STATIC = 0,          // 固定亮度
+    MPWM_SCENE_BREATHING,           // 呼吸灯
+    MPWM_SCENE_FADE,                // 渐变中
+    MPWM_SCENE_FLASH,               // 频闪中
+    MPWM_SCENE_UNSTABLE             // 电压不稳定
+};
+
+// 场景条目：每通道10字节
+//   STATIC:    duty
+//   BREATHING: a=周期ms
+//   FADE:      level=目标亮度, a=剩余ms
+//   FLASH:     duty=点亮电平, level=熄灭电平, a=亮ms, b=灭ms, c=剩余次数
+//   UNSTABLE:  level=基础电压, a=不稳定程度
+struct MPWMSceneEntry {
+    int8_t pin;
+    uint8_t mode;                   // MPWMSceneMode
+    uint8_t duty;
+    uint8_t level;
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+};
+
+struct MPWMScene {
+    uint8_t count;                  // 有效条目数，0=空场景
+    MPWMSceneEntry entries[MPWM_MAX_CHANNELS];
+};
 
 /**
  * @brief PWM通道类 - 单个PWM通道的完整功能
@@ -75,17 +118,33 @@ private:
     unsigned long dropoutStart;
     uint8_t instabilityLevel;        // 不稳定程度 1-5
     
+    // 硬件PWM后端
+    bool hardwarePwm;                // 使用定时器比较输出
+    int16_t hwDuty;                  // 已写入比较寄存器的占空比，-1=未写入
+    
+    // 频闪相关（按截止时间切换，不随update调用间隔漂移）
+    bool flashEnabled;
+    bool flashPhaseOn;               // 当前处于点亮阶段
+    uint8_t flashOnLevel;
+    uint8_t flashOffLevel;
+    uint16_t flashOnMs;
+    uint16_t flashOffMs;
+    uint16_t flashRemaining;         // 剩余闪烁次数，0=无限
+    unsigned long flashDeadline;     // 下次切换的截止时间
+    
     void updateTiming();
     void updateBreathing();
     void updateUnstable();
     void updateFade();
+    void updateFlash();
     
 public:
     int8_t pin;  // 改为int8_t，Arduino引脚号不会超过127
     PWMChannel();
     
     // 基本PWM控制
-    bool start(int pin, uint8_t dutyCycle = 128, unsigned long periodMs = MPWM_DEFAULT_PERIOD);
+    bool start(int pin, uint8_t dutyCycle = 128, unsigned long periodMs = MPWM_DEFAULT_PERIOD,
+               unsigned long phaseMs = 0);
     void stop();
     void setDutyCycle(uint8_t dutyCycle);
     void setPeriod(unsigned long periodMs);
@@ -100,6 +159,11 @@ public:
     void fadeTo(uint8_t targetValue, unsigned long durationMs);
     void stopFade();
     
+    // 频闪控制：亮onMs、灭offMs，共count次（0=无限），结束后停在offLevel
+    void startFlash(unsigned long onMs, unsigned long offMs, uint16_t count = 0,
+                    uint8_t onLevel = 255, uint8_t offLevel = 0);
+    void stopFlash();
+    
     // 电压不稳定控制
     void startUnstable(uint8_t baseVoltage = 180, uint8_t instabilityLevel = 3);
     void stopUnstable();
@@ -112,9 +176,17 @@ public:
     bool isBreathing() const;
     bool isUnstable() const;
     bool isFading() const;
+    bool isFlashing() const;
+    bool isHardwarePwm() const;
+    void refreshBackend();              // 按定时器当前模式重新选择硬件/软件PWM
     
-    // 更新函数 - 必须在loop()中调用
-    void update();
+#if MPWM_SCENE_SLOTS > 0
+    // 场景快照
+    void saveScene(MPWMSceneEntry& entry) const;
+#endif
+    
+    // 更新函数 - 必须在loop()中调用，返回本次引脚翻转次数(0/1)
+    uint8_t update();
 };
 
 /**
@@ -126,6 +198,12 @@ private:
     static uint8_t breathingTable[MPWM_BREATHING_TABLE_SIZE];
     static bool initialized;
     static int channelCount;
+    static uint8_t lastPassEdges;    // 上一次update的引脚翻转数
+    static uint8_t maxPassEdges;     // 单次update最大翻转数
+    
+#if MPWM_SCENE_SLOTS > 0
+    static MPWMScene scenes[MPWM_SCENE_SLOTS];
+#endif
     
     static void generateBreathingTable();
     static int findChannelByPin(int pin);
@@ -155,6 +233,19 @@ public:
     static bool fadeTo(int pin, uint8_t targetValue, unsigned long durationMs = 1000);
     static void stopFade(int pin);
     
+    // 频闪控制
+    static bool startFlash(int pin, unsigned long onMs, unsigned long offMs, uint16_t count = 0,
+                           uint8_t onLevel = 255, uint8_t offLevel = 0);
+    static void stopFlash(int pin);
+    
+#if MPWM_SCENE_SLOTS > 0
+    // 灯光场景：一次调用保存/恢复所有通道的模式、亮度和效果参数
+    static bool saveScene(uint8_t slot);
+    static bool restoreScene(uint8_t slot, unsigned long crossfadeMs = 0);   // crossfadeMs>0时固定亮度通道渐变过渡
+    static bool hasScene(uint8_t slot);
+    static void clearScene(uint8_t slot);
+#endif
+    
     // 电压不稳定控制
     static bool startUnstable(int pin, uint8_t baseVoltage = 180, uint8_t instabilityLevel = 3);
     static void stopUnstable(int pin);
@@ -168,10 +259,10 @@ public:
     static void initializeMultiChannel(int startPin, int endPin, int basePeriodMs = 15);
     static void startStaggeredBreathing(int startPin, int endPin, int minCycleMs = 750, int maxCycleMs = 3000);
     static void printDetailedStatus();  // 已移除打印功能，使用getter方法获取状态
-    static void printSimpleStatus();    // 已移除打印功能，使用getter方法获取状态
+    static void printSimpleStatus();    // 一行概要（含单次update翻转统计），打印后清零统计
     
-    // 智能命令处理器
-    static bool processCommand(String command, int startPin = 22, int endPin = 52);
+    // 智能命令处理器（命令表见MillisPWM.cpp）
+    static bool processCommand(const String& command, int startPin = 22, int endPin = 52);
     
     // 状态查询
     static bool isActive(int pin);
@@ -179,10 +270,13 @@ public:
     static bool isBreathing(int pin);
     static bool isUnstable(int pin);
     static bool isFading(int pin);
+    static bool isFlashing(int pin);
+    static bool isHardwarePwm(int pin);     // 该引脚是否使用硬件PWM后端
     static int getActiveCount();
     static int getBreathingCount();
     static int getUnstableCount();
     static int getFadingCount();
+    static int getFlashingCount();
     
     // 更新函数 - 必须在loop()中调用
     static void update();
@@ -190,6 +284,9 @@ public:
     // 性能监控
     static unsigned long getUpdateCount();
     static void resetUpdateCount();
+    static uint8_t getLastPassEdges();   // 上一次update中翻转的引脚数
+    static uint8_t getMaxPassEdges();    // 单次update最大翻转引脚数（相位错开效果指标）
+    static void resetEdgeStats();
     
     // 获取呼吸表值 (内部使用)
     static uint8_t getBreathingValue(uint8_t index);
@@ -205,5 +302,10 @@ public:
 #define MPWM_FADEIN(pin, target, duration)  MillisPWM::fadeIn(pin, target, duration)
 #define MPWM_FADEOUT(pin, duration) MillisPWM::fadeOut(pin, duration)
 #define MPWM_FADETO(pin, target, duration)  MillisPWM::fadeTo(pin, target, duration)
+#define MPWM_FLASH(pin, on, off, count)     MillisPWM::startFlash(pin, on, off, count)
+#if MPWM_SCENE_SLOTS > 0
+#define MPWM_SCENE_SAVE(slot)               MillisPWM::saveScene(slot)
+#define MPWM_SCENE_RESTORE(slot, fadeMs)    MillisPWM::restoreScene(slot, fadeMs)
+#endif
 
 #endif // MILLIS_PWM_H 
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "SimpleGameStage.h"
 #include "MillisPWM.h"
 #include "GameFlowManager.h"
+#include "UniversalHarbingerClient.h"
 
 // 前向声明，避免循环依赖
 class GameFlowManager;
@@ -32,7 +33,7 @@ SimpleGameStage::SimpleGameStage() {
 // 开始指定环节
 void SimpleGameStage::startStage(int stageNumber) {
     currentStage = stageNumber;
-    stageStartTime = millis();
+    stageStartTime = MillisTimeSource::getCurrentTime() - harbingerClient.getDispatchLateness();  // at=定时启动时对齐到约定时刻
     stageRunning = true;
     
     // 重置所有时间段的执行状态
@@ -47,6 +48,24 @@ void SimpleGameStage::startStage(int stageNumber) {
     Serial.println("个时间段)");
 }
 
+// 从指定时间继续：已过的时间段在下一次update时补执行开始/结束动作
+// 已过的STAGE_JUMP断电前已发出，且此时网络未就绪，标记为已执行不再重放
+void SimpleGameStage::resumeAt(unsigned long elapsedMs) {
+    stageStartTime = MillisTimeSource::getCurrentTime() - elapsedMs;
+    
+    for (int i = 0; i < segmentCount; i++) {
+        if (timeSegments[i].action == STAGE_JUMP && timeSegments[i].startTime <= elapsedMs) {
+            timeSegments[i].flags |= 0x03;  // 设置startExecuted和endExecuted
+        }
+    }
+    
+    Serial.print(F("⏩ 环节 "));
+    Serial.print(currentStage);
+    Serial.print(F(" 从"));
+    Serial.print(elapsedMs);
+    Serial.println(F("ms处继续"));
+}
+
 // 停止当前环节
 void SimpleGameStage::stopStage() {
     // 停止所有活跃的动作
@@ -65,7 +84,7 @@ void SimpleGameStage::stopStage() {
 void SimpleGameStage::update() {
     if (!stageRunning) return;
     
-    unsigned long currentTime = millis() - stageStartTime;
+    unsigned long currentTime = MillisTimeSource::getCurrentTime() - stageStartTime;
     
     // 检查所有时间段
     for (int i = 0; i < segmentCount; i++) {
@@ -216,18 +235,25 @@ void SimpleGameStage::executeStartAction(int segmentIndex) {
             Serial.println("ms)");
             break;
             
-        case LED_FLASH:
-            pinMode(segment.pin, OUTPUT);
-            // value1是间隔时间，这里开始第一次点亮
-            digitalWrite(segment.pin, HIGH);
+        case LED_FLASH: {
+            // value1是点亮时间，value2是熄灭时间(0=与点亮相同)，由PWM通道按截止时间频闪
+            int offMs = (segment.value2 > 0) ? segment.value2 : segment.value1;
+            uint16_t count = segment.duration / max(segment.value1 + offMs, 1);
+            if (count == 0) count = 1;  // 时长不足一个周期也只闪一次；startFlash的0表示无限
+            MillisPWM::startFlash(segment.pin, segment.value1, offMs, count);
             Serial.print("LED");
             Serial.print(segment.pin);
-            Serial.print(" FLASH开始 (间隔");
+            Serial.print(" FLASH开始 (");
             Serial.print(segment.value1);
-            Serial.print("ms, 持续");
+            Serial.print("/");
+            Serial.print(offMs);
+            Serial.print("ms x");
+            Serial.print(count);
+            Serial.print(", 持续");
             Serial.print(segment.duration);
             Serial.println("ms)");
             break;
+        }
             
         case PWM_RAMP:
             pinMode(segment.pin, OUTPUT);
@@ -314,7 +340,8 @@ void SimpleGameStage::executeEndAction(int segmentIndex) {
             break;
             
         case LED_FLASH:
-            digitalWrite(segment.pin, LOW);
+            MillisPWM::stopFlash(segment.pin);
+            MillisPWM::setBrightness(segment.pin, 0);
             Serial.print("LED");
             Serial.print(segment.pin);
             Serial.println(" FLASH STOP");
@@ -426,8 +453,8 @@ void SimpleGameStage::ledBreathing(unsigned long startTime, unsigned long durati
     addSegment(startTime, duration, pin, LED_BREATHING, cycleMs, 0);
 }
 
-void SimpleGameStage::ledFlash(unsigned long startTime, unsigned long duration, int pin, int intervalMs) {
-    addSegment(startTime, duration, pin, LED_FLASH, intervalMs, 0);
+void SimpleGameStage::ledFlash(unsigned long startTime, unsigned long duration, int pin, int intervalMs, int offMs) {
+    addSegment(startTime, duration, pin, LED_FLASH, intervalMs, offMs);
 }
 
 void SimpleGameStage::pwmRamp(unsigned long startTime, unsigned long duration, int pin, int fromValue, int toValue) {
@@ -469,7 +496,7 @@ int SimpleGameStage::getCurrentStage() {
 }
 
 unsigned long SimpleGameStage::getStageTime() {
-    return stageRunning ? (millis() - stageStartTime) : 0;
+    return stageRunning ? (MillisTimeSource::getCurrentTime() - stageStartTime) : 0;
 }
 
 bool SimpleGameStage::isRunning() {
@@ -533,7 +560,7 @@ void SimpleGameStage::printAllSegments() {
         return;
     }
     
-    unsigned long currentTime = millis() - stageStartTime;
+    unsigned long currentTime = MillisTimeSource::getCurrentTime() - stageStartTime;
     Serial.print(F("当前时间: "));
     Serial.print(currentTime);
     Serial.println(F("ms"));
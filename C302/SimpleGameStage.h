@@ -63,6 +63,7 @@ public:
     void stopStage();                          // 停止当前环节
     void update();                             // 更新(需要在loop中调用)
     void clearStage();                         // 清空当前环节
+    void resumeAt(unsigned long elapsedMs);    // 环节起点前移，从elapsedMs处继续（断电恢复）
     
     // ==========================================
     // 核心方法：统一的时间段添加接口
@@ -85,7 +86,7 @@ public:
     
     // === 专用快捷方法（最常用的几种） ===
     void ledBreathing(unsigned long startTime, unsigned long duration, int pin, float cycleSeconds = 2.0);
-    void ledFlash(unsigned long startTime, unsigned long duration, int pin, int intervalMs = 100);
+    void ledFlash(unsigned long startTime, unsigned long duration, int pin, int intervalMs = 100, int offMs = 0);
     void pwmRamp(unsigned long startTime, unsigned long duration, int pin, int fromValue, int toValue);
     void digitalPulse(unsigned long startTime, unsigned long duration, int pin);
     void jumpToStage(unsigned long startTime, int nextStage);                    // 数字版本（向后兼容）
@@ -11,13 +11,37 @@
 
 #include <Arduino.h>
 #include <Ethernet.h>
+#include "HarbingerFrame.h"
+
+// ========================== 可选功能 ==========================
+// 关闭的功能连同成员变量一起编译掉，接口保留（返回未启用的结果），按控制器实际需要打开
+#define HARBINGER_BINARY_FRAMES   1     // HARD二进制帧：解析器约200字节RAM，sendFrame约200字节栈（只有C302用）
+#define HARBINGER_GROUP_COMMANDS  1     // 组播组命令：EthernetUDP + 序号去重窗口，约50字节
+#define HARBINGER_CLOCK_SYNC      1     // 时钟同步与at=定时执行：8个时钟样本 + 4个定时槽，约190字节
+#define HARBINGER_NET_STATS       1     // 心跳/SPI/耗时统计（printStatus诊断用），约25字节
 
 // ========================== 配置常量 ==========================
-#define MAX_MESSAGE_LENGTH    200
+#define MAX_MESSAGE_LENGTH    200   // 长HARD MULTI列表用设备范围(C03IL01-C03IL25)或二进制MULTI帧
 #define CONNECTION_TIMEOUT    5000
-#define HEARTBEAT_INTERVAL    3000
+#define HEARTBEAT_INTERVAL    3000  // 空闲心跳间隔；收发两个方向都有其他流量时不发心跳
+#define HEARTBEAT_ACK_TIMEOUT_INIT 1000  // 还没有RTT样本时的ACK超时(ms)
+#define HEARTBEAT_ACK_TIMEOUT_MIN  300   // ACK超时 = SRTT + 4*RTTVAR，限制在[MIN, MAX]
+#define HEARTBEAT_ACK_TIMEOUT_MAX  3000
+#define HEARTBEAT_MAX_MISSED  3     // 连续丢失ACK次数，达到即判定对端失联并重连（半开连接）
 #define RECONNECT_INTERVAL    5000
-#define ETHERNET_STABILIZE_TIME 800  // 🚀 从2秒减少到0.8秒
+#define ETHERNET_STABILIZE_TIME 800  // 🚀 从2秒减少到0.8秒（W5100不报告链路状态时的等待）
+#define ETHERNET_LINK_POLL_INTERVAL 10   // 等待链路时查询链路状态的间隔(ms)
+#define NETWORK_LOOP_BUDGET_US 1000  // 每个loop网络处理的时间预算(us)，超出后剩余数据留在W5100缓冲区下一轮再读
+#define NETWORK_READ_CHUNK    32    // 成块读取的字节数（逐字节read()每个字节都要几次SPI寄存器访问）
+#define GROUP_MULTICAST_PORT  9001  // 组播组命令端口
+#define GROUP_SEQ_WINDOW      32    // 最高序号以下这么多个序号按位图去重（乱序到达的未执行序号照常执行），更早的视为服务器重启后的新序号
+#define CLOCK_FILTER_SIZE     8     // 时钟同步样本数，采用其中RTT最小的（NTP时钟滤波）
+#define CLOCK_SYNC_INTERVAL   10000 // 超过这么久没有时钟样本时，即使两个方向都有流量也发心跳
+#define CLOCK_DRIFT_MIN_SPAN  20000 // 估计时钟漂移的最短样本间隔(ms)
+#define CLOCK_DRIFT_MAX_PPM   5000  // 漂移限幅（Mega的陶瓷谐振器可达±0.5%）
+#define CLOCK_RESIDUAL_PPM    50    // 漂移修正后的残余误差估计，用于样本老化
+#define SCHEDULE_SLOTS        4     // 等待at=时刻执行的消息数
+#define SCHEDULE_MAX_AHEAD    60000 // at=最多提前多久(ms)，更远的视为时钟错误立即执行
 
 // ========================== 连接状态 ==========================
 enum ConnectionState {
@@ -33,6 +57,15 @@ enum ConnectionState {
 // ========================== 回调函数类型 ==========================
 typedef void (*ConnectionChangeCallback)(bool connected);
 typedef void (*MessageReceivedCallback)(String message);
+typedef void (*FrameReceivedCallback)(const HarbingerFrame& frame);
+typedef bool (*SendHookCallback)(const uint8_t* data, uint16_t length);   // 返回true表示已接管，不再真正发出
+
+// 时钟同步样本：服务器时间 - 本地时间，取自一次心跳往返
+struct ClockSample {
+    unsigned long local;                 // 往返中点的本地时刻
+    long offset;
+    unsigned long rtt;
+};
 
 // ========================== UniversalHarbingerClient类 ==========================
 class UniversalHarbingerClient {
@@ -46,7 +79,73 @@ private:
     // 连接管理
     EthernetClient client;
     ConnectionState connectionState;
-    unsigned long lastHeartbeat;
+    unsigned long lastHeartbeat;         // 上一个心跳节拍（发出或因有流量而省略）
+    
+    // 心跳与RTT：发送/接收任意数据都刷新时间，心跳只在某个方向空闲时补发
+    unsigned long lastTxTime;
+    unsigned long lastRxTime;
+    unsigned long heartbeatSentAt;       // 待确认心跳的发送时间
+    bool awaitingAck;
+    uint8_t missedAcks;                  // 连续丢失的ACK数
+    long srtt8;                          // 平滑RTT * 8 (ms)，算法同TCP (RFC 6298)
+    long rttvar4;                        // RTT偏差 * 4 (ms)
+    bool rttValid;
+    
+    // SPI开销：W5100的每次socket调用都是几次SPI寄存器访问
+    bool socketConnected;                // 每轮查询一次client.connected()的缓存，isConnected()只读这个值
+    unsigned long passStart;             // 本轮网络处理开始时刻(us)
+    String rxBuffer;                     // 未收完的ASCII消息
+    
+#if HARBINGER_NET_STATS
+    unsigned long lastRtt;
+    uint16_t heartbeatsSent;
+    uint16_t heartbeatsSkipped;          // 因有流量而省略的心跳
+    uint16_t acksMissed;
+    uint16_t spiOps;                     // 本轮socket调用次数（含loop其他地方sendMessage的发送）
+    uint16_t lastPassSpiOps;
+    uint16_t maxPassSpiOps;
+    unsigned long lastPassUs;
+    unsigned long maxPassUs;
+    uint16_t budgetOverruns;             // 超出预算、把数据留到下一轮的次数
+#endif
+    
+#if HARBINGER_GROUP_COMMANDS
+    // 组播组命令：一个数据报同时到达所有控制器；带gseq的命令经组播或TCP到达都只执行一次
+    EthernetUDP groupUdp;
+    IPAddress groupIP;
+    uint16_t groupPort;
+    bool groupJoined;
+    bool groupSeqValid;
+    uint32_t groupSeq;                   // 已执行的最高组命令序号
+    uint32_t groupSeen;                  // 去重位图：bit i = 序号groupSeq-i已执行
+    uint16_t groupReceived;              // 收到的组播数据报
+    uint16_t groupApplied;
+    uint16_t groupDuplicates;            // 重复/过期而丢弃的组命令（含TCP到达的）
+#endif
+    
+#if HARBINGER_CLOCK_SYNC
+    // 时钟同步：HEARTBEAT_ACK带server_time，偏移 = server_time - (发送时刻 + RTT/2)
+    ClockSample clockSamples[CLOCK_FILTER_SIZE];
+    uint8_t clockSampleCount;
+    uint8_t clockSampleNext;
+    bool clockSynced;
+    unsigned long clockRefLocal;         // 采用样本的本地时刻
+    long clockOffset;                    // 该时刻的 服务器时间 - 本地时间(ms)
+    unsigned long clockRtt;              // 该样本的RTT，同步误差不超过RTT/2
+    float clockDriftPpm;                 // 服务器时钟比本地快多少(ppm)
+    bool driftValid;
+    unsigned long driftAnchorLocal;      // 上次估计漂移时采用的样本
+    long driftAnchorOffset;
+    unsigned long lastClockSample;
+    
+    // at=<服务器时刻>的HARD/GAME消息：换算成本地时刻，到点才交给消息回调
+    String scheduledMessages[SCHEDULE_SLOTS];    // 空=槽位空闲
+    unsigned long scheduledAt[SCHEDULE_SLOTS];
+    long dispatchLateness;               // 正在执行的定时消息比约定时刻晚了多少(ms)
+    String atReport;                     // 执行定时消息期间发出的应答附加",at_error=.."
+    uint16_t scheduledExecuted;
+    long lastAtError;
+#endif
     unsigned long lastReconnectAttempt;
     unsigned long ethernetInitTime;
     bool networkInitialized;
@@ -55,14 +154,45 @@ private:
     // 回调函数
     ConnectionChangeCallback connectionCallback;
     MessageReceivedCallback messageCallback;
+    SendHookCallback sendHook;
+    
+    // REGISTER附加参数（如断电恢复信息），收到REGISTER_CONFIRM后清空
+    String registerParams;
+    String bootPhases;                   // 启动阶段时间戳 "hw:3;eth:562;link:1365"，随首次REGISTER上报
+    bool bootReported;                   // 首次REGISTER已确认，之后不再记录启动阶段
+    unsigned long lastLinkPoll;
+    
+#if HARBINGER_BINARY_FRAMES
+    // 二进制帧（REGISTER协商）
+    FrameReceivedCallback frameCallback;
+    bool binaryFraming;
+    HarbingerFrameParser frameParser;
+#endif
     
     // 内部方法
     bool connectToServer();
     void handleIncomingData();
+    void handleIncomingByte(char c);
+    void dispatchMessage(const String& message);
+    void deliverMessage(const String& message);
+#if HARBINGER_GROUP_COMMANDS
+    void handleGroupData();
+    bool acceptGroupMessage(const String& message);
+#endif
+#if HARBINGER_CLOCK_SYNC
+    void deliverScheduled(const String& message, unsigned long localAt);
+    void runScheduledMessages();
+    void updateClock(unsigned long serverTime, unsigned long sentAt, unsigned long now);
+#endif
+    bool clockSampleDue(unsigned long now) const;    // 需要一个时钟样本（心跳不可省略）
     void sendHeartbeat();
     void sendRegistration();
     bool validateMessageFormat(const String& message);
     String buildDeviceList();
+    void checkRegisterConfirm(const String& message);
+    void checkHeartbeatAck(const String& message);
+    void updateRtt(unsigned long rtt);
+    void connectionLost();
     
 public:
     // 构造函数和析构函数
@@ -73,16 +203,28 @@ public:
     bool begin(const String& controllerId, const String& deviceType);
     bool connect(IPAddress serverIP, uint16_t serverPort);
     void disconnect();
+    bool joinGroup(IPAddress group, uint16_t port = GROUP_MULTICAST_PORT);   // 加入组播组，接收组命令（需要HARBINGER_GROUP_COMMANDS）
     
     // 状态查询
     bool isConnected() const;
     ConnectionState getConnectionState() const;
     String getLocalIP() const;
     String getServerInfo() const;
+    unsigned long getRtt() const;                    // 平滑RTT(ms)，无样本时为0
+    unsigned long getRttJitter() const;              // RTT偏差(ms)
+    unsigned long getAckTimeout() const;             // 当前心跳ACK超时(ms)
+    bool isClockSynced() const;                      // 未启用HARBINGER_CLOCK_SYNC时始终为false
+    unsigned long getServerTime() const;             // 估计的当前服务器时间(ms)
+    unsigned long serverToLocal(unsigned long serverMs) const;
+    unsigned long getDispatchLateness() const;       // 正在执行的at=消息比约定时刻晚了多少(ms)，环节据此对齐起点
     
     // 回调设置
     void setConnectionCallback(ConnectionChangeCallback callback);
     void setMessageCallback(MessageReceivedCallback callback);
+    void setFrameCallback(FrameReceivedCallback callback);   // 设置后REGISTER声明支持二进制帧（需要HARBINGER_BINARY_FRAMES）
+    void setSendHook(SendHookCallback hook);                 // 观察/接管所有sendMessage/sendFrame（录制回放用）
+    void setRegisterParams(const String& params);            // 下一次REGISTER附加的参数，如"recovered_stage=072-7"
+    void markBootPhase(const __FlashStringHelper* name);     // 记录启动阶段完成时刻(millis)，随首次REGISTER上报
     
     // 消息发送
     bool sendMessage(const String& message);
@@ -90,6 +232,10 @@ public:
     bool sendGAMEResponse(const String& command, const String& result = "OK");
     bool sendHARDResponse(const String& command, const String& result = "OK");
     
+    // 二进制帧发送（仅在双方协商成功后可用，否则返回false由调用方走ASCII）
+    bool isBinaryFraming() const;
+    bool sendFrame(uint8_t type, uint8_t command, const uint8_t* payload, uint8_t length);
+    
     // 主循环处理
     void handleAllNetworkOperations();
     
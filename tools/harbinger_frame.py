@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""
+Harbinger二进制帧 - 服务器端编解码
+与控制器端 HarbingerFrame.h 保持一致。
+
+帧格式（多字节字段均为小端）:
+    SYNC(0xA5) | LEN | TYPE | CMD | PAYLOAD[LEN] | CRC16
+    CRC-16/CCITT-FALSE(多项式0x1021，初值0xFFFF)，覆盖LEN到PAYLOAD末尾
+
+协商:
+    控制器在REGISTER中带 frame=bin1 表示支持；服务器在REGISTER_CONFIRM中
+    回 frame=bin1 后，双方即可对HARD命令使用二进制帧。未协商时一律走ASCII。
+
+元器件编号:
+    REGISTER devices列表中的位置(从0开始)，例如C302: 0=C03LK01, 2=C03IL01。
+"""
+
+import struct
+
+SYNC = 0xA5
+MAX_PAYLOAD = 192
+FRAME_TAG = "bin1"
+
+TYPE_INFO = 1
+TYPE_GAME = 2
+TYPE_HARD = 3
+
+HARD_SINGLE = 0x01
+HARD_MULTI = 0x02
+HARD_EMERGENCY = 0x03
+HARD_ACK = 0x81
+HARD_ERROR = 0x82
+
+ACTION_ON = 1
+ACTION_OFF = 2
+ACTION_BREATH = 3
+
+SCOPE_ALL = 0
+SCOPE_LIGHTING = 1
+SCOPE_POWER = 2
+
+ERR_UNKNOWN_COMMAND = 1
+ERR_BAD_LENGTH = 2
+
+
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def encode(frame_type, command, payload=b""):
+    if len(payload) > MAX_PAYLOAD:
+        raise ValueError("payload too long: %d > %d" % (len(payload), MAX_PAYLOAD))
+    body = bytes([len(payload), frame_type, command]) + bytes(payload)
+    return bytes([SYNC]) + body + struct.pack("<H", crc16(body))
+
+
+class Decoder:
+    """流式解码：feed()返回本次收齐的 (type, command, payload) 列表，CRC错误的帧被丢弃。"""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.crc_errors = 0
+
+    def feed(self, data):
+        self.buffer.extend(data)
+        frames = []
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                self.buffer.clear()
+                break
+            del self.buffer[:start]
+            if len(self.buffer) < 2:
+                break
+            length = self.buffer[1]
+            if length > MAX_PAYLOAD:
+                del self.buffer[:1]
+                continue
+            total = length + 6
+            if len(self.buffer) < total:
+                break
+            body = bytes(self.buffer[1:4 + length])
+            (crc,) = struct.unpack_from("<H", self.buffer, 4 + length)
+            if crc == crc16(body):
+                frames.append((body[1], body[2], body[3:]))
+                del self.buffer[:total]
+            else:
+                self.crc_errors += 1
+                del self.buffer[:1]
+        return frames
+
+
+# ========================== HARD命令 ==========================
+def hard_item(first, last=None, action=ACTION_ON, brightness=100, cycle_ms=2000):
+    last = first if last is None else last
+    return struct.pack("<BBBBH", first, last, action, brightness, cycle_ms)
+
+
+def hard_single(device, action=ACTION_ON, brightness=100, cycle_ms=2000):
+    return encode(TYPE_HARD, HARD_SINGLE, hard_item(device, device, action, brightness, cycle_ms))
+
+
+def hard_multi(items):
+    """items: hard_item()的列表"""
+    return encode(TYPE_HARD, HARD_MULTI, b"".join(items))
+
+
+def hard_emergency(scope=SCOPE_ALL):
+    return encode(TYPE_HARD, HARD_EMERGENCY, bytes([scope]))
+
+
+def parse_hard_response(command, payload):
+    if command == HARD_ACK:
+        cmd, total, success, committed, mask = struct.unpack("<BBBBI", payload)
+        # item_results: bit i = 请求中第i项是否通过校验
+        return {"ack": cmd, "total": total, "success": success,
+                "committed": bool(committed), "item_results": mask}
+    if command == HARD_ERROR:
+        cmd, code = struct.unpack("<BB", payload)
+        return {"error": cmd, "code": code}
+    raise ValueError("unknown HARD response 0x%02x" % command)
+
+
+def device_index(register_devices, component_id):
+    """REGISTER的devices=字段(逗号分隔) -> 元器件编号"""
+    return register_devices.split(",").index(component_id)
+
+
+if __name__ == "__main__":
+    # 示例: C302全部按键灯以80%亮度点亮 + 蜡烛灯呼吸
+    frame = hard_multi([
+        hard_item(2, 26, ACTION_ON, 80),
+        hard_item(0, 1, ACTION_BREATH, cycle_ms=1500),
+    ])
+    print(frame.hex())
+    print(Decoder().feed(frame))
@@ -0,0 +1,588 @@
+#!/usr/bin/env python3
+"""
+Harbinger本地服务器替身 + 压力发生器
+
+以服务器身份监听控制器连接（默认端口9000，与ArduinoSystemHelper一致），
+应答REGISTER/HEARTBEAT，控制器注册后按脚本以指定速率下发GAME/HARD命令，
+统计ACK延迟、丢失（超时未应答）、断线重连，输出每个控制器的吞吐量(命令/秒)。
+
+用法:
+    python3 tools/harbinger_server.py --script tools/loadgen_c302.txt --loops 20
+    python3 tools/harbinger_server.py --script tools/loadgen_c302.txt --binary --json results.jsonl --label v2.1
+    python3 tools/harbinger_server.py --script tools/group_room.txt --expect 3 --group 239.255.10.10:9001
+
+脚本格式（每行一条，#开头为注释）:
+    rate <命令/秒>                      之后的命令按该速率发送（0=不限速，只受--max-inflight限制）
+    wait <毫秒>                         暂停
+    HARD <命令> <参数>                  如 HARD SINGLE component_id=C03IL07,action=on,params=brightness=100
+    GAME <命令> <参数>                  如 GAME STEP session_id={session},step_id=001-1
+    BIN MULTI <first-last:action:亮度[:周期ms]> ...   二进制帧（未协商时自动改发等价ASCII）
+    BIN SINGLE <device:action:亮度[:周期ms]>
+    BIN EMERGENCY <all|lighting|power>
+    GROUP HARD|GAME <命令> <参数>      组命令：自动附加gseq=<序号>，--group时以组播数据报发给整组，
+                                        否则逐个控制器经TCP发送（对比用）；参数可带targets=C101;C302
+参数中的 {session} 替换为 --session，{controller} 替换为控制器ID，
+{at+毫秒} 替换为 服务器时间+毫秒（配合at=定时执行，如 GROUP GAME STEP session_id={session},step_id=072-1,at={at+300}）。
+服务器时间为本进程启动后的毫秒数，随HEARTBEAT_ACK的server_time下发供控制器同步时钟。
+脚本含GROUP行时由一个执行器对全部控制器执行（等--expect个控制器注册后开始），
+普通HARD/GAME/BIN行发给每个控制器；结束时输出各组命令在不同控制器上ACK到达时刻的最大差值。
+"""
+
+import argparse
+import asyncio
+import json
+import re
+import socket
+import statistics
+import sys
+import time
+from collections import deque
+
+import harbinger_frame as hbf
+
+START = time.monotonic()
+AT_RE = re.compile(r"\{at\+(\d+)\}")
+MESSAGE_RE = re.compile(r"\$\[(\w+)\]@([^{]*)\{\^([^^]*)\^\((.*)\)\}#", re.S)
+MESSAGE_END = b")}#"
+
+# 请求 -> 期望的应答命令
+EXPECTED_ACK = {
+    ("HARD", "SINGLE"): "SINGLE_ACK",
+    ("HARD", "MULTI"): "MULTI_ACK",
+    ("HARD", "EMERGENCY"): "EMERGENCY_ACK",
+    ("HARD", "EFFECT"): "EFFECT_ACK",
+    ("HARD", "STATUS"): "STATUS_ACK",
+    ("GAME", "INIT"): "INIT",
+    ("GAME", "START"): "START",
+    ("GAME", "STOP"): "STOP",
+    ("GAME", "STEP"): "STEP_COMPLETE",
+}
+
+ACTIONS = {"on": hbf.ACTION_ON, "off": hbf.ACTION_OFF, "breath": hbf.ACTION_BREATH}
+SCOPES = {"all": hbf.SCOPE_ALL, "lighting": hbf.SCOPE_LIGHTING, "power": hbf.SCOPE_POWER}
+BIN_COMMANDS = {"SINGLE": hbf.HARD_SINGLE, "MULTI": hbf.HARD_MULTI, "EMERGENCY": hbf.HARD_EMERGENCY}
+
+
+def server_ms():
+    return int((time.monotonic() - START) * 1000)
+
+
+def expand(params, session, controller=""):
+    params = params.replace("{session}", session).replace("{controller}", controller)
+    return AT_RE.sub(lambda m: str(server_ms() + int(m.group(1))), params)
+
+
+def parse_params(text):
+    params = {}
+    for part in text.split(","):
+        if "=" in part:
+            key, value = part.split("=", 1)
+            params[key] = value
+    return params
+
+
+def parse_bin_items(tokens):
+    """'2-26:on:80' / '0:breath:100:1500' -> hard_item列表"""
+    items = []
+    for token in tokens:
+        fields = token.split(":")
+        first, _, last = fields[0].partition("-")
+        items.append(hbf.hard_item(int(first), int(last or first), ACTIONS[fields[1]],
+                                   int(fields[2]) if len(fields) > 2 else 100,
+                                   int(fields[3]) if len(fields) > 3 else 2000))
+    return items
+
+
+def load_script(path):
+    steps = []
+    with open(path, encoding="utf-8") as f:
+        for number, raw in enumerate(f, 1):
+            line = raw.split("#", 1)[0].strip()
+            if not line:
+                continue
+            word, _, rest = line.partition(" ")
+            if word == "rate":
+                steps.append(("rate", float(rest)))
+            elif word == "wait":
+                steps.append(("wait", float(rest) / 1000.0))
+            elif word in ("HARD", "GAME"):
+                command, _, params = rest.strip().partition(" ")
+                steps.append(("send", word, command, params.strip()))
+            elif word == "GROUP":
+                kind, _, rest = rest.strip().partition(" ")
+                command, _, params = rest.strip().partition(" ")
+                if kind not in ("HARD", "GAME"):
+                    sys.exit("%s:%d: GROUP needs HARD or GAME" % (path, number))
+                steps.append(("group", kind, command, params.strip()))
+            elif word == "BIN":
+                command, _, args = rest.strip().partition(" ")
+                if command not in BIN_COMMANDS:
+                    sys.exit("%s:%d: unknown BIN command %s" % (path, number, command))
+                steps.append(("bin", command, args.split()))
+            else:
+                sys.exit("%s:%d: cannot parse '%s'" % (path, number, line))
+    return steps
+
+
+def next_message(buffer, binary):
+    """从接收缓冲切出一条消息: ("ascii", 文本) / ("frame", (type, cmd, payload)) / None(数据不足)"""
+    while buffer:
+        if buffer[0] == ord("$"):
+            end = buffer.find(MESSAGE_END)
+            if end < 0:
+                return None
+            text = bytes(buffer[:end + len(MESSAGE_END)]).decode("utf-8", errors="replace")
+            del buffer[:end + len(MESSAGE_END)]
+            return ("ascii", text)
+        # 二进制帧只在两条ASCII消息之间、以同步字节开始
+        if binary and buffer[0] == hbf.SYNC:
+            if len(buffer) < 2:
+                return None
+            if buffer[1] <= hbf.MAX_PAYLOAD:
+                total = buffer[1] + 6
+                if len(buffer) < total:
+                    return None
+                frames = hbf.Decoder().feed(bytes(buffer[:total]))
+                if frames:
+                    del buffer[:total]
+                    return ("frame", frames[0])
+        del buffer[:1]      # 换行、损坏帧等杂散字节
+    return None
+
+
+def percentile(values, fraction):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * fraction))]
+
+
+class ControllerStats:
+    def __init__(self, controller_id):
+        self.controller_id = controller_id
+        self.sent = 0
+        self.acked = 0
+        self.errors = 0
+        self.dropped = 0
+        self.unexpected = 0
+        self.latencies = []
+        self.at_errors = []                 # at=定时执行的实际误差(ms)
+        self.heartbeats = 0
+        self.connections = 0
+        self.reconnect_gaps = []
+        self.disconnected_at = None
+        self.started_at = None
+        self.finished_at = None
+
+    def summary(self):
+        elapsed = (self.finished_at or time.monotonic()) - (self.started_at or time.monotonic())
+        ms = [v * 1000.0 for v in self.latencies]
+        at = [abs(v) for v in self.at_errors]
+        return {
+            "controller": self.controller_id,
+            "sent": self.sent,
+            "acked": self.acked,
+            "errors": self.errors,
+            "dropped": self.dropped,
+            "unexpected_acks": self.unexpected,
+            "elapsed_s": round(elapsed, 3),
+            "throughput_cmd_s": round(self.acked / elapsed, 2) if elapsed > 0 else 0.0,
+            "latency_ms_p50": round(percentile(ms, 0.50), 2),
+            "latency_ms_p95": round(percentile(ms, 0.95), 2),
+            "latency_ms_max": round(max(ms), 2) if ms else 0.0,
+            "latency_ms_mean": round(statistics.mean(ms), 2) if ms else 0.0,
+            "at_executed": len(at),
+            "at_error_ms_p50": percentile(at, 0.50),
+            "at_error_ms_max": max(at) if at else 0,
+            "heartbeats": self.heartbeats,
+            "connections": self.connections,
+            "reconnects": max(0, self.connections - 1),
+            "reconnect_ms_max": round(max(self.reconnect_gaps) * 1000.0, 1) if self.reconnect_gaps else 0.0,
+        }
+
+
+class Controller:
+    """一个控制器ID对应一个会话；断线重连后沿用同一个脚本进度和统计。"""
+
+    def __init__(self, server, controller_id):
+        self.server = server
+        self.controller_id = controller_id
+        self.stats = ControllerStats(controller_id)
+        self.writer = None
+        self.binary = False
+        self.pending = deque()              # (expected_ack, sent_time, gseq或None)
+        self.connected = asyncio.Event()
+        self.slot_freed = asyncio.Event()
+        self.runner = None
+
+    # ---------- 连接 ----------
+    def attach(self, writer, binary):
+        if self.stats.disconnected_at is not None:
+            self.stats.reconnect_gaps.append(time.monotonic() - self.stats.disconnected_at)
+            self.stats.disconnected_at = None
+        self.stats.connections += 1
+        self.writer = writer
+        self.binary = binary
+        self.connected.set()
+        if self.runner is None and not self.server.group_mode:
+            self.runner = asyncio.ensure_future(self.run_script())
+
+    def detach(self, writer):
+        if self.writer is not writer:
+            return
+        self.writer = None
+        self.connected.clear()
+        self.stats.disconnected_at = time.monotonic()
+        # 断线时未应答的命令计为丢失
+        self.stats.dropped += len(self.pending)
+        self.pending.clear()
+        self.slot_freed.set()
+
+    # ---------- 应答匹配 ----------
+    def on_response(self, kind, command, params):
+        if kind == "INFO" and command == "HEARTBEAT":
+            self.stats.heartbeats += 1
+            # 回显timestamp，控制器据此计算RTT；server_time用于时钟同步
+            ack = "status=OK" + (",timestamp=" + params["timestamp"] if "timestamp" in params else "")
+            ack += ",server_time=%d" % server_ms()
+            self.server.send_ascii(self, "INFO", "HEARTBEAT_ACK", ack)
+            return
+        if kind == "GAME" and command == "STEP_COMPLETE" and "result" not in params:
+            return      # 环节自然结束的通知，不是STEP的应答
+        if params.get("at_error", "").lstrip("-").isdigit():
+            self.stats.at_errors.append(int(params["at_error"]))
+        expected = "ERROR" if command == "ERROR" else command
+        self.match(expected, error=(command == "ERROR" or params.get("result", "").upper() == "ERROR"))
+
+    def on_frame(self, frame_type, command, payload):
+        if frame_type != hbf.TYPE_HARD or command not in (hbf.HARD_ACK, hbf.HARD_ERROR):
+            self.stats.unexpected += 1
+            return
+        response = hbf.parse_hard_response(command, payload)
+        failed = command == hbf.HARD_ERROR or not response.get("committed", False)
+        self.match("BIN", error=failed)
+
+    def match(self, expected, error):
+        now = time.monotonic()
+        for index, (want, sent_at, gseq) in enumerate(self.pending):
+            # ERROR应答匹配最早的HARD请求
+            if want == expected or (expected == "ERROR" and want.endswith("_ACK")):
+                del self.pending[index]
+                self.stats.latencies.append(now - sent_at)
+                if gseq is not None:
+                    self.server.group_acks.setdefault(gseq, {})[self.controller_id] = now
+                self.stats.acked += 1
+                if error:
+                    self.stats.errors += 1
+                self.slot_freed.set()
+                return
+        self.stats.unexpected += 1
+
+    def expire(self, timeout):
+        now = time.monotonic()
+        while self.pending and now - self.pending[0][1] > timeout:
+            self.pending.popleft()
+            self.stats.dropped += 1
+            self.slot_freed.set()
+
+    # ---------- 脚本执行 ----------
+    async def wait_for_slot(self):
+        while True:
+            await self.connected.wait()
+            self.expire(self.server.args.timeout)
+            if len(self.pending) < self.server.args.max_inflight:
+                return
+            self.slot_freed.clear()
+            try:
+                await asyncio.wait_for(self.slot_freed.wait(), timeout=0.05)
+            except asyncio.TimeoutError:
+                pass
+
+    async def run_script(self):
+        args = self.server.args
+        await asyncio.sleep(args.warmup)
+        self.stats.started_at = time.monotonic()
+        interval = 0.0
+        next_send = time.monotonic()
+
+        for _ in range(args.loops):
+            for step in self.server.script:
+                if step[0] == "rate":
+                    interval = 1.0 / step[1] if step[1] > 0 else 0.0
+                    continue
+                if step[0] == "wait":
+                    await asyncio.sleep(step[1])
+                    next_send = time.monotonic()
+                    continue
+
+                delay = next_send - time.monotonic()
+                if delay > 0:
+                    await asyncio.sleep(delay)
+                await self.wait_for_slot()
+                next_send = max(next_send + interval, time.monotonic() - interval)
+                self.send_step(step)
+
+        # 等待最后一批应答
+        deadline = time.monotonic() + args.timeout
+        while self.pending and time.monotonic() < deadline:
+            await asyncio.sleep(0.01)
+        self.expire(0)
+        self.stats.finished_at = time.monotonic()
+        self.server.finished(self)
+
+    def send_step(self, step):
+        now = time.monotonic()
+        if step[0] == "bin" and self.binary:
+            command = BIN_COMMANDS[step[1]]
+            if command == hbf.HARD_EMERGENCY:
+                data = hbf.hard_emergency(SCOPES[step[2][0]])
+            else:
+                data = hbf.encode(hbf.TYPE_HARD, command, b"".join(parse_bin_items(step[2])))
+            self.server.write(self, data)
+            self.pending.append(("BIN", now, None))
+        else:
+            kind, command, params = (("HARD",) + self.bin_as_ascii(step)) if step[0] == "bin" else step[1:]
+            params = expand(params, self.server.args.session, self.controller_id)
+            self.server.send_ascii(self, kind, command, params)
+            self.pending.append((EXPECTED_ACK.get((kind, command), command + "_ACK"), now, None))
+        self.stats.sent += 1
+
+    def expect_group_ack(self, kind, command, gseq):
+        self.pending.append((EXPECTED_ACK.get((kind, command), command + "_ACK"), time.monotonic(), gseq))
+        self.stats.sent += 1
+
+    def bin_as_ascii(self, step):
+        # 未协商二进制时发送等价的ASCII命令，保证同一脚本可对比两种帧格式
+        devices = self.server.devices.get(self.controller_id, [])
+        if step[1] == "EMERGENCY":
+            return "EMERGENCY", "scope=" + step[2][0]
+        components, actions, params = [], [], []
+        for token in step[2]:
+            fields = token.split(":")
+            first, _, last = fields[0].partition("-")
+            first_id = devices[int(first)]
+            components.append(first_id + ("-" + devices[int(last)] if last else ""))
+            actions.append(fields[1])
+            item = "brightness=" + (fields[2] if len(fields) > 2 else "100")
+            if len(fields) > 3:
+                item += "&cycle=%g" % (int(fields[3]) / 1000.0)
+            params.append(item)
+        return "MULTI", "component_list=%s,action_list=%s,params_list=%s" % (
+            ",".join(components), ",".join(actions), ";".join(params))
+
+
+class HarbingerServer:
+    def __init__(self, args, script):
+        self.args = args
+        self.script = script
+        self.controllers = {}
+        self.devices = {}
+        self.done = asyncio.Event()
+        self.group_mode = any(step[0] == "group" for step in script)
+        self.group_seq = 0
+        self.group_acks = {}                # gseq -> {控制器ID: ACK到达时刻}
+        self.group_socket = None
+        if args.group:
+            host, _, port = args.group.partition(":")
+            self.group_address = (host, int(port or 9001))
+            self.group_socket = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+            self.group_socket.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1)
+            if args.group_if:
+                self.group_socket.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF,
+                                             socket.inet_aton(args.group_if))
+
+    def write(self, controller, data):
+        if controller.writer is not None:
+            controller.writer.write(data)
+
+    def send_ascii(self, controller, kind, command, params):
+        self.write(controller, ("$[%s]@SERVER{^%s^(%s)}#" % (kind, command, params)).encode("utf-8"))
+
+    def send_group(self, kind, command, params):
+        """组命令：组播时一个数据报到达整组（重复发送防丢包，控制器按gseq去重）"""
+        self.group_seq += 1
+        params = expand(params, self.args.session)
+        text = "$[%s]@SERVER{^%s^(%s%sgseq=%d)}#" % (kind, command, params, "," if params else "", self.group_seq)
+        targets = re.search(r"targets=([^,)]*)", params)
+        targets = targets.group(1).split(";") if targets else None
+        for controller in self.controllers.values():
+            if controller.writer is not None and (targets is None or controller.controller_id in targets):
+                controller.expect_group_ack(kind, command, self.group_seq)
+        if self.group_socket is not None:
+            loop = asyncio.get_event_loop()
+            for repeat in range(self.args.group_repeat):
+                loop.call_later(repeat * 0.005, self.group_socket.sendto, text.encode("utf-8"), self.group_address)
+        else:
+            for controller in self.controllers.values():
+                self.write(controller, text.encode("utf-8"))
+
+    async def run_group_script(self):
+        while len(self.controllers) < self.args.expect:
+            await asyncio.sleep(0.05)
+        await asyncio.sleep(self.args.warmup)
+        for controller in self.controllers.values():
+            controller.stats.started_at = time.monotonic()
+        interval = 0.0
+        for _ in range(self.args.loops):
+            for step in self.script:
+                if step[0] == "rate":
+                    interval = 1.0 / step[1] if step[1] > 0 else 0.0
+                    continue
+                if step[0] == "wait":
+                    await asyncio.sleep(step[1])
+                    continue
+                if step[0] == "group":
+                    self.send_group(*step[1:])
+                else:
+                    for controller in self.controllers.values():
+                        if controller.writer is not None:
+                            controller.send_step(step)
+                await asyncio.sleep(interval)
+
+        deadline = time.monotonic() + self.args.timeout
+        while any(c.pending for c in self.controllers.values()) and time.monotonic() < deadline:
+            await asyncio.sleep(0.01)
+        for controller in self.controllers.values():
+            controller.expire(0)
+            controller.stats.finished_at = time.monotonic()
+            self.finished(controller)
+        self.print_group_skew()
+
+    def print_group_skew(self):
+        skews = [(max(acks.values()) - min(acks.values())) * 1000.0
+                 for acks in self.group_acks.values() if len(acks) > 1]
+        print("=== 组命令 (%s) ===" % ("组播%s:%d" % self.group_address if self.group_socket else "逐个TCP"))
+        print("发出 %d  全部控制器应答 %d" % (self.group_seq, len(skews)))
+        if skews:
+            print("控制器间ACK到达差 p50 %.1fms  p95 %.1fms  max %.1fms" % (
+                percentile(skews, 0.50), percentile(skews, 0.95), max(skews)))
+        if self.args.json:
+            with open(self.args.json, "a", encoding="utf-8") as f:
+                f.write(json.dumps({"label": self.args.label, "group": bool(self.group_socket),
+                                    "group_commands": self.group_seq, "complete": len(skews),
+                                    "skew_ms_p50": round(percentile(skews, 0.50), 2),
+                                    "skew_ms_p95": round(percentile(skews, 0.95), 2),
+                                    "skew_ms_max": round(max(skews), 2) if skews else 0.0},
+                                   ensure_ascii=False) + "\n")
+
+    def finished(self, controller):
+        summary = controller.stats.summary()
+        summary["label"] = self.args.label
+        summary["binary"] = controller.binary
+        print_summary(summary)
+        if self.args.json:
+            with open(self.args.json, "a", encoding="utf-8") as f:
+                f.write(json.dumps(summary, ensure_ascii=False) + "\n")
+        if not self.group_mode and all(c.stats.finished_at for c in self.controllers.values()):
+            self.done.set()
+
+    async def handle_client(self, reader, writer):
+        peer = writer.get_extra_info("peername")
+        print("连接: %s:%d" % peer[:2])
+        buffer = bytearray()
+        controller = None
+
+        try:
+            while True:
+                data = await reader.read(1024)
+                if not data:
+                    break
+                buffer.extend(data)
+
+                while True:
+                    message = next_message(buffer, controller is not None and controller.binary)
+                    if message is None:
+                        break
+                    if message[0] == "frame":
+                        controller.on_frame(*message[1])
+                        continue
+                    match = MESSAGE_RE.match(message[1])
+                    if not match:
+                        continue
+                    kind, sender, command, raw_params = match.groups()
+                    params = parse_params(raw_params)
+
+                    if kind == "INFO" and command == "REGISTER":
+                        controller_id = params.get("client_id", sender)
+                        if self.args.controller and controller_id != self.args.controller:
+                            continue
+                        self.devices[controller_id] = self.register_devices(raw_params)
+                        binary = self.args.binary and params.get("frame") == hbf.FRAME_TAG
+                        controller = self.controllers.get(controller_id) or Controller(self, controller_id)
+                        self.controllers[controller_id] = controller
+                        confirm = "status=OK" + (",frame=" + hbf.FRAME_TAG if binary else "")
+                        writer.write(("$[INFO]@SERVER{^REGISTER_CONFIRM^(%s)}#" % confirm).encode())
+                        print("注册: %s 设备%d个 帧格式=%s" % (controller_id, len(self.devices[controller_id]),
+                                                          "二进制" if binary else "ASCII"))
+                        if "boot" in params:
+                            print("  启动阶段(ms): %s" % params["boot"].replace(";", " "))
+                        if "free_ram" in params:
+                            print("  启动后空闲RAM: %s字节" % params["free_ram"])
+                        if "recovered_stage" in params:
+                            print("  断电恢复: 环节%s 已运行%sms" % (params["recovered_stage"],
+                                                             params.get("recovered_elapsed", "?")))
+                        controller.attach(writer, binary)
+                    elif controller is not None:
+                        controller.on_response(kind, command, params)
+        except (ConnectionError, asyncio.CancelledError):
+            pass        # 断线 / 结束时关闭
+        finally:
+            if controller is not None:
+                controller.detach(writer)
+            print("断开: %s:%d" % peer[:2])
+            writer.close()
+
+    @staticmethod
+    def register_devices(raw_params):
+        # devices=列表本身含逗号，取到下一个",key="为止
+        match = re.search(r"devices=(.*?)(?:,[a-z_]+=|$)", raw_params)
+        return [d for d in match.group(1).split(",") if d] if match else []
+
+
+def print_summary(s):
+    print("=== %s %s ===" % (s["controller"], "(二进制帧)" if s["binary"] else "(ASCII)"))
+    print("发送 %d  应答 %d  错误 %d  丢失 %d  意外应答 %d" % (
+        s["sent"], s["acked"], s["errors"], s["dropped"], s["unexpected_acks"]))
+    print("吞吐量 %.2f 命令/秒  (%.1f秒)" % (s["throughput_cmd_s"], s["elapsed_s"]))
+    print("ACK延迟 p50 %.1fms  p95 %.1fms  max %.1fms" % (
+        s["latency_ms_p50"], s["latency_ms_p95"], s["latency_ms_max"]))
+    print("心跳 %d  重连 %d  最长重连 %.0fms" % (s["heartbeats"], s["reconnects"], s["reconnect_ms_max"]))
+    if s["at_executed"]:
+        print("定时执行 %d  误差 p50 %dms  max %dms" % (s["at_executed"], s["at_error_ms_p50"], s["at_error_ms_max"]))
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="Harbinger服务器替身 / 压力发生器")
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=9000)
+    parser.add_argument("--script", required=True, help="命令脚本")
+    parser.add_argument("--loops", type=int, default=1, help="脚本重复次数")
+    parser.add_argument("--controller", help="只对该控制器ID加压（默认全部）")
+    parser.add_argument("--session", default="LOADGEN_001", help="替换脚本中的{session}")
+    parser.add_argument("--max-inflight", type=int, default=4, help="最多未应答命令数")
+    parser.add_argument("--timeout", type=float, default=2.0, help="ACK超时(秒)，超时计为丢失")
+    parser.add_argument("--warmup", type=float, default=1.0, help="注册后等待(秒)再开始加压")
+    parser.add_argument("--binary", action="store_true", help="控制器声明frame=bin1时启用二进制帧")
+    parser.add_argument("--json", help="结果追加写入JSON Lines文件，便于跟踪各版本吞吐量")
+    parser.add_argument("--label", default="", help="写入结果的版本标签")
+    parser.add_argument("--expect", type=int, default=1, help="组命令脚本：等这么多个控制器注册后开始")
+    parser.add_argument("--group", help="组播组 地址:端口（如239.255.10.10:9001），不指定时组命令逐个经TCP发送")
+    parser.add_argument("--group-if", help="发送组播的本机网卡IP")
+    parser.add_argument("--group-repeat", type=int, default=2, help="每个组播数据报发送次数（间隔5ms）")
+    args = parser.parse_args()
+
+    server = HarbingerServer(args, load_script(args.script))
+    listener = await asyncio.start_server(server.handle_client, args.host, args.port)
+    print("监听 %s:%d，等待控制器注册..." % (args.host, args.port))
+    async with listener:
+        if server.group_mode:
+            await server.run_group_script()
+        else:
+            await server.done.wait()
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        pass
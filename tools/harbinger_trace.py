@@ -0,0 +1,372 @@
+#!/usr/bin/env python3
+"""
+Harbinger控制器录制/回放驱动（与控制器端 EventTrace.h 保持一致）
+
+录制: 打开串口（Mega随之复位），等控制器启动完成后发送 trace_on，期间把串口上的
+      记录帧存入文件，Ctrl-C或--duration到时发送 trace_off。
+回放: 再次打开串口（同样从刚上电的状态开始），发送 trace_replay，控制器每请求一次
+      (TRACE_PULL) 就按序送回一条录制的输入记录；控制器用虚拟时钟在原时刻送入
+      GameFlowManager等同一套代码，网络不收不发。
+对比: 回放产生的输出（发出的网络消息、环节启动）与录制时逐条对比时刻，
+      并给出两次的loop耗时（平均/最大），用于二分定位延迟回归。
+
+用法:
+    python3 tools/harbinger_trace.py capture /dev/ttyACM0 room.htr --duration 120
+    python3 tools/harbinger_trace.py replay /dev/ttyACM0 room.htr --json results.jsonl --label v2.1
+    python3 tools/harbinger_trace.py show room.htr
+
+依赖: pyserial（capture/replay）
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+import harbinger_frame as hbf
+
+TRACE_FRAME_TYPE = 0x54
+
+TRACE_BEGIN = 0x01
+TRACE_SERIAL_LINE = 0x02
+TRACE_NET_MESSAGE = 0x03
+TRACE_NET_FRAME = 0x04
+TRACE_INPUT_EDGE = 0x05
+TRACE_BUSY_EDGE = 0x06
+TRACE_TEXT_CONT = 0x0F
+TRACE_NET_SEND = 0x41
+TRACE_STAGE = 0x42
+TRACE_LOOP = 0x43
+TRACE_PULL = 0x61
+TRACE_END = 0x62
+TRACE_SUMMARY = 0x63
+
+INPUT_RECORDS = (TRACE_BEGIN, TRACE_SERIAL_LINE, TRACE_NET_MESSAGE, TRACE_NET_FRAME,
+                 TRACE_INPUT_EDGE, TRACE_BUSY_EDGE)
+OUTPUT_RECORDS = (TRACE_NET_SEND, TRACE_STAGE)
+
+NAMES = {
+    TRACE_BEGIN: "BEGIN", TRACE_SERIAL_LINE: "SERIAL", TRACE_NET_MESSAGE: "NET_MSG",
+    TRACE_NET_FRAME: "NET_FRAME", TRACE_INPUT_EDGE: "INPUT", TRACE_BUSY_EDGE: "BUSY",
+    TRACE_NET_SEND: "SEND", TRACE_STAGE: "STAGE", TRACE_LOOP: "LOOP",
+    TRACE_PULL: "PULL", TRACE_END: "END", TRACE_SUMMARY: "SUMMARY",
+}
+
+BOOT_MARK = "所有组件初始化完成"
+
+
+class Record:
+    """一条完整记录（超长记录的CONT段已拼接）；raw保存原始帧，回放时原样送回"""
+
+    def __init__(self, code, t, data, raw):
+        self.code = code
+        self.t = t
+        self.data = data
+        self.raw = raw
+
+    def describe(self):
+        if self.code in (TRACE_SERIAL_LINE, TRACE_NET_MESSAGE, TRACE_STAGE) or \
+                (self.code == TRACE_NET_SEND and self.data[:1] == b"$"):
+            return self.data.decode("utf-8", "replace")
+        if self.code == TRACE_INPUT_EDGE:
+            return "pin%d=%s" % (self.data[0], "HIGH" if self.data[1] else "LOW")
+        if self.code == TRACE_BUSY_EDGE:
+            return "ch%d=%s" % (self.data[0], "HIGH" if self.data[1] else "LOW")
+        if self.code == TRACE_BEGIN:
+            return "seed=%d" % struct.unpack("<I", self.data)[0]
+        if self.code == TRACE_LOOP:
+            return "loops=%d avg=%dus max=%dus" % struct.unpack("<HHH", self.data)
+        if self.code == TRACE_SUMMARY:
+            return "events=%d loops=%d total=%dus max=%dus" % struct.unpack("<HIII", self.data)
+        return self.data.hex()
+
+
+class TraceStream:
+    """把串口字节流拆成调试文本行和记录；调试文本中偶然出现的0xA5靠CRC排除"""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.text = bytearray()
+        self.parts = []
+        self.raw_parts = []
+
+    def feed(self, data):
+        self.buffer.extend(data)
+        events = []
+        while self.buffer:
+            if self.buffer[0] != hbf.SYNC:
+                self.take_text(events)
+                continue
+            if len(self.buffer) < 2:
+                break
+            length = self.buffer[1]
+            total = length + 6
+            if length > hbf.MAX_PAYLOAD or length < 4:
+                self.take_text(events)
+                continue
+            if len(self.buffer) < total:
+                break
+            body = bytes(self.buffer[1:4 + length])
+            (crc,) = struct.unpack_from("<H", self.buffer, 4 + length)
+            if crc != hbf.crc16(body) or body[1] != TRACE_FRAME_TYPE:
+                self.take_text(events)
+                continue
+            raw = bytes(self.buffer[:total])
+            del self.buffer[:total]
+            self.take_record(body[2], body[3:], raw, events)
+        return events
+
+    def flush_stalled(self):
+        """长时间收不齐的"帧头"其实是文本，移走一个字节继续解析"""
+        events = []
+        if self.buffer:
+            self.take_text(events)
+            events.extend(self.feed(b""))
+        return events
+
+    def take_text(self, events):
+        byte = self.buffer.pop(0)
+        if byte == 0x0A:
+            events.append(("text", self.text.decode("utf-8", "replace").rstrip("\r")))
+            self.text.clear()
+        else:
+            self.text.append(byte)
+
+    def take_record(self, code, payload, raw, events):
+        (t,) = struct.unpack_from("<I", payload)
+        self.parts.append(payload[4:])
+        self.raw_parts.append(raw)
+        if code == TRACE_TEXT_CONT:
+            return
+        record = Record(code, t, b"".join(self.parts), b"".join(self.raw_parts))
+        self.parts, self.raw_parts = [], []
+        events.append(("record", record))
+
+
+def load_trace(path):
+    with open(path, "rb") as f:
+        stream = TraceStream()
+        return [event[1] for event in stream.feed(f.read()) if event[0] == "record"]
+
+
+def save_trace(path, records):
+    with open(path, "wb") as f:
+        for record in records:
+            f.write(record.raw)
+
+
+def end_frame(records):
+    """回放运行到录制结束的时刻，录制末尾的定时输出也能对比"""
+    end = max((record.t for record in records), default=0)
+    return hbf.encode(TRACE_FRAME_TYPE, TRACE_END, struct.pack("<I", end))
+
+
+# ========================== 串口会话 ==========================
+class Session:
+    def __init__(self, port, baud, echo):
+        import serial   # 仅capture/replay需要pyserial
+        self.port = serial.Serial(port, baud, timeout=0.02)
+        self.stream = TraceStream()
+        self.echo = echo
+        self.last_data = time.monotonic()
+
+    def poll(self):
+        data = self.port.read(4096)
+        now = time.monotonic()
+        if data:
+            self.last_data = now
+            events = self.stream.feed(data)
+        elif now - self.last_data > 0.05:
+            events = self.stream.flush_stalled()
+        else:
+            events = []
+        for kind, value in events:
+            if kind == "text" and self.echo:
+                print("  | " + value)
+        return events
+
+    def wait_boot(self, timeout):
+        deadline = time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            for kind, value in self.poll():
+                if kind == "text" and BOOT_MARK in value:
+                    return True
+        return False
+
+    def command(self, line):
+        self.port.write((line + "\n").encode())
+
+    def close(self):
+        self.port.close()
+
+
+def capture(args):
+    session = Session(args.port, args.baud, args.echo)
+    if not session.wait_boot(args.boot_timeout):
+        print("未等到控制器启动完成，继续录制")
+    session.command("trace_on")
+    print("录制中... Ctrl-C结束")
+
+    records = []
+    deadline = time.monotonic() + args.duration if args.duration else None
+    try:
+        while deadline is None or time.monotonic() < deadline:
+            records.extend(value for kind, value in session.poll() if kind == "record")
+    except KeyboardInterrupt:
+        pass
+
+    session.command("trace_off")
+    stop_deadline = time.monotonic() + 3
+    while time.monotonic() < stop_deadline:
+        events = [value for kind, value in session.poll() if kind == "record"]
+        records.extend(events)
+        if any(record.code == TRACE_SUMMARY for record in events):
+            break
+    session.close()
+
+    save_trace(args.trace, records)
+    inputs = sum(1 for record in records if record.code in INPUT_RECORDS)
+    print("已保存 %s: %d条记录 (输入%d条)" % (args.trace, len(records), inputs))
+
+
+def replay(args):
+    captured = load_trace(args.trace)
+    inputs = [record for record in captured if record.code in INPUT_RECORDS]
+
+    session = Session(args.port, args.baud, args.echo)
+    if not session.wait_boot(args.boot_timeout):
+        print("未等到控制器启动完成，继续回放")
+    session.command("trace_replay")
+
+    replayed = []
+    sent = 0
+    last_progress = time.monotonic()
+    while True:
+        events = [value for kind, value in session.poll() if kind == "record"]
+        if events:
+            last_progress = time.monotonic()
+        elif time.monotonic() - last_progress > args.timeout:
+            print("回放超时：控制器无响应")
+            break
+
+        done = False
+        for record in events:
+            if record.code == TRACE_PULL:
+                session.port.write(inputs[sent].raw if sent < len(inputs) else end_frame(captured))
+                sent += 1
+            elif record.code == TRACE_SUMMARY:
+                replayed.append(record)
+                done = True
+            else:
+                replayed.append(record)
+        if done:
+            break
+    session.close()
+
+    result = compare(captured, replayed)
+    result.update(trace=args.trace, label=args.label, inputs=len(inputs))
+    print_report(result, args.verbose)
+    if args.json:
+        with open(args.json, "a", encoding="utf-8") as f:
+            f.write(json.dumps(result, ensure_ascii=False) + "\n")
+
+
+# ========================== 对比 ==========================
+def loop_cost(records):
+    summary = next((r for r in records if r.code == TRACE_SUMMARY), None)
+    windows = [struct.unpack("<HHH", r.data) for r in records if r.code == TRACE_LOOP]
+    if summary:
+        events, loops, total_us, max_us = struct.unpack("<HIII", summary.data)
+    else:
+        events = 0
+        loops = sum(w[0] for w in windows)
+        total_us = sum(w[0] * w[1] for w in windows)
+        max_us = max((w[2] for w in windows), default=0)
+    worst = max((w[1] for w in windows), default=0)
+    return {"loops": loops, "avg_us": round(total_us / loops, 1) if loops else 0,
+            "max_us": max_us, "worst_window_avg_us": worst, "events": events}
+
+
+def compare(captured, replayed):
+    """按输出类型各自按序配对，比较时刻与内容"""
+    outputs = []
+    mismatches = 0
+    for code in OUTPUT_RECORDS:
+        before = [r for r in captured if r.code == code]
+        after = [r for r in replayed if r.code == code]
+        for index in range(max(len(before), len(after))):
+            a = before[index] if index < len(before) else None
+            b = after[index] if index < len(after) else None
+            same = a is not None and b is not None and a.data == b.data
+            mismatches += 0 if same else 1
+            outputs.append({
+                "type": NAMES[code],
+                "content": (a or b).describe()[:60],
+                "capture_ms": a.t if a else None,
+                "replay_ms": b.t if b else None,
+                "delta_ms": (b.t - a.t) if a and b else None,
+                "match": same,
+            })
+    outputs.sort(key=lambda o: o["capture_ms"] if o["capture_ms"] is not None else o["replay_ms"])
+    deltas = [abs(o["delta_ms"]) for o in outputs if o["delta_ms"] is not None]
+    return {
+        "outputs": outputs,
+        "mismatches": mismatches,
+        "max_abs_delta_ms": max(deltas, default=0),
+        "capture_loop": loop_cost(captured),
+        "replay_loop": loop_cost(replayed),
+    }
+
+
+def print_report(result, verbose):
+    print("=== 回放对比 (%s) ===" % result["trace"])
+    for output in result["outputs"]:
+        if not verbose and output["match"] and not output["delta_ms"]:
+            continue
+        print("%-6s 录制%8s  回放%8s  差%6s  %s%s" % (
+            output["type"],
+            "-" if output["capture_ms"] is None else "%dms" % output["capture_ms"],
+            "-" if output["replay_ms"] is None else "%dms" % output["replay_ms"],
+            "-" if output["delta_ms"] is None else "%+d" % output["delta_ms"],
+            output["content"], "" if output["match"] else "  ≠"))
+    print("输出 %d 条  不一致 %d  最大时刻偏差 %dms" % (
+        len(result["outputs"]), result["mismatches"], result["max_abs_delta_ms"]))
+    for name in ("capture_loop", "replay_loop"):
+        cost = result[name]
+        print("%s: loop %d次  平均 %.1fus  最大 %dus  最差窗口平均 %dus" % (
+            "录制" if name == "capture_loop" else "回放",
+            cost["loops"], cost["avg_us"], cost["max_us"], cost["worst_window_avg_us"]))
+
+
+def show(args):
+    for record in load_trace(args.trace):
+        print("%8dms  %-9s %s" % (record.t, NAMES.get(record.code, hex(record.code)), record.describe()))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Harbinger控制器录制/回放")
+    sub = parser.add_subparsers(dest="action", required=True)
+
+    for name in ("capture", "replay"):
+        p = sub.add_parser(name)
+        p.add_argument("port", help="串口，如 /dev/ttyACM0 或 COM5")
+        p.add_argument("trace", help="记录文件")
+        p.add_argument("--baud", type=int, default=115200)
+        p.add_argument("--boot-timeout", type=float, default=15, help="等待控制器启动完成(秒)")
+        p.add_argument("--echo", action="store_true", help="同时显示控制器调试输出")
+    sub.choices["capture"].add_argument("--duration", type=float, default=0, help="录制时长(秒)，0=直到Ctrl-C")
+    sub.choices["replay"].add_argument("--timeout", type=float, default=5, help="控制器无响应超时(秒)")
+    sub.choices["replay"].add_argument("--json", help="结果追加写入JSON Lines文件")
+    sub.choices["replay"].add_argument("--label", default="", help="写入结果的版本标签")
+    sub.choices["replay"].add_argument("--verbose", action="store_true", help="列出全部输出（默认只列有偏差的）")
+
+    p = sub.add_parser("show")
+    p.add_argument("trace")
+
+    args = parser.parse_args()
+    {"capture": capture, "replay": replay, "show": show}[args.action](args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
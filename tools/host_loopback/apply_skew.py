@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""
+对比两个host_controller日志里同一gseq的APPLY时刻，输出控制器间执行时间差分位数。
+
+用法: python3 apply_skew.py c102.log c302.log [--split N]
+    --split N  另外分别统计前N条和后N条（时钟同步测试：漂移收敛前后）
+"""
+
+import re
+import sys
+
+APPLY_RE = re.compile(r"APPLY \S+ gseq=(\d+) at=(\d+)")
+DRIFT_RE = re.compile(r"drift=(-?\d+) drift_valid=1")
+
+
+def load(path):
+    applied = {}
+    duplicates = 0
+    for line in open(path):
+        m = APPLY_RE.match(line)
+        if m:
+            gseq = int(m.group(1))
+            if gseq in applied:
+                duplicates += 1
+            else:
+                applied[gseq] = int(m.group(2))
+    return applied, duplicates
+
+
+def report(label, skews):
+    skews = sorted(skews)
+    if not skews:
+        print("%s: 没有两边都执行的命令" % label)
+        return
+    print("%s: n=%d  执行时间差 p50 %.2fms  p95 %.2fms  max %.2fms" % (
+        label, len(skews), skews[len(skews) // 2], skews[int(len(skews) * 0.95)], skews[-1]))
+
+
+def last_drift(path):
+    drift = None
+    for line in open(path):
+        m = DRIFT_RE.search(line)
+        if m:
+            drift = int(m.group(1))
+    return drift
+
+
+def main():
+    paths = [arg for arg in sys.argv[1:] if not arg.startswith("--")][:2]
+    split = int(sys.argv[sys.argv.index("--split") + 1]) if "--split" in sys.argv else 0
+    (a, dup_a), (b, dup_b) = load(paths[0]), load(paths[1])
+    common = sorted(set(a) & set(b))
+    print("执行: %d / %d 条  重复执行: %d / %d 次" % (len(a), len(b), dup_a, dup_b))
+    report("全部", [abs(a[k] - b[k]) / 1000.0 for k in common])
+    if split:
+        report("前%d条" % split, [abs(a[k] - b[k]) / 1000.0 for k in common[:split]])
+        report("后%d条" % split, [abs(a[k] - b[k]) / 1000.0 for k in common[-split:]])
+        print("最终漂移估计(ppm): %s / %s" % (last_drift(paths[0]), last_drift(paths[1])))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,19 @@
+#!/bin/bash
+# 把草图目录里的UniversalHarbingerClient和HarbingerFrame用shim/垫片编译成主机进程
+# 用法: tools/host_loopback/build.sh [草图目录，默认C102] [输出目录，默认/tmp/harbinger_host]
+# 源文件先复制到输出目录：客户端的 #include "ArduinoSystemHelper.h" 会先在源文件所在目录查找，
+# 复制后才能用到shim/里的替身，而不是草图里依赖AVR寄存器的真实实现
+
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+REPO=$(cd "$HERE/../.." && pwd)
+SKETCH=${1:-C102}
+BUILD=${2:-/tmp/harbinger_host}
+
+mkdir -p "$BUILD/src"
+for f in UniversalHarbingerClient.h UniversalHarbingerClient.cpp HarbingerFrame.h HarbingerFrame.cpp; do
+    cp "$REPO/$SKETCH/$f" "$BUILD/src/"
+done
+cp "$HERE/host_controller.cpp" "$BUILD/src/"
+g++ -std=gnu++11 -O1 -w -I"$HERE/shim" -I"$BUILD/src" -o "$BUILD/host_controller" \
+    "$BUILD/src/host_controller.cpp" "$BUILD/src/UniversalHarbingerClient.cpp" "$BUILD/src/HarbingerFrame.cpp"
@@ -0,0 +1,33 @@
+#!/bin/bash
+# 时钟同步回环测试：两个host_controller进程分别带不同的时钟偏移和漂移，
+# 服务器每500ms组播一条at=+300ms的命令，输出漂移估计、漂移收敛前后的执行时间差和at_error。
+#
+# 用法: tools/host_loopback/clock_sync.sh [组命令条数，默认160即80秒] [端口]
+# 环境变量: SKETCH / LOOP_WORK_US / BUILD 同group_skew.sh
+#           C102_CLOCK="12345 3000"  C302_CLOCK="5000 -3000"  各进程的 时钟偏移ms 漂移ppm
+# 漂移至少要两个相隔CLOCK_DRIFT_MIN_SPAN(20s)的样本才能估计，前40条（约20秒）是收敛前的结果
+
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+REPO=$(cd "$HERE/../.." && pwd)
+LOOPS=${1:-160}
+PORT=${2:-9400}
+SKETCH=${SKETCH:-C102}
+BUILD=${BUILD:-/tmp/harbinger_host}
+
+"$HERE/build.sh" "$SKETCH" "$BUILD"
+
+python3 "$REPO/tools/harbinger_server.py" --host 127.0.0.1 --port "$PORT" \
+    --script "$HERE/clock_room.txt" --expect 2 --loops "$LOOPS" --warmup 1 \
+    --group 239.255.10.10:9001 --group-if 127.0.0.1 > "$BUILD/server.log" 2>&1 &
+SERVER=$!
+sleep 0.5
+"$BUILD/host_controller" C102 "$PORT" "${LOOP_WORK_US:-1000}" ${C102_CLOCK:-12345 3000} > "$BUILD/c102.log" 2>&1 &
+A=$!
+"$BUILD/host_controller" C302 "$PORT" "${LOOP_WORK_US:-1000}" ${C302_CLOCK:-5000 -3000} > "$BUILD/c302.log" 2>&1 &
+B=$!
+wait $SERVER || true
+kill $A $B 2>/dev/null || true
+
+python3 "$HERE/apply_skew.py" "$BUILD/c102.log" "$BUILD/c302.log" --split 40
+grep -A6 "=== C" "$BUILD/server.log" | grep "定时执行\\|=== C" || true
@@ -0,0 +1,41 @@
+#!/bin/bash
+# 组播组命令回环测试：两个host_controller进程（C102/C302）连接本机harbinger_server.py，
+# 按tools/group_room.txt发组命令，输出每条命令是否恰好执行一次和两个进程的执行时间差。
+#
+# 用法: tools/host_loopback/group_skew.sh [multicast|tcp] [组命令条数] [端口]
+#   multicast  组播数据报（每个发两次，验证去重），默认
+#   tcp        逐个控制器经TCP发送，对比用
+# 环境变量: SKETCH=C102  编译哪个草图目录里的UniversalHarbingerClient
+#           LOOP_WORK_US=3000  每轮loop模拟工作上限
+#           BUILD=/tmp/harbinger_host  编译和日志目录
+# 注意: 回环网卡没有逐个控制器的传输开销，单核环境下两个忙循环进程互相抢CPU，
+#       结果主要是调度和loop相位噪声，只用于验证去重和功能，传输方式的差别要在真实网络上看。
+
+set -e
+HERE=$(cd "$(dirname "$0")" && pwd)
+REPO=$(cd "$HERE/../.." && pwd)
+MODE=${1:-multicast}
+LOOPS=${2:-40}
+PORT=${3:-9300}
+SKETCH=${SKETCH:-C102}
+BUILD=${BUILD:-/tmp/harbinger_host}
+
+"$HERE/build.sh" "$SKETCH" "$BUILD"
+
+GROUP_ARGS=""
+[ "$MODE" = "multicast" ] && GROUP_ARGS="--group 239.255.10.10:9001 --group-if 127.0.0.1"
+
+python3 "$REPO/tools/harbinger_server.py" --host 127.0.0.1 --port "$PORT" \
+    --script "$REPO/tools/group_room.txt" --expect 2 --loops "$LOOPS" --warmup 0.5 \
+    $GROUP_ARGS > "$BUILD/server.log" 2>&1 &
+SERVER=$!
+sleep 0.5
+"$BUILD/host_controller" C102 "$PORT" "${LOOP_WORK_US:-3000}" > "$BUILD/c102.log" 2>&1 &
+A=$!
+"$BUILD/host_controller" C302 "$PORT" "${LOOP_WORK_US:-3000}" > "$BUILD/c302.log" 2>&1 &
+B=$!
+wait $SERVER || true
+kill $A $B 2>/dev/null || true
+
+python3 "$HERE/apply_skew.py" "$BUILD/c102.log" "$BUILD/c302.log"
+grep -A3 "=== 组命令" "$BUILD/server.log" || tail -5 "$BUILD/server.log"
@@ -0,0 +1,73 @@
+// 主机回环测试驱动：把草图里的UniversalHarbingerClient编译成Linux进程，连接本机的
+// tools/harbinger_server.py，加入组播组，收到HARD命令时打印执行时刻并回EMERGENCY_ACK。
+// 用法: host_controller <控制器ID> <服务器端口> [每轮loop模拟工作上限us] [时钟偏移ms] [时钟漂移ppm]
+// 输出: APPLY <ID> gseq=<序号> at=<执行时刻us，CLOCK_MONOTONIC> ...，供apply_skew.py对比各进程的执行时刻
+// 时钟偏移/漂移只作用于millis()/micros()（模拟Mega上电时刻不同和陶瓷谐振器误差），at始终是主机真实时间
+
+#define private public     // 打印时钟滤波器内部状态（offset/drift），只在测试驱动里这样做
+#include "UniversalHarbingerClient.h"
+#undef private
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+int hostServerPort = 9000;
+EthernetClass Ethernet;
+HardwareSerial Serial;
+
+static unsigned long long monotonicUs() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000ULL + t.tv_nsec / 1000;
+}
+
+static unsigned long long startUs;
+static const char* controllerId;
+static long clockOffsetMs = 0;
+static double clockDriftPpm = 0;
+
+unsigned long micros() {
+    return (unsigned long)((monotonicUs() - startUs) * (1.0 + clockDriftPpm * 1e-6)) + clockOffsetMs * 1000UL;
+}
+unsigned long millis() { return micros() / 1000; }
+void delay(unsigned long ms) { usleep(ms * 1000); }
+void delayMicroseconds(unsigned int us) { usleep(us); }
+
+static void onMessage(String message) {
+    if (message.indexOf("[HARD]") < 0) return;
+    int p = message.indexOf("gseq=");
+    printf("APPLY %s gseq=%ld at=%llu late=%lu offset=%ld drift=%.0f drift_valid=%d samples=%d rtt=%lu\n",
+           controllerId, p >= 0 ? atol(message.c_str() + p + 5) : -1L, monotonicUs(),
+           harbingerClient.getDispatchLateness(), harbingerClient.clockOffset, harbingerClient.clockDriftPpm,
+           harbingerClient.driftValid, harbingerClient.clockSampleCount, harbingerClient.clockRtt);
+    fflush(stdout);
+    harbingerClient.sendHARDResponse("EMERGENCY_ACK", "scope=all,status=stopped");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <controller_id> <server_port> [loop_work_us] [clock_offset_ms] [drift_ppm]\n", argv[0]);
+        return 2;
+    }
+    startUs = monotonicUs();
+    controllerId = argv[1];
+    hostServerPort = atoi(argv[2]);
+    int loopWorkUs = argc > 3 ? atoi(argv[3]) : 0;
+    clockOffsetMs = argc > 4 ? atol(argv[4]) : 0;
+    clockDriftPpm = argc > 5 ? atof(argv[5]) : 0;
+    srand(getpid());
+
+    harbingerClient.begin(controllerId, "Arduino");
+    harbingerClient.setMessageCallback(onMessage);
+    harbingerClient.connect(IPAddress(127, 0, 0, 1), hostServerPort);
+    if (!harbingerClient.joinGroup(IPAddress(239, 255, 10, 10))) {
+        fprintf(stderr, "joinGroup failed\n");
+    }
+
+    for (;;) {
+        harbingerClient.handleAllNetworkOperations();
+        // 模拟loop里的其他工作（PWM、游戏逻辑），每轮0..loopWorkUs随机，让各进程处于不同的loop相位
+        unsigned long long until = monotonicUs() + (loopWorkUs > 0 ? rand() % loopWorkUs : 0);
+        while (monotonicUs() < until) {}
+    }
+}
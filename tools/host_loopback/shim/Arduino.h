@@ -0,0 +1,131 @@
+// 主机回环测试垫片：UniversalHarbingerClient用到的Arduino核心API，String基于std::string，
+// 串口输出全部丢弃（测试驱动自己往stdout打印），millis()/micros()由测试驱动提供
+#pragma once
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <string>
+
+class __FlashStringHelper;
+#define F(x) ((const __FlashStringHelper*)(x))
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define DEC 10
+#define HEX 16
+typedef uint8_t byte;
+typedef bool boolean;
+
+template<class T, class U> auto min(T a, U b) -> decltype(a < b ? a : b) { return a < b ? a : b; }
+template<class T, class U> auto max(T a, U b) -> decltype(a > b ? a : b) { return a > b ? a : b; }
+#define constrain(a, l, h) ((a) < (l) ? (l) : ((a) > (h) ? (h) : (a)))
+#define abs(x) ((x) > 0 ? (x) : -(x))
+#define noInterrupts()
+#define interrupts()
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+inline bool isAlpha(int c) { return isalpha(c); }
+inline bool isSpace(int c) { return isspace(c); }
+inline bool isUpperCase(int c) { return c >= 'A' && c <= 'Z'; }
+inline bool isLowerCase(int c) { return c >= 'a' && c <= 'z'; }
+
+class String {
+public:
+    std::string s;
+    String(const char* c = "") : s(c) {}
+    String(const __FlashStringHelper* f) : s((const char*)f) {}
+    String(const std::string& x) : s(x) {}
+    String(char c) : s(1, c) {}
+    String(int v, int base = 10) : s(std::to_string(v)) {}
+    String(unsigned int v, int base = 10) : s(std::to_string(v)) {}
+    String(long v, int base = 10) : s(std::to_string(v)) {}
+    String(unsigned long v, int base = 10) : s(std::to_string(v)) {}
+    String(double v, int digits = 2) : s(std::to_string(v)) {}
+    unsigned int length() const { return s.size(); }
+    const char* c_str() const { return s.c_str(); }
+    bool reserve(unsigned int n) { s.reserve(n); return true; }
+    char charAt(unsigned int i) const { return s[i]; }
+    char operator[](unsigned int i) const { return s[i]; }
+    char& operator[](unsigned int i) { return s[i]; }
+    int indexOf(const String& x, unsigned int from = 0) const { size_t p = s.find(x.s, from); return p == std::string::npos ? -1 : (int)p; }
+    int indexOf(char c, unsigned int from = 0) const { size_t p = s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+    int lastIndexOf(const String& x) const { size_t p = s.rfind(x.s); return p == std::string::npos ? -1 : (int)p; }
+    int lastIndexOf(char c) const { size_t p = s.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+    String substring(unsigned int a) const { return a >= s.size() ? String() : String(s.substr(a)); }
+    String substring(unsigned int a, unsigned int b) const { return a >= s.size() || b <= a ? String() : String(s.substr(a, b - a)); }
+    bool startsWith(const String& x) const { return s.compare(0, x.s.size(), x.s) == 0; }
+    bool endsWith(const String& x) const { return s.size() >= x.s.size() && s.compare(s.size() - x.s.size(), x.s.size(), x.s) == 0; }
+    bool equals(const String& x) const { return s == x.s; }
+    bool equalsIgnoreCase(const String& x) const { return strcasecmp(s.c_str(), x.s.c_str()) == 0; }
+    long toInt() const { return atol(s.c_str()); }
+    float toFloat() const { return atof(s.c_str()); }
+    void trim() {
+        size_t a = s.find_first_not_of(" \t\r\n");
+        size_t b = s.find_last_not_of(" \t\r\n");
+        s = a == std::string::npos ? std::string() : s.substr(a, b - a + 1);
+    }
+    void toUpperCase() { for (char& c : s) c = toupper(c); }
+    void toLowerCase() { for (char& c : s) c = tolower(c); }
+    void replace(const String& from, const String& to) {
+        if (from.s.empty()) return;
+        for (size_t p = 0; (p = s.find(from.s, p)) != std::string::npos; p += to.s.size()) s.replace(p, from.s.size(), to.s);
+    }
+    void remove(unsigned int index, unsigned int count = 1) { if (index < s.size()) s.erase(index, count); }
+    void toCharArray(char* buf, unsigned int n) const { strncpy(buf, s.c_str(), n); if (n) buf[n - 1] = '\0'; }
+    String& operator+=(const String& x) { s += x.s; return *this; }
+    String& operator+=(const char* c) { s += c; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+    String& operator+=(int v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned int v) { s += std::to_string(v); return *this; }
+    String& operator+=(long v) { s += std::to_string(v); return *this; }
+    String& operator+=(unsigned long v) { s += std::to_string(v); return *this; }
+    bool operator==(const String& x) const { return s == x.s; }
+    bool operator!=(const String& x) const { return s != x.s; }
+    bool operator==(const char* x) const { return s == x; }
+    bool operator!=(const char* x) const { return s != x; }
+};
+inline String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+inline String operator+(const String& a, const char* b) { return String(a.s + b); }
+inline String operator+(const char* a, const String& b) { return String(std::string(a) + b.s); }
+inline String operator+(const String& a, char b) { return String(a.s + b); }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buf, size_t n) { size_t r = 0; while (n--) r += write(*buf++); return r; }
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    template<class T> size_t print(T) { return 0; }
+    template<class T> size_t print(T, int) { return 0; }
+    template<class T> size_t println(T) { return 0; }
+    template<class T> size_t println(T, int) { return 0; }
+    size_t println() { return 0; }
+    void flush() {}
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    void setTimeout(unsigned long) {}
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    int available() { return 0; }
+    int read() { return -1; }
+    int peek() { return -1; }
+    size_t write(uint8_t) { return 1; }
+    using Print::write;
+    operator bool() { return true; }
+};
+extern HardwareSerial Serial;
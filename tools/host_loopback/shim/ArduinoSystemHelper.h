@@ -0,0 +1,6 @@
+// 主机回环测试垫片：UniversalHarbingerClient只用到freeMemory()（REGISTER的free_ram）
+#pragma once
+class ArduinoSystemHelper {
+public:
+    static int freeMemory() { return 0; }
+};
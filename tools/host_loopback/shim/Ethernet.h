@@ -0,0 +1,137 @@
+// 主机回环测试垫片：Ethernet库API映射到POSIX socket
+// EthernetClient连127.0.0.1:hostServerPort（忽略草图里的服务器地址），
+// EthernetUDP::beginMulticast在回环网卡上加入组播组，多个进程可同时绑定同一端口
+#pragma once
+#include <Arduino.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+extern int hostServerPort;
+
+class IPAddress {
+public:
+    uint8_t b[4];
+    IPAddress() { memset(b, 0, 4); }
+    IPAddress(uint8_t a0, uint8_t a1, uint8_t a2, uint8_t a3) { b[0] = a0; b[1] = a1; b[2] = a2; b[3] = a3; }
+    uint8_t operator[](int i) const { return b[i]; }
+    uint8_t& operator[](int i) { return b[i]; }
+    bool operator==(const IPAddress& o) const { return memcmp(b, o.b, 4) == 0; }
+};
+
+class EthernetClient : public Stream {
+public:
+    int fd = -1;
+    bool up = false;
+
+    int connect(IPAddress, uint16_t) {
+        stop();
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in a = {};
+        a.sin_family = AF_INET;
+        a.sin_port = htons(hostServerPort);
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, (sockaddr*)&a, sizeof a) < 0) { ::close(fd); fd = -1; return 0; }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        up = true;
+        return 1;
+    }
+    uint8_t connected() {
+        if (fd < 0) return 0;
+        char c;
+        if (recv(fd, &c, 1, MSG_PEEK) == 0) up = false;
+        return up;
+    }
+    void stop() { if (fd >= 0) ::close(fd); fd = -1; up = false; }
+    int available() {
+        if (fd < 0) return 0;
+        char buf[2048];
+        int r = recv(fd, buf, sizeof buf, MSG_PEEK);
+        return r > 0 ? r : 0;
+    }
+    int read() { uint8_t c; return read(&c, 1) == 1 ? c : -1; }
+    int read(uint8_t* buf, size_t n) { int r = recv(fd, buf, n, 0); return r > 0 ? r : 0; }
+    int peek() { return -1; }
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t write(const uint8_t* buf, size_t n) { int r = send(fd, buf, n, MSG_NOSIGNAL); return r > 0 ? r : 0; }
+    size_t print(const String& m) { return write((const uint8_t*)m.s.data(), m.s.size()); }
+    using Print::print;
+    operator bool() { return fd >= 0; }
+    void setConnectionTimeout(uint16_t) {}
+    IPAddress remoteIP() { return IPAddress(127, 0, 0, 1); }
+};
+
+class EthernetUDP : public Stream {
+public:
+    int fd = -1;
+    uint8_t pkt[1500];
+    int len = 0, pos = 0;
+
+    uint8_t begin(uint16_t) { return 1; }
+    uint8_t beginMulticast(IPAddress group, uint16_t port) {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof one);
+        sockaddr_in a = {};
+        a.sin_family = AF_INET;
+        a.sin_port = htons(port);
+        a.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(fd, (sockaddr*)&a, sizeof a) < 0) { perror("bind"); return 0; }
+        ip_mreq m = {};
+        memcpy(&m.imr_multiaddr.s_addr, group.b, 4);
+        m.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &m, sizeof m) < 0) { perror("IP_ADD_MEMBERSHIP"); return 0; }
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        return 1;
+    }
+    void stop() { if (fd >= 0) ::close(fd); fd = -1; }
+    int parsePacket() {
+        len = fd < 0 ? 0 : recv(fd, pkt, sizeof pkt, 0);
+        if (len < 0) len = 0;
+        pos = 0;
+        return len;
+    }
+    int available() { return len - pos; }
+    int read() { return pos < len ? pkt[pos++] : -1; }
+    int read(uint8_t* buf, size_t n) {
+        if (pos >= len) return -1;
+        int k = (int)n < len - pos ? (int)n : len - pos;
+        memcpy(buf, pkt + pos, k);
+        pos += k;
+        return k;
+    }
+    int read(char* buf, size_t n) { return read((uint8_t*)buf, n); }
+    int peek() { return pos < len ? pkt[pos] : -1; }
+    size_t write(uint8_t) { return 1; }
+    using Print::write;
+    int beginPacket(IPAddress, uint16_t) { return 1; }
+    int endPacket() { return 1; }
+    IPAddress remoteIP() { return IPAddress(); }
+    uint16_t remotePort() { return 0; }
+};
+
+enum EthernetLinkStatus { Unknown, LinkON, LinkOFF };
+enum EthernetHardwareStatus { EthernetNoHardware, EthernetW5100, EthernetW5200, EthernetW5500 };
+
+class EthernetClass {
+public:
+    int begin(uint8_t*) { return 1; }
+    void begin(uint8_t*, IPAddress) {}
+    void begin(uint8_t*, IPAddress, IPAddress) {}
+    void begin(uint8_t*, IPAddress, IPAddress, IPAddress) {}
+    void begin(uint8_t*, IPAddress, IPAddress, IPAddress, IPAddress) {}
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+    EthernetLinkStatus linkStatus() { return LinkON; }
+    EthernetHardwareStatus hardwareStatus() { return EthernetW5100; }
+    int maintain() { return 0; }
+    void init(uint8_t) {}
+};
+extern EthernetClass Ethernet;
@@ -0,0 +1,15 @@
+// 主机回环测试垫片：PROGMEM数据在主机上就是普通内存
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#define PROGMEM
+#define PSTR(x) x
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strlen_P strlen
+#define memcpy_P memcpy
+#define memcmp_P memcmp